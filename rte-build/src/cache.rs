@@ -0,0 +1,163 @@
+//! A cache of the generated bindings and the compiled stub library,
+//! shared by the crates and the CI jobs building against the same DPDK.
+//!
+//! An artifact is keyed by the DPDK version and a hash of the compiler flags, the CPU features,
+//! the content of every header it is built from, as listed by the dependency output of the compiler,
+//! and the bindgen and libclang releases for the bindings,
+//! so it is only rebuilt when a header actually changed.
+//!
+//! The cache lives in `RTE_BUILD_CACHE`, or `$XDG_CACHE_HOME/rte-build`, or `$HOME/.cache/rte-build`,
+//! it is disabled with `RTE_BUILD_CACHE=off`.
+use std::env;
+use std::fs;
+use std::io;
+use std::path::{Path, PathBuf};
+use std::process;
+
+use cc;
+
+/// A FNV-1a hash, stable across the Rust releases unlike the `std` hashers.
+#[derive(Clone, Debug)]
+pub struct Fingerprint(u64);
+
+const FNV_OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+const FNV_PRIME: u64 = 0x0100_0000_01b3;
+
+impl Default for Fingerprint {
+    fn default() -> Self {
+        Fingerprint(FNV_OFFSET)
+    }
+}
+
+impl Fingerprint {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Hash some data, terminated so the concatenations differ.
+    pub fn update<T: AsRef<[u8]>>(&mut self, data: T) -> &mut Self {
+        for &b in data.as_ref().iter().chain(&[0xff]) {
+            self.0 ^= b as u64;
+            self.0 = self.0.wrapping_mul(FNV_PRIME);
+        }
+
+        self
+    }
+
+    /// Hash the path and the content of a file.
+    pub fn file<P: AsRef<Path>>(&mut self, path: P) -> io::Result<&mut Self> {
+        let content = fs::read(path.as_ref())?;
+
+        Ok(self.update(path.as_ref().to_string_lossy().as_bytes()).update(content))
+    }
+
+    /// Hash the command line of a compiler.
+    pub fn compiler(&mut self, tool: &cc::Tool) -> &mut Self {
+        self.update(tool.path().to_string_lossy().as_bytes());
+
+        for arg in tool.args() {
+            self.update(arg.to_string_lossy().as_bytes());
+        }
+
+        self
+    }
+
+    /// Hash the sources compiled by a build, and all the headers they include,
+    /// cargo reruns the build script when any of them changes.
+    pub fn sources<P: AsRef<Path>>(&mut self, build: &cc::Build, sources: &[P]) -> io::Result<&mut Self> {
+        self.compiler(&build.get_compiler());
+
+        for source in sources {
+            for header in header_deps(build, source)? {
+                println!("cargo:rerun-if-changed={}", header.display());
+
+                self.file(header)?;
+            }
+        }
+
+        Ok(self)
+    }
+
+    /// The key of an artifact built against a DPDK version.
+    pub fn key(&self, version: &str) -> String {
+        format!("{}-{:016x}", version, self.0)
+    }
+}
+
+/// The headers included by a source file, with the file itself, from the `-M` output of the compiler.
+pub fn header_deps<P: AsRef<Path>>(build: &cc::Build, source: P) -> io::Result<Vec<PathBuf>> {
+    let output = build
+        .get_compiler()
+        .to_command()
+        .arg("-M")
+        .arg(source.as_ref())
+        .stderr(process::Stdio::inherit())
+        .output()?;
+
+    if !output.status.success() {
+        return Err(io::Error::new(
+            io::ErrorKind::Other,
+            format!("fail to list the headers of {:?}", source.as_ref()),
+        ));
+    }
+
+    // `target.o: source.c header.h \` with a continuation line per header
+    Ok(String::from_utf8_lossy(&output.stdout)
+        .split_whitespace()
+        .skip(1)
+        .filter(|&s| s != "\\")
+        .map(PathBuf::from)
+        .collect())
+}
+
+/// A directory of artifacts, each one in a directory named after its key.
+pub struct Cache {
+    dir: PathBuf,
+}
+
+impl Cache {
+    /// Open the cache, unless it is disabled or has no home.
+    pub fn open() -> Option<Cache> {
+        println!("cargo:rerun-if-env-changed=RTE_BUILD_CACHE");
+
+        let dir = match env::var_os("RTE_BUILD_CACHE") {
+            Some(ref dir) if dir == "off" => return None,
+            Some(dir) => PathBuf::from(dir),
+            None => env::var_os("XDG_CACHE_HOME")
+                .map(PathBuf::from)
+                .or_else(|| env::var_os("HOME").map(|home| Path::new(&home).join(".cache")))?
+                .join("rte-build"),
+        };
+
+        Some(Cache { dir })
+    }
+
+    /// Copy a cached artifact to `dest`, return `false` if it is missing.
+    pub fn get(&self, key: &str, name: &str, dest: &Path) -> bool {
+        let path = self.dir.join(key).join(name);
+
+        match fs::copy(&path, dest) {
+            Ok(_) => {
+                info!("using the cached {:?}", path);
+
+                true
+            }
+            Err(_) => false,
+        }
+    }
+
+    /// Store an artifact, the concurrent builds only see a complete file.
+    pub fn put(&self, key: &str, name: &str, src: &Path) {
+        let dir = self.dir.join(key);
+        let tmp = dir.join(format!(".{}.{}", name, process::id()));
+
+        if let Err(err) = fs::create_dir_all(&dir)
+            .and_then(|_| fs::copy(src, &tmp))
+            .and_then(|_| fs::rename(&tmp, dir.join(name)))
+        {
+            let _ = fs::remove_file(&tmp);
+
+            warn!("fail to cache {:?} in {:?}, {}", src, dir, err);
+        }
+    }
+}
@@ -1,4 +1,5 @@
 use std::env;
+use std::fs;
 use std::path::PathBuf;
 
 lazy_static! {
@@ -28,3 +29,31 @@ pub fn gen_cargo_config<S: AsRef<str>>(
         println!("cargo:include={}", dir.as_ref());
     }
 }
+
+/// The version of a package locked in the `Cargo.lock` of the workspace, cargo reruns the build script when it changes.
+pub fn locked_version(name: &str) -> Option<String> {
+    let dir = PathBuf::from(env::var_os("CARGO_MANIFEST_DIR")?);
+    let lock = dir
+        .ancestors()
+        .map(|dir| dir.join("Cargo.lock"))
+        .find(|path| path.is_file())?;
+
+    println!("cargo:rerun-if-changed={}", lock.display());
+
+    let content = fs::read_to_string(&lock).ok()?;
+    let package = format!("name = \"{}\"", name);
+    let mut lines = content.lines();
+
+    // `name = "..."` is followed by `version = "..."` in each `[[package]]`
+    while let Some(line) = lines.next() {
+        if line == package {
+            return lines
+                .next()
+                .and_then(|line| line.strip_prefix("version = \""))
+                .and_then(|version| version.strip_suffix('"'))
+                .map(String::from);
+        }
+    }
+
+    None
+}
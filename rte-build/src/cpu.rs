@@ -2,7 +2,25 @@ use std::iter;
 
 use raw_cpuid;
 
+use crate::rte::{MACHINE, RTE_MACHINE};
+
+lazy_static! {
+    /// The CPU features of the build host, probed once.
+    ///
+    /// A build for another `RTE_MACHINE` than the host relies on the macros predefined by `-march`,
+    /// such as `__AVX2__`, and the data path selects its kernels at runtime.
+    static ref CPU_FEATURES: Vec<(&'static str, Option<String>)> = if *RTE_MACHINE == MACHINE {
+        probe_cpu_features().collect()
+    } else {
+        vec![]
+    };
+}
+
 pub fn gen_cpu_features() -> impl Iterator<Item = (&'static str, Option<String>)> {
+    CPU_FEATURES.iter().cloned()
+}
+
+fn probe_cpu_features() -> impl Iterator<Item = (&'static str, Option<String>)> {
     let mut cflags = vec![];
     let mut compile_time_cpuflags = vec![];
 
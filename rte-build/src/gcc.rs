@@ -3,6 +3,7 @@ use std::path::Path;
 use cc;
 
 use crate::gen_cpu_features;
+use crate::rte::RTE_MACHINE;
 
 pub fn gcc_rte_config<S: AsRef<Path>>(rte_include_dir: &Vec<S>) -> cc::Build {
     let mut build = cc::Build::new();
@@ -11,7 +12,7 @@ pub fn gcc_rte_config<S: AsRef<Path>>(rte_include_dir: &Vec<S>) -> cc::Build {
         build.include(dir);
     }
 
-    build.flag("-march=native").cargo_metadata(true);
+    build.flag(&format!("-march={}", *RTE_MACHINE)).cargo_metadata(true);
 
     for (name, value) in gen_cpu_features() {
         let define = if let Some(value) = value {
@@ -8,12 +8,14 @@ extern crate num_cpus;
 extern crate pkg_config;
 extern crate raw_cpuid;
 
+mod cache;
 mod cargo;
 mod cpu;
 mod gcc;
 mod rte;
 
-pub use crate::cargo::{gen_cargo_config, OUT_DIR};
+pub use crate::cache::{header_deps, Cache, Fingerprint};
+pub use crate::cargo::{gen_cargo_config, locked_version, OUT_DIR};
 pub use crate::cpu::gen_cpu_features;
 pub use crate::gcc::gcc_rte_config;
 pub use crate::rte::*;
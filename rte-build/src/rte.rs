@@ -10,51 +10,21 @@ pub const MACHINE: &str = "native";
 pub const TOOLCHAIN: &str = "gcc";
 
 lazy_static! {
-    pub static ref RTE_LIB_DIR: std::vec::Vec<std::string::String> = {
-        let libdpdk = pkg_config::Config::new()
-            .cargo_metadata(true)
-            .env_metadata(true)
-            .probe("libdpdk")
-            .expect("RTE_LIBDIR - Failed to get information from libdpdk.pc");
-        libdpdk.link_paths.iter().map(|p| p.to_string_lossy().to_string()).rev().collect()
-    };
-    pub static ref RTE_INCLUDE_DIR: std::vec::Vec<std::string::String> = {
-        let libdpdk = pkg_config::Config::new()
-            .cargo_metadata(true)
-            .env_metadata(true)
-            .probe("libdpdk")
-            .expect("RTE_LIBDIR - Failed to get information from libdpdk.pc");
-        libdpdk.include_paths.iter().map(|p| p.to_string_lossy().to_string()).rev().collect()
-    };
-    pub static ref RTE_CORE_LIBS: std::vec::Vec<std::string::String> = {
-        let libdpdk = pkg_config::Config::new()
-            .cargo_metadata(true)
-            .env_metadata(true)
-            .probe("libdpdk")
-            .expect("RTE_LIBDIR - Failed to get information from libdpdk.pc");
-        let mut libs = Vec::new();
-        for lib in &libdpdk.libs {
-            if lib.contains("pmd") {
-                continue;
-            }
-            libs.push(lib.to_string());
-        }
-        return libs;
-    };
-    pub static ref RTE_PMD_LIBS: std::vec::Vec<std::string::String> = {
-        let libdpdk = pkg_config::Config::new()
-            .cargo_metadata(true)
-            .env_metadata(true)
-            .probe("libdpdk")
-            .expect("RTE_LIBDIR - Failed to get information of libdpdk.pc");
-        let mut libs = Vec::new();
-        for lib in &libdpdk.libs {
-            if lib.contains("pmd") {
-                libs.push(lib.to_string());
-            }
-        }
-        return libs;
-    };
+    /// The `libdpdk` package, probed once by pkg-config.
+    pub static ref LIBDPDK: pkg_config::Library = pkg_config::Config::new()
+        .cargo_metadata(true)
+        .env_metadata(true)
+        .probe("libdpdk")
+        .expect("RTE_LIBDIR - Failed to get information from libdpdk.pc");
+    pub static ref RTE_VERSION: String = LIBDPDK.version.clone();
+    pub static ref RTE_LIB_DIR: std::vec::Vec<std::string::String> =
+        LIBDPDK.link_paths.iter().map(|p| p.to_string_lossy().to_string()).rev().collect();
+    pub static ref RTE_INCLUDE_DIR: std::vec::Vec<std::string::String> =
+        LIBDPDK.include_paths.iter().map(|p| p.to_string_lossy().to_string()).rev().collect();
+    pub static ref RTE_CORE_LIBS: std::vec::Vec<std::string::String> =
+        LIBDPDK.libs.iter().filter(|lib| !lib.contains("pmd")).cloned().collect();
+    pub static ref RTE_PMD_LIBS: std::vec::Vec<std::string::String> =
+        LIBDPDK.libs.iter().filter(|lib| lib.contains("pmd")).cloned().collect();
     // pub static ref RTE_SDK: PathBuf = env::var("RTE_SDK")
     //     .expect("RTE_SDK - Points to the DPDK installation directory.")
     //     .into();
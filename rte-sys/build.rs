@@ -8,24 +8,41 @@ extern crate bindgen;
 extern crate rte_build;
 
 use std::path::Path;
-use std::slice::Iter;
 
 use rte_build::*;
 
-#[cfg(feature = "gen")]
-fn gen_rte_binding<S: AsRef<str>>(rte_include_dir: impl Iterator<Item = S>, dest_path: &Path) {
-    let rte_header = "src/rte.h";
-    let stub_header = "src/stub.h";
-
-    info!("generating RTE binding file base on \"{}\"", rte_header);
+/// The headers the bindings are generated from.
+const BINDING_HEADERS: &[&str] = &["src/rte.h", "src/stub.h"];
 
-    // let rte_sdk_inc_dir = rte_sdk_dir.join("include");
-    let mut cflags: Vec<String> = vec![String::from("-march=native")];
+/// The clang flags of the bindings, for `RTE_MACHINE` and the CPU features of the build host.
+fn binding_cflags<S: AsRef<str>>(rte_include_dir: impl Iterator<Item = S>) -> Vec<String> {
+    let mut cflags: Vec<String> = vec![
+        format!("-march={}", *RTE_MACHINE),
+        String::from("-DALLOW_EXPERIMENTAL_API"),
+    ];
     for dir in rte_include_dir {
         cflags.push(String::from("-I"));
         cflags.push(dir.as_ref().to_string());
     }
 
+    cflags.extend(gen_cpu_features().map(|(name, value)| {
+        if let Some(value) = value {
+            format!("-D{}={}", name, value)
+        } else {
+            format!("-D{}", name)
+        }
+    }));
+
+    cflags
+}
+
+#[cfg(feature = "gen")]
+fn gen_rte_binding(cflags: Vec<String>, dest_path: &Path) {
+    let rte_header = BINDING_HEADERS[0];
+    let stub_header = BINDING_HEADERS[1];
+
+    info!("generating RTE binding file base on \"{}\"", rte_header);
+
     bindgen::Builder::default()
         .header(rte_header)
         .header(stub_header)
@@ -37,7 +54,7 @@ fn gen_rte_binding<S: AsRef<str>>(rte_include_dir: impl Iterator<Item = S>, dest
         .whitelist_type(r"(rte|cmdline|ether|eth|arp|vlan|vxlan)_.*")
         .whitelist_function(r"(_rte|rte|cmdline|lcore|ether|eth|arp|is)_.*")
         .whitelist_var(
-            r"(RTE|CMDLINE|ETHER|ARP|VXLAN|BONDING|LCORE|MEMPOOL|ARP|PKT|EXT_ATTACHED|IND_ATTACHED|lcore|rte|cmdline|per_lcore)_.*",
+            r"(RTE|CMDLINE|ETHER|ARP|VXLAN|BONDING|LCORE|MEMPOOL|RING|ARP|PKT|EXT_ATTACHED|IND_ATTACHED|lcore|rte|cmdline|per_lcore)_.*",
         )
         .derive_copy(true)
         .derive_debug(true)
@@ -45,18 +62,7 @@ fn gen_rte_binding<S: AsRef<str>>(rte_include_dir: impl Iterator<Item = S>, dest
         .derive_partialeq(true)
         .default_enum_style(bindgen::EnumVariation::ModuleConsts)
         .clang_arg("-fkeep-inline-functions")
-        .clang_args(
-            cflags
-                .into_iter()
-                .map(|s| s.to_owned())
-                .chain(gen_cpu_features().map(|(name, value)| {
-                    if let Some(value) = value {
-                        format!("-D{}={}", name, value)
-                    } else {
-                        format!("-D{}", name)
-                    }
-                })),
-        )
+        .clang_args(cflags)
         .rustfmt_bindings(true)
         .time_phases(true)
         .generate()
@@ -66,7 +72,7 @@ fn gen_rte_binding<S: AsRef<str>>(rte_include_dir: impl Iterator<Item = S>, dest
 }
 
 #[cfg(not(feature = "gen"))]
-fn gen_rte_binding<S: AsRef<str>>(_rte_sdk_dir: impl Iterator<Item = S>, dest_path: &Path) {
+fn gen_rte_binding(_cflags: Vec<String>, dest_path: &Path) {
     use std::fs;
 
     info!("coping RTE binding file");
@@ -74,25 +80,101 @@ fn gen_rte_binding<S: AsRef<str>>(_rte_sdk_dir: impl Iterator<Item = S>, dest_pa
     fs::copy("src/raw.rs", dest_path).expect("copy binding file");
 }
 
+/// The bindgen and libclang releases, which the generated bindings depend on.
+#[cfg(feature = "gen")]
+fn bindgen_version() -> String {
+    format!(
+        "bindgen {}, {}",
+        locked_version("bindgen").unwrap_or_default(),
+        bindgen::clang_version().full
+    )
+}
+
+#[cfg(not(feature = "gen"))]
+fn bindgen_version() -> String {
+    String::new()
+}
+
+/// The sources of the build script, cargo only reruns it when one of them, or a DPDK header, changes.
+const SOURCES: &[&str] = &["build.rs", "src/rte.h", "src/stub.h", "src/stub.c", "src/raw.rs"];
+
 fn main() {
     pretty_env_logger::init();
 
-    // let rte_sdk_dir = RTE_SDK.join(RTE_TARGET.as_str());
+    for source in SOURCES {
+        println!("cargo:rerun-if-changed={}", source);
+    }
+    println!("cargo:rerun-if-env-changed=RTE_MACHINE");
 
-    // info!("using DPDK @ {:?}", rte_sdk_dir);
+    let cache = Cache::open();
+    let mut build = gcc_rte_config(&RTE_INCLUDE_DIR);
+
+    if cfg!(feature = "lto") {
+        // emit ThinLTO bitcode, so the linker plugin could inline the shims into the Rust callers,
+        // the crate must be built with `RUSTFLAGS="-Clinker-plugin-lto -Clinker=clang -Clink-arg=-fuse-ld=lld"`
+        build.compiler("clang").flag("-flto=thin");
+    }
+
+    // the ring peek and zero-copy APIs are still experimental in 20.11
+    build
+        .define("ALLOW_EXPERIMENTAL_API", None)
+        .file("src/stub.c")
+        .include("src");
 
     if cfg!(feature = "gen") {
         // gen_rte_config(&rte_sdk_dir, &OUT_DIR.join("config.rs"));
 
         let binding_file = OUT_DIR.join("raw.rs");
-
-        gen_rte_binding(RTE_INCLUDE_DIR.iter(), &binding_file);
+        let cflags = binding_cflags(RTE_INCLUDE_DIR.iter());
+        // fingerprinted even without cache, for the headers to rerun the build script
+        let key = {
+            let mut fingerprint = Fingerprint::new();
+
+            for flag in &cflags {
+                fingerprint.update(flag);
+            }
+
+            fingerprint
+                .update(bindgen_version())
+                .file("build.rs")
+                .and_then(|fingerprint| fingerprint.sources(&build, BINDING_HEADERS))
+                .map(|fingerprint| fingerprint.key(&RTE_VERSION))
+                .map_err(|err| warn!("fail to fingerprint the bindings, {}", err))
+                .ok()
+        };
+
+        match (cache.as_ref(), key) {
+            (Some(cache), Some(ref key)) if cache.get(key, "raw.rs", &binding_file) => {}
+            (cache, key) => {
+                gen_rte_binding(cflags, &binding_file);
+
+                if let (Some(cache), Some(ref key)) = (cache, key) {
+                    cache.put(key, "raw.rs", &binding_file);
+                }
+            }
+        }
     }
 
-    gcc_rte_config(&RTE_INCLUDE_DIR)
-        .file("src/stub.c")
-        .include("src")
-        .compile("rte_stub");
+    let stub_lib = OUT_DIR.join("librte_stub.a");
+    let key = Fingerprint::new()
+        .sources(&build, &["src/stub.c"])
+        .map(|fingerprint| fingerprint.key(&RTE_VERSION))
+        .map_err(|err| warn!("fail to fingerprint the stub library, {}", err))
+        .ok();
+
+    match (cache.as_ref(), key) {
+        (Some(cache), Some(ref key)) if cache.get(key, "librte_stub.a", &stub_lib) => {
+            println!("cargo:rustc-link-lib=static=rte_stub");
+            println!("cargo:rustc-link-search=native={}", OUT_DIR.display());
+        }
+        (cache, key) => {
+            build.compile("rte_stub");
+
+            if let (Some(cache), Some(ref key)) = (cache, key) {
+                cache.put(key, "librte_stub.a", &stub_lib);
+            }
+        }
+    }
 
     let link_kind = if cfg!(feature = "static") { "static" } else { "dylib" };
 
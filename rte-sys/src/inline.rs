@@ -0,0 +1,101 @@
+//! Rust ports of the hottest `static inline` functions of DPDK.
+//!
+//! The `stub.c` shims are out-of-line C functions, so every packet level operation
+//! pays a call and a return that rustc can't see through. The ports below follow
+//! the DPDK 20.11 inline implementations and read the ethdev fast-path fields directly,
+//! so they inline into the Rust loops. The rare paths, such as the RX/TX callbacks,
+//! still go through the C shims.
+use std::os::raw::c_void;
+use std::ptr;
+use std::sync::atomic::{AtomicPtr, AtomicU16, Ordering};
+
+use raw;
+use raw::{rte_eth_dev, rte_mbuf};
+
+#[inline(always)]
+unsafe fn eth_dev(port_id: u16) -> *mut rte_eth_dev {
+    (ptr::addr_of_mut!(raw::rte_eth_devices) as *mut rte_eth_dev).add(port_id as usize)
+}
+
+#[inline(always)]
+unsafe fn mbuf_refcnt<'a>(m: *const rte_mbuf) -> &'a AtomicU16 {
+    &*(&(*m).refcnt as *const u16 as *const AtomicU16)
+}
+
+/// Read the time-stamp counter.
+#[cfg(target_arch = "x86_64")]
+#[inline(always)]
+pub unsafe fn _rte_rdtsc() -> u64 {
+    ::std::arch::x86_64::_rdtsc()
+}
+
+#[cfg(not(target_arch = "x86_64"))]
+#[inline(always)]
+pub unsafe fn _rte_rdtsc() -> u64 {
+    raw::_rte_rdtsc()
+}
+
+/// Get the number of cycles since boot from the default timer.
+#[inline(always)]
+pub unsafe fn _rte_get_tsc_cycles() -> u64 {
+    _rte_rdtsc()
+}
+
+/// Reads the value of an mbuf's refcnt.
+#[inline(always)]
+pub unsafe fn _rte_mbuf_refcnt_read(m: *const rte_mbuf) -> u16 {
+    mbuf_refcnt(m).load(Ordering::Relaxed)
+}
+
+/// Sets an mbuf's refcnt to a defined value.
+#[inline(always)]
+pub unsafe fn _rte_mbuf_refcnt_set(m: *mut rte_mbuf, new_value: u16) {
+    mbuf_refcnt(m).store(new_value, Ordering::Relaxed)
+}
+
+/// Adds given value to an mbuf's refcnt and returns its new value.
+#[inline(always)]
+pub unsafe fn _rte_mbuf_refcnt_update(m: *mut rte_mbuf, value: i16) -> u16 {
+    let refcnt = mbuf_refcnt(m);
+
+    // an unshared mbuf is only seen by the current thread, so no atomic operation is needed
+    if refcnt.load(Ordering::Relaxed) == 1 {
+        let value = value.wrapping_add(1) as u16;
+
+        refcnt.store(value, Ordering::Relaxed);
+
+        value
+    } else {
+        refcnt
+            .fetch_add(value as u16, Ordering::AcqRel)
+            .wrapping_add(value as u16)
+    }
+}
+
+/// Retrieve a burst of input packets from a receive queue of an Ethernet device.
+#[inline(always)]
+pub unsafe fn _rte_eth_rx_burst(port_id: u16, queue_id: u16, rx_pkts: *mut *mut rte_mbuf, nb_pkts: u16) -> u16 {
+    let dev = eth_dev(port_id);
+    let cb = &*(&(*dev).post_rx_burst_cbs[queue_id as usize] as *const _ as *const AtomicPtr<c_void>);
+
+    match (*dev).rx_pkt_burst {
+        Some(rx_pkt_burst) if cb.load(Ordering::Relaxed).is_null() => {
+            rx_pkt_burst(*(*(*dev).data).rx_queues.add(queue_id as usize), rx_pkts, nb_pkts)
+        }
+        _ => raw::_rte_eth_rx_burst(port_id, queue_id, rx_pkts, nb_pkts),
+    }
+}
+
+/// Send a burst of output packets on a transmit queue of an Ethernet device.
+#[inline(always)]
+pub unsafe fn _rte_eth_tx_burst(port_id: u16, queue_id: u16, tx_pkts: *mut *mut rte_mbuf, nb_pkts: u16) -> u16 {
+    let dev = eth_dev(port_id);
+    let cb = &*(&(*dev).pre_tx_burst_cbs[queue_id as usize] as *const _ as *const AtomicPtr<c_void>);
+
+    match (*dev).tx_pkt_burst {
+        Some(tx_pkt_burst) if cb.load(Ordering::Relaxed).is_null() => {
+            tx_pkt_burst(*(*(*dev).data).tx_queues.add(queue_id as usize), tx_pkts, nb_pkts)
+        }
+        _ => raw::_rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_pkts),
+    }
+}
@@ -3,12 +3,27 @@
 #[macro_use]
 extern crate cfg_if;
 
-cfg_if! {
-    if #[cfg(feature = "gen")] {
-        // include!(concat!(env!("OUT_DIR"), "/config.rs"));
-        include!(concat!(env!("OUT_DIR"), "/raw.rs"));
-    } else {
-        // include!("config.rs");
-        include!("raw.rs");
+/// The generated bindings, including the out-of-line shims of `stub.c`.
+pub mod raw {
+    cfg_if! {
+        if #[cfg(feature = "gen")] {
+            // include!(concat!(env!("OUT_DIR"), "/config.rs"));
+            include!(concat!(env!("OUT_DIR"), "/raw.rs"));
+        } else {
+            // include!("config.rs");
+            include!("raw.rs");
+        }
     }
 }
+
+pub use raw::*;
+
+#[cfg(feature = "inline")]
+mod inline;
+
+// the Rust ports shadow the `stub.c` shims of the same name
+#[cfg(feature = "inline")]
+pub use inline::{
+    _rte_eth_rx_burst, _rte_eth_tx_burst, _rte_get_tsc_cycles, _rte_mbuf_refcnt_read, _rte_mbuf_refcnt_set,
+    _rte_mbuf_refcnt_update, _rte_rdtsc,
+};
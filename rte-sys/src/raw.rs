@@ -631,6 +631,13 @@ pub const RTE_MEMZONE_NAMESIZE: u32 = 32;
 pub const RTE_TAILQ_RING_NAME: &'static [u8; 9usize] = b"RTE_RING\0";
 pub const RTE_RING_MZ_PREFIX: &'static [u8; 4usize] = b"RG_\0";
 pub const RTE_RING_SZ_MASK: u32 = 2147483647;
+pub const RING_F_SP_ENQ: u32 = 1;
+pub const RING_F_SC_DEQ: u32 = 2;
+pub const RING_F_EXACT_SZ: u32 = 4;
+pub const RING_F_MP_RTS_ENQ: u32 = 8;
+pub const RING_F_MC_RTS_DEQ: u32 = 16;
+pub const RING_F_MP_HTS_ENQ: u32 = 32;
+pub const RING_F_MC_HTS_DEQ: u32 = 64;
 pub const RTE_MEMPOOL_HEADER_COOKIE1: i64 = -4982197544707871147;
 pub const RTE_MEMPOOL_HEADER_COOKIE2: i64 = -941548164385788331;
 pub const RTE_MEMPOOL_TRAILER_COOKIE: i64 = -5921418378119291987;
@@ -1010,6 +1017,42 @@ pub const BONDING_MODE_BROADCAST: u32 = 3;
 pub const BONDING_MODE_8023AD: u32 = 4;
 pub const BONDING_MODE_TLB: u32 = 5;
 pub const BONDING_MODE_ALB: u32 = 6;
+pub const BALANCE_XMIT_POLICY_LAYER2: u32 = 0;
+pub const BALANCE_XMIT_POLICY_LAYER23: u32 = 1;
+pub const BALANCE_XMIT_POLICY_LAYER34: u32 = 2;
+pub const RTE_GRO_MAX_BURST_ITEM_NUM: u32 = 128;
+pub const RTE_GRO_TYPE_MAX_NUM: u32 = 64;
+pub const RTE_GRO_TYPE_SUPPORT_NUM: u32 = 4;
+pub const RTE_GRO_TCP_IPV4_INDEX: u32 = 0;
+pub const RTE_GRO_TCP_IPV4: u32 = 1;
+pub const RTE_GRO_IPV4_VXLAN_TCP_IPV4_INDEX: u32 = 1;
+pub const RTE_GRO_IPV4_VXLAN_TCP_IPV4: u32 = 2;
+pub const RTE_GRO_UDP_IPV4_INDEX: u32 = 2;
+pub const RTE_GRO_UDP_IPV4: u32 = 4;
+pub const RTE_GRO_IPV4_VXLAN_UDP_IPV4_INDEX: u32 = 3;
+pub const RTE_GRO_IPV4_VXLAN_UDP_IPV4: u32 = 8;
+pub const RTE_GSO_SEG_SIZE_MIN: u32 = 256;
+pub const RTE_GSO_FLAG_IPID_FIXED: u32 = 1;
+pub const RTE_HASH_ENTRIES_MAX: u32 = 1073741824;
+pub const RTE_HASH_NAMESIZE: u32 = 32;
+pub const RTE_HASH_LOOKUP_BULK_MAX: u32 = 64;
+pub const RTE_HASH_LOOKUP_MULTI_MAX: u32 = 64;
+pub const RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT: u32 = 1;
+pub const RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD: u32 = 2;
+pub const RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY: u32 = 4;
+pub const RTE_HASH_EXTRA_FLAGS_EXT_TABLE: u32 = 8;
+pub const RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL: u32 = 16;
+pub const RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF: u32 = 32;
+pub const RTE_LPM_NAMESIZE: u32 = 32;
+pub const RTE_LPM_MAX_DEPTH: u32 = 32;
+pub const RTE_LPM_TBL24_NUM_ENTRIES: u32 = 16777216;
+pub const RTE_LPM_TBL8_GROUP_NUM_ENTRIES: u32 = 256;
+pub const RTE_LPM_MAX_TBL8_NUM_GROUPS: u32 = 16777216;
+pub const RTE_LPM_TBL8_NUM_GROUPS: u32 = 256;
+pub const RTE_LPM_LOOKUP_SUCCESS: u32 = 16777216;
+pub const RTE_LPM6_MAX_DEPTH: u32 = 128;
+pub const RTE_LPM6_IPV6_ADDR_SIZE: u32 = 16;
+pub const RTE_LPM6_NAMESIZE: u32 = 32;
 pub const RTE_VXLAN_DEFAULT_PORT: u32 = 4789;
 pub const RTE_VXLAN_GPE_DEFAULT_PORT: u32 = 4790;
 pub const RTE_VXLAN_GPE_TYPE_IPV4: u32 = 1;
@@ -7707,6 +7750,10 @@ pub mod rte_ring_sync_type {
     pub const RTE_RING_SYNC_MT: Type = 0;
     #[doc = "< single thread only"]
     pub const RTE_RING_SYNC_ST: Type = 1;
+    #[doc = "< multi-thread relaxed tail sync"]
+    pub const RTE_RING_SYNC_MT_RTS: Type = 2;
+    #[doc = "< multi-thread head/tail sync"]
+    pub const RTE_RING_SYNC_MT_HTS: Type = 3;
 }
 #[doc = " structures to hold a pair of head/tail values and other metadata."]
 #[doc = " Depending on sync_type format of that structure might be different,"]
@@ -8305,6 +8352,66 @@ impl Default for rte_ring {
         unsafe { ::std::mem::zeroed() }
     }
 }
+#[doc = " Ring zero-copy information structure."]
+#[doc = ""]
+#[doc = " This structure contains the pointers and length of the space"]
+#[doc = " reserved on the ring storage."]
+#[repr(C)]
+#[repr(align(64))]
+#[derive(Debug, Copy, Clone, PartialEq)]
+pub struct rte_ring_zc_data {
+    pub ptr1: *mut ::std::os::raw::c_void,
+    pub ptr2: *mut ::std::os::raw::c_void,
+    pub n1: ::std::os::raw::c_uint,
+}
+#[test]
+fn bindgen_test_layout_rte_ring_zc_data() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_ring_zc_data>(),
+        64usize,
+        concat!("Size of: ", stringify!(rte_ring_zc_data))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_ring_zc_data>(),
+        64usize,
+        concat!("Alignment of ", stringify!(rte_ring_zc_data))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_ring_zc_data>())).ptr1 as *const _ as usize },
+        0usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_ring_zc_data),
+            "::",
+            stringify!(ptr1)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_ring_zc_data>())).ptr2 as *const _ as usize },
+        8usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_ring_zc_data),
+            "::",
+            stringify!(ptr2)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_ring_zc_data>())).n1 as *const _ as usize },
+        16usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_ring_zc_data),
+            "::",
+            stringify!(n1)
+        )
+    );
+}
+impl Default for rte_ring_zc_data {
+    fn default() -> Self {
+        unsafe { ::std::mem::zeroed() }
+    }
+}
 extern "C" {
     #[doc = " Calculate the memory size needed for a ring with given element size"]
     #[doc = ""]
@@ -35203,6 +35310,1075 @@ extern "C" {
     #[doc = "  Delay period on success, negative value otherwise."]
     pub fn rte_eth_bond_link_up_prop_delay_get(bonded_port_id: u16) -> ::std::os::raw::c_int;
 }
+pub mod rte_bond_8023ad_agg_selection {
+    #[doc = " Aggregator selection policy of a mode 4 bonded device."]
+    pub type Type = ::std::os::raw::c_uint;
+    pub const AGG_BANDWIDTH: Type = 0;
+    pub const AGG_COUNT: Type = 1;
+    pub const AGG_STABLE: Type = 2;
+}
+#[doc = " Callback of the LACP frames received by a slave, when they are not handled by the bonded device."]
+pub type rte_eth_bond_8023ad_ext_slowrx_fn =
+    ::std::option::Option<unsafe extern "C" fn(slave_id: u16, lacp_pkt: *mut rte_mbuf)>;
+#[doc = " Mode 4 configuration structure"]
+#[repr(C)]
+#[derive(Debug, Default, Copy, Clone, PartialEq)]
+pub struct rte_eth_bond_8023ad_conf {
+    pub fast_periodic_ms: u32,
+    pub slow_periodic_ms: u32,
+    pub short_timeout_ms: u32,
+    pub long_timeout_ms: u32,
+    pub aggregate_wait_timeout_ms: u32,
+    pub tx_period_ms: u32,
+    pub rx_marker_period_ms: u32,
+    pub update_timeout_ms: u32,
+    pub slowrx_cb: rte_eth_bond_8023ad_ext_slowrx_fn,
+    pub agg_selection: rte_bond_8023ad_agg_selection::Type,
+}
+#[test]
+fn bindgen_test_layout_rte_eth_bond_8023ad_conf() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_eth_bond_8023ad_conf>(),
+        48usize,
+        concat!("Size of: ", stringify!(rte_eth_bond_8023ad_conf))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_eth_bond_8023ad_conf>(),
+        8usize,
+        concat!("Alignment of ", stringify!(rte_eth_bond_8023ad_conf))
+    );
+}
+extern "C" {
+    #[doc = " Configure mode 4 parameters of the bonded device."]
+    #[doc = ""]
+    #[doc = " @param port_id Bonding device id"]
+    #[doc = " @param conf parameters to set, NULL to use the defaults"]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise."]
+    pub fn rte_eth_bond_8023ad_setup(port_id: u16, conf: *mut rte_eth_bond_8023ad_conf) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Get the mode 4 parameters of the bonded device."]
+    #[doc = ""]
+    #[doc = " @param port_id Bonding device id"]
+    #[doc = " @param conf pointer to the configuration to fill"]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise."]
+    pub fn rte_eth_bond_8023ad_conf_get(port_id: u16, conf: *mut rte_eth_bond_8023ad_conf) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Enable dedicated hw queues for the LACP control traffic on the slaves."]
+    #[doc = ""]
+    #[doc = " The bonded device must be stopped, and the slaves must support a flow rule"]
+    #[doc = " steering the slow protocol frames to an extra RX queue."]
+    #[doc = ""]
+    #[doc = " @param port_id Bonding device id"]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise."]
+    pub fn rte_eth_bond_8023ad_dedicated_queues_enable(port_id: u16) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Disable the dedicated hw queues for the LACP control traffic."]
+    #[doc = ""]
+    #[doc = " @param port_id Bonding device id"]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise."]
+    pub fn rte_eth_bond_8023ad_dedicated_queues_disable(port_id: u16) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Set the aggregator selection policy of the bonded device."]
+    pub fn rte_eth_bond_8023ad_agg_selection_set(
+        port_id: u16,
+        agg_selection: rte_bond_8023ad_agg_selection::Type,
+    ) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Get the aggregator selection policy of the bonded device."]
+    pub fn rte_eth_bond_8023ad_agg_selection_get(port_id: u16) -> ::std::os::raw::c_int;
+}
+#[doc = " Structure used to create GRO context objects or used to pass"]
+#[doc = " application-determined parameters to rte_gro_reassemble_burst()."]
+#[repr(C)]
+#[derive(Debug, Default, Copy, Clone, PartialEq)]
+pub struct rte_gro_param {
+    #[doc = "< desired GRO types"]
+    pub gro_types: u64,
+    #[doc = "< max flow number"]
+    pub max_flow_num: u16,
+    #[doc = "< max packet number per flow"]
+    pub max_item_per_flow: u16,
+    #[doc = "< socket index for allocating GRO related data structures,"]
+    #[doc = " like reassembly tables. When use rte_gro_reassemble_burst(),"]
+    #[doc = " applications don't need to set this value."]
+    pub socket_id: u16,
+}
+#[test]
+fn bindgen_test_layout_rte_gro_param() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_gro_param>(),
+        16usize,
+        concat!("Size of: ", stringify!(rte_gro_param))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_gro_param>(),
+        8usize,
+        concat!("Alignment of ", stringify!(rte_gro_param))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gro_param>())).gro_types as *const _ as usize },
+        0usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gro_param),
+            "::",
+            stringify!(gro_types)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gro_param>())).max_flow_num as *const _ as usize },
+        8usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gro_param),
+            "::",
+            stringify!(max_flow_num)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gro_param>())).max_item_per_flow as *const _ as usize },
+        10usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gro_param),
+            "::",
+            stringify!(max_item_per_flow)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gro_param>())).socket_id as *const _ as usize },
+        12usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gro_param),
+            "::",
+            stringify!(socket_id)
+        )
+    );
+}
+extern "C" {
+    #[doc = " This function create a GRO context object, which is used to merge"]
+    #[doc = " packets in rte_gro_reassemble()."]
+    #[doc = ""]
+    #[doc = " @param param"]
+    #[doc = "   applications use it to pass needed parameters to create a GRO"]
+    #[doc = "   context object."]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   if create successfully, return a pointer which points to the GRO"]
+    #[doc = "   context object. Otherwise, return NULL."]
+    pub fn rte_gro_ctx_create(param: *const rte_gro_param) -> *mut ::std::os::raw::c_void;
+}
+extern "C" {
+    #[doc = " This function destroys a GRO context object."]
+    #[doc = ""]
+    #[doc = " @param ctx"]
+    #[doc = "   pointer points to a GRO context object."]
+    pub fn rte_gro_ctx_destroy(ctx: *mut ::std::os::raw::c_void);
+}
+extern "C" {
+    #[doc = " This is one of the main reassembly APIs, which merges numbers of"]
+    #[doc = " packets at a time. It doesn't check if input packets have correct"]
+    #[doc = " checksums and doesn't re-calculate checksums for merged packets."]
+    #[doc = " It assumes the packets are complete (i.e., MF==0 && frag_off==0),"]
+    #[doc = " when IP fragmentation is possible (i.e., DF==0). The GROed packets"]
+    #[doc = " are returned as soon as the function finishes."]
+    #[doc = ""]
+    #[doc = " @param pkts"]
+    #[doc = "   Pointer array pointing to the packets to reassemble. Besides, it"]
+    #[doc = "   keeps MBUF addresses for the GROed packets."]
+    #[doc = " @param nb_pkts"]
+    #[doc = "   The number of packets to reassemble"]
+    #[doc = " @param param"]
+    #[doc = "   Application-determined parameters for reassembling packets."]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   The number of packets after been GROed. If no packets are merged,"]
+    #[doc = "   the return value is equals to nb_pkts."]
+    pub fn rte_gro_reassemble_burst(pkts: *mut *mut rte_mbuf, nb_pkts: u16, param: *const rte_gro_param) -> u16;
+}
+extern "C" {
+    #[doc = " Reassembly function, which tries to merge input packets with the"]
+    #[doc = " existed packets in the reassembly tables of a given GRO context."]
+    #[doc = " It doesn't check if input packets have correct checksums and doesn't"]
+    #[doc = " re-calculate checksums for merged packets. Additionally, it assumes"]
+    #[doc = " the packets are complete (i.e., MF==0 && frag_off==0), when IP"]
+    #[doc = " fragmentation is possible (i.e., DF==0)."]
+    #[doc = ""]
+    #[doc = " If the input packets have invalid parameters (e.g. no data payload,"]
+    #[doc = " unsupported GRO types), they are returned to applications. Otherwise,"]
+    #[doc = " they are either merged or inserted into the table. Applications need"]
+    #[doc = " to flush packets from the tables by flush API, if they want to get the"]
+    #[doc = " GROed packets."]
+    #[doc = ""]
+    #[doc = " @param pkts"]
+    #[doc = "   Packets to reassemble. It's also used to store the unprocessed packets."]
+    #[doc = " @param nb_pkts"]
+    #[doc = "   The number of packets to reassemble"]
+    #[doc = " @param ctx"]
+    #[doc = "   GRO context object pointer"]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   The number of unprocessed packets."]
+    pub fn rte_gro_reassemble(pkts: *mut *mut rte_mbuf, nb_pkts: u16, ctx: *mut ::std::os::raw::c_void) -> u16;
+}
+extern "C" {
+    #[doc = " This function flushes the timeout packets from the reassembly tables"]
+    #[doc = " of desired GRO types. The max number of flushed packets is the"]
+    #[doc = " element number of 'out'."]
+    #[doc = ""]
+    #[doc = " Additionally, the flushed packets may have incorrect checksums, since"]
+    #[doc = " this function doesn't re-calculate checksums for merged packets."]
+    #[doc = ""]
+    #[doc = " @param ctx"]
+    #[doc = "   GRO context object pointer."]
+    #[doc = " @param timeout_cycles"]
+    #[doc = "   The max TTL for packets in reassembly tables, measured in nanosecond."]
+    #[doc = " @param gro_types"]
+    #[doc = "   This function flushes packets whose GRO types are specified by"]
+    #[doc = "   gro_types."]
+    #[doc = " @param out"]
+    #[doc = "   Pointer array used to keep flushed packets."]
+    #[doc = " @param max_nb_out"]
+    #[doc = "   The element number of 'out'. It's also the max number of allowed"]
+    #[doc = "   flushed packets."]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   The number of flushed packets."]
+    pub fn rte_gro_timeout_flush(
+        ctx: *mut ::std::os::raw::c_void,
+        timeout_cycles: u64,
+        gro_types: u64,
+        out: *mut *mut rte_mbuf,
+        max_nb_out: u16,
+    ) -> u16;
+}
+extern "C" {
+    #[doc = " This function returns the number of packets in all reassembly tables"]
+    #[doc = " of a given GRO context."]
+    #[doc = ""]
+    #[doc = " @param ctx"]
+    #[doc = "   GRO context object pointer."]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   The number of packets in the tables."]
+    pub fn rte_gro_get_pkt_count(ctx: *mut ::std::os::raw::c_void) -> u64;
+}
+#[doc = " GSO context structure."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, PartialEq)]
+pub struct rte_gso_ctx {
+    #[doc = "< MBUF pool for allocating direct buffers for output segments"]
+    pub direct_pool: *mut rte_mempool,
+    #[doc = "< MBUF pool for allocating indirect buffers for output segments"]
+    pub indirect_pool: *mut rte_mempool,
+    #[doc = "< flag that indicates the final status of the GSO segments"]
+    pub flag: u64,
+    #[doc = "< the bit mask of required GSO types. The GSO library"]
+    #[doc = " uses the same macros as that of describing device TX"]
+    #[doc = " offloading capabilities (i.e. DEV_TX_OFFLOAD_*_TSO) for"]
+    #[doc = " gso_types."]
+    pub gso_types: u32,
+    #[doc = "< maximum size of an output GSO segment, including packet"]
+    #[doc = " header and payload, measured in bytes. Must exceed"]
+    #[doc = " RTE_GSO_SEG_SIZE_MIN."]
+    pub gso_size: u16,
+}
+#[test]
+fn bindgen_test_layout_rte_gso_ctx() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_gso_ctx>(),
+        32usize,
+        concat!("Size of: ", stringify!(rte_gso_ctx))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_gso_ctx>(),
+        8usize,
+        concat!("Alignment of ", stringify!(rte_gso_ctx))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gso_ctx>())).direct_pool as *const _ as usize },
+        0usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gso_ctx),
+            "::",
+            stringify!(direct_pool)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gso_ctx>())).indirect_pool as *const _ as usize },
+        8usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gso_ctx),
+            "::",
+            stringify!(indirect_pool)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gso_ctx>())).flag as *const _ as usize },
+        16usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gso_ctx),
+            "::",
+            stringify!(flag)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gso_ctx>())).gso_types as *const _ as usize },
+        24usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gso_ctx),
+            "::",
+            stringify!(gso_types)
+        )
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_gso_ctx>())).gso_size as *const _ as usize },
+        28usize,
+        concat!(
+            "Offset of field: ",
+            stringify!(rte_gso_ctx),
+            "::",
+            stringify!(gso_size)
+        )
+    );
+}
+impl Default for rte_gso_ctx {
+    fn default() -> Self {
+        unsafe { ::std::mem::zeroed() }
+    }
+}
+extern "C" {
+    #[doc = " Segmentation function, which supports processing of both single- and"]
+    #[doc = " multi- MBUF packets."]
+    #[doc = ""]
+    #[doc = " Note that we refer to the packets that are segmented from the input"]
+    #[doc = " packet as 'GSO segments'. rte_gso_segment() doesn't check if the"]
+    #[doc = " input packet has correct checksums, and doesn't update checksums for"]
+    #[doc = " output GSO segments. Additionally, it doesn't process IP fragment"]
+    #[doc = " packets."]
+    #[doc = ""]
+    #[doc = " Before calling rte_gso_segment(), applications must set proper ol_flags"]
+    #[doc = " for the packet. The GSO library uses the same macros as that of TSO."]
+    #[doc = " For example, set PKT_TX_TCP_SEG and PKT_TX_IPV4 in ol_flags to segment"]
+    #[doc = " a TCP/IPv4 packet. If rte_gso_segment() succeeds, the PKT_TX_TCP_SEG"]
+    #[doc = " flag is removed for all GSO segments and the input packet."]
+    #[doc = ""]
+    #[doc = " Each of the newly-created GSO segments is organized as a two-segment"]
+    #[doc = " MBUF, where the first segment is a standard MBUF, which stores a copy"]
+    #[doc = " of packet header, and the second is an indirect MBUF which points to"]
+    #[doc = " a section of data in the input packet. Since each GSO segment has"]
+    #[doc = " multiple MBUFs (i.e. typically 2 MBUFs), the driver of the interface which"]
+    #[doc = " the GSO segments are sent to should support transmission of multi-segment"]
+    #[doc = " packets."]
+    #[doc = ""]
+    #[doc = " If the input packet is GSO'd, all the indirect segments are attached to the"]
+    #[doc = " input packet."]
+    #[doc = ""]
+    #[doc = " rte_gso_segment() will not free the input packet no matter whether it is"]
+    #[doc = " GSO'd or not, the application should free it after calling rte_gso_segment()."]
+    #[doc = ""]
+    #[doc = " If the memory space in pkts_out or MBUF pools is insufficient, this"]
+    #[doc = " function fails, and it returns (-1) * errno. Otherwise, GSO succeeds,"]
+    #[doc = " and this function returns the number of output GSO segments filled in"]
+    #[doc = " pkts_out."]
+    #[doc = ""]
+    #[doc = " @param pkt"]
+    #[doc = "   The packet mbuf to segment."]
+    #[doc = " @param ctx"]
+    #[doc = "   GSO context object pointer."]
+    #[doc = " @param pkts_out"]
+    #[doc = "   Pointer array used to store the MBUF addresses of output GSO"]
+    #[doc = "   segments, when rte_gso_segment() succeeds."]
+    #[doc = " @param nb_pkts_out"]
+    #[doc = "   The max number of items that pkts_out can keep."]
+    #[doc = ""]
+    #[doc = " @return"]
+    #[doc = "   - The number of GSO segments filled in pkts_out on success."]
+    #[doc = "   - Return 0 if it does not need to be GSO'd."]
+    #[doc = "   - Return -ENOMEM if run out of memory in MBUF pools."]
+    #[doc = "   - Return -EINVAL for invalid parameters."]
+    pub fn rte_gso_segment(
+        pkt: *mut rte_mbuf,
+        ctx: *const rte_gso_ctx,
+        pkts_out: *mut *mut rte_mbuf,
+        nb_pkts_out: u16,
+    ) -> ::std::os::raw::c_int;
+}
+#[doc = " Signature of key that is stored internally."]
+pub type hash_sig_t = u32;
+#[doc = " Type of function that can be used for calculating the hash value."]
+pub type rte_hash_function =
+    ::std::option::Option<unsafe extern "C" fn(key: *const ::std::os::raw::c_void, key_len: u32, init_val: u32) -> u32>;
+#[doc = " Type of function used to compare the hash key."]
+pub type rte_hash_cmp_eq_t =
+    ::std::option::Option<unsafe extern "C" fn(key1: *const ::std::os::raw::c_void, key2: *const ::std::os::raw::c_void, key_len: usize) -> ::std::os::raw::c_int>;
+#[doc = " Parameters used when creating the hash table."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone, PartialEq)]
+pub struct rte_hash_parameters {
+    #[doc = "< Name of the hash."]
+    pub name: *const ::std::os::raw::c_char,
+    #[doc = "< Total hash table entries."]
+    pub entries: u32,
+    #[doc = "< Unused field. Should be set to 0"]
+    pub reserved: u32,
+    #[doc = "< Length of hash key."]
+    pub key_len: u32,
+    #[doc = "< Primary Hash function used to calculate hash."]
+    pub hash_func: rte_hash_function,
+    #[doc = "< Init value used by hash_func."]
+    pub hash_func_init_val: u32,
+    #[doc = "< NUMA Socket ID for memory."]
+    pub socket_id: ::std::os::raw::c_int,
+    #[doc = "< Indicate if additional parameters are present."]
+    pub extra_flag: u8,
+}
+#[test]
+fn bindgen_test_layout_rte_hash_parameters() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_hash_parameters>(),
+        48usize,
+        concat!("Size of: ", stringify!(rte_hash_parameters))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_hash_parameters>(),
+        8usize,
+        concat!("Alignment of ", stringify!(rte_hash_parameters))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).name as *const _ as usize },
+        0usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(name))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).entries as *const _ as usize },
+        8usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(entries))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).reserved as *const _ as usize },
+        12usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(reserved))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).key_len as *const _ as usize },
+        16usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(key_len))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).hash_func as *const _ as usize },
+        24usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(hash_func))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).hash_func_init_val as *const _ as usize },
+        32usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(hash_func_init_val))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).socket_id as *const _ as usize },
+        36usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(socket_id))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_hash_parameters>())).extra_flag as *const _ as usize },
+        40usize,
+        concat!("Offset of field: ", stringify!(rte_hash_parameters), "::", stringify!(extra_flag))
+    );
+}
+impl Default for rte_hash_parameters {
+    fn default() -> Self {
+        unsafe { ::std::mem::zeroed() }
+    }
+}
+#[doc = " @internal A hash table structure."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct rte_hash {
+    _unused: [u8; 0],
+}
+extern "C" {
+    #[doc = " Create a new hash table."]
+    #[doc = ""]
+    #[doc = " @param params"]
+    #[doc = "   Parameters used to create and initialise the hash table."]
+    #[doc = " @return"]
+    #[doc = "   Pointer to hash table structure that is used in future hash table"]
+    #[doc = "   operations, or NULL on error, with error code set in rte_errno."]
+    pub fn rte_hash_create(params: *const rte_hash_parameters) -> *mut rte_hash;
+}
+extern "C" {
+    #[doc = " Find an existing hash table object and return a pointer to it."]
+    #[doc = ""]
+    #[doc = " @param name"]
+    #[doc = "   Name of the hash table as passed to rte_hash_create()"]
+    #[doc = " @return"]
+    #[doc = "   Pointer to hash table or NULL if object not found"]
+    #[doc = "   with rte_errno set appropriately."]
+    pub fn rte_hash_find_existing(name: *const ::std::os::raw::c_char) -> *mut rte_hash;
+}
+extern "C" {
+    #[doc = " De-allocate all memory used by hash table."]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to free"]
+    pub fn rte_hash_free(h: *mut rte_hash);
+}
+extern "C" {
+    #[doc = " Reset all hash structure, by zeroing all entries."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to reset"]
+    pub fn rte_hash_reset(h: *mut rte_hash);
+}
+extern "C" {
+    #[doc = " Return the number of keys in the hash table"]
+    #[doc = " @param h"]
+    #[doc = "  Hash table to query from"]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if parameters are invalid"]
+    #[doc = "   - A value indicating how many keys were inserted in the table."]
+    pub fn rte_hash_count(h: *const rte_hash) -> i32;
+}
+extern "C" {
+    #[doc = " Add a key-value pair to an existing hash table."]
+    #[doc = " This operation is not multi-thread safe"]
+    #[doc = " and should only be called from one thread by default."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to add the key to."]
+    #[doc = " @param key"]
+    #[doc = "   Key to add to the hash table."]
+    #[doc = " @param data"]
+    #[doc = "   Data to add to the hash table."]
+    #[doc = " @return"]
+    #[doc = "   - 0 if added successfully"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOSPC if there is no space in the hash for this key."]
+    pub fn rte_hash_add_key_data(h: *const rte_hash, key: *const ::std::os::raw::c_void, data: *mut ::std::os::raw::c_void) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Add a key to an existing hash table. This operation is not multi-thread safe"]
+    #[doc = " and should only be called from one thread by default."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to add the key to."]
+    #[doc = " @param key"]
+    #[doc = "   Key to add to the hash table."]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOSPC if there is no space in the hash for this key."]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key."]
+    pub fn rte_hash_add_key(h: *const rte_hash, key: *const ::std::os::raw::c_void) -> i32;
+}
+extern "C" {
+    #[doc = " Add a key to an existing hash table."]
+    #[doc = " This operation is not multi-thread safe"]
+    #[doc = " and should only be called from one thread by default."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to add the key to."]
+    #[doc = " @param key"]
+    #[doc = "   Key to add to the hash table."]
+    #[doc = " @param sig"]
+    #[doc = "   Precomputed hash value for 'key'."]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOSPC if there is no space in the hash for this key."]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key."]
+    pub fn rte_hash_add_key_with_hash(h: *const rte_hash, key: *const ::std::os::raw::c_void, sig: hash_sig_t) -> i32;
+}
+extern "C" {
+    #[doc = " Remove a key from an existing hash table."]
+    #[doc = " This operation is not multi-thread safe"]
+    #[doc = " and should only be called from one thread by default."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to remove the key from."]
+    #[doc = " @param key"]
+    #[doc = "   Key to remove from the hash table."]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOENT if the key is not found."]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key, and is the same"]
+    #[doc = "     value that was returned when the key was added."]
+    pub fn rte_hash_del_key(h: *const rte_hash, key: *const ::std::os::raw::c_void) -> i32;
+}
+extern "C" {
+    #[doc = " Find a key-value pair in the hash table."]
+    #[doc = " This operation is multi-thread safe with regarding to other lookup threads."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param key"]
+    #[doc = "   Key to find."]
+    #[doc = " @param data"]
+    #[doc = "   Output with pointer to data returned from the hash table."]
+    #[doc = " @return"]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key, and is the same"]
+    #[doc = "     value that was returned when the key was added."]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOENT if the key is not found."]
+    pub fn rte_hash_lookup_data(h: *const rte_hash, key: *const ::std::os::raw::c_void, data: *mut *mut ::std::os::raw::c_void) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Find a key in the hash table."]
+    #[doc = " This operation is multi-thread safe with regarding to other lookup threads."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param key"]
+    #[doc = "   Key to find."]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOENT if the key is not found."]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key, and is the same"]
+    #[doc = "     value that was returned when the key was added."]
+    pub fn rte_hash_lookup(h: *const rte_hash, key: *const ::std::os::raw::c_void) -> i32;
+}
+extern "C" {
+    #[doc = " Find a key in the hash table."]
+    #[doc = " This operation is multi-thread safe with regarding to other lookup threads."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param key"]
+    #[doc = "   Key to find."]
+    #[doc = " @param sig"]
+    #[doc = "   Precomputed hash value for 'key'."]
+    #[doc = " @return"]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOENT if the key is not found."]
+    #[doc = "   - A positive value that can be used by the caller as an offset into an"]
+    #[doc = "     array of user data. This value is unique for this key, and is the same"]
+    #[doc = "     value that was returned when the key was added."]
+    pub fn rte_hash_lookup_with_hash(h: *const rte_hash, key: *const ::std::os::raw::c_void, sig: hash_sig_t) -> i32;
+}
+extern "C" {
+    #[doc = " Calc a hash value by key."]
+    #[doc = " This operation is not multi-process safe."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param key"]
+    #[doc = "   Key to find."]
+    #[doc = " @return"]
+    #[doc = "   - hash value"]
+    pub fn rte_hash_hash(h: *const rte_hash, key: *const ::std::os::raw::c_void) -> hash_sig_t;
+}
+extern "C" {
+    #[doc = " Find multiple keys in the hash table."]
+    #[doc = " This operation is multi-thread safe with regarding to other lookup threads."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param keys"]
+    #[doc = "   A pointer to a list of keys to look for."]
+    #[doc = " @param num_keys"]
+    #[doc = "   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX)."]
+    #[doc = " @param hit_mask"]
+    #[doc = "   Output containing a bitmask with all successful lookups."]
+    #[doc = " @param data"]
+    #[doc = "   Output containing array of data returned from all the successful lookups."]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL if there's an error, otherwise number of successful lookups."]
+    pub fn rte_hash_lookup_bulk_data(
+        h: *const rte_hash,
+        keys: *mut *const ::std::os::raw::c_void,
+        num_keys: u32,
+        hit_mask: *mut u64,
+        data: *mut *mut ::std::os::raw::c_void,
+    ) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Find multiple keys in the hash table."]
+    #[doc = " This operation is multi-thread safe with regarding to other lookup threads."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to look in."]
+    #[doc = " @param keys"]
+    #[doc = "   A pointer to a list of keys to look for."]
+    #[doc = " @param num_keys"]
+    #[doc = "   How many keys are in the keys list (less than RTE_HASH_LOOKUP_BULK_MAX)."]
+    #[doc = " @param positions"]
+    #[doc = "   Output containing a list of values, corresponding to the list of keys that"]
+    #[doc = "   can be used by the caller as an offset into an array of user data. These"]
+    #[doc = "   values are unique for each key, and are the same values that were returned"]
+    #[doc = "   when each key was added. If a key in the list was not found, then -ENOENT"]
+    #[doc = "   will be the value."]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL if there's an error, otherwise 0."]
+    pub fn rte_hash_lookup_bulk(
+        h: *const rte_hash,
+        keys: *mut *const ::std::os::raw::c_void,
+        num_keys: u32,
+        positions: *mut i32,
+    ) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Iterate through the hash table, returning key-value pairs."]
+    #[doc = ""]
+    #[doc = " @param h"]
+    #[doc = "   Hash table to iterate"]
+    #[doc = " @param key"]
+    #[doc = "   Output containing the key where current iterator"]
+    #[doc = "   was pointing at"]
+    #[doc = " @param data"]
+    #[doc = "   Output containing the data associated with key."]
+    #[doc = "   Returns NULL if data was not stored."]
+    #[doc = " @param next"]
+    #[doc = "   Pointer to iterator. Should be 0 to start iterating the hash table."]
+    #[doc = "   Iterator is incremented after each call of this function."]
+    #[doc = " @return"]
+    #[doc = "   Position where key was stored, if successful."]
+    #[doc = "   - -EINVAL if the parameters are invalid."]
+    #[doc = "   - -ENOENT if end of the hash table."]
+    pub fn rte_hash_iterate(
+        h: *const rte_hash,
+        key: *mut *const ::std::os::raw::c_void,
+        data: *mut *mut ::std::os::raw::c_void,
+        next: *mut u32,
+    ) -> i32;
+}
+#[doc = " LPM configuration structure."]
+#[repr(C)]
+#[derive(Debug, Default, Copy, Clone, PartialEq)]
+pub struct rte_lpm_config {
+    #[doc = "< Max number of rules."]
+    pub max_rules: u32,
+    #[doc = "< Number of tbl8s to allocate."]
+    pub number_tbl8s: u32,
+    #[doc = "< This field is currently unused."]
+    pub flags: ::std::os::raw::c_int,
+}
+#[test]
+fn bindgen_test_layout_rte_lpm_config() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_lpm_config>(),
+        12usize,
+        concat!("Size of: ", stringify!(rte_lpm_config))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_lpm_config>(),
+        4usize,
+        concat!("Alignment of ", stringify!(rte_lpm_config))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm_config>())).max_rules as *const _ as usize },
+        0usize,
+        concat!("Offset of field: ", stringify!(rte_lpm_config), "::", stringify!(max_rules))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm_config>())).number_tbl8s as *const _ as usize },
+        4usize,
+        concat!("Offset of field: ", stringify!(rte_lpm_config), "::", stringify!(number_tbl8s))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm_config>())).flags as *const _ as usize },
+        8usize,
+        concat!("Offset of field: ", stringify!(rte_lpm_config), "::", stringify!(flags))
+    );
+}
+#[doc = " @internal LPM structure."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct rte_lpm {
+    _unused: [u8; 0],
+}
+extern "C" {
+    #[doc = " Create an LPM object."]
+    #[doc = ""]
+    #[doc = " @param name"]
+    #[doc = "   LPM object name"]
+    #[doc = " @param socket_id"]
+    #[doc = "   NUMA socket ID for LPM table memory allocation"]
+    #[doc = " @param config"]
+    #[doc = "   Structure containing the configuration"]
+    #[doc = " @return"]
+    #[doc = "   Handle to LPM object on success, NULL otherwise with rte_errno set"]
+    #[doc = "   to an appropriate values. Possible rte_errno values include:"]
+    #[doc = "    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure"]
+    #[doc = "    - E_RTE_SECONDARY - function was called from a secondary process instance"]
+    #[doc = "    - EINVAL - invalid parameter passed to function"]
+    #[doc = "    - ENOSPC - the maximum number of memzones has already been allocated"]
+    #[doc = "    - EEXIST - a memzone with the same name already exists"]
+    #[doc = "    - ENOMEM - no appropriate memory area found in which to create memzone"]
+    pub fn rte_lpm_create(name: *const ::std::os::raw::c_char, socket_id: ::std::os::raw::c_int, config: *const rte_lpm_config) -> *mut rte_lpm;
+}
+extern "C" {
+    #[doc = " Find an existing LPM object and return a pointer to it."]
+    #[doc = ""]
+    #[doc = " @param name"]
+    #[doc = "   Name of the lpm object as passed to rte_lpm_create()"]
+    #[doc = " @return"]
+    #[doc = "   Pointer to lpm object or NULL if object not found with rte_errno"]
+    #[doc = "   set appropriately. Possible rte_errno values include:"]
+    #[doc = "    - ENOENT - required entry not available to return."]
+    pub fn rte_lpm_find_existing(name: *const ::std::os::raw::c_char) -> *mut rte_lpm;
+}
+extern "C" {
+    #[doc = " Free an LPM object."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @return"]
+    #[doc = "   None"]
+    pub fn rte_lpm_free(lpm: *mut rte_lpm);
+}
+extern "C" {
+    #[doc = " Add a rule to the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be added to the LPM table"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to be added to the LPM table"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the rule to be added to the LPM table"]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise"]
+    pub fn rte_lpm_add(lpm: *mut rte_lpm, ip: u32, depth: u8, next_hop: u32) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Check if a rule is present in the LPM table,"]
+    #[doc = " and provide its next hop if it is."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be searched"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to searched"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the rule (valid only if it is found)"]
+    #[doc = " @return"]
+    #[doc = "   1 if the rule exists, 0 if it does not, a negative value on failure"]
+    pub fn rte_lpm_is_rule_present(
+        lpm: *mut rte_lpm,
+        ip: u32,
+        depth: u8,
+        next_hop: *mut u32,
+    ) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Delete a rule from the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be deleted from the LPM table"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to be deleted from the LPM table"]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise"]
+    pub fn rte_lpm_delete(lpm: *mut rte_lpm, ip: u32, depth: u8) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Delete all rules from the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    pub fn rte_lpm_delete_all(lpm: *mut rte_lpm);
+}
+#[doc = " LPM configuration structure."]
+#[repr(C)]
+#[derive(Debug, Default, Copy, Clone, PartialEq)]
+pub struct rte_lpm6_config {
+    #[doc = "< Max number of rules."]
+    pub max_rules: u32,
+    #[doc = "< Number of tbl8s to allocate."]
+    pub number_tbl8s: u32,
+    #[doc = "< This field is currently unused."]
+    pub flags: ::std::os::raw::c_int,
+}
+#[test]
+fn bindgen_test_layout_rte_lpm6_config() {
+    assert_eq!(
+        ::std::mem::size_of::<rte_lpm6_config>(),
+        12usize,
+        concat!("Size of: ", stringify!(rte_lpm6_config))
+    );
+    assert_eq!(
+        ::std::mem::align_of::<rte_lpm6_config>(),
+        4usize,
+        concat!("Alignment of ", stringify!(rte_lpm6_config))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm6_config>())).max_rules as *const _ as usize },
+        0usize,
+        concat!("Offset of field: ", stringify!(rte_lpm6_config), "::", stringify!(max_rules))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm6_config>())).number_tbl8s as *const _ as usize },
+        4usize,
+        concat!("Offset of field: ", stringify!(rte_lpm6_config), "::", stringify!(number_tbl8s))
+    );
+    assert_eq!(
+        unsafe { &(*(::std::ptr::null::<rte_lpm6_config>())).flags as *const _ as usize },
+        8usize,
+        concat!("Offset of field: ", stringify!(rte_lpm6_config), "::", stringify!(flags))
+    );
+}
+#[doc = " @internal LPM structure."]
+#[repr(C)]
+#[derive(Debug, Copy, Clone)]
+pub struct rte_lpm6 {
+    _unused: [u8; 0],
+}
+extern "C" {
+    #[doc = " Create an LPM object."]
+    #[doc = ""]
+    #[doc = " @param name"]
+    #[doc = "   LPM object name"]
+    #[doc = " @param socket_id"]
+    #[doc = "   NUMA socket ID for LPM table memory allocation"]
+    #[doc = " @param config"]
+    #[doc = "   Structure containing the configuration"]
+    #[doc = " @return"]
+    #[doc = "   Handle to LPM object on success, NULL otherwise with rte_errno set"]
+    #[doc = "   to an appropriate values. Possible rte_errno values include:"]
+    #[doc = "    - E_RTE_NO_CONFIG - function could not get pointer to rte_config structure"]
+    #[doc = "    - E_RTE_SECONDARY - function was called from a secondary process instance"]
+    #[doc = "    - EINVAL - invalid parameter passed to function"]
+    #[doc = "    - ENOSPC - the maximum number of memzones has already been allocated"]
+    #[doc = "    - EEXIST - a memzone with the same name already exists"]
+    #[doc = "    - ENOMEM - no appropriate memory area found in which to create memzone"]
+    pub fn rte_lpm6_create(name: *const ::std::os::raw::c_char, socket_id: ::std::os::raw::c_int, config: *const rte_lpm6_config) -> *mut rte_lpm6;
+}
+extern "C" {
+    #[doc = " Find an existing LPM object and return a pointer to it."]
+    #[doc = ""]
+    #[doc = " @param name"]
+    #[doc = "   Name of the lpm object as passed to rte_lpm6_create()"]
+    #[doc = " @return"]
+    #[doc = "   Pointer to lpm object or NULL if object not found with rte_errno"]
+    #[doc = "   set appropriately. Possible rte_errno values include:"]
+    #[doc = "    - ENOENT - required entry not available to return."]
+    pub fn rte_lpm6_find_existing(name: *const ::std::os::raw::c_char) -> *mut rte_lpm6;
+}
+extern "C" {
+    #[doc = " Free an LPM object."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @return"]
+    #[doc = "   None"]
+    pub fn rte_lpm6_free(lpm: *mut rte_lpm6);
+}
+extern "C" {
+    #[doc = " Add a rule to the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be added to the LPM table"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to be added to the LPM table"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the rule to be added to the LPM table"]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise"]
+    pub fn rte_lpm6_add(lpm: *mut rte_lpm6, ip: *const u8, depth: u8, next_hop: u32) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Check if a rule is present in the LPM table,"]
+    #[doc = " and provide its next hop if it is."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be searched"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to searched"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the rule (valid only if it is found)"]
+    #[doc = " @return"]
+    #[doc = "   1 if the rule exists, 0 if it does not, a negative value on failure"]
+    pub fn rte_lpm6_is_rule_present(
+        lpm: *mut rte_lpm6,
+        ip: *const u8,
+        depth: u8,
+        next_hop: *mut u32,
+    ) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Delete a rule from the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP of the rule to be deleted from the LPM table"]
+    #[doc = " @param depth"]
+    #[doc = "   Depth of the rule to be deleted from the LPM table"]
+    #[doc = " @return"]
+    #[doc = "   0 on success, negative value otherwise"]
+    pub fn rte_lpm6_delete(lpm: *mut rte_lpm6, ip: *const u8, depth: u8) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Delete all rules from the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    pub fn rte_lpm6_delete_all(lpm: *mut rte_lpm6);
+}
+extern "C" {
+    #[doc = " Lookup an IP into the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP to be looked up in the LPM table"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the most specific rule found for IP (valid on lookup hit only)"]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL for incorrect arguments, -ENOENT on lookup miss, 0 on lookup hit"]
+    pub fn rte_lpm6_lookup(lpm: *const rte_lpm6, ip: *const u8, next_hop: *mut u32) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Lookup multiple IP addresses in an LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ips"]
+    #[doc = "   Array of IPs to be looked up in the LPM table"]
+    #[doc = " @param next_hops"]
+    #[doc = "   Next hop of the most specific rule found for IP (valid on lookup hit only)."]
+    #[doc = "   This is an array of two byte values. The next hop will be stored on"]
+    #[doc = "   each position on success; otherwise the position will be set to -1."]
+    #[doc = " @param n"]
+    #[doc = "   Number of elements in ips (and next_hops) array to lookup."]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL for incorrect arguments, otherwise 0"]
+    pub fn rte_lpm6_lookup_bulk_func(
+        lpm: *const rte_lpm6,
+        ips: *mut [u8; 16usize],
+        next_hops: *mut i32,
+        n: ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_int;
+}
 #[doc = " VXLAN protocol header."]
 #[doc = " Contains the 8-bit flag, 24-bit VXLAN Network Identifier and"]
 #[doc = " Reserved fields (24 bits and 8 bits)"]
@@ -38125,6 +39301,549 @@ extern "C" {
     #[doc = "   -ENOSPC: not enough headroom in mbuf"]
     pub fn _rte_vlan_insert(m: *mut *mut rte_mbuf) -> ::std::os::raw::c_int;
 }
+extern "C" {
+    #[doc = " Enqueue several objects on a ring."]
+    #[doc = ""]
+    #[doc = " This function enqueues exactly n objects, or none of them."]
+    #[doc = " It uses the producer sync mode that was specified at ring creation time."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects enqueued, either 0 or n"]
+    pub fn _rte_ring_enqueue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Enqueue several objects on a ring (multi-producers safe)."]
+    #[doc = ""]
+    #[doc = " This function enqueues exactly n objects, or none of them."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects enqueued, either 0 or n"]
+    pub fn _rte_ring_mp_enqueue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Enqueue several objects on a ring (NOT multi-producers safe)."]
+    #[doc = ""]
+    #[doc = " This function enqueues exactly n objects, or none of them."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects enqueued, either 0 or n"]
+    pub fn _rte_ring_sp_enqueue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Enqueue several objects on a ring."]
+    #[doc = ""]
+    #[doc = " This function enqueues as many objects as possible, up to n."]
+    #[doc = " It uses the producer sync mode that was specified at ring creation time."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects enqueued."]
+    pub fn _rte_ring_enqueue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Enqueue several objects on a ring (multi-producers safe)."]
+    #[doc = ""]
+    #[doc = " This function enqueues as many objects as possible, up to n."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects enqueued."]
+    pub fn _rte_ring_mp_enqueue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Enqueue several objects on a ring (NOT multi-producers safe)."]
+    #[doc = ""]
+    #[doc = " This function enqueues as many objects as possible, up to n."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring from the obj_table."]
+    #[doc = " @param free_space"]
+    #[doc = "   if non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   enqueue operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects enqueued."]
+    pub fn _rte_ring_sp_enqueue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *const ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring."]
+    #[doc = ""]
+    #[doc = " This function dequeues exactly n objects, or none of them."]
+    #[doc = " It uses the consumer sync mode that was specified at ring creation time."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects dequeued, either 0 or n"]
+    pub fn _rte_ring_dequeue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring (multi-consumers safe)."]
+    #[doc = ""]
+    #[doc = " This function dequeues exactly n objects, or none of them."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects dequeued, either 0 or n"]
+    pub fn _rte_ring_mc_dequeue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring (NOT multi-consumers safe)."]
+    #[doc = ""]
+    #[doc = " This function dequeues exactly n objects, or none of them."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects dequeued, either 0 or n"]
+    pub fn _rte_ring_sc_dequeue_bulk_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring."]
+    #[doc = ""]
+    #[doc = " This function dequeues as many objects as possible, up to n."]
+    #[doc = " It uses the consumer sync mode that was specified at ring creation time."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects dequeued, 0 if ring is empty"]
+    pub fn _rte_ring_dequeue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring (multi-consumers safe)."]
+    #[doc = ""]
+    #[doc = " This function dequeues as many objects as possible, up to n."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects dequeued, 0 if ring is empty"]
+    pub fn _rte_ring_mc_dequeue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Dequeue several objects from a ring (NOT multi-consumers safe)."]
+    #[doc = ""]
+    #[doc = " This function dequeues as many objects as possible, up to n."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param obj_table"]
+    #[doc = "   A pointer to a table of objects that will be filled."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to dequeue from the ring to the obj_table."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   - n: Actual number of objects dequeued, 0 if ring is empty"]
+    pub fn _rte_ring_sc_dequeue_burst_elem(
+        r: *mut rte_ring,
+        obj_table: *mut ::std::os::raw::c_void,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Return the number of entries in a ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   The number of entries in the ring."]
+    pub fn _rte_ring_count(r: *const rte_ring) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Return the number of free entries in a ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   The number of free entries in the ring."]
+    pub fn _rte_ring_free_count(r: *const rte_ring) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Test if a ring is full."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   - 1: The ring is full."]
+    #[doc = "   - 0: The ring is not full."]
+    pub fn _rte_ring_full(r: *const rte_ring) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Test if a ring is empty."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   - 1: The ring is empty."]
+    #[doc = "   - 0: The ring is not empty."]
+    pub fn _rte_ring_empty(r: *const rte_ring) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Return the size of the ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   The size of the data store used by the ring."]
+    #[doc = "   NOTE: this is not the same as the usable space in the ring. To query that"]
+    #[doc = "   use ``rte_ring_get_capacity()``."]
+    pub fn _rte_ring_get_size(r: *const rte_ring) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Return the number of elements which can be stored in the ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   The usable size of the ring."]
+    pub fn _rte_ring_get_capacity(r: *const rte_ring) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Return sync type used by producer in the ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   Producer sync type value."]
+    pub fn _rte_ring_get_prod_sync_type(r: *const rte_ring) -> rte_ring_sync_type::Type;
+}
+extern "C" {
+    #[doc = " Return sync type used by consumer in the ring."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @return"]
+    #[doc = "   Consumer sync type value."]
+    pub fn _rte_ring_get_cons_sync_type(r: *const rte_ring) -> rte_ring_sync_type::Type;
+}
+extern "C" {
+    #[doc = " Start to enqueue several objects on the ring."]
+    #[doc = ""]
+    #[doc = " Note that no actual objects are put in the queue by this function,"]
+    #[doc = " it just reserves space for the user on the ring."]
+    #[doc = " User has to copy objects into the queue using the returned pointers."]
+    #[doc = " User should call rte_ring_enqueue_zc_finish to complete the"]
+    #[doc = " enqueue operation. Only valid for single-producer or HTS rings."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to add in the ring."]
+    #[doc = " @param zcd"]
+    #[doc = "   Structure containing the pointers and length of the space"]
+    #[doc = "   reserved on the ring storage."]
+    #[doc = " @param free_space"]
+    #[doc = "   If non-NULL, returns the amount of space in the ring after the"]
+    #[doc = "   reservation operation has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects that can be enqueued, up to n"]
+    pub fn _rte_ring_enqueue_zc_burst_elem_start(
+        r: *mut rte_ring,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        zcd: *mut rte_ring_zc_data,
+        free_space: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Complete enqueuing several pointers to objects on the ring."]
+    #[doc = ""]
+    #[doc = " Note that number of objects to enqueue should not exceed previous"]
+    #[doc = " enqueue_start return value."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param n"]
+    #[doc = "   The number of pointers to objects to add to the ring."]
+    pub fn _rte_ring_enqueue_zc_finish(r: *mut rte_ring, n: ::std::os::raw::c_uint);
+}
+extern "C" {
+    #[doc = " Start to dequeue several objects from the ring."]
+    #[doc = ""]
+    #[doc = " Note that no actual objects are copied from the queue by this function."]
+    #[doc = " User has to copy objects from the queue using the returned pointers."]
+    #[doc = " User should call rte_ring_dequeue_zc_finish to complete the"]
+    #[doc = " dequeue operation. Only valid for single-consumer or HTS rings."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param esize"]
+    #[doc = "   The size of ring element, in bytes. It must be a multiple of 4."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to remove from the ring."]
+    #[doc = " @param zcd"]
+    #[doc = "   Structure containing the pointers and length of the space"]
+    #[doc = "   reserved on the ring storage."]
+    #[doc = " @param available"]
+    #[doc = "   If non-NULL, returns the number of remaining ring entries after the"]
+    #[doc = "   dequeue has finished."]
+    #[doc = " @return"]
+    #[doc = "   The number of objects that can be dequeued, up to n"]
+    pub fn _rte_ring_dequeue_zc_burst_elem_start(
+        r: *mut rte_ring,
+        esize: ::std::os::raw::c_uint,
+        n: ::std::os::raw::c_uint,
+        zcd: *mut rte_ring_zc_data,
+        available: *mut ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_uint;
+}
+extern "C" {
+    #[doc = " Complete dequeuing several objects from the ring."]
+    #[doc = ""]
+    #[doc = " Note that number of objects to dequeued should not exceed previous"]
+    #[doc = " dequeue_start return value."]
+    #[doc = ""]
+    #[doc = " @param r"]
+    #[doc = "   A pointer to the ring structure."]
+    #[doc = " @param n"]
+    #[doc = "   The number of objects to remove from the ring."]
+    pub fn _rte_ring_dequeue_zc_finish(r: *mut rte_ring, n: ::std::os::raw::c_uint);
+}
+extern "C" {
+    #[doc = " Calculate CRC32 hash on user-supplied byte array."]
+    #[doc = ""]
+    #[doc = " @param data"]
+    #[doc = "   Data to perform hash on."]
+    #[doc = " @param data_len"]
+    #[doc = "   How many bytes to use to calculate hash value."]
+    #[doc = " @param init_val"]
+    #[doc = "   Value to initialise hash generator."]
+    #[doc = " @return"]
+    #[doc = "   32bit calculated hash value."]
+    pub fn _rte_hash_crc(data: *const ::std::os::raw::c_void, data_len: u32, init_val: u32) -> u32;
+}
+extern "C" {
+    #[doc = " The most generic version, hashes an arbitrary sequence"]
+    #[doc = " of bytes.  No alignment or length assumptions are made about"]
+    #[doc = " the input key."]
+    #[doc = ""]
+    #[doc = " @param key"]
+    #[doc = "   Key to calculate hash of."]
+    #[doc = " @param length"]
+    #[doc = "   Length of key in bytes."]
+    #[doc = " @param initval"]
+    #[doc = "   Initialising value of hash."]
+    #[doc = " @return"]
+    #[doc = "   Calculated hash value."]
+    pub fn _rte_jhash(key: *const ::std::os::raw::c_void, length: u32, initval: u32) -> u32;
+}
+extern "C" {
+    #[doc = " Lookup an IP into the LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ip"]
+    #[doc = "   IP to be looked up in the LPM table"]
+    #[doc = " @param next_hop"]
+    #[doc = "   Next hop of the most specific rule found for IP (valid on lookup hit only)"]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL for incorrect arguments, -ENOENT on lookup miss, 0 on lookup hit"]
+    pub fn _rte_lpm_lookup(lpm: *mut rte_lpm, ip: u32, next_hop: *mut u32) -> ::std::os::raw::c_int;
+}
+extern "C" {
+    #[doc = " Lookup multiple IP addresses in an LPM table."]
+    #[doc = ""]
+    #[doc = " @param lpm"]
+    #[doc = "   LPM object handle"]
+    #[doc = " @param ips"]
+    #[doc = "   Array of IPs to be looked up in the LPM table"]
+    #[doc = " @param next_hops"]
+    #[doc = "   Next hop of the most specific rule found for IP (valid on lookup hit only)."]
+    #[doc = "   This is an array of four byte values. If the lookup was successful for the"]
+    #[doc = "   given IP, then least significant byte of the corresponding element is the"]
+    #[doc = "   actual next hop and the most significant byte is zero."]
+    #[doc = "   If the lookup for the given IP failed, then corresponding element would"]
+    #[doc = "   contain default value, see description of then next parameter."]
+    #[doc = " @param n"]
+    #[doc = "   Number of elements in ips (and next_hops) array to lookup."]
+    #[doc = " @return"]
+    #[doc = "   -EINVAL for incorrect arguments, otherwise 0"]
+    pub fn _rte_lpm_lookup_bulk(
+        lpm: *const rte_lpm,
+        ips: *const u32,
+        next_hops: *mut u32,
+        n: ::std::os::raw::c_uint,
+    ) -> ::std::os::raw::c_int;
+}
 pub type __builtin_va_list = [__va_list_tag; 1usize];
 #[repr(C)]
 #[derive(Debug, Copy, Clone, PartialEq)]
@@ -27,6 +27,12 @@
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
 
+#include <rte_hash.h>
+#include <rte_hash_crc.h>
+#include <rte_jhash.h>
+#include <rte_lpm.h>
+#include <rte_lpm6.h>
+
 #include <rte_timer.h>
 #include <rte_malloc.h>
 #include <rte_debug.h>
@@ -37,8 +43,12 @@
 #include <rte_interrupts.h>
 #include <rte_pci.h>
 #include <rte_ethdev.h>
+#include <rte_flow.h>
 #include <rte_kni.h>
 #include <rte_eth_bond.h>
+#include <rte_eth_bond_8023ad.h>
+#include <rte_gro.h>
+#include <rte_gso.h>
 
 #include <rte_ether.h>
 #include <rte_arp.h>
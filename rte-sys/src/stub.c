@@ -508,3 +508,143 @@ int
 _rte_vlan_insert(struct rte_mbuf **m) {
     return rte_vlan_insert(m);
 }
+
+unsigned int
+_rte_ring_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_enqueue_bulk_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_mp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_mp_enqueue_bulk_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_sp_enqueue_bulk_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_sp_enqueue_bulk_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_enqueue_burst_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_enqueue_burst_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_mp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_mp_enqueue_burst_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_sp_enqueue_burst_elem(struct rte_ring *r, const void *obj_table, unsigned int esize, unsigned int n, unsigned int *free_space) {
+    return rte_ring_sp_enqueue_burst_elem(r, obj_table, esize, n, free_space);
+}
+
+unsigned int
+_rte_ring_dequeue_bulk_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_dequeue_bulk_elem(r, obj_table, esize, n, available);
+}
+
+unsigned int
+_rte_ring_mc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_mc_dequeue_bulk_elem(r, obj_table, esize, n, available);
+}
+
+unsigned int
+_rte_ring_sc_dequeue_bulk_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_sc_dequeue_bulk_elem(r, obj_table, esize, n, available);
+}
+
+unsigned int
+_rte_ring_dequeue_burst_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_dequeue_burst_elem(r, obj_table, esize, n, available);
+}
+
+unsigned int
+_rte_ring_mc_dequeue_burst_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_mc_dequeue_burst_elem(r, obj_table, esize, n, available);
+}
+
+unsigned int
+_rte_ring_sc_dequeue_burst_elem(struct rte_ring *r, void *obj_table, unsigned int esize, unsigned int n, unsigned int *available) {
+    return rte_ring_sc_dequeue_burst_elem(r, obj_table, esize, n, available);
+}
+
+unsigned
+_rte_ring_count(const struct rte_ring *r) {
+    return rte_ring_count(r);
+}
+
+unsigned
+_rte_ring_free_count(const struct rte_ring *r) {
+    return rte_ring_free_count(r);
+}
+
+int
+_rte_ring_full(const struct rte_ring *r) {
+    return rte_ring_full(r);
+}
+
+int
+_rte_ring_empty(const struct rte_ring *r) {
+    return rte_ring_empty(r);
+}
+
+unsigned int
+_rte_ring_get_size(const struct rte_ring *r) {
+    return rte_ring_get_size(r);
+}
+
+unsigned int
+_rte_ring_get_capacity(const struct rte_ring *r) {
+    return rte_ring_get_capacity(r);
+}
+
+enum rte_ring_sync_type
+_rte_ring_get_prod_sync_type(const struct rte_ring *r) {
+    return rte_ring_get_prod_sync_type(r);
+}
+
+enum rte_ring_sync_type
+_rte_ring_get_cons_sync_type(const struct rte_ring *r) {
+    return rte_ring_get_cons_sync_type(r);
+}
+
+unsigned int
+_rte_ring_enqueue_zc_burst_elem_start(struct rte_ring *r, unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd, unsigned int *free_space) {
+    return rte_ring_enqueue_zc_burst_elem_start(r, esize, n, zcd, free_space);
+}
+
+void
+_rte_ring_enqueue_zc_finish(struct rte_ring *r, unsigned int n) {
+    rte_ring_enqueue_zc_finish(r, n);
+}
+
+unsigned int
+_rte_ring_dequeue_zc_burst_elem_start(struct rte_ring *r, unsigned int esize, unsigned int n, struct rte_ring_zc_data *zcd, unsigned int *available) {
+    return rte_ring_dequeue_zc_burst_elem_start(r, esize, n, zcd, available);
+}
+
+void
+_rte_ring_dequeue_zc_finish(struct rte_ring *r, unsigned int n) {
+    rte_ring_dequeue_zc_finish(r, n);
+}
+
+uint32_t
+_rte_hash_crc(const void *data, uint32_t data_len, uint32_t init_val) {
+    return rte_hash_crc(data, data_len, init_val);
+}
+
+uint32_t
+_rte_jhash(const void *key, uint32_t length, uint32_t initval) {
+    return rte_jhash(key, length, initval);
+}
+
+int
+_rte_lpm_lookup(struct rte_lpm *lpm, uint32_t ip, uint32_t *next_hop) {
+    return rte_lpm_lookup(lpm, ip, next_hop);
+}
+
+int
+_rte_lpm_lookup_bulk(const struct rte_lpm *lpm, const uint32_t *ips, uint32_t *next_hops, unsigned n) {
+    return rte_lpm_lookup_bulk(lpm, ips, next_hops, n);
+}
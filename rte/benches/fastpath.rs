@@ -0,0 +1,165 @@
+//! Cycles spent in the hot-path primitives, the out-of-line `stub.c` shims
+//! against the functions exported by `rte-sys`.
+//!
+//! Build it with the `inline` feature to compare the shims with the Rust ports,
+//! or with the `lto` feature and `-Clinker-plugin-lto` to compare them with the inlined shims.
+//!
+//! ```
+//! $ cargo bench --bench fastpath --features inline
+//! ```
+extern crate rte;
+
+use std::hint::black_box;
+use std::mem;
+
+use rte::ethdev::{EthConf, EthDevice};
+use rte::ffi;
+use rte::*;
+
+const ROUNDS: usize = 10_000_000;
+const BURST_ROUNDS: usize = 1_000_000;
+const BURST_SIZE: usize = 32;
+
+const NB_MBUF: u32 = 8191;
+const MEMPOOL_CACHE_SIZE: u32 = 256;
+const NB_DESC: u16 = 1024;
+
+fn rdtsc() -> u64 {
+    unsafe { ffi::raw::_rte_rdtsc() }
+}
+
+/// Run `f` for `rounds` rounds and return the cycles spent per operation.
+fn cycles_per_op<F: FnMut() -> usize>(rounds: usize, mut f: F) -> f64 {
+    // warm up the caches and the branch predictors
+    for _ in 0..rounds / 10 {
+        f();
+    }
+
+    let mut ops = 0;
+    let start = rdtsc();
+
+    for _ in 0..rounds {
+        ops += f();
+    }
+
+    (rdtsc() - start) as f64 / ops.max(1) as f64
+}
+
+fn report(name: &str, shim: f64, fastpath: f64) {
+    println!(
+        "{:<24} shim {:>8.2} cycles/op, fast path {:>8.2} cycles/op, saved {:>6.2} cycles/op",
+        name,
+        shim,
+        fastpath,
+        shim - fastpath
+    );
+}
+
+fn bench_rdtsc() {
+    let shim = cycles_per_op(ROUNDS, || {
+        black_box(unsafe { ffi::raw::_rte_rdtsc() });
+        1
+    });
+    let fastpath = cycles_per_op(ROUNDS, || {
+        black_box(unsafe { ffi::_rte_rdtsc() });
+        1
+    });
+
+    report("rte_rdtsc", shim, fastpath);
+}
+
+fn bench_refcnt_update() {
+    let mut m: ffi::rte_mbuf = unsafe { mem::zeroed() };
+    let m = black_box(&mut m as *mut ffi::rte_mbuf);
+
+    unsafe { ffi::raw::_rte_mbuf_refcnt_set(m, 1) };
+
+    // take and release a reference, once on the unshared fast path and once atomically
+    let shim = cycles_per_op(ROUNDS, || unsafe {
+        ffi::raw::_rte_mbuf_refcnt_update(m, 1);
+        ffi::raw::_rte_mbuf_refcnt_update(m, -1);
+        2
+    });
+    let fastpath = cycles_per_op(ROUNDS, || unsafe {
+        ffi::_rte_mbuf_refcnt_update(m, 1);
+        ffi::_rte_mbuf_refcnt_update(m, -1);
+        2
+    });
+
+    report("rte_mbuf_refcnt_update", shim, fastpath);
+}
+
+/// Forward the packets generated by a `net_null` device back to it, return the cycles per packet.
+fn forward<R, T>(dev: ethdev::PortId, rx_burst: R, tx_burst: T) -> f64
+where
+    R: Fn(u16, u16, *mut *mut ffi::rte_mbuf, u16) -> u16,
+    T: Fn(u16, u16, *mut *mut ffi::rte_mbuf, u16) -> u16,
+{
+    let mut pkts = [std::ptr::null_mut(); BURST_SIZE];
+
+    cycles_per_op(BURST_ROUNDS, || {
+        let nb_rx = rx_burst(dev, 0, pkts.as_mut_ptr(), BURST_SIZE as u16);
+        let nb_tx = tx_burst(dev, 0, pkts.as_mut_ptr(), nb_rx);
+
+        for &m in &pkts[nb_tx as usize..nb_rx as usize] {
+            unsafe { ffi::_rte_pktmbuf_free(m) }
+        }
+
+        nb_rx as usize
+    })
+}
+
+fn bench_burst() {
+    eal::init(&[
+        "fastpath",
+        "--no-huge",
+        "--no-pci",
+        "-m",
+        "512",
+        "-l",
+        "0",
+        "--vdev=net_null0",
+        "--log-level=error",
+    ])
+    .expect("Cannot init EAL");
+
+    let mut pool = mbuf::pool_create(
+        "fastpath_pool",
+        NB_MBUF,
+        MEMPOOL_CACHE_SIZE,
+        0,
+        mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16,
+        lcore::socket_id() as i32,
+    )
+    .expect("Cannot init mbuf pool");
+
+    let dev: ethdev::PortId = 0;
+
+    dev.configure(1, 1, &EthConf::default())
+        .expect("Cannot configure device");
+    dev.rx_queue_setup(0, NB_DESC, None, &mut pool)
+        .expect("Cannot setup RX queue");
+    dev.tx_queue_setup(0, NB_DESC, None).expect("Cannot setup TX queue");
+    dev.start().expect("Cannot start device");
+
+    let shim = forward(
+        dev,
+        |port, queue, pkts, n| unsafe { ffi::raw::_rte_eth_rx_burst(port, queue, pkts, n) },
+        |port, queue, pkts, n| unsafe { ffi::raw::_rte_eth_tx_burst(port, queue, pkts, n) },
+    );
+    let fastpath = forward(
+        dev,
+        |port, queue, pkts, n| unsafe { ffi::_rte_eth_rx_burst(port, queue, pkts, n) },
+        |port, queue, pkts, n| unsafe { ffi::_rte_eth_tx_burst(port, queue, pkts, n) },
+    );
+
+    report("rte_eth_rx/tx_burst", shim, fastpath);
+
+    dev.stop().close();
+}
+
+fn main() {
+    bench_rdtsc();
+    bench_refcnt_update();
+    bench_burst();
+}
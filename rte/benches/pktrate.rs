@@ -0,0 +1,270 @@
+//! Packet rate of the binding layer against the raw C functions, over software devices.
+//!
+//! - `net_null` receives newly allocated packets and frees the sent ones.
+//! - `net_ring` loops the sent packets back to its RX queue, so it only measures the ethdev path.
+//!
+//! Each case runs the safe wrappers (`EthDevice::rx_burst/tx_burst`, `MBufPool::alloc_bulk`, `MBuf` drop)
+//! and the same loop over the `rte-sys` shims, for burst sizes from 1 to 256,
+//! and reports the Mpps and cycles per packet of both, so a regression of the wrappers shows up as a gap.
+//!
+//! ```
+//! $ cargo bench --bench pktrate
+//! $ cargo bench --bench pktrate --features inline
+//! ```
+extern crate rte;
+
+use std::ptr;
+
+use rte::ethdev::{EthConf, EthDevice};
+use rte::ffi;
+use rte::mbuf::{MBufPool, MbufBurst};
+use rte::utils::AsRaw;
+use rte::*;
+
+/// Packets to send through each case.
+const PACKETS: usize = 20_000_000;
+
+const NB_MBUF: u32 = 8191;
+const MEMPOOL_CACHE_SIZE: u32 = 256;
+const NB_DESC: u16 = 1024;
+const MAX_BURST: usize = 256;
+
+/// Packets looping in the `net_ring` device.
+const RING_PACKETS: usize = 2 * MAX_BURST;
+
+/// The rate of a case.
+struct Rate {
+    cycles_per_pkt: f64,
+    mpps: f64,
+}
+
+/// Run `f` until it processed `PACKETS` packets.
+fn measure<F: FnMut() -> usize>(mut f: F) -> Rate {
+    // warm up the caches and the branch predictors
+    let mut pkts = 0;
+
+    while pkts < PACKETS / 10 {
+        pkts += f();
+    }
+
+    pkts = 0;
+
+    let start = rdtsc();
+
+    while pkts < PACKETS {
+        pkts += f();
+    }
+
+    let cycles = (rdtsc() - start) as f64;
+
+    Rate {
+        cycles_per_pkt: cycles / pkts as f64,
+        mpps: pkts as f64 * get_tsc_hz() as f64 / cycles / 1e6,
+    }
+}
+
+fn report(case: &str, burst: usize, safe: Rate, raw: Rate) {
+    println!(
+        "{:<16} burst {:>3}: safe {:>7.2} Mpps {:>7.2} cycles/pkt, raw {:>7.2} Mpps {:>7.2} cycles/pkt, overhead {:>+6.2} cycles/pkt",
+        case,
+        burst,
+        safe.mpps,
+        safe.cycles_per_pkt,
+        raw.mpps,
+        raw.cycles_per_pkt,
+        safe.cycles_per_pkt - raw.cycles_per_pkt
+    );
+}
+
+/// Receive a burst and send it back to the device.
+fn rx_tx<const N: usize>(case: &str, dev: ethdev::PortId) {
+    let mut burst = MbufBurst::<N>::new();
+
+    let safe = measure(|| {
+        let nb_rx = dev.rx_burst(0, &mut burst);
+
+        dev.tx_burst(0, &mut burst);
+        burst.clear();
+
+        nb_rx
+    });
+
+    let mut pkts = [ptr::null_mut(); N];
+
+    let raw = measure(|| unsafe {
+        let nb_rx = ffi::raw::_rte_eth_rx_burst(dev, 0, pkts.as_mut_ptr(), N as u16);
+        let nb_tx = ffi::raw::_rte_eth_tx_burst(dev, 0, pkts.as_mut_ptr(), nb_rx);
+
+        for &m in &pkts[nb_tx as usize..nb_rx as usize] {
+            ffi::raw::_rte_pktmbuf_free(m);
+        }
+
+        nb_rx as usize
+    });
+
+    report(case, N, safe, raw);
+}
+
+/// Allocate a burst of packets and free them.
+fn alloc_free<const N: usize>(pool: &mut mempool::MemoryPool) {
+    let mut mbufs: Vec<Option<mbuf::MBuf>> = (0..N).map(|_| None).collect();
+
+    let safe = measure(|| {
+        pool.alloc_bulk(&mut mbufs).expect("fail to allocate mbufs");
+
+        for m in mbufs.iter_mut() {
+            drop(m.take());
+        }
+
+        N
+    });
+
+    let mut pkts = [ptr::null_mut(); N];
+
+    let raw = measure(|| unsafe {
+        if ffi::raw::_rte_pktmbuf_alloc_bulk(pool.as_raw_mut(), pkts.as_mut_ptr(), N as u32) != 0 {
+            panic!("fail to allocate mbufs");
+        }
+
+        for &m in &pkts[..] {
+            ffi::raw::_rte_pktmbuf_free(m);
+        }
+
+        N
+    });
+
+    report("alloc/free", N, safe, raw);
+}
+
+/// The l2fwd forward path, receive a burst, rewrite the MAC addresses and send it back.
+fn forward<const N: usize>(case: &str, dev: ethdev::PortId) {
+    let dst = ether::EtherAddr::new(0x02, 0, 0, 0, 0, dev as u8);
+    let src = dev.mac_addr();
+
+    let mut burst = MbufBurst::<N>::new();
+
+    let safe = measure(|| {
+        let nb_rx = dev.rx_burst(0, &mut burst);
+
+        for m in burst.iter() {
+            let eth = unsafe { m.mtod::<ether::EtherHdr>().as_mut() };
+
+            eth.d_addr.addr_bytes = *dst.octets();
+            eth.s_addr.addr_bytes = *src.octets();
+        }
+
+        dev.tx_burst(0, &mut burst);
+        burst.clear();
+
+        nb_rx
+    });
+
+    let mut pkts = [ptr::null_mut(); N];
+
+    let raw = measure(|| unsafe {
+        let nb_rx = ffi::raw::_rte_eth_rx_burst(dev, 0, pkts.as_mut_ptr(), N as u16);
+
+        for &m in &pkts[..nb_rx as usize] {
+            let eth = ((*m).buf_addr as *mut u8).add((*m).data_off as usize) as *mut ffi::rte_ether_hdr;
+
+            (*eth).d_addr.addr_bytes = *dst.octets();
+            (*eth).s_addr.addr_bytes = *src.octets();
+        }
+
+        let nb_tx = ffi::raw::_rte_eth_tx_burst(dev, 0, pkts.as_mut_ptr(), nb_rx);
+
+        for &m in &pkts[nb_tx as usize..nb_rx as usize] {
+            ffi::raw::_rte_pktmbuf_free(m);
+        }
+
+        nb_rx as usize
+    });
+
+    report(case, N, safe, raw);
+}
+
+macro_rules! burst_sizes {
+    ($case:ident ( $($arg:expr),* )) => {
+        $case::<1>($($arg),*);
+        $case::<2>($($arg),*);
+        $case::<4>($($arg),*);
+        $case::<8>($($arg),*);
+        $case::<16>($($arg),*);
+        $case::<32>($($arg),*);
+        $case::<64>($($arg),*);
+        $case::<128>($($arg),*);
+        $case::<256>($($arg),*);
+    };
+}
+
+fn port_by_name(name: &str) -> ethdev::PortId {
+    let name = std::ffi::CString::new(name).unwrap();
+    let mut port_id = 0;
+
+    if unsafe { ffi::rte_eth_dev_get_port_by_name(name.as_ptr(), &mut port_id) } != 0 {
+        panic!("no device {:?}", name);
+    }
+
+    port_id
+}
+
+fn setup_port(dev: ethdev::PortId, pool: &mut mempool::MemoryPool) {
+    dev.configure(1, 1, &EthConf::default())
+        .expect("Cannot configure device");
+    dev.rx_queue_setup(0, NB_DESC, None, pool)
+        .expect("Cannot setup RX queue");
+    dev.tx_queue_setup(0, NB_DESC, None).expect("Cannot setup TX queue");
+    dev.start().expect("Cannot start device");
+}
+
+fn main() {
+    eal::init(&[
+        "pktrate",
+        "--no-huge",
+        "--no-pci",
+        "-m",
+        "512",
+        "-l",
+        "0",
+        "--vdev=net_null0",
+        "--vdev=net_ring0",
+        "--log-level=error",
+    ])
+    .expect("Cannot init EAL");
+
+    let mut pool = mbuf::pool_create(
+        "pktrate_pool",
+        NB_MBUF,
+        MEMPOOL_CACHE_SIZE,
+        0,
+        mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16,
+        lcore::socket_id() as i32,
+    )
+    .expect("Cannot init mbuf pool");
+
+    let null_dev = port_by_name("net_null0");
+    let ring_dev = port_by_name("net_ring0");
+
+    setup_port(null_dev, &mut pool);
+    setup_port(ring_dev, &mut pool);
+
+    // the packets looping in the ring device
+    let mut seed = MbufBurst::<RING_PACKETS>::new();
+
+    while !seed.is_full() {
+        let _ = seed.push(pool.alloc().expect("fail to allocate mbufs"));
+    }
+
+    while !seed.is_empty() {
+        ring_dev.tx_burst(0, &mut seed);
+    }
+
+    burst_sizes!(alloc_free(&mut pool));
+    burst_sizes!(rx_tx("rx/tx net_null", null_dev));
+    burst_sizes!(rx_tx("rx/tx net_ring", ring_dev));
+    burst_sizes!(forward("l2fwd net_null", null_dev));
+    burst_sizes!(forward("l2fwd net_ring", ring_dev));
+
+    null_dev.stop().close();
+    ring_dev.stop().close();
+}
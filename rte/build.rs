@@ -3,15 +3,30 @@ extern crate log;
 
 extern crate rte_build;
 
+use std::env;
+
 use rte_build::*;
 
 fn main() {
     pretty_env_logger::init();
 
-    gcc_rte_config(&RTE_INCLUDE_DIR)
+    let examples_config = || {
+        let mut build = gcc_rte_config(&RTE_INCLUDE_DIR);
+
+        build.include("examples/common");
+
+        // the cycle accounting of the poll loops, see `examples/common/poll_stats.h`
+        if env::var_os("CARGO_FEATURE_POLL_STATS").is_some() {
+            build.define("RTE_POLL_STATS", None);
+        }
+
+        build
+    };
+
+    examples_config()
         .file("examples/l2fwd/l2fwd_core.c")
         .compile("libl2fwd_core.a");
-    gcc_rte_config(&RTE_INCLUDE_DIR)
+    examples_config()
         .file("examples/kni/kni_core.c")
         .compile("libkni_core.a");
 
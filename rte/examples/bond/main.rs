@@ -1,6 +1,7 @@
 #[macro_use]
 extern crate log;
 extern crate cfile;
+extern crate getopts;
 extern crate libc;
 extern crate nix;
 extern crate pretty_env_logger;
@@ -10,15 +11,16 @@ use std::cell::RefCell;
 use std::env;
 use std::mem;
 use std::net;
+use std::path::Path;
+use std::process;
 use std::ptr::NonNull;
 use std::rc::Rc;
 use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 
 use rte::arp::{RTE_ARP_HRD_ETHER, RTE_ARP_OP_REPLY, RTE_ARP_OP_REQUEST};
-use rte::bond::BondedDevice;
+use rte::bond::{BondMode, BondedDevice, TransmitPolicy};
 use rte::ethdev::EthDevice;
 use rte::ether::{RTE_ETHER_TYPE_IPV4, ETHER_ADDR_LEN, RTE_ETHER_TYPE_ARP};
-use rte::lcore::RTE_MAX_LCORE;
 use rte::mbuf::MBufPool;
 use rte::memory::AsMutRef;
 use rte::*;
@@ -43,9 +45,16 @@ const MEMPOOL_CACHE_SZ: u32 = PKT_BURST_SZ;
 const RTE_RX_DESC_DEFAULT: u16 = 128;
 const RTE_TX_DESC_DEFAULT: u16 = 512;
 
+struct Args {
+    mode: BondMode,
+    xmit_policy: TransmitPolicy,
+    dedicated_queues: bool,
+}
+
 struct AppConfig {
     lcore_main_is_running: AtomicBool,
-    lcore_main_core_id: lcore::Id,
+    /// The lcores polling the bonded port, each one on its own RX and TX queue.
+    lcore_main_core_ids: Vec<lcore::Id>,
     bond_ip: net::Ipv4Addr,
     bond_mac_addr: ether::EtherAddr,
     bonded_port_id: PortId,
@@ -53,50 +62,68 @@ struct AppConfig {
     port_packets: [AtomicUsize; 4],
 }
 
-impl Default for AppConfig {
-    fn default() -> Self {
-        unsafe { mem::zeroed() }
-    }
-}
-
 impl AppConfig {
     fn is_running(&self) -> bool {
         self.lcore_main_is_running.load(Ordering::Relaxed)
     }
 
-    fn start(&self) {
-        launch::remote_launch(lcore_main, Some(self), self.lcore_main_core_id).expect("Cannot launch task");
+    /// The queue polled by an lcore.
+    fn queue_of(&self, lcore_id: lcore::Id) -> QueueId {
+        self.lcore_main_core_ids.iter().position(|&id| id == lcore_id).unwrap() as QueueId
+    }
 
+    /// The TX queue of the command line, after the ones of the lcores.
+    fn cmdline_tx_queue(&self) -> QueueId {
+        self.lcore_main_core_ids.len() as QueueId
+    }
+
+    fn start(&self) {
         self.lcore_main_is_running.store(true, Ordering::Relaxed);
 
-        info!(
-            "Starting lcore_main on core {} Our IP {}",
-            self.lcore_main_core_id, self.bond_ip
-        );
+        for &lcore_id in &self.lcore_main_core_ids {
+            launch::remote_launch(lcore_main, Some(self), lcore_id).expect("Cannot launch task");
+
+            info!(
+                "Starting lcore_main on core {} queue {} Our IP {}",
+                lcore_id,
+                self.queue_of(lcore_id),
+                self.bond_ip
+            );
+        }
     }
 
     fn stop(&self) {
         self.lcore_main_is_running.store(false, Ordering::Relaxed);
 
-        self.lcore_main_core_id.wait();
+        for lcore_id in &self.lcore_main_core_ids {
+            lcore_id.wait();
+        }
     }
 }
 
-fn slave_port_init(port_id: ethdev::PortId, port_conf: &ethdev::EthConf, pktmbuf_pool: &mut mempool::MemoryPool) {
+fn slave_port_init(
+    port_id: ethdev::PortId,
+    nb_rx_queues: QueueId,
+    nb_tx_queues: QueueId,
+    port_conf: &ethdev::EthConf,
+    pktmbuf_pool: &mut mempool::MemoryPool,
+) {
     info!("Setup port {}", port_id);
 
     let dev = port_id;
 
-    dev.configure(1, 1, &port_conf)
+    dev.configure(nb_rx_queues, nb_tx_queues, &port_conf)
         .expect(&format!("fail to configure device: port={}", port_id));
 
-    // init one RX queue
-    dev.rx_queue_setup(0, RTE_RX_DESC_DEFAULT, None, pktmbuf_pool)
-        .expect(&format!("fail to setup device rx queue: port={}", port_id));
+    for queue_id in 0..nb_rx_queues {
+        dev.rx_queue_setup(queue_id, RTE_RX_DESC_DEFAULT, None, pktmbuf_pool)
+            .expect(&format!("fail to setup device rx queue: port={}", port_id));
+    }
 
-    // init one TX queue on each port
-    dev.tx_queue_setup(0, RTE_TX_DESC_DEFAULT, None)
-        .expect(&format!("fail to setup device tx queue: port={}", port_id));
+    for queue_id in 0..nb_tx_queues {
+        dev.tx_queue_setup(queue_id, RTE_TX_DESC_DEFAULT, None)
+            .expect(&format!("fail to setup device tx queue: port={}", port_id));
+    }
 
     // Start device
     dev.start().expect(&format!("fail to start device: port={}", port_id));
@@ -108,23 +135,29 @@ fn slave_port_init(port_id: ethdev::PortId, port_conf: &ethdev::EthConf, pktmbuf
 
 fn bond_port_init(
     slave_count: u16,
+    nb_rx_queues: QueueId,
+    nb_tx_queues: QueueId,
+    args: &Args,
     port_conf: &ethdev::EthConf,
     pktmbuf_pool: &mut mempool::MemoryPool,
 ) -> ethdev::PortId {
-    let dev = bond::create("bond0", bond::BondMode::AdaptiveLB, 0).expect("Faled to create bond port");
+    let dev = bond::create("bond0", args.mode, 0).expect("Faled to create bond port");
 
     let bonded_port_id = dev;
 
-    dev.configure(1, 1, &port_conf)
+    dev.configure(nb_rx_queues, nb_tx_queues, &port_conf)
         .expect(&format!("fail to configure device: port={}", bonded_port_id));
 
-    // init one RX queue
-    dev.rx_queue_setup(0, RTE_RX_DESC_DEFAULT, None, pktmbuf_pool)
-        .expect(&format!("fail to setup device rx queue: port={}", bonded_port_id));
+    // the queues of the bonded port are mapped to the same queues of the slaves
+    for queue_id in 0..nb_rx_queues {
+        dev.rx_queue_setup(queue_id, RTE_RX_DESC_DEFAULT, None, pktmbuf_pool)
+            .expect(&format!("fail to setup device rx queue: port={}", bonded_port_id));
+    }
 
-    // init one TX queue on each port
-    dev.tx_queue_setup(0, RTE_TX_DESC_DEFAULT, None)
-        .expect(&format!("fail to setup device tx queue: port={}", bonded_port_id));
+    for queue_id in 0..nb_tx_queues {
+        dev.tx_queue_setup(queue_id, RTE_TX_DESC_DEFAULT, None)
+            .expect(&format!("fail to setup device tx queue: port={}", bonded_port_id));
+    }
 
     for slave_port_id in 0..slave_count {
         dev.add_slave(slave_port_id).expect(&format!(
@@ -133,6 +166,17 @@ fn bond_port_init(
         ));
     }
 
+    if args.mode == BondMode::Balance || args.mode == BondMode::AutoNeg {
+        dev.set_xmit_policy(args.xmit_policy)
+            .expect(&format!("fail to set transmit policy: port={}", bonded_port_id));
+    }
+
+    // the LACP frames are steered to an extra queue of each slave, out of the data path bursts
+    if args.dedicated_queues {
+        dev.enable_dedicated_queues()
+            .expect(&format!("fail to enable dedicated queues: port={}", bonded_port_id));
+    }
+
     // Start device
     dev.start()
         .expect(&format!("fail to start device: port={}", bonded_port_id));
@@ -168,11 +212,13 @@ fn lcore_main(app_conf: Option<&AppConfig>) -> i32 {
 
     let app_conf = app_conf.unwrap();
     let dev = app_conf.bonded_port_id;
-    let mut pkts: [Option<mbuf::MBuf>; MAX_PKT_BURST] = unsafe { mem::zeroed() };
+    let queue_id = app_conf.queue_of(lcore::current().unwrap());
+    let mut pkts = mbuf::MbufBurst::<MAX_PKT_BURST>::new();
+    let mut replies = mbuf::MbufBurst::<MAX_PKT_BURST>::new();
     let bond_ip = u32::from(app_conf.bond_ip).to_be();
 
     while app_conf.lcore_main_is_running.load(Ordering::Relaxed) {
-        let rx_cnt = dev.rx_burst(0, &mut pkts[..]);
+        let rx_cnt = dev.rx_burst(queue_id, &mut pkts);
 
         // If didn't receive any packets, wait and go to next iteration
         if rx_cnt == 0 {
@@ -181,76 +227,82 @@ fn lcore_main(app_conf: Option<&AppConfig>) -> i32 {
             continue;
         }
 
-        debug!("received {} packets from bonded port {}", rx_cnt, dev.portid());
+        debug!(
+            "received {} packets from bonded port {} queue {}",
+            rx_cnt,
+            dev.portid(),
+            queue_id
+        );
 
         app_conf.port_packets[0].fetch_add(rx_cnt, Ordering::Relaxed);
 
         // Search incoming data for ARP packets and prepare response
-        for pkt in pkts.into_iter().take(rx_cnt) {
-            if let Some(m) = pkt {
-                let mut p = m.mtod::<ether::EtherHdr>();
-                let ether_hdr = unsafe { p.as_mut() };
-                let (next_hdr, next_proto) = strip_vlan_hdr(ether_hdr);
-
-                match next_proto {
-                    ether::ETHER_TYPE_ARP_BE => {
-                        app_conf.port_packets[1].fetch_add(1, Ordering::Relaxed);
-
-                        if let Some(mut arp_hdr) = (next_hdr as *mut arp::ArpHdr).as_mut_ref() {
-                            if arp_hdr.arp_data.arp_tip == bond_ip {
-                                debug!(
-                                    "received ARP {:x} packet from {}",
-                                    arp_hdr.arp_opcode.to_le(),
-                                    ether::EtherAddr::from(arp_hdr.arp_data.arp_sha)
+        for m in pkts.drain() {
+            let mut p = m.mtod::<ether::EtherHdr>();
+            let ether_hdr = unsafe { p.as_mut() };
+            let (next_hdr, next_proto) = strip_vlan_hdr(ether_hdr);
+
+            match next_proto {
+                ether::ETHER_TYPE_ARP_BE => {
+                    app_conf.port_packets[1].fetch_add(1, Ordering::Relaxed);
+
+                    if let Some(mut arp_hdr) = (next_hdr as *mut arp::ArpHdr).as_mut_ref() {
+                        if arp_hdr.arp_data.arp_tip == bond_ip {
+                            debug!(
+                                "received ARP {:x} packet from {}",
+                                arp_hdr.arp_opcode.to_le(),
+                                ether::EtherAddr::from(arp_hdr.arp_data.arp_sha)
+                            );
+
+                            if arp_hdr.arp_opcode == (RTE_ARP_OP_REQUEST as u16).to_be() {
+                                arp_hdr.arp_opcode = (RTE_ARP_OP_REPLY as u16).to_be();
+
+                                ether::EtherAddr::copy(&ether_hdr.s_addr.addr_bytes, &mut ether_hdr.d_addr.addr_bytes);
+                                ether::EtherAddr::copy(&app_conf.bond_mac_addr, &mut ether_hdr.s_addr.addr_bytes);
+
+                                ether::EtherAddr::copy(
+                                    &arp_hdr.arp_data.arp_sha.addr_bytes,
+                                    &mut arp_hdr.arp_data.arp_tha.addr_bytes,
+                                );
+                                ether::EtherAddr::copy(
+                                    &app_conf.bond_mac_addr,
+                                    &mut arp_hdr.arp_data.arp_sha.addr_bytes,
                                 );
 
-                                if arp_hdr.arp_opcode == (RTE_ARP_OP_REQUEST as u16).to_be() {
-                                    arp_hdr.arp_opcode = (RTE_ARP_OP_REPLY as u16).to_be();
-
-                                    ether::EtherAddr::copy(
-                                        &ether_hdr.s_addr.addr_bytes,
-                                        &mut ether_hdr.d_addr.addr_bytes,
-                                    );
-                                    ether::EtherAddr::copy(&app_conf.bond_mac_addr, &mut ether_hdr.s_addr.addr_bytes);
-
-                                    ether::EtherAddr::copy(
-                                        &arp_hdr.arp_data.arp_sha.addr_bytes,
-                                        &mut arp_hdr.arp_data.arp_tha.addr_bytes,
-                                    );
-                                    ether::EtherAddr::copy(
-                                        &app_conf.bond_mac_addr,
-                                        &mut arp_hdr.arp_data.arp_sha.addr_bytes,
-                                    );
-
-                                    arp_hdr.arp_data.arp_tip = arp_hdr.arp_data.arp_sip;
-                                    arp_hdr.arp_data.arp_sip = bond_ip;
-
-                                    let _ = dev.tx_burst(0, &mut [m]);
-                                }
+                                arp_hdr.arp_data.arp_tip = arp_hdr.arp_data.arp_sip;
+                                arp_hdr.arp_data.arp_sip = bond_ip;
+
+                                let _ = replies.push(m);
                             }
                         }
                     }
-                    ether::ETHER_TYPE_IPV4_BE => {
-                        app_conf.port_packets[2].fetch_add(1, Ordering::Relaxed);
+                }
+                ether::ETHER_TYPE_IPV4_BE => {
+                    app_conf.port_packets[2].fetch_add(1, Ordering::Relaxed);
 
-                        if let Some(mut ipv4_hdr) = (next_hdr as *mut ip::Ipv4Hdr).as_mut_ref() {
-                            if ipv4_hdr.dst_addr == bond_ip {
-                                debug!("received IP packet from {}", net::Ipv4Addr::from(ipv4_hdr.src_addr));
+                    if let Some(mut ipv4_hdr) = (next_hdr as *mut ip::Ipv4Hdr).as_mut_ref() {
+                        if ipv4_hdr.dst_addr == bond_ip {
+                            debug!("received IP packet from {}", net::Ipv4Addr::from(ipv4_hdr.src_addr));
 
-                                ether::EtherAddr::copy(&ether_hdr.s_addr.addr_bytes, &mut ether_hdr.d_addr.addr_bytes);
-                                ether::EtherAddr::copy(&app_conf.bond_mac_addr, &mut ether_hdr.s_addr.addr_bytes);
+                            ether::EtherAddr::copy(&ether_hdr.s_addr.addr_bytes, &mut ether_hdr.d_addr.addr_bytes);
+                            ether::EtherAddr::copy(&app_conf.bond_mac_addr, &mut ether_hdr.s_addr.addr_bytes);
 
-                                ipv4_hdr.dst_addr = ipv4_hdr.src_addr;
-                                ipv4_hdr.src_addr = bond_ip;
+                            ipv4_hdr.dst_addr = ipv4_hdr.src_addr;
+                            ipv4_hdr.src_addr = bond_ip;
 
-                                let _ = dev.tx_burst(0, &mut [m]);
-                            }
+                            let _ = replies.push(m);
                         }
                     }
-                    _ => {}
                 }
+                _ => {}
             }
         }
+
+        // Send the replies, the packets not sent are freed
+        if !replies.is_empty() {
+            dev.tx_burst(queue_id, &mut replies);
+            replies.clear();
+        }
     }
 
     debug!("BYE lcore_main");
@@ -301,7 +353,10 @@ impl CmdActionResult {
                 arp_hdr.arp_data.arp_sip = u32::from(app_conf.bond_ip).to_be();
                 arp_hdr.arp_data.arp_tip = u32::from(ip).to_be();
 
-                if app_conf.bonded_port_id.tx_burst(0, &mut [m]) == 1 {
+                let mut pkts = mbuf::MbufBurst::<1>::new();
+                let _ = pkts.push(m);
+
+                if app_conf.bonded_port_id.tx_burst(app_conf.cmdline_tx_queue(), &mut pkts) == 1 {
                     debug!("send ARP request to {}", ip);
                 }
             }
@@ -317,8 +372,8 @@ impl CmdActionResult {
 
         if app_conf.is_running() {
             cl.println(&format!(
-                "lcore_main already running on core: {}",
-                app_conf.lcore_main_core_id
+                "lcore_main already running on cores: {:?}",
+                app_conf.lcore_main_core_ids
             ))
             .unwrap();
         } else {
@@ -332,15 +387,18 @@ impl CmdActionResult {
 
         if !app_conf.is_running() {
             cl.println(&format!(
-                "lcore_main not running on core: {}",
-                app_conf.lcore_main_core_id
+                "lcore_main not running on cores: {:?}",
+                app_conf.lcore_main_core_ids
             ))
             .unwrap();
         } else {
             app_conf.stop();
 
-            cl.println(&format!("lcore_main stopped on core: {}", app_conf.lcore_main_core_id))
-                .unwrap();
+            cl.println(&format!(
+                "lcore_main stopped on cores: {:?}",
+                app_conf.lcore_main_core_ids
+            ))
+            .unwrap();
         }
     }
 
@@ -366,6 +424,15 @@ impl CmdActionResult {
                 .unwrap();
         }
 
+        if let Ok(mode) = dev.mode() {
+            cl.println(&format!("Mode: {}", mode as u8)).unwrap();
+
+            if mode == BondMode::Balance || mode == BondMode::AutoNeg {
+                cl.println(&format!("Transmit policy: {}", dev.xmit_policy().unwrap() as u8))
+                    .unwrap();
+            }
+        }
+
         cl.println(&format!(
             "Active_slaves: {}, packets received:Tot: {}, Arp: {}, IPv4: {}",
             active_slaves.len(),
@@ -378,7 +445,7 @@ impl CmdActionResult {
 
     fn help(&mut self, cl: &cmdline::CmdLine, _: Option<Rc<RefCell<AppConfig>>>) {
         cl.println(
-            r#"ALB - link bonding mode 6 example
+            r#"link bonding example
     send IP    - sends one ARPrequest thru bonding for IP.
     start      - starts listening ARPs.
     stop       - stops lcore_main.
@@ -447,19 +514,122 @@ fn prompt(app_conf: AppConfig) {
     let cmds = &[&cmd_send, &cmd_start, &cmd_stop, &cmd_show, &cmd_help, &cmd_quit];
 
     cmdline::new(cmds)
-        .open_stdin("bond6> ")
+        .open_stdin("bond> ")
         .expect("fail to open stdin")
         .interact();
 }
 
+// display usage
+fn print_usage(program: &String, opts: getopts::Options) -> ! {
+    let brief = format!("Usage: {} [EAL options] -- [options]", program);
+
+    print!("{}", opts.usage(&brief));
+
+    process::exit(-1);
+}
+
+// Parse the argument given in the command line of the application
+fn parse_args(args: &Vec<String>) -> Args {
+    let mut opts = getopts::Options::new();
+    let program = args[0].clone();
+
+    opts.optopt(
+        "m",
+        "mode",
+        "bonding mode, 0 to 6 (default is 6, adaptive load balancing)",
+        "MODE",
+    );
+    opts.optopt(
+        "x",
+        "xmit-policy",
+        "transmit hash policy of the balance and 802.3ad modes (l2 default)",
+        "l2|l23|l34",
+    );
+    opts.optflag(
+        "d",
+        "dedicated-queues",
+        "handle the LACP frames on dedicated queues of the slaves in 802.3ad mode",
+    );
+    opts.optflag("h", "help", "print this help menu");
+
+    let matches = match opts.parse(&args[1..]) {
+        Ok(m) => m,
+        Err(err) => {
+            println!("Invalid bond arguments, {}", err);
+
+            print_usage(&program, opts);
+        }
+    };
+
+    if matches.opt_present("h") {
+        print_usage(&program, opts);
+    }
+
+    let mut args = Args {
+        mode: BondMode::AdaptiveLB,
+        xmit_policy: TransmitPolicy::Layer2,
+        dedicated_queues: matches.opt_present("d"),
+    };
+
+    if let Some(arg) = matches.opt_str("m") {
+        match arg.parse::<u8>() {
+            Ok(mode) if mode <= ffi::BONDING_MODE_ALB as u8 => args.mode = BondMode::from(mode),
+            _ => {
+                println!("invalid bonding mode, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("x") {
+        args.xmit_policy = match arg.as_str() {
+            "l2" => TransmitPolicy::Layer2,
+            "l23" => TransmitPolicy::Layer23,
+            "l34" => TransmitPolicy::Layer34,
+            _ => {
+                println!("invalid transmit policy, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if args.dedicated_queues && args.mode != BondMode::AutoNeg {
+        println!("dedicated queues need the 802.3ad mode (4)");
+
+        print_usage(&program, opts);
+    }
+
+    args
+}
+
+fn prepare_args(args: &mut Vec<String>) -> (Vec<String>, Vec<String>) {
+    let program = String::from(Path::new(&args[0]).file_name().unwrap().to_str().unwrap());
+
+    if let Some(pos) = args.iter().position(|arg| arg == "--") {
+        let (eal_args, opt_args) = args.split_at_mut(pos);
+
+        opt_args[0] = program;
+
+        (eal_args.to_vec(), opt_args.to_vec())
+    } else {
+        (args[..1].to_vec(), args.clone())
+    }
+}
+
 // Main function, does initialisation and calls the per-lcore functions
 fn main() {
     pretty_env_logger::init();
 
-    let args: Vec<String> = env::args().collect();
+    let mut args: Vec<String> = env::args().collect();
+
+    let (eal_args, opt_args) = prepare_args(&mut args);
+
+    let args = parse_args(&opt_args);
 
     // init EAL
-    eal::init(&args).expect("Cannot init EAL");
+    eal::init(&eal_args).expect("Cannot init EAL");
 
     let stdout = cfile::stdout().unwrap();
 
@@ -486,7 +656,36 @@ fn main() {
     )
     .expect("fail to initial mbuf pool");
 
+    // check state of lcores
+    lcore::foreach_slave(|lcore_id| {
+        if lcore_id.state() != launch::State::Wait {
+            eal::exit(-libc::EBUSY, "lcores not ready");
+        }
+    });
+
+    // start lcore main on every core != master_core - ARP response threads
+    let mut slave_core_ids = vec![];
+
+    lcore::foreach_slave(|lcore_id| slave_core_ids.push(lcore_id));
+
+    if slave_core_ids.is_empty() {
+        eal::exit(-libc::EPERM, "missing slave core");
+    }
+
+    // a RX and TX queue per lcore, and a TX queue for the command line
+    let nb_rx_queues = slave_core_ids.len() as QueueId;
+    let nb_tx_queues = nb_rx_queues + 1;
+
+    // spread the flows over the RX queues of the lcores
     let port_conf = ethdev::EthConf {
+        rxmode: if nb_rx_queues > 1 {
+            Some(ethdev::EthRxMode {
+                mq_mode: ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_RSS,
+                ..Default::default()
+            })
+        } else {
+            None
+        },
         rx_adv_conf: Some(ethdev::RxAdvConf {
             rss_conf: Some(ethdev::EthRssConf {
                 key: None,
@@ -499,33 +698,26 @@ fn main() {
 
     // initialize all ports
     for portid in 0..nb_ports {
-        slave_port_init(portid, &port_conf, &mut pktmbuf_pool);
+        slave_port_init(portid, nb_rx_queues, nb_tx_queues, &port_conf, &mut pktmbuf_pool);
     }
 
-    let bonded_dev = bond_port_init(nb_ports, &port_conf, &mut pktmbuf_pool);
-
-    // check state of lcores
-    lcore::foreach_slave(|lcore_id| {
-        if lcore_id.state() != launch::State::Wait {
-            eal::exit(-libc::EBUSY, "lcores not ready");
-        }
-    });
-
-    // start lcore main on core != master_core - ARP response thread
-    let slave_core_id = lcore::current().unwrap().next().unwrap();
-
-    if slave_core_id == 0 || slave_core_id >= RTE_MAX_LCORE {
-        eal::exit(-libc::EPERM, "missing slave core");
-    }
+    let bonded_dev = bond_port_init(
+        nb_ports,
+        nb_rx_queues,
+        nb_tx_queues,
+        &args,
+        &port_conf,
+        &mut pktmbuf_pool,
+    );
 
     let app_conf = AppConfig {
         bond_ip: net::Ipv4Addr::new(10, 0, 0, 7),
         bond_mac_addr: bonded_dev.mac_addr(),
         bonded_port_id: bonded_dev.portid(),
-        lcore_main_is_running: AtomicBool::new(true),
-        lcore_main_core_id: slave_core_id,
+        lcore_main_is_running: AtomicBool::new(false),
+        lcore_main_core_ids: slave_core_ids,
         pktmbuf_pool,
-        ..AppConfig::default()
+        port_packets: Default::default(),
     };
 
     app_conf.start();
@@ -0,0 +1,13 @@
+#ifndef _LCORE_STATS_H_
+#define _LCORE_STATS_H_
+
+/*
+ * Counters written by a single lcore and read by the others.
+ *
+ * The single writer doesn't need a locked read-modify-write, a relaxed
+ * load/store pair is enough to keep the counters tear-free for the readers.
+ */
+#define LCORE_STATS_ADD(counter, n) \
+    __atomic_store_n(&(counter), (counter) + (n), __ATOMIC_RELAXED)
+
+#endif /* _LCORE_STATS_H_ */
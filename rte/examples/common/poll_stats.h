@@ -0,0 +1,95 @@
+#ifndef _POLL_STATS_H_
+#define _POLL_STATS_H_
+
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_lcore.h>
+
+#include "lcore_stats.h"
+
+/*
+ * Cycle accounting of the poll loops, compiled in with the `poll-stats`
+ * feature of the rte crate, which defines RTE_POLL_STATS.
+ *
+ * Each lcore writes its own slot of the Rust `poll_stats` module with
+ * LCORE_STATS_ADD. Without RTE_POLL_STATS, the POLL_STATS() statements
+ * compile out.
+ */
+#ifdef RTE_POLL_STATS
+
+#define POLL_STATS_BURST_BUCKETS 16
+#define POLL_STATS_CYCLE_BUCKETS 32
+
+/* Mirror of `PollStats` in rte/src/common/poll_stats.rs */
+struct poll_stats
+{
+    uint64_t polls;
+    uint64_t empty_polls;
+    uint64_t packets;
+    uint64_t rx_cycles;
+    uint64_t empty_cycles;
+    uint64_t proc_cycles;
+    uint64_t tx_cycles;
+    uint64_t burst_sizes[POLL_STATS_BURST_BUCKETS];
+    uint64_t burst_cycles[POLL_STATS_CYCLE_BUCKETS];
+} __rte_cache_aligned;
+
+/* The slot of an lcore, exported by the rte crate */
+extern struct poll_stats *_rte_poll_stats(unsigned lcore_id);
+
+#define POLL_STATS(stmt) stmt
+
+#define POLL_STATS_ADD(counter, n) LCORE_STATS_ADD(counter, n)
+
+/* The log2 bucket of a value */
+static inline unsigned
+poll_stats_bucket(uint64_t v, unsigned buckets)
+{
+    unsigned b = v ? 64 - __builtin_clzll(v) : 0;
+
+    return RTE_MIN(b, buckets - 1);
+}
+
+/* Account a RX poll which returned nb_rx packets in cycles */
+static inline void
+poll_stats_rx(struct poll_stats *s, unsigned nb_rx, uint64_t cycles)
+{
+    POLL_STATS_ADD(s->polls, 1);
+    POLL_STATS_ADD(s->burst_sizes[poll_stats_bucket(nb_rx, POLL_STATS_BURST_BUCKETS)], 1);
+
+    if (nb_rx == 0)
+    {
+        POLL_STATS_ADD(s->empty_polls, 1);
+        POLL_STATS_ADD(s->empty_cycles, cycles);
+    }
+    else
+    {
+        POLL_STATS_ADD(s->packets, nb_rx);
+        POLL_STATS_ADD(s->rx_cycles, cycles);
+    }
+}
+
+/* Account the processing of a burst in cycles, and the burst_cycles to receive and process it */
+static inline void
+poll_stats_proc(struct poll_stats *s, uint64_t cycles, uint64_t burst_cycles)
+{
+    POLL_STATS_ADD(s->proc_cycles, cycles);
+    POLL_STATS_ADD(s->burst_cycles[poll_stats_bucket(burst_cycles, POLL_STATS_CYCLE_BUCKETS)], 1);
+}
+
+/* Account a flush of the TX buffers in cycles */
+static inline void
+poll_stats_tx(struct poll_stats *s, uint64_t cycles)
+{
+    POLL_STATS_ADD(s->tx_cycles, cycles);
+}
+
+#else
+
+#define POLL_STATS(stmt)
+
+#endif /* RTE_POLL_STATS */
+
+#endif /* _POLL_STATS_H_ */
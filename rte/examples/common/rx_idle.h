@@ -0,0 +1,133 @@
+#ifndef _RX_IDLE_H_
+#define _RX_IDLE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <rte_common.h>
+#include <rte_cycles.h>
+#include <rte_pause.h>
+#include <rte_log.h>
+#include <rte_lcore.h>
+#include <rte_interrupts.h>
+#include <rte_ethdev.h>
+
+#define RX_IDLE_MAX_QUEUE 16
+
+/*
+ * Idle back-off policy of a polling lcore, disabled when pause_polls is 0.
+ *
+ * After pause_polls consecutive empty polls the lcore pauses between polls,
+ * after sleep_us without any packet it sleeps until a RX interrupt of one of
+ * its queues fires, or for at most timeout_ms, and stays in that state until
+ * a poll returns packets again.
+ */
+struct rx_idle_conf
+{
+    uint32_t pause_polls;
+    uint32_t sleep_us;
+    uint32_t timeout_ms;
+};
+
+struct rx_idle
+{
+    const struct rx_idle_conf *conf;
+    uint64_t sleep_tsc;
+    uint64_t idle_tsc;
+    uint32_t empty_polls;
+    int intr; /* all the queues wake up the per-thread epoll instance */
+    unsigned n_queue;
+    struct
+    {
+        uint16_t port_id;
+        uint16_t queue_id;
+    } queues[RX_IDLE_MAX_QUEUE];
+};
+
+static inline void
+rx_idle_init(struct rx_idle *idle, const struct rx_idle_conf *conf)
+{
+    memset(idle, 0, sizeof(*idle));
+
+    idle->conf = conf;
+    idle->sleep_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * conf->sleep_us;
+    idle->intr = 1;
+}
+
+/*
+ * Register the RX interrupt of a queue in the epoll instance of the calling
+ * lcore, the lcore naps instead if any of its queues has no RX interrupt.
+ */
+static inline void
+rx_idle_add_queue(struct rx_idle *idle, uint16_t port_id, uint16_t queue_id)
+{
+    int ret;
+
+    if (idle->conf->pause_polls == 0)
+        return;
+
+    if (idle->n_queue == RX_IDLE_MAX_QUEUE)
+    {
+        idle->intr = 0;
+        return;
+    }
+
+    ret = rte_eth_dev_rx_intr_ctl_q(port_id, queue_id, RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_ADD, NULL);
+    if (ret != 0)
+    {
+        RTE_LOG(INFO, USER1, "lcore %u: no RX interrupt on port %u queue %u (%d), napping when idle\n",
+                rte_lcore_id(), port_id, queue_id, ret);
+        idle->intr = 0;
+    }
+
+    idle->queues[idle->n_queue].port_id = port_id;
+    idle->queues[idle->n_queue].queue_id = queue_id;
+    idle->n_queue++;
+}
+
+static inline void
+rx_idle_sleep(struct rx_idle *idle)
+{
+    struct rte_epoll_event events[RX_IDLE_MAX_QUEUE];
+    unsigned i;
+
+    if (!idle->intr || idle->n_queue == 0)
+    {
+        rte_delay_us_sleep(idle->conf->sleep_us);
+        return;
+    }
+
+    for (i = 0; i < idle->n_queue; i++)
+        rte_eth_dev_rx_intr_enable(idle->queues[i].port_id, idle->queues[i].queue_id);
+
+    rte_epoll_wait(RTE_EPOLL_PER_THREAD, events, idle->n_queue, idle->conf->timeout_ms);
+
+    for (i = 0; i < idle->n_queue; i++)
+        rte_eth_dev_rx_intr_disable(idle->queues[i].port_id, idle->queues[i].queue_id);
+}
+
+/* Account a poll of all the queues of the lcore, which returned nb_rx packets */
+static inline void
+rx_idle_update(struct rx_idle *idle, unsigned nb_rx)
+{
+    if (likely(nb_rx > 0 || idle->conf->pause_polls == 0))
+    {
+        idle->empty_polls = 0;
+        return;
+    }
+
+    if (idle->empty_polls < idle->conf->pause_polls)
+    {
+        if (++idle->empty_polls < idle->conf->pause_polls)
+            return;
+
+        idle->idle_tsc = rte_rdtsc();
+    }
+
+    if (rte_rdtsc() - idle->idle_tsc < idle->sleep_tsc)
+        rte_pause();
+    else
+        rx_idle_sleep(idle);
+}
+
+#endif /* _RX_IDLE_H_ */
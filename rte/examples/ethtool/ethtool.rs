@@ -11,8 +11,7 @@ pub const MAX_PORTS: u16 = RTE_MAX_ETHPORTS as u16;
 pub const MAX_BURST_LENGTH: usize = 32;
 
 pub struct TxQueuePort {
-    pub cnt_unsent: usize,
-    pub buf_frames: [Option<mbuf::MBuf>; MAX_BURST_LENGTH],
+    pub buf_frames: mbuf::MbufBurst<MAX_BURST_LENGTH>,
 }
 
 pub struct AppPort {
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <rte_config.h>
 #include <rte_common.h>
@@ -12,6 +13,9 @@
 #include <rte_mbuf.h>
 #include <rte_kni.h>
 
+#include "rx_idle.h"
+#include "lcore_stats.h"
+
 /* Macros for printing using RTE_LOG */
 #define RTE_LOGTYPE_APP RTE_LOGTYPE_USER1
 
@@ -23,6 +27,8 @@
 
 #define KNI_MAX_KTHREAD 32
 
+#define KNI_REQ_PERIOD_MS 10 /* handle the KNI requests every ~10ms */
+
 /*
  * Structure of port parameters
  */
@@ -55,14 +61,70 @@ struct kni_interface_stats
     uint64_t tx_dropped;
 };
 
-/* kni device statistics array */
-struct kni_interface_stats kni_stats[RTE_MAX_ETHPORTS];
+/*
+ * Per-lcore shard of the kni device statistics, so the RX and TX lcores
+ * of a port never write to the same cache line.
+ */
+struct kni_lcore_stats
+{
+    struct kni_interface_stats port[RTE_MAX_ETHPORTS];
+} __rte_cache_aligned;
+
+static struct kni_lcore_stats kni_lcore_stats[RTE_MAX_LCORE];
+
+/* Totals at the last reset, the datapath counters themselves are never cleared */
+static struct kni_interface_stats kni_stats_base[RTE_MAX_ETHPORTS];
+
+static void
+kni_port_stats_total(uint16_t port_id, struct kni_interface_stats *stats)
+{
+    const struct kni_interface_stats *shard;
+    unsigned lcore_id;
+
+    memset(stats, 0, sizeof(*stats));
+
+    RTE_LCORE_FOREACH(lcore_id)
+    {
+        shard = &kni_lcore_stats[lcore_id].port[port_id];
+
+        stats->rx_packets += __atomic_load_n(&shard->rx_packets, __ATOMIC_RELAXED);
+        stats->rx_dropped += __atomic_load_n(&shard->rx_dropped, __ATOMIC_RELAXED);
+        stats->tx_packets += __atomic_load_n(&shard->tx_packets, __ATOMIC_RELAXED);
+        stats->tx_dropped += __atomic_load_n(&shard->tx_dropped, __ATOMIC_RELAXED);
+    }
+}
+
+/* Aggregate the statistics of a port over all the lcores since the last reset */
+void kni_port_stats(uint16_t port_id, struct kni_interface_stats *stats)
+{
+    const struct kni_interface_stats *base = &kni_stats_base[port_id];
+
+    kni_port_stats_total(port_id, stats);
+
+    stats->rx_packets -= base->rx_packets;
+    stats->rx_dropped -= base->rx_dropped;
+    stats->tx_packets -= base->tx_packets;
+    stats->tx_dropped -= base->tx_dropped;
+}
+
+/* Reset the statistics of all the ports without touching the datapath counters */
+void kni_reset_stats(void)
+{
+    uint16_t i;
+
+    for (i = 0; i < RTE_MAX_ETHPORTS; i++)
+        kni_port_stats_total(i, &kni_stats_base[i]);
+}
 
 int kni_stop = 0;
 
+/* idle back-off of the RX and TX lcores, disabled by default */
+struct rx_idle_conf kni_idle_conf = {0, 300, 10};
+
 /* Print out statistics on packets handled */
 void kni_print_stats(void)
 {
+    struct kni_interface_stats stats;
     uint8_t i;
 
     printf("\n**KNI example application statistics**\n"
@@ -74,15 +136,17 @@ void kni_print_stats(void)
         if (!kni_port_params_array[i])
             continue;
 
+        kni_port_stats(i, &stats);
+
         printf("%7d %10u/%2u %13" PRIu64 " %13" PRIu64 " %13" PRIu64 " "
                "%13" PRIu64 "\n",
                i,
                kni_port_params_array[i]->lcore_rx,
                kni_port_params_array[i]->lcore_tx,
-               kni_stats[i].rx_packets,
-               kni_stats[i].rx_dropped,
-               kni_stats[i].tx_packets,
-               kni_stats[i].tx_dropped);
+               stats.rx_packets,
+               stats.rx_dropped,
+               stats.tx_packets,
+               stats.tx_dropped);
     }
     printf("======  ==============  ============  ============  ============  ============\n");
 }
@@ -95,35 +159,63 @@ kni_burst_free_mbufs(struct rte_mbuf **pkts, unsigned num)
     if (pkts == NULL)
         return;
 
+    /* one put per run of mbufs from the same mempool */
+    rte_pktmbuf_free_bulk(pkts, num);
+
     for (i = 0; i < num; i++)
-    {
-        rte_pktmbuf_free(pkts[i]);
         pkts[i] = NULL;
-    }
 }
 
 /**
  * Interface to burst rx and enqueue mbufs into rx_q
+ *
+ * Each KNI device of a port owns the RX queue of the same index,
+ * the flows are spread over them by RSS.
  */
 int kni_ingress(struct kni_port_params *p)
 {
     uint8_t i, port_id;
-    unsigned nb_rx, num;
+    unsigned nb_rx, nb_rx_total, num;
     uint32_t nb_kni;
     struct rte_mbuf *pkts_burst[PKT_BURST_SZ];
+    struct kni_interface_stats *stats;
+    struct rx_idle idle;
+    const uint64_t req_tsc = (rte_get_tsc_hz() + MS_PER_S - 1) / MS_PER_S * KNI_REQ_PERIOD_MS;
+    uint64_t prev_req_tsc = 0, cur_tsc;
 
     if (p == NULL)
         return 0;
 
+    stats = &kni_lcore_stats[rte_lcore_id()].port[p->port_id];
+
     nb_kni = p->nb_kni;
     port_id = p->port_id;
 
+    rx_idle_init(&idle, &kni_idle_conf);
+
+    for (i = 0; i < nb_kni; i++)
+        rx_idle_add_queue(&idle, port_id, i);
+
     while (!kni_stop)
     {
+        /* the requests from the kernel, MTU or link changes, are rare */
+        cur_tsc = rte_rdtsc();
+
+        if (unlikely(cur_tsc - prev_req_tsc > req_tsc))
+        {
+            for (i = 0; i < nb_kni; i++)
+                rte_kni_handle_request(p->kni[i]);
+
+            prev_req_tsc = cur_tsc;
+        }
+
+        nb_rx_total = 0;
+
         for (i = 0; i < nb_kni; i++)
         {
             /* Burst rx from eth */
-            nb_rx = rte_eth_rx_burst(port_id, 0, pkts_burst, PKT_BURST_SZ);
+            nb_rx = rte_eth_rx_burst(port_id, i, pkts_burst, PKT_BURST_SZ);
+            nb_rx_total += nb_rx;
             if (unlikely(nb_rx > PKT_BURST_SZ))
             {
                 RTE_LOG(ERR, APP, "Error receiving from eth\n");
@@ -131,16 +223,17 @@ int kni_ingress(struct kni_port_params *p)
             }
             /* Burst tx to kni */
             num = rte_kni_tx_burst(p->kni[i], pkts_burst, nb_rx);
-            kni_stats[port_id].rx_packets += num;
+            LCORE_STATS_ADD(stats->rx_packets, num);
 
-            rte_kni_handle_request(p->kni[i]);
             if (unlikely(num < nb_rx))
             {
                 /* Free mbufs not tx to kni interface */
                 kni_burst_free_mbufs(&pkts_burst[num], nb_rx - num);
-                kni_stats[port_id].rx_dropped += nb_rx - num;
+                LCORE_STATS_ADD(stats->rx_dropped, nb_rx - num);
             }
         }
+
+        rx_idle_update(&idle, nb_rx_total);
     }
 
     return 0;
@@ -148,41 +241,55 @@ int kni_ingress(struct kni_port_params *p)
 
 /**
  * Interface to dequeue mbufs from tx_q and burst tx
+ *
+ * Each KNI device of a port owns the TX queue of the same index.
  */
 int kni_egress(struct kni_port_params *p)
 {
     uint8_t i, port_id;
-    unsigned nb_tx, num;
+    unsigned nb_tx, num, num_total;
     uint32_t nb_kni;
     struct rte_mbuf *pkts_burst[PKT_BURST_SZ];
+    struct kni_interface_stats *stats;
+    struct rx_idle idle;
 
     if (p == NULL)
         return -1;
 
+    stats = &kni_lcore_stats[rte_lcore_id()].port[p->port_id];
+
     nb_kni = p->nb_kni;
     port_id = p->port_id;
 
+    /* the KNI queues have no interrupt, the lcore naps when idle */
+    rx_idle_init(&idle, &kni_idle_conf);
+
     while (!kni_stop)
     {
+        num_total = 0;
+
         for (i = 0; i < nb_kni; i++)
         {
             /* Burst rx from kni */
             num = rte_kni_rx_burst(p->kni[i], pkts_burst, PKT_BURST_SZ);
+            num_total += num;
             if (unlikely(num > PKT_BURST_SZ))
             {
                 RTE_LOG(ERR, APP, "Error receiving from KNI\n");
                 return -1;
             }
             /* Burst tx to eth */
-            nb_tx = rte_eth_tx_burst(port_id, 0, pkts_burst, (uint16_t)num);
-            kni_stats[port_id].tx_packets += nb_tx;
+            nb_tx = rte_eth_tx_burst(port_id, i, pkts_burst, (uint16_t)num);
+            LCORE_STATS_ADD(stats->tx_packets, nb_tx);
             if (unlikely(nb_tx < num))
             {
                 /* Free mbufs not tx to NIC */
                 kni_burst_free_mbufs(&pkts_burst[nb_tx], num - nb_tx);
-                kni_stats[port_id].tx_dropped += num - nb_tx;
+                LCORE_STATS_ADD(stats->tx_dropped, num - nb_tx);
             }
         }
+
+        rx_idle_update(&idle, num_total);
     }
 
     return 0;
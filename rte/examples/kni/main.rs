@@ -23,7 +23,7 @@ use std::str::FromStr;
 use anyhow::Result;
 use nix::sys::signal;
 
-use rte::ethdev::EthDevice;
+use rte::ethdev::{EthDevice, EthDeviceInfo};
 use rte::ffi::{RTE_ETHER_MAX_LEN, RTE_MAX_ETHPORTS, RTE_PKTMBUF_HEADROOM};
 use rte::lcore::RTE_MAX_LCORE;
 use rte::*;
@@ -59,6 +59,10 @@ const KNI_ENET_FCS_SIZE: u32 = 4;
 
 const KNI_MAX_KTHREAD: usize = 32;
 
+// Idle time before an idle lcore sleeps, and the longest sleep
+const IDLE_SLEEP_US: u32 = 300;
+const IDLE_TIMEOUT_MS: u32 = 10;
+
 #[repr(C)]
 #[derive(Clone, Debug)]
 struct kni_port_params {
@@ -85,6 +89,8 @@ struct Conf {
     promiscuous_on: bool,
 
     port_params: [Option<kni_port_params>; RTE_MAX_ETHPORTS as usize],
+
+    idle_conf: RxIdleConf,
 }
 
 impl fmt::Debug for Conf {
@@ -165,7 +171,7 @@ extern "C" fn handle_sigint(sig: libc::c_int) {
         // When we receive a USR2 signal, reset stats
         signal::SIGUSR2 => {
             unsafe {
-                kni_stats = mem::zeroed();
+                kni_reset_stats();
             }
 
             println!("**Statistics have been reset**");
@@ -230,6 +236,18 @@ fn parse_args(args: &Vec<String>) -> result::Result<Conf, String> {
     opts.optflag("h", "help", "print this help menu");
     opts.optopt("p", "", "hexadecimal bitmask of ports to configure", "PORTMASK");
     opts.optflag("P", "", "enable promiscuous mode");
+    opts.optopt(
+        "",
+        "idle-polls",
+        "pause after N consecutive empty polls, then sleep (0 to disable, default)",
+        "N",
+    );
+    opts.optopt(
+        "",
+        "idle-sleep-us",
+        "sleep after US microseconds without traffic (300 default)",
+        "US",
+    );
     opts.optmulti(
         "c",
         "config",
@@ -265,6 +283,34 @@ fn parse_args(args: &Vec<String>) -> result::Result<Conf, String> {
 
     conf.promiscuous_on = matches.opt_present("P");
 
+    conf.idle_conf = RxIdleConf {
+        pause_polls: 0,
+        sleep_us: IDLE_SLEEP_US,
+        timeout_ms: IDLE_TIMEOUT_MS,
+    };
+
+    if let Some(arg) = matches.opt_str("idle-polls") {
+        match u32::from_str(arg.as_str()) {
+            Ok(n) => conf.idle_conf.pause_polls = n,
+            _ => {
+                println!("invalid empty poll threshold, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("idle-sleep-us") {
+        match u32::from_str(arg.as_str()) {
+            Ok(us) => conf.idle_conf.sleep_us = us,
+            _ => {
+                println!("invalid idle sleep delay, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
     for arg in matches.opt_strs("c") {
         try!(conf.parse_config(&arg));
     }
@@ -286,23 +332,76 @@ fn init_kni(conf: &Conf) -> Result<()> {
     kni::init(num_of_kni_ports as usize)
 }
 
+// The port configuration, with RSS spreading the flows over the queues of the KNI devices
+fn kni_port_conf(dev: ethdev::PortId, nb_queues: u16) -> ethdev::EthConf {
+    let mut port_conf = ethdev::EthConf {
+        intr_conf: rx_intr_conf(),
+        ..Default::default()
+    };
+
+    if nb_queues > 1 {
+        let rss_hf =
+            (ethdev::RssHashFunc::ETH_RSS_IP | ethdev::RssHashFunc::ETH_RSS_TCP | ethdev::RssHashFunc::ETH_RSS_UDP)
+                & dev.info().rss_offloads();
+
+        if rss_hf.is_empty() {
+            warn!("port {} can't hash IP/TCP/UDP flows, RSS is disabled.", dev.portid());
+        }
+
+        port_conf.rxmode = Some(ethdev::EthRxMode {
+            mq_mode: if rss_hf.is_empty() {
+                ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_NONE
+            } else {
+                ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_RSS
+            },
+            ..Default::default()
+        });
+        port_conf.rx_adv_conf = Some(ethdev::RxAdvConf {
+            rss_conf: Some(ethdev::EthRssConf {
+                key: None,
+                hash: rss_hf,
+            }),
+            ..Default::default()
+        });
+    }
+
+    port_conf
+}
+
 // Initialise a single port on an Ethernet device
-fn init_port(conf: &Conf, dev: ethdev::PortId, port_conf: &ethdev::EthConf, pktmbuf_pool: &mut mempool::MemoryPool) {
+fn init_port(conf: &Conf, dev: ethdev::PortId, pktmbuf_pool: &mut mempool::MemoryPool) {
     let portid = dev.portid();
 
+    // one RX/TX queue pair for each KNI device of the port
+    let nb_queues = conf.port_params[portid as usize]
+        .as_ref()
+        .map_or(1, |param| cmp::max(param.nb_lcore_k, 1)) as u16;
+
     // Initialise device and RX/TX queues
-    info!("Initialising port {} ...", portid);
+    info!("Initialising port {} with {} queues ...", portid, nb_queues);
+
+    let info = dev.info();
+
+    if nb_queues > info.max_rx_queues || nb_queues > info.max_tx_queues {
+        eal::exit(
+            EXIT_FAILURE,
+            &format!(
+                "port {} supports at most {} RX and {} TX queues\n",
+                portid, info.max_rx_queues, info.max_tx_queues
+            ),
+        );
+    }
 
-    dev.configure(1, 1, &port_conf)
+    dev.configure(nb_queues, nb_queues, &kni_port_conf(dev, nb_queues))
         .expect(&format!("fail to configure device: port={}", portid));
 
-    // init one RX queue
-    dev.rx_queue_setup(0, NB_RXD, None, pktmbuf_pool)
-        .expect(&format!("fail to setup device rx queue: port={}", portid));
+    for queue_id in 0..nb_queues {
+        dev.rx_queue_setup(queue_id, NB_RXD, None, pktmbuf_pool)
+            .expect(&format!("fail to setup device rx queue: port={}", portid));
 
-    // init one TX queue on each port
-    dev.tx_queue_setup(0, NB_TXD, None)
-        .expect(&format!("fail to setup device tx queue: port={}", portid));
+        dev.tx_queue_setup(queue_id, NB_TXD, None)
+            .expect(&format!("fail to setup device tx queue: port={}", portid));
+    }
 
     // Start device
     dev.start().expect(&format!("fail to start device: port={}", portid));
@@ -330,16 +429,17 @@ extern "C" fn kni_change_mtu(port_id: u16, new_mtu: libc::c_uint) -> libc::c_int
 
         dev.stop();
 
-        // Set new MTU
-        let mut port_conf = ethdev::EthConf::default();
+        // Set new MTU, keeping the queues of the KNI devices
+        let nb_queues = dev.info().nb_rx_queues;
+        let mut port_conf = kni_port_conf(dev, nb_queues);
 
-        let mut rxmode: ethdev::EthRxMode = Default::default();
+        let mut rxmode = port_conf.rxmode.unwrap_or_default();
 
         rxmode.max_rx_pkt_len = new_mtu + KNI_ENET_HEADER_SIZE + KNI_ENET_FCS_SIZE;
 
         port_conf.rxmode = Some(rxmode);
 
-        if let Err(err) = dev.configure(1, 1, &port_conf) {
+        if let Err(err) = dev.configure(nb_queues, nb_queues, &port_conf) {
             error!("Fail to reconfigure port {}, {}", port_id, err);
 
             if let Some(&RteError(errno)) = err.downcast_ref::<RteError>() {
@@ -527,6 +627,7 @@ fn check_all_ports_link_status(enabled_devices: &Vec<ethdev::PortId>) {
 }
 
 #[repr(C)]
+#[derive(Default)]
 struct Struct_kni_interface_stats {
     // number of pkts received from NIC, and sent to KNI
     rx_packets: libc::uint64_t,
@@ -541,13 +642,39 @@ struct Struct_kni_interface_stats {
     tx_dropped: libc::uint64_t,
 }
 
+// Mirror of `struct rx_idle_conf` in rx_idle.h
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct RxIdleConf {
+    pause_polls: u32,
+    sleep_us: u32,
+    timeout_ms: u32,
+}
+
+// The RX interrupts are needed by the RX lcores to sleep when idle
+fn rx_intr_conf() -> Option<ffi::rte_intr_conf> {
+    if unsafe { kni_idle_conf.pause_polls } > 0 {
+        let mut intr_conf = ffi::rte_intr_conf::default();
+
+        intr_conf.set_rxq(1);
+
+        Some(intr_conf)
+    } else {
+        None
+    }
+}
+
 #[link(name = "kni_core")]
 extern "C" {
     static mut kni_stop: libc::c_int;
 
+    static mut kni_idle_conf: RxIdleConf;
+
     static mut kni_port_params_array: *const *mut kni_port_params;
 
-    static mut kni_stats: [Struct_kni_interface_stats; RTE_MAX_ETHPORTS as usize];
+    fn kni_port_stats(port_id: u16, stats: *mut Struct_kni_interface_stats);
+
+    fn kni_reset_stats();
 
     fn kni_print_stats();
 
@@ -617,6 +744,7 @@ fn main() {
 
     unsafe {
         kni_port_params_array = conf.port_params.as_ptr() as *const _;
+        kni_idle_conf = conf.idle_conf;
     }
 
     // create the mbuf pool
@@ -642,10 +770,8 @@ fn main() {
     init_kni(&conf).expect("initial KNI");
 
     // Initialise each port
-    let port_conf = ethdev::EthConf::default();
-
     for dev in &enabled_devices {
-        init_port(&conf, dev.portid(), &port_conf, &mut pktmbuf_pool);
+        init_port(&conf, dev.portid(), &mut pktmbuf_pool);
 
         kni_alloc(&mut conf, dev.portid(), &mut pktmbuf_pool);
     }
@@ -657,6 +783,21 @@ fn main() {
 
     launch::mp_wait_lcore();
 
+    for dev in &enabled_devices {
+        let mut stats = Struct_kni_interface_stats::default();
+
+        unsafe { kni_port_stats(dev.portid(), &mut stats) };
+
+        info!(
+            "port {}: rx_packets {}, rx_dropped {}, tx_packets {}, tx_dropped {}",
+            dev.portid(),
+            stats.rx_packets,
+            stats.rx_dropped,
+            stats.tx_packets,
+            stats.tx_dropped
+        );
+    }
+
     // Release resources
     for dev in &enabled_devices {
         kni_free_kni(&conf, dev.portid());
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <net/ethernet.h>
 
@@ -11,9 +12,19 @@
 #include <rte_ether.h>
 #include <rte_ethdev.h>
 #include <rte_mbuf.h>
+#include <rte_vect.h>
+
+#include "rx_idle.h"
+#include "lcore_stats.h"
+#include "poll_stats.h"
 
 #define MAX_PKT_BURST 32
-#define BURST_TX_DRAIN_US 100 /* TX drain every ~100us */
+#define BURST_TX_DRAIN_US 100     /* TX drain at most every ~100us */
+#define BURST_TX_DRAIN_MIN_US 10  /* TX drain at least every ~10us */
+
+#define MAX_RX_QUEUE_PER_LCORE 16
+
+#define PREFETCH_OFFSET 4 /* prefetch the packets this far ahead of the MAC rewrite */
 
 int l2fwd_force_quit = 0;
 
@@ -26,7 +37,27 @@ struct ether_addr l2fwd_ports_eth_addr[RTE_MAX_ETHPORTS];
 /* list of enabled ports */
 uint32_t l2fwd_dst_ports[RTE_MAX_ETHPORTS];
 
-struct rte_eth_dev_tx_buffer *l2fwd_tx_buffers[RTE_MAX_ETHPORTS];
+/* RX queue of a port polled by a logical core */
+struct l2fwd_rx_queue
+{
+    uint16_t port_id;
+    uint16_t queue_id;
+};
+
+/*
+ * Per-lcore forwarding configuration.
+ *
+ * Every (port, queue) pair is polled by exactly one lcore, and every lcore
+ * owns a dedicated TX queue on all the ports, so the hot path never shares
+ * a queue or a TX buffer with another lcore.
+ */
+struct l2fwd_lcore_queue_conf
+{
+    unsigned n_rx_queue;
+    struct l2fwd_rx_queue rx_queue_list[MAX_RX_QUEUE_PER_LCORE];
+    uint16_t tx_queue_id;
+    struct rte_eth_dev_tx_buffer *tx_buffers[RTE_MAX_ETHPORTS];
+} __rte_cache_aligned;
 
 /* Per-port statistics struct */
 struct l2fwd_port_statistics
@@ -34,22 +65,57 @@ struct l2fwd_port_statistics
     uint64_t tx;
     uint64_t rx;
     uint64_t dropped;
+    uint64_t tx_bursts;
+};
+
+/* Per-lcore shard of the port statistics, summed up by l2fwd_port_stats() */
+struct l2fwd_lcore_statistics
+{
+    struct l2fwd_port_statistics port[RTE_MAX_ETHPORTS];
 } __rte_cache_aligned;
 
-struct l2fwd_port_statistics port_statistics[RTE_MAX_ETHPORTS];
+static struct l2fwd_lcore_statistics l2fwd_lcore_statistics[RTE_MAX_LCORE];
 
 int64_t l2fwd_timer_period; /* default period is 10 seconds */
 
+/* bounds of the adaptive TX drain interval */
+uint32_t l2fwd_drain_min_us = BURST_TX_DRAIN_MIN_US;
+uint32_t l2fwd_drain_max_us = BURST_TX_DRAIN_US;
+
+/* idle back-off of the forwarding lcores, disabled by default */
+struct rx_idle_conf l2fwd_idle_conf = {0, 300, 10};
+
+/* Aggregate the statistics of a port over all the lcores */
+void l2fwd_port_stats(unsigned portid, struct l2fwd_port_statistics *stats)
+{
+    const struct l2fwd_port_statistics *shard;
+    unsigned lcore_id;
+
+    memset(stats, 0, sizeof(*stats));
+
+    RTE_LCORE_FOREACH(lcore_id)
+    {
+        shard = &l2fwd_lcore_statistics[lcore_id].port[portid];
+
+        stats->tx += __atomic_load_n(&shard->tx, __ATOMIC_RELAXED);
+        stats->rx += __atomic_load_n(&shard->rx, __ATOMIC_RELAXED);
+        stats->dropped += __atomic_load_n(&shard->dropped, __ATOMIC_RELAXED);
+        stats->tx_bursts += __atomic_load_n(&shard->tx_bursts, __ATOMIC_RELAXED);
+    }
+}
+
 /* Print out statistics on packets dropped */
 static void
 print_stats(void)
 {
-    uint64_t total_packets_dropped, total_packets_tx, total_packets_rx;
+    uint64_t total_packets_dropped, total_packets_tx, total_packets_rx, total_tx_bursts;
+    struct l2fwd_port_statistics stats;
     unsigned portid;
 
     total_packets_dropped = 0;
     total_packets_tx = 0;
     total_packets_rx = 0;
+    total_tx_bursts = 0;
 
     const char clr[] = {27, '[', '2', 'J', '\0'};
     const char topLeft[] = {27, '[', '1', ';', '1', 'H', '\0'};
@@ -65,63 +131,185 @@ print_stats(void)
         if ((l2fwd_enabled_port_mask & (1 << portid)) == 0)
             continue;
 
+        l2fwd_port_stats(portid, &stats);
+
         printf("\nStatistics for port %u ------------------------------"
                "\nPackets sent: %24" PRIu64
                "\nPackets received: %20" PRIu64
-               "\nPackets dropped: %21" PRIu64,
+               "\nPackets dropped: %21" PRIu64
+               "\nTX bursts: %27" PRIu64
+               "\nPackets per TX burst: %16.1f",
                portid,
-               port_statistics[portid].tx,
-               port_statistics[portid].rx,
-               port_statistics[portid].dropped);
-
-        total_packets_dropped += port_statistics[portid].dropped;
-        total_packets_tx += port_statistics[portid].tx;
-        total_packets_rx += port_statistics[portid].rx;
+               stats.tx,
+               stats.rx,
+               stats.dropped,
+               stats.tx_bursts,
+               stats.tx_bursts ? (double)stats.tx / stats.tx_bursts : 0.0);
+
+        total_packets_dropped += stats.dropped;
+        total_packets_tx += stats.tx;
+        total_packets_rx += stats.rx;
+        total_tx_bursts += stats.tx_bursts;
     }
     printf("\nAggregate statistics ==============================="
            "\nTotal packets sent: %18" PRIu64
            "\nTotal packets received: %14" PRIu64
-           "\nTotal packets dropped: %15" PRIu64,
+           "\nTotal packets dropped: %15" PRIu64
+           "\nTotal TX bursts: %21" PRIu64
+           "\nTotal packets per TX burst: %10.1f",
            total_packets_tx,
            total_packets_rx,
-           total_packets_dropped);
+           total_packets_dropped,
+           total_tx_bursts,
+           total_tx_bursts ? (double)total_packets_tx / total_tx_bursts : 0.0);
     printf("\n====================================================\n");
 }
 
-static void
-l2fwd_simple_forward(struct rte_mbuf *m, unsigned portid)
+/*
+ * Ethernet header written into the packets forwarded to a destination port.
+ *
+ * The destination and the source MACs are the first 12 bytes of the packet,
+ * they are rewritten with a single 16-byte masked store that keeps the ether
+ * type and the next 2 bytes of the packet.
+ */
+struct l2fwd_mac_hdr
 {
-    struct rte_ether_hdr *eth;
-    void *tmp;
-    unsigned dst_port;
-    int sent;
-    struct rte_eth_dev_tx_buffer *buffer;
+    uint8_t bytes[16];
+} __rte_aligned(16);
 
-    dst_port = l2fwd_dst_ports[portid];
-    eth = rte_pktmbuf_mtod(m, struct ether_hdr *);
+static void
+l2fwd_mac_hdr_init(struct l2fwd_mac_hdr *hdr, unsigned dst_port)
+{
+    memset(hdr, 0, sizeof(*hdr));
 
     /* 02:00:00:00:00:xx */
-    tmp = &eth->d_addr.addr_bytes[0];
-    *((uint64_t *)tmp) = 0x000000000002 + ((uint64_t)dst_port << 40);
+    hdr->bytes[0] = 0x02;
+    hdr->bytes[5] = (uint8_t)dst_port;
 
     /* src addr */
-    rte_ether_addr_copy(&l2fwd_ports_eth_addr[dst_port], &eth->s_addr);
+    memcpy(&hdr->bytes[RTE_ETHER_ADDR_LEN], &l2fwd_ports_eth_addr[dst_port], RTE_ETHER_ADDR_LEN);
+}
+
+static inline void
+l2fwd_mac_rewrite(struct rte_mbuf *m, const struct l2fwd_mac_hdr *hdr)
+{
+    uint8_t *eth = rte_pktmbuf_mtod(m, uint8_t *);
+
+#if defined(__SSE2__)
+    const __m128i mask = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0);
+    __m128i data = _mm_loadu_si128((const __m128i *)eth);
+
+    data = _mm_or_si128(_mm_andnot_si128(mask, data), _mm_load_si128((const __m128i *)hdr->bytes));
+
+    _mm_storeu_si128((__m128i *)eth, data);
+#else
+    memcpy(eth, hdr->bytes, 2 * RTE_ETHER_ADDR_LEN);
+#endif
+}
+
+static void
+l2fwd_burst_forward(struct rte_mbuf **pkts, unsigned nb_rx, unsigned portid,
+                    const struct l2fwd_lcore_queue_conf *qconf, const struct l2fwd_mac_hdr *mac_hdrs,
+                    struct l2fwd_port_statistics *stats)
+{
+    unsigned dst_port = l2fwd_dst_ports[portid];
+    const struct l2fwd_mac_hdr *hdr = &mac_hdrs[dst_port];
+    struct rte_eth_dev_tx_buffer *buffer = qconf->tx_buffers[dst_port];
+    unsigned j, n, sent = 0, bursts = 0;
+
+    for (j = 0; j < PREFETCH_OFFSET && j < nb_rx; j++)
+        rte_prefetch0(rte_pktmbuf_mtod(pkts[j], void *));
+
+    for (j = 0; j + PREFETCH_OFFSET < nb_rx; j++)
+    {
+        rte_prefetch0(rte_pktmbuf_mtod(pkts[j + PREFETCH_OFFSET], void *));
+        l2fwd_mac_rewrite(pkts[j], hdr);
+    }
+
+    for (; j < nb_rx; j++)
+        l2fwd_mac_rewrite(pkts[j], hdr);
+
+    /* a full burst goes to the NIC right away, unless older packets are still buffered */
+    j = 0;
+    if (nb_rx == MAX_PKT_BURST && buffer->length == 0)
+    {
+        j = sent = rte_eth_tx_burst(dst_port, qconf->tx_queue_id, pkts, nb_rx);
+        bursts += sent > 0;
+    }
+
+    /* the other packets are buffered until the buffer is full or drained */
+    for (; j < nb_rx; j++)
+    {
+        n = rte_eth_tx_buffer(dst_port, qconf->tx_queue_id, buffer, pkts[j]);
+        sent += n;
+        bursts += n > 0;
+    }
 
-    buffer = l2fwd_tx_buffers[dst_port];
-    sent = rte_eth_tx_buffer(dst_port, 0, buffer, m);
     if (sent)
-        port_statistics[dst_port].tx += sent;
+    {
+        LCORE_STATS_ADD(stats[dst_port].tx, sent);
+        LCORE_STATS_ADD(stats[dst_port].tx_bursts, bursts);
+    }
 }
 
-int l2fwd_main_loop(uint32_t *rx_port_list, unsigned n_rx_port)
+/* Flush the TX buffers of all the destination ports of a lcore */
+static void
+l2fwd_drain(const struct l2fwd_lcore_queue_conf *qconf, struct l2fwd_port_statistics *stats)
+{
+    unsigned i, portid;
+    int sent;
+
+    for (i = 0; i < qconf->n_rx_queue; i++)
+    {
+        portid = l2fwd_dst_ports[qconf->rx_queue_list[i].port_id];
+
+        sent = rte_eth_tx_buffer_flush(portid, qconf->tx_queue_id, qconf->tx_buffers[portid]);
+        if (sent)
+        {
+            LCORE_STATS_ADD(stats[portid].tx, sent);
+            LCORE_STATS_ADD(stats[portid].tx_bursts, 1);
+        }
+    }
+}
+
+/*
+ * The TX buffers are drained on an adaptive interval, bounded by
+ * l2fwd_drain_min_us and l2fwd_drain_max_us.
+ *
+ * When the RX queues are idle, the buffered packets are sent right away since
+ * nothing will fill the buffers up. Otherwise the interval doubles when most
+ * of the RX bursts since the last drain were full, the buffers then fill and
+ * flush by themselves, and it halves when they were partial, to bound the
+ * latency of the packets waiting in the buffers.
+ */
+int l2fwd_main_loop(const struct l2fwd_lcore_queue_conf *qconf)
 {
     unsigned lcore_id = rte_lcore_id();
+    struct l2fwd_port_statistics *stats = l2fwd_lcore_statistics[lcore_id].port;
     uint64_t prev_tsc = 0, diff_tsc, cur_tsc, timer_tsc = 0;
-    const uint64_t drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S * BURST_TX_DRAIN_US;
-    unsigned portid, nb_rx;
-    struct rte_eth_dev_tx_buffer *buffer;
-    struct rte_mbuf *pkts_burst[MAX_PKT_BURST], *m;
-    int sent, i, j;
+    const uint64_t tsc_per_us = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S;
+    const uint64_t drain_min_tsc = tsc_per_us * l2fwd_drain_min_us;
+    const uint64_t drain_max_tsc = tsc_per_us * l2fwd_drain_max_us;
+    uint64_t drain_tsc = drain_max_tsc;
+    unsigned portid, queueid, nb_rx, nb_rx_total;
+    unsigned nb_bursts = 0, nb_full_bursts = 0, pending = 0;
+    struct rte_mbuf *pkts_burst[MAX_PKT_BURST];
+    struct l2fwd_mac_hdr mac_hdrs[RTE_MAX_ETHPORTS];
+    struct rx_idle idle;
+    int i;
+    POLL_STATS(struct poll_stats *pstats = _rte_poll_stats(lcore_id));
+    POLL_STATS(uint64_t rx_tsc);
+    POLL_STATS(uint64_t proc_tsc);
+
+    rx_idle_init(&idle, &l2fwd_idle_conf);
+
+    for (i = 0; i < (int)qconf->n_rx_queue; i++)
+    {
+        portid = l2fwd_dst_ports[qconf->rx_queue_list[i].port_id];
+        l2fwd_mac_hdr_init(&mac_hdrs[portid], portid);
+
+        rx_idle_add_queue(&idle, qconf->rx_queue_list[i].port_id, qconf->rx_queue_list[i].queue_id);
+    }
 
     while (!l2fwd_force_quit)
     {
@@ -134,16 +322,18 @@ int l2fwd_main_loop(uint32_t *rx_port_list, unsigned n_rx_port)
 
         if (unlikely(diff_tsc > drain_tsc))
         {
-            for (i = 0; i < (int)n_rx_port; i++)
-            {
+            l2fwd_drain(qconf, stats);
+            pending = 0;
+            POLL_STATS(poll_stats_tx(pstats, rte_rdtsc() - cur_tsc));
 
-                portid = l2fwd_dst_ports[rx_port_list[i]];
-                buffer = l2fwd_tx_buffers[portid];
+            /* adapt the drain interval to the bursts seen since the last drain */
+            if (nb_bursts && nb_full_bursts * 2 >= nb_bursts)
+                drain_tsc = RTE_MIN(RTE_MAX(drain_tsc * 2, tsc_per_us), drain_max_tsc);
+            else
+                drain_tsc = RTE_MAX(drain_tsc / 2, drain_min_tsc);
 
-                sent = rte_eth_tx_buffer_flush(portid, 0, buffer);
-                if (sent)
-                    port_statistics[portid].tx += sent;
-            }
+            nb_bursts = 0;
+            nb_full_bursts = 0;
 
             /* if timer is enabled */
             if (l2fwd_timer_period > 0)
@@ -172,21 +362,46 @@ int l2fwd_main_loop(uint32_t *rx_port_list, unsigned n_rx_port)
         /*
          * Read packet from RX queues
          */
-        for (i = 0; i < (int)n_rx_port; i++)
+        nb_rx_total = 0;
+
+        for (i = 0; i < (int)qconf->n_rx_queue; i++)
         {
 
-            portid = rx_port_list[i];
-            nb_rx = rte_eth_rx_burst((uint8_t)portid, 0, pkts_burst, MAX_PKT_BURST);
+            portid = qconf->rx_queue_list[i].port_id;
+            queueid = qconf->rx_queue_list[i].queue_id;
+            POLL_STATS(rx_tsc = rte_rdtsc());
+            nb_rx = rte_eth_rx_burst(portid, queueid, pkts_burst, MAX_PKT_BURST);
+            POLL_STATS(proc_tsc = rte_rdtsc());
+            POLL_STATS(poll_stats_rx(pstats, nb_rx, proc_tsc - rx_tsc));
 
-            port_statistics[portid].rx += nb_rx;
+            LCORE_STATS_ADD(stats[portid].rx, nb_rx);
 
-            for (j = 0; j < (int)nb_rx; j++)
+            if (nb_rx)
             {
-                m = pkts_burst[j];
-                rte_prefetch0(rte_pktmbuf_mtod(m, void *));
-                l2fwd_simple_forward(m, portid);
+                nb_rx_total += nb_rx;
+                nb_bursts++;
+                nb_full_bursts += nb_rx == MAX_PKT_BURST;
+
+                l2fwd_burst_forward(pkts_burst, nb_rx, portid, qconf, mac_hdrs, stats);
+                POLL_STATS(cur_tsc = rte_rdtsc());
+                POLL_STATS(poll_stats_proc(pstats, cur_tsc - proc_tsc, cur_tsc - rx_tsc));
             }
         }
+
+        if (nb_rx_total)
+        {
+            pending = 1;
+        }
+        else if (pending)
+        {
+            /* the RX queues are idle, don't keep the partial bursts waiting */
+            POLL_STATS(cur_tsc = rte_rdtsc());
+            l2fwd_drain(qconf, stats);
+            pending = 0;
+            POLL_STATS(poll_stats_tx(pstats, rte_rdtsc() - cur_tsc));
+        }
+
+        rx_idle_update(&idle, nb_rx_total);
     }
 
     return 0;
@@ -30,6 +30,15 @@ const MAX_PKT_BURST: usize = 32;
 
 const MAX_RX_QUEUE_PER_LCORE: u32 = 16;
 
+const MAX_RX_QUEUE_PER_PORT: u16 = 128;
+
+const BURST_TX_DRAIN_MIN_US: u32 = 10;
+const BURST_TX_DRAIN_MAX_US: u32 = 100;
+const MAX_BURST_TX_DRAIN_US: u32 = 100_000;
+
+const IDLE_SLEEP_US: u32 = 300;
+const IDLE_TIMEOUT_MS: u32 = 10;
+
 // A tsc-based timer responsible for triggering statistics printout
 const TIMER_MILLISECOND: i64 = 2000000; /* around 1ms at 2 Ghz */
 const MAX_TIMER_PERIOD: u32 = 86400; /* 1 day max */
@@ -41,9 +50,20 @@ const NB_MBUF: u32 = 2048;
 const RTE_TEST_RX_DESC_DEFAULT: u16 = 128;
 const RTE_TEST_TX_DESC_DEFAULT: u16 = 512;
 
+#[repr(C)]
+#[derive(Clone, Copy)]
+struct RxQueue {
+    port_id: u16,
+    queue_id: u16,
+}
+
+// Mirror of `struct l2fwd_lcore_queue_conf` in l2fwd_core.c
+#[repr(C, align(64))]
 struct LcoreQueueConf {
-    n_rx_port: u32,
-    rx_port_list: [u32; MAX_RX_QUEUE_PER_LCORE as usize],
+    n_rx_queue: libc::c_uint,
+    rx_queue_list: [RxQueue; MAX_RX_QUEUE_PER_LCORE as usize],
+    tx_queue_id: u16,
+    tx_buffers: [*mut rte::ffi::rte_eth_dev_tx_buffer; RTE_MAX_ETHPORTS as usize],
 }
 
 struct Conf {
@@ -74,12 +94,18 @@ fn print_usage(program: &String, opts: getopts::Options) -> ! {
 }
 
 // Parse the argument given in the command line of the application
-fn parse_args(args: &Vec<String>) -> (u32, u32, u32) {
+fn parse_args(args: &Vec<String>) -> (u32, u32, u16, u32, (u32, u32), RxIdleConf, placement::Policy) {
     let mut opts = getopts::Options::new();
     let program = args[0].clone();
 
     opts.optopt("p", "", "hexadecimal bitmask of ports to configure", "PORTMASK");
-    opts.optopt("q", "", "number of queue (=ports) per lcore (default is 1)", "NQ");
+    opts.optopt("q", "", "number of RX queues per lcore (default is 1)", "NQ");
+    opts.optopt(
+        "Q",
+        "",
+        "number of RX queues per port, packets are spread over them with RSS (default is 1)",
+        "NQ",
+    );
     opts.optopt(
         "T",
         "",
@@ -87,6 +113,35 @@ fn parse_args(args: &Vec<String>) -> (u32, u32, u32) {
          86400 maximum)",
         "PERIOD",
     );
+    opts.optopt(
+        "",
+        "drain-min-us",
+        "lower bound of the adaptive TX drain interval, in microseconds (10 default)",
+        "US",
+    );
+    opts.optopt(
+        "",
+        "drain-max-us",
+        "upper bound of the adaptive TX drain interval, in microseconds (100 default, 100000 maximum)",
+        "US",
+    );
+    opts.optopt(
+        "",
+        "idle-polls",
+        "pause after N consecutive empty polls, then sleep on RX interrupts (0 to disable, default)",
+        "N",
+    );
+    opts.optopt(
+        "",
+        "idle-sleep-us",
+        "sleep on RX interrupts after US microseconds without traffic (300 default)",
+        "US",
+    );
+    opts.optflag(
+        "",
+        "strict-numa",
+        "fail instead of warning when a queue can't be polled by an lcore on the socket of its port",
+    );
     opts.optflag("h", "help", "print this help menu");
 
     let matches = match opts.parse(&args[1..]) {
@@ -104,7 +159,15 @@ fn parse_args(args: &Vec<String>) -> (u32, u32, u32) {
 
     let mut enabled_port_mask: u32 = 0; // mask of enabled ports
     let mut rx_queue_per_lcore: u32 = 1;
+    let mut rx_queue_per_port: u16 = 1;
     let mut timer_period_seconds: u32 = 10; // default period is 10 seconds
+    let mut drain_min_us = BURST_TX_DRAIN_MIN_US;
+    let mut drain_max_us = BURST_TX_DRAIN_MAX_US;
+    let mut idle_conf = RxIdleConf {
+        pause_polls: 0,
+        sleep_us: IDLE_SLEEP_US,
+        timeout_ms: IDLE_TIMEOUT_MS,
+    };
 
     if let Some(arg) = matches.opt_str("p") {
         match u32::from_str_radix(arg.as_str(), 16) {
@@ -128,6 +191,17 @@ fn parse_args(args: &Vec<String>) -> (u32, u32, u32) {
         }
     }
 
+    if let Some(arg) = matches.opt_str("Q") {
+        match u16::from_str(arg.as_str()) {
+            Ok(n) if 0 < n && n <= MAX_RX_QUEUE_PER_PORT => rx_queue_per_port = n,
+            _ => {
+                println!("invalid queue number, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
     if let Some(arg) = matches.opt_str("T") {
         match u32::from_str(arg.as_str()) {
             Ok(t) if 0 < t && t < MAX_TIMER_PERIOD => timer_period_seconds = t,
@@ -139,7 +213,71 @@ fn parse_args(args: &Vec<String>) -> (u32, u32, u32) {
         }
     }
 
-    (enabled_port_mask, rx_queue_per_lcore, timer_period_seconds)
+    if let Some(arg) = matches.opt_str("drain-min-us") {
+        match u32::from_str(arg.as_str()) {
+            Ok(us) if us <= MAX_BURST_TX_DRAIN_US => drain_min_us = us,
+            _ => {
+                println!("invalid drain interval, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("drain-max-us") {
+        match u32::from_str(arg.as_str()) {
+            Ok(us) if 0 < us && us <= MAX_BURST_TX_DRAIN_US => drain_max_us = us,
+            _ => {
+                println!("invalid drain interval, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if drain_min_us > drain_max_us {
+        println!("invalid drain interval, {}us > {}us", drain_min_us, drain_max_us);
+
+        print_usage(&program, opts);
+    }
+
+    if let Some(arg) = matches.opt_str("idle-polls") {
+        match u32::from_str(arg.as_str()) {
+            Ok(n) => idle_conf.pause_polls = n,
+            _ => {
+                println!("invalid empty poll threshold, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("idle-sleep-us") {
+        match u32::from_str(arg.as_str()) {
+            Ok(us) => idle_conf.sleep_us = us,
+            _ => {
+                println!("invalid idle sleep delay, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    let numa_policy = if matches.opt_present("strict-numa") {
+        placement::Policy::Strict
+    } else {
+        placement::Policy::Warn
+    };
+
+    (
+        enabled_port_mask,
+        rx_queue_per_lcore,
+        rx_queue_per_port,
+        timer_period_seconds,
+        (drain_min_us, drain_max_us),
+        idle_conf,
+        numa_policy,
+    )
 }
 
 // Check the link status of all ports in up to 9s, and print them finally
@@ -183,6 +321,24 @@ fn check_all_ports_link_status(enabled_devices: &Vec<ethdev::PortId>) {
     }
 }
 
+// Mirror of `struct rx_idle_conf` in rx_idle.h
+#[repr(C)]
+struct RxIdleConf {
+    pause_polls: u32,
+    sleep_us: u32,
+    timeout_ms: u32,
+}
+
+// Mirror of `struct l2fwd_port_statistics` in l2fwd_core.c
+#[repr(C)]
+#[derive(Default)]
+struct PortStatistics {
+    tx: u64,
+    rx: u64,
+    dropped: u64,
+    tx_bursts: u64,
+}
+
 #[link(name = "l2fwd_core")]
 extern "C" {
     static mut l2fwd_force_quit: libc::c_int;
@@ -193,18 +349,24 @@ extern "C" {
 
     static mut l2fwd_dst_ports: [libc::uint32_t; RTE_MAX_ETHPORTS as usize];
 
-    static mut l2fwd_tx_buffers: [*mut rte::ffi::rte_eth_dev_tx_buffer; RTE_MAX_ETHPORTS as usize];
-
     static mut l2fwd_timer_period: libc::int64_t;
 
-    fn l2fwd_main_loop(rx_port_list: *const libc::uint32_t, n_rx_port: libc::c_uint) -> libc::c_int;
+    static mut l2fwd_drain_min_us: libc::uint32_t;
+
+    static mut l2fwd_drain_max_us: libc::uint32_t;
+
+    static mut l2fwd_idle_conf: RxIdleConf;
+
+    fn l2fwd_port_stats(portid: libc::c_uint, stats: *mut PortStatistics);
+
+    fn l2fwd_main_loop(qconf: *const LcoreQueueConf) -> libc::c_int;
 }
 
 fn l2fwd_launch_one_lcore(conf: Option<&Conf>) -> i32 {
     let lcore_id = lcore::current().unwrap();
     let qconf = &conf.unwrap().queue_conf[*lcore_id as usize];
 
-    if qconf.n_rx_port == 0 {
+    if qconf.n_rx_queue == 0 {
         info!("lcore {} has nothing to do", lcore_id);
 
         return -1;
@@ -212,11 +374,14 @@ fn l2fwd_launch_one_lcore(conf: Option<&Conf>) -> i32 {
 
     info!("entering main loop on lcore {}", lcore_id);
 
-    for portid in &qconf.rx_port_list[..qconf.n_rx_port as usize] {
-        info!(" -- lcoreid={} portid={}", lcore_id, portid);
+    for q in &qconf.rx_queue_list[..qconf.n_rx_queue as usize] {
+        info!(
+            " -- lcoreid={} portid={} rxqueueid={} txqueueid={}",
+            lcore_id, q.port_id, q.queue_id, qconf.tx_queue_id
+        );
     }
 
-    unsafe { l2fwd_main_loop(qconf.rx_port_list.as_ptr(), qconf.n_rx_port) }
+    unsafe { l2fwd_main_loop(qconf) }
 }
 
 extern "C" fn handle_sigint(sig: libc::c_int) {
@@ -269,27 +434,28 @@ fn main() {
 
     debug!("eal args: {:?}, l2fwd args: {:?}", eal_args, opt_args);
 
-    let (enabled_port_mask, rx_queue_per_lcore, timer_period_seconds) = parse_args(&opt_args);
+    let (
+        enabled_port_mask,
+        rx_queue_per_lcore,
+        rx_queue_per_port,
+        timer_period_seconds,
+        (drain_min_us, drain_max_us),
+        idle_conf,
+        numa_policy,
+    ) = parse_args(&opt_args);
+    let rx_intr = idle_conf.pause_polls > 0;
 
     unsafe {
         l2fwd_enabled_port_mask = enabled_port_mask;
         l2fwd_timer_period = timer_period_seconds as i64 * TIMER_MILLISECOND * 1000;
+        l2fwd_drain_min_us = drain_min_us;
+        l2fwd_drain_max_us = drain_max_us;
+        l2fwd_idle_conf = idle_conf;
     }
 
     // init EAL
     eal::init(&eal_args).expect("fail to initial EAL");
 
-    // create the mbuf pool
-    let mut l2fwd_pktmbuf_pool = mbuf::pool_create(
-        "mbuf_pool",
-        NB_MBUF,
-        32,
-        0,
-        mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16,
-        rte::socket_id() as i32,
-    )
-    .unwrap();
-
     let enabled_devices: Vec<ethdev::PortId> = ethdev::devices()
         .filter(|dev| ((1 << dev.portid()) & enabled_port_mask) != 0)
         .collect();
@@ -330,33 +496,51 @@ fn main() {
     }
 
     let mut conf = Conf::default();
+    let mut nb_fwd_lcores: u16 = 0;
 
-    let mut rx_lcore_id = lcore::id(0);
+    // Assign the RX queues to the lcores on the socket of their port.
+    //
+    // An lcore takes `rx_queue_per_lcore` queues before the next one is used, so the RSS queues
+    // of a port only spread over several lcores when they don't fit on one.
+    let mut planner = placement::Planner::new(numa_policy, rx_queue_per_lcore as usize);
 
-    // Initialize the port/queue configuration of each logical core
     for dev in &enabled_devices {
-        let portid = dev.portid();
+        planner.port(dev.portid(), rx_queue_per_port);
+    }
 
-        loop {
-            if let Some(id) = rx_lcore_id.next() {
-                if conf.queue_conf[*rx_lcore_id as usize].n_rx_port == rx_queue_per_lcore {
-                    rx_lcore_id = id
-                }
-            }
+    let placement = planner.plan().expect("fail to place the RX queues");
 
-            break;
-        }
+    // Initialize the port/queue configuration of each logical core.
+    for a in &placement.assignments {
+        let qconf = &mut conf.queue_conf[*a.lcore_id as usize];
 
-        // Assigned a new logical core in the loop above.
-        let qconf = &mut conf.queue_conf[*rx_lcore_id as usize];
+        if qconf.n_rx_queue == 0 {
+            // Each logical core is assigned a dedicated TX queue on each port.
+            qconf.tx_queue_id = nb_fwd_lcores;
+            nb_fwd_lcores += 1;
+        }
 
-        qconf.rx_port_list[qconf.n_rx_port as usize] = portid as u32;
-        qconf.n_rx_port += 1;
+        qconf.rx_queue_list[qconf.n_rx_queue as usize] = RxQueue {
+            port_id: a.port_id,
+            queue_id: a.queue_id,
+        };
+        qconf.n_rx_queue += 1;
 
-        println!("Lcore {}: RX port {}", rx_lcore_id, portid);
+        println!(
+            "Lcore {}: RX port {} queue {}, TX queue {}, socket {}{}",
+            a.lcore_id,
+            a.port_id,
+            a.queue_id,
+            qconf.tx_queue_id,
+            a.socket_id,
+            if a.remote { " (remote port)" } else { "" }
+        );
     }
 
-    let port_conf = ethdev::EthConf::default();
+    // create one mbuf pool on each socket of the forwarding lcores
+    let mut l2fwd_pktmbuf_pools = placement
+        .create_pools("mbuf_pool", NB_MBUF, 32, 0, mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16)
+        .unwrap();
 
     // Initialise each port
     for dev in &enabled_devices {
@@ -365,7 +549,56 @@ fn main() {
         // init port
         print!("Initializing port {}... ", portid);
 
-        dev.configure(1, 1, &port_conf)
+        let info = dev.info();
+
+        if rx_queue_per_port > info.max_rx_queues || nb_fwd_lcores > info.max_tx_queues {
+            eal::exit(
+                EXIT_FAILURE,
+                &format!(
+                    "port {} supports at most {} RX and {} TX queues\n",
+                    portid, info.max_rx_queues, info.max_tx_queues
+                ),
+            );
+        }
+
+        let mut port_conf = ethdev::EthConf::default();
+
+        if rx_queue_per_port > 1 {
+            let rss_hf =
+                (ethdev::RssHashFunc::ETH_RSS_IP | ethdev::RssHashFunc::ETH_RSS_TCP | ethdev::RssHashFunc::ETH_RSS_UDP)
+                    & info.rss_offloads();
+
+            if rss_hf.is_empty() {
+                println!("Notice: port {} can't hash IP/TCP/UDP flows, RSS is disabled.", portid);
+            }
+
+            port_conf.rxmode = Some(ethdev::EthRxMode {
+                mq_mode: if rss_hf.is_empty() {
+                    ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_NONE
+                } else {
+                    ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_RSS
+                },
+                ..Default::default()
+            });
+            port_conf.rx_adv_conf = Some(ethdev::RxAdvConf {
+                rss_conf: Some(ethdev::EthRssConf {
+                    key: None,
+                    hash: rss_hf,
+                }),
+                ..Default::default()
+            });
+        }
+
+        if rx_intr {
+            let mut intr_conf = ffi::rte_intr_conf::default();
+
+            // the idle lcores sleep until a RX interrupt fires
+            intr_conf.set_rxq(1);
+
+            port_conf.intr_conf = Some(intr_conf);
+        }
+
+        dev.configure(rx_queue_per_port, nb_fwd_lcores, &port_conf)
             .expect(&format!("fail to configure device: port={}", portid));
 
         let mac_addr = dev.mac_addr();
@@ -374,24 +607,22 @@ fn main() {
             l2fwd_ports_eth_addr[portid] = *mac_addr.octets();
         }
 
-        // init one RX queue
-        dev.rx_queue_setup(0, conf.nb_rxd, None, &mut l2fwd_pktmbuf_pool)
-            .expect(&format!("fail to setup device rx queue: port={}", portid));
-
-        // init one TX queue on each port
-        dev.tx_queue_setup(0, conf.nb_txd, None)
-            .expect(&format!("fail to setup device tx queue: port={}", portid));
+        // init the RX queues, from the mbuf pool of the socket of their lcore
+        for a in placement.assignments.iter().filter(|a| a.port_id == portid as u16) {
+            let pool = l2fwd_pktmbuf_pools.for_queue(a).unwrap();
 
-        // Initialize TX buffers
-        let buf = ethdev::alloc_buffer(MAX_PKT_BURST, dev.socket_id())
-            .as_mut_ref()
-            .expect(&format!("fail to allocate buffer for tx: port={}", portid));
-
-        buf.count_err_packets()
-            .expect(&format!("failt to set error callback for tx buffer: port={}", portid));
+            dev.rx_queue_setup(a.queue_id, conf.nb_rxd, None, pool).expect(&format!(
+                "fail to setup device rx queue: port={} queue={}",
+                portid, a.queue_id
+            ));
+        }
 
-        unsafe {
-            l2fwd_tx_buffers[portid] = buf;
+        // init one TX queue per forwarding lcore
+        for queueid in 0..nb_fwd_lcores {
+            dev.tx_queue_setup(queueid, conf.nb_txd, None).expect(&format!(
+                "fail to setup device tx queue: port={} queue={}",
+                portid, queueid
+            ));
         }
 
         // Start device
@@ -411,6 +642,26 @@ fn main() {
         );
     }
 
+    // Initialize the per-lcore TX buffers of every destination port
+    for qconf in conf.queue_conf.iter_mut().filter(|qconf| qconf.n_rx_queue > 0) {
+        for i in 0..qconf.n_rx_queue as usize {
+            let dst_port = unsafe { l2fwd_dst_ports[qconf.rx_queue_list[i].port_id as usize] } as usize;
+
+            if !qconf.tx_buffers[dst_port].is_null() {
+                continue;
+            }
+
+            let buf = ethdev::alloc_buffer(MAX_PKT_BURST, (dst_port as ethdev::PortId).socket_id())
+                .as_mut_ref()
+                .expect(&format!("fail to allocate buffer for tx: port={}", dst_port));
+
+            buf.count_err_packets()
+                .expect(&format!("failt to set error callback for tx buffer: port={}", dst_port));
+
+            qconf.tx_buffers[dst_port] = buf;
+        }
+    }
+
     check_all_ports_link_status(&enabled_devices);
 
     // launch per-lcore init on every lcore
@@ -418,13 +669,48 @@ fn main() {
 
     launch::mp_wait_lcore();
 
+    for dev in &enabled_devices {
+        let mut stats = PortStatistics::default();
+
+        unsafe { l2fwd_port_stats(dev.portid() as libc::c_uint, &mut stats) };
+
+        println!(
+            "Port {}: {} packets sent, {} received, {} dropped, {:.1} packets per TX burst",
+            dev.portid(),
+            stats.tx,
+            stats.rx,
+            stats.dropped,
+            if stats.tx_bursts > 0 {
+                stats.tx as f64 / stats.tx_bursts as f64
+            } else {
+                0.0
+            }
+        );
+    }
+
+    // the cycle accounting of the forwarding lcores, with the `poll-stats` feature
+    for lcore_id in placement.lcores() {
+        if let Some(s) = poll_stats::lcore(lcore_id) {
+            println!(
+                "Lcore {}: {:.1} cycles per packet, {:.1} packets per RX burst, {:.1}% empty polls ({:.1}% of the cycles)",
+                lcore_id,
+                s.cycles_per_packet(),
+                s.avg_burst_size(),
+                s.empty_poll_ratio() * 100.0,
+                s.empty_cycles_ratio() * 100.0
+            );
+        }
+    }
+
     for dev in &enabled_devices {
         print!("Closing port {}...", dev.portid());
         dev.stop();
         dev.close();
         println!(" Done");
+    }
 
-        if let Some(buf) = (unsafe { l2fwd_tx_buffers[dev.portid() as usize] }).as_mut_ref() {
+    for qconf in conf.queue_conf.iter() {
+        for buf in qconf.tx_buffers.iter().filter_map(|&buf| buf.as_mut_ref()) {
             buf.free();
         }
     }
@@ -0,0 +1,885 @@
+//! L3 forwarding over LPM routes or exact-match flows.
+//!
+//! - In `lpm` mode, the IPv4 packets are routed by the longest prefix of their destination,
+//!   with a bulk lookup of each received burst, and the IPv6 packets by a lookup of the IPv6 table.
+//! - In `em` mode, the IPv4 packets are forwarded by an exact match of their 5-tuple in a hash table.
+//!
+//! The routes and flows are given on the command line, or default to `198.18.<port>.0/24`
+//! and `2001:db8:<port>::/48` to each enabled port.
+//!
+//! With `--telemetry`, the counters are sampled on a control thread and served on a Unix socket.
+//! With `--capture`, the received packets are written to a pcap file per lcore by a control thread.
+//!
+//! ```
+//! $ l3fwd -l 1-2 -- -p 0x3 -r 10.0.0.0/8,1 -r 2001:db8::/32,0
+//! $ l3fwd -l 1-2 -- -p 0x3 --mode em -f 198.18.1.1,198.18.0.1,11,101,6,1
+//! $ l3fwd -l 1-2 -- -p 0x3 --telemetry /tmp/l3fwd.sock & socat - UNIX-CONNECT:/tmp/l3fwd.sock
+//! ```
+#[macro_use]
+extern crate log;
+extern crate getopts;
+extern crate libc;
+extern crate nix;
+extern crate pretty_env_logger;
+extern crate rte;
+
+use std::convert::TryFrom;
+use std::env;
+use std::io;
+use std::io::prelude::*;
+use std::mem;
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
+use std::path::Path;
+use std::process;
+use std::str::FromStr;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Mutex;
+use std::time::Duration;
+
+use nix::sys::signal;
+
+use rte::ethdev::{EthDevice, EthDeviceInfo};
+use rte::ffi::RTE_MAX_ETHPORTS;
+use rte::hash::{Hash, HashFlags};
+use rte::lcore::RTE_MAX_LCORE;
+use rte::lpm::{Lpm, Lpm6};
+use rte::mbuf::{MBuf, MbufBurst};
+use rte::memory::SOCKET_ID_ANY;
+use rte::packet::PacketView;
+use rte::*;
+
+const EXIT_FAILURE: i32 = -1;
+
+const MAX_PKT_BURST: usize = 32;
+
+const MAX_RX_QUEUE_PER_LCORE: u32 = 16;
+
+const MAX_RX_QUEUE_PER_PORT: u16 = 128;
+
+const NB_MBUF: u32 = 8192;
+
+const MEMPOOL_CACHE_SIZE: u32 = 256;
+
+// Configurable number of RX/TX ring descriptors
+const RTE_TEST_RX_DESC_DEFAULT: u16 = 1024;
+const RTE_TEST_TX_DESC_DEFAULT: u16 = 1024;
+
+const LPM_MAX_RULES: u32 = 1024;
+const LPM_NUMBER_TBL8S: u32 = 1 << 8;
+
+const EM_HASH_ENTRIES: usize = 1024 * 1024;
+
+// The headers of the received packets are captured in batches of 1MB
+const CAPTURE_SNAPLEN: usize = 128;
+const CAPTURE_BATCH_LEN: usize = 1 << 20;
+
+const IPPROTO_TCP: u8 = 6;
+
+// the Rust allocations are served from the hugepages, on the socket of the allocating lcore
+#[global_allocator]
+static ALLOC: malloc::HugepageAlloc = malloc::HugepageAlloc::new();
+
+static FORCE_QUIT: AtomicBool = AtomicBool::new(false);
+
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum Mode {
+    Lpm,
+    Em,
+}
+
+/// An IPv4 5-tuple, hashed as raw bytes.
+#[repr(C, packed)]
+#[derive(Clone, Copy, Debug, Default)]
+struct Ipv4Tuple {
+    ip_dst: u32,
+    ip_src: u32,
+    port_dst: u16,
+    port_src: u16,
+    proto: u8,
+}
+
+struct Route {
+    addr: IpAddr,
+    depth: u8,
+    port_id: PortId,
+}
+
+struct Flow {
+    key: Ipv4Tuple,
+    port_id: PortId,
+}
+
+#[derive(Default)]
+struct LcoreConf {
+    rx_queues: Vec<(PortId, ethdev::QueueId)>,
+    tx_queue_id: ethdev::QueueId,
+    forwarded: AtomicU64,
+    dropped: AtomicU64,
+    tap: Mutex<Option<pcap::Tap>>,
+}
+
+struct Conf {
+    mode: Mode,
+    enabled_port_mask: u32,
+    ports_eth_addr: [ether::EtherAddr; RTE_MAX_ETHPORTS as usize],
+    lpm: Lpm,
+    lpm6: Lpm6,
+    em: Hash<Ipv4Tuple>,
+    em_ports: Vec<PortId>,
+    lcores: Vec<LcoreConf>,
+}
+
+impl Conf {
+    fn is_enabled(&self, port_id: PortId) -> bool {
+        (port_id as u32) < RTE_MAX_ETHPORTS && (self.enabled_port_mask & (1 << port_id)) != 0
+    }
+
+    /// Look up the output ports of a burst.
+    #[inline]
+    fn lookup(&self, pkts: &MbufBurst<MAX_PKT_BURST>, ports: &mut [Option<u32>; MAX_PKT_BURST]) {
+        match self.mode {
+            Mode::Lpm => {
+                self.lpm.lookup_burst(
+                    pkts,
+                    |m| ipv4_hdr(m).map_or(0, |ip| u32::from_be(ip.dst_addr)),
+                    &mut ports[..],
+                );
+
+                for (m, port) in pkts.iter().zip(ports.iter_mut()) {
+                    if ipv4_hdr(m).is_none() {
+                        *port = ipv6_hdr(m).and_then(|ip| self.lpm6.lookup(&Ipv6Addr::from(ip.dst_addr)));
+                    }
+                }
+            }
+            Mode::Em => {
+                let mut positions = [None; MAX_PKT_BURST];
+
+                self.em
+                    .lookup_burst(pkts, |m| ipv4_tuple(m).unwrap_or_default(), &mut positions[..]);
+
+                for (port, pos) in ports.iter_mut().zip(&positions[..]) {
+                    *port = pos.map(|pos| self.em_ports[pos] as u32);
+                }
+            }
+        }
+    }
+}
+
+#[inline]
+fn ipv4_hdr(m: &MBuf) -> Option<&ip::Ipv4Hdr> {
+    let eth = unsafe { m.mtod::<ether::EtherHdr>().as_ref() };
+
+    if { eth.ether_type } == ether::ETHER_TYPE_IPV4_BE {
+        Some(unsafe { m.mtod_offset::<ip::Ipv4Hdr>(mem::size_of::<ether::EtherHdr>()).as_ref() })
+    } else {
+        None
+    }
+}
+
+#[inline]
+fn ipv6_hdr(m: &MBuf) -> Option<&ip::Ipv6Hdr> {
+    let eth = unsafe { m.mtod::<ether::EtherHdr>().as_ref() };
+
+    if { eth.ether_type } == ether::ETHER_TYPE_IPV6_BE {
+        Some(unsafe { m.mtod_offset::<ip::Ipv6Hdr>(mem::size_of::<ether::EtherHdr>()).as_ref() })
+    } else {
+        None
+    }
+}
+
+#[inline]
+fn ipv4_tuple(m: &MBuf) -> Option<Ipv4Tuple> {
+    let view = PacketView::parse(m)?;
+    let ip = view.ipv4()?;
+    let (port_dst, port_src) = if let Some(tcp) = view.tcp() {
+        (u16::from_be(tcp.dst_port), u16::from_be(tcp.src_port))
+    } else if let Some(udp) = view.udp() {
+        (u16::from_be(udp.dst_port), u16::from_be(udp.src_port))
+    } else {
+        (0, 0)
+    };
+
+    Some(Ipv4Tuple {
+        ip_dst: u32::from_be(ip.dst_addr),
+        ip_src: u32::from_be(ip.src_addr),
+        port_dst,
+        port_src,
+        proto: ip.next_proto_id,
+    })
+}
+
+/// Rewrite the MAC addresses of a packet sent to a port, and decrement the TTL of the IPv4 packets.
+#[inline]
+fn rewrite(m: &MBuf, port_id: PortId, conf: &Conf) {
+    let eth = unsafe { m.mtod::<ether::EtherHdr>().as_mut() };
+
+    if { eth.ether_type } == ether::ETHER_TYPE_IPV4_BE {
+        let ip = unsafe { m.mtod_offset::<ip::Ipv4Hdr>(mem::size_of::<ether::EtherHdr>()).as_mut() };
+
+        // the TTL is the high byte of its 16-bit word, update the checksum incrementally (RFC 1624)
+        let sum = u16::from_be(ip.hdr_checksum) as u32 + 0x0100;
+
+        ip.time_to_live = ip.time_to_live.wrapping_sub(1);
+        ip.hdr_checksum = (((sum & 0xffff) + (sum >> 16)) as u16).to_be();
+    }
+
+    // 02:00:00:00:00:xx
+    eth.d_addr.addr_bytes = [0x02, 0, 0, 0, 0, port_id as u8];
+    eth.s_addr.addr_bytes = *conf.ports_eth_addr[port_id as usize].octets();
+}
+
+fn l3fwd_main_loop(conf: Option<&Conf>) -> i32 {
+    let conf = conf.unwrap();
+    let lcore_id = lcore::current().unwrap();
+    let qconf = &conf.lcores[*lcore_id as usize];
+
+    if qconf.rx_queues.is_empty() {
+        info!("lcore {} has nothing to do", lcore_id);
+
+        return 0;
+    }
+
+    info!("entering main loop on lcore {}", lcore_id);
+
+    for &(port_id, queue_id) in &qconf.rx_queues {
+        info!(
+            " -- lcoreid={} portid={} rxqueueid={} txqueueid={}",
+            lcore_id, port_id, queue_id, qconf.tx_queue_id
+        );
+    }
+
+    let mut tap = qconf.tap.lock().unwrap().take();
+    let mut pkts = MbufBurst::<MAX_PKT_BURST>::new();
+    let mut ports = [None; MAX_PKT_BURST];
+    let mut tx_pkts = (0..RTE_MAX_ETHPORTS)
+        .map(|_| MbufBurst::<MAX_PKT_BURST>::new())
+        .collect::<Vec<_>>();
+
+    while !FORCE_QUIT.load(Ordering::Relaxed) {
+        for &(port_id, queue_id) in &qconf.rx_queues {
+            if port_id.rx_burst(queue_id, &mut pkts) == 0 {
+                continue;
+            }
+
+            if let Some(ref mut tap) = tap {
+                tap.capture(&pkts);
+            }
+
+            conf.lookup(&pkts, &mut ports);
+
+            let mut dropped = 0;
+
+            for (m, &port) in pkts.drain().zip(&ports[..]) {
+                match port.map(|port| port as PortId).filter(|&port| conf.is_enabled(port)) {
+                    Some(dst_port) => {
+                        rewrite(&m, dst_port, conf);
+
+                        let _ = tx_pkts[dst_port as usize].push(m);
+                    }
+                    None => dropped += 1,
+                }
+            }
+
+            let mut forwarded = 0;
+
+            for (dst_port, burst) in tx_pkts.iter_mut().enumerate().filter(|(_, burst)| !burst.is_empty()) {
+                forwarded += (dst_port as PortId).tx_burst(qconf.tx_queue_id, burst);
+                dropped += burst.len();
+
+                burst.clear();
+            }
+
+            utils::add_counter(&qconf.forwarded, forwarded as u64);
+            utils::add_counter(&qconf.dropped, dropped as u64);
+        }
+    }
+
+    0
+}
+
+// display usage
+fn print_usage(program: &String, opts: getopts::Options) -> ! {
+    let brief = format!("Usage: {} [EAL options] -- [options]", program);
+
+    print!("{}", opts.usage(&brief));
+
+    process::exit(-1);
+}
+
+struct Args {
+    enabled_port_mask: u32,
+    rx_queue_per_lcore: u32,
+    rx_queue_per_port: u16,
+    mode: Mode,
+    routes: Vec<Route>,
+    flows: Vec<Flow>,
+    telemetry: Option<String>,
+    capture: Option<String>,
+}
+
+fn parse_route(s: &str) -> Option<Route> {
+    let (prefix, port) = s.split_at(s.find(',')?);
+    let (addr, depth) = prefix.split_at(prefix.find('/')?);
+    let addr = IpAddr::from_str(addr).ok()?;
+    let depth = u8::from_str(&depth[1..]).ok()?;
+    let max_depth = if addr.is_ipv4() {
+        lpm::MAX_DEPTH
+    } else {
+        lpm::MAX_DEPTH6
+    };
+
+    if depth > max_depth {
+        return None;
+    }
+
+    Some(Route {
+        addr,
+        depth,
+        port_id: PortId::from_str(&port[1..]).ok()?,
+    })
+}
+
+fn parse_flow(s: &str) -> Option<Flow> {
+    let fields = s.split(',').collect::<Vec<_>>();
+
+    if fields.len() != 6 {
+        return None;
+    }
+
+    Some(Flow {
+        key: Ipv4Tuple {
+            ip_dst: Ipv4Addr::from_str(fields[0]).ok()?.into(),
+            ip_src: Ipv4Addr::from_str(fields[1]).ok()?.into(),
+            port_dst: u16::from_str(fields[2]).ok()?,
+            port_src: u16::from_str(fields[3]).ok()?,
+            proto: u8::from_str(fields[4]).ok()?,
+        },
+        port_id: PortId::from_str(fields[5]).ok()?,
+    })
+}
+
+// Parse the argument given in the command line of the application
+fn parse_args(args: &Vec<String>) -> Args {
+    let mut opts = getopts::Options::new();
+    let program = args[0].clone();
+
+    opts.optopt("p", "", "hexadecimal bitmask of ports to configure", "PORTMASK");
+    opts.optopt("q", "", "number of RX queues per lcore (default is 1)", "NQ");
+    opts.optopt(
+        "Q",
+        "",
+        "number of RX queues per port, packets are spread over them with RSS (default is 1)",
+        "NQ",
+    );
+    opts.optopt(
+        "",
+        "mode",
+        "lookup with LPM routes or exact-match flows (lpm default)",
+        "lpm|em",
+    );
+    opts.optmulti(
+        "r",
+        "route",
+        "route a prefix to a port in lpm mode",
+        "PREFIX/DEPTH,PORT",
+    );
+    opts.optmulti(
+        "f",
+        "flow",
+        "forward an IPv4 5-tuple to a port in em mode",
+        "DST,SRC,DPORT,SPORT,PROTO,PORT",
+    );
+    opts.optopt(
+        "",
+        "telemetry",
+        "serve the port, queue and mempool counters on a Unix socket",
+        "PATH",
+    );
+    opts.optopt(
+        "",
+        "capture",
+        "capture the received packets of each lcore to PREFIX-<lcore>.pcap",
+        "PREFIX",
+    );
+    opts.optflag("h", "help", "print this help menu");
+
+    let matches = match opts.parse(&args[1..]) {
+        Ok(m) => m,
+        Err(err) => {
+            println!("Invalid L3FWD arguments, {}", err);
+
+            print_usage(&program, opts);
+        }
+    };
+
+    if matches.opt_present("h") {
+        print_usage(&program, opts);
+    }
+
+    let mut args = Args {
+        enabled_port_mask: 0,
+        rx_queue_per_lcore: 1,
+        rx_queue_per_port: 1,
+        mode: Mode::Lpm,
+        routes: vec![],
+        flows: vec![],
+        telemetry: matches.opt_str("telemetry"),
+        capture: matches.opt_str("capture"),
+    };
+
+    if let Some(arg) = matches.opt_str("p") {
+        match u32::from_str_radix(arg.as_str(), 16) {
+            Ok(mask) if mask != 0 => args.enabled_port_mask = mask,
+            _ => {
+                println!("invalid portmask, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("q") {
+        match u32::from_str(arg.as_str()) {
+            Ok(n) if 0 < n && n < MAX_RX_QUEUE_PER_LCORE => args.rx_queue_per_lcore = n,
+            _ => {
+                println!("invalid queue number, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("Q") {
+        match u16::from_str(arg.as_str()) {
+            Ok(n) if 0 < n && n <= MAX_RX_QUEUE_PER_PORT => args.rx_queue_per_port = n,
+            _ => {
+                println!("invalid queue number, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    if let Some(arg) = matches.opt_str("mode") {
+        match arg.as_str() {
+            "lpm" => args.mode = Mode::Lpm,
+            "em" => args.mode = Mode::Em,
+            _ => {
+                println!("invalid lookup mode, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    for arg in matches.opt_strs("r") {
+        match parse_route(&arg) {
+            Some(route) => args.routes.push(route),
+            None => {
+                println!("invalid route, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    for arg in matches.opt_strs("f") {
+        match parse_flow(&arg) {
+            Some(flow) => args.flows.push(flow),
+            None => {
+                println!("invalid flow, {}", arg);
+
+                print_usage(&program, opts);
+            }
+        }
+    }
+
+    args
+}
+
+/// The default routes and flows of a port, `198.18.<port>.0/24` and `2001:db8:<port>::/48`.
+fn default_rules(args: &mut Args, port_id: PortId) {
+    args.routes.push(Route {
+        addr: IpAddr::V4(Ipv4Addr::new(198, 18, port_id as u8, 0)),
+        depth: 24,
+        port_id,
+    });
+    args.routes.push(Route {
+        addr: IpAddr::V6(Ipv6Addr::new(0x2001, 0xdb8, port_id, 0, 0, 0, 0, 0)),
+        depth: 48,
+        port_id,
+    });
+    args.flows.push(Flow {
+        key: Ipv4Tuple {
+            ip_dst: Ipv4Addr::new(198, 18, port_id as u8, 1).into(),
+            ip_src: Ipv4Addr::new(198, 18, 0, 1).into(),
+            port_dst: 11,
+            port_src: 101,
+            proto: IPPROTO_TCP,
+        },
+        port_id,
+    });
+}
+
+// Check the link status of all ports in up to 9s, and print them finally
+fn check_all_ports_link_status(enabled_devices: &Vec<ethdev::PortId>) {
+    print!("Checking link status");
+
+    const CHECK_INTERVAL: u32 = 100;
+    const MAX_CHECK_TIME: usize = 90;
+
+    for _ in 0..MAX_CHECK_TIME {
+        if FORCE_QUIT.load(Ordering::Relaxed) {
+            break;
+        }
+
+        if enabled_devices.iter().all(|dev| dev.link_nowait().up) {
+            break;
+        }
+
+        delay_ms(CHECK_INTERVAL);
+
+        print!(".");
+
+        io::stdout().flush().unwrap();
+    }
+
+    println!("Done:");
+
+    for dev in enabled_devices {
+        let link = dev.link();
+
+        if link.up {
+            println!(
+                "  Port {} Link Up - speed {} Mbps - {}",
+                dev.portid(),
+                link.speed,
+                if link.duplex { "full-duplex" } else { "half-duplex" }
+            )
+        } else {
+            println!("  Port {} Link Down", dev.portid());
+        }
+    }
+}
+
+extern "C" fn handle_sigint(sig: libc::c_int) {
+    match signal::Signal::try_from(sig).unwrap() {
+        signal::SIGINT | signal::SIGTERM => {
+            println!("Signal {} received, preparing to exit...", sig);
+
+            FORCE_QUIT.store(true, Ordering::Relaxed);
+        }
+        _ => info!("unexpect signo: {}", sig),
+    }
+}
+
+fn handle_signals() -> nix::Result<()> {
+    let sig_action = signal::SigAction::new(
+        signal::SigHandler::Handler(handle_sigint),
+        signal::SaFlags::empty(),
+        signal::SigSet::empty(),
+    );
+    unsafe {
+        signal::sigaction(signal::SIGINT, &sig_action)?;
+        signal::sigaction(signal::SIGTERM, &sig_action)?;
+    }
+
+    Ok(())
+}
+
+fn prepare_args(args: &mut Vec<String>) -> (Vec<String>, Vec<String>) {
+    let program = String::from(Path::new(&args[0]).file_name().unwrap().to_str().unwrap());
+
+    if let Some(pos) = args.iter().position(|arg| arg == "--") {
+        let (eal_args, opt_args) = args.split_at_mut(pos);
+
+        opt_args[0] = program;
+
+        (eal_args.to_vec(), opt_args.to_vec())
+    } else {
+        (args[..1].to_vec(), args.clone())
+    }
+}
+
+fn main() {
+    pretty_env_logger::init();
+
+    handle_signals().expect("fail to handle signals");
+
+    let mut args: Vec<String> = env::args().collect();
+
+    let (eal_args, opt_args) = prepare_args(&mut args);
+
+    debug!("eal args: {:?}, l3fwd args: {:?}", eal_args, opt_args);
+
+    let mut args = parse_args(&opt_args);
+
+    // init EAL
+    eal::init(&eal_args).expect("fail to initial EAL");
+
+    let enabled_devices: Vec<ethdev::PortId> = ethdev::devices()
+        .filter(|dev| ((1 << dev.portid()) & args.enabled_port_mask) != 0)
+        .collect();
+
+    if enabled_devices.is_empty() {
+        eal::exit(EXIT_FAILURE, "All available ports are disabled. Please set portmask.\n");
+    }
+
+    if args.routes.is_empty() && args.flows.is_empty() {
+        for dev in &enabled_devices {
+            default_rules(&mut args, dev.portid());
+        }
+    }
+
+    // the lookup tables are read by the lcores of all the sockets
+    let mut lpm =
+        Lpm::create("l3fwd_lpm", SOCKET_ID_ANY, LPM_MAX_RULES, LPM_NUMBER_TBL8S).expect("fail to create the LPM table");
+    let mut lpm6 = Lpm6::create("l3fwd_lpm6", SOCKET_ID_ANY, LPM_MAX_RULES, LPM_NUMBER_TBL8S)
+        .expect("fail to create the LPM6 table");
+    let mut em = Hash::<Ipv4Tuple>::create("l3fwd_em", EM_HASH_ENTRIES, SOCKET_ID_ANY, HashFlags::empty())
+        .expect("fail to create the exact-match table");
+    let mut em_ports = vec![0; EM_HASH_ENTRIES];
+
+    for route in &args.routes {
+        match route.addr {
+            IpAddr::V4(addr) => lpm.add(addr, route.depth, route.port_id as u32),
+            IpAddr::V6(addr) => lpm6.add(addr, route.depth, route.port_id as u32),
+        }
+        .expect(&format!("fail to add route {}/{}", route.addr, route.depth));
+
+        println!("Route {}/{} to port {}", route.addr, route.depth, route.port_id);
+    }
+
+    for flow in &args.flows {
+        let pos = em.add(&flow.key).expect(&format!("fail to add flow {:?}", flow.key));
+
+        em_ports[pos] = flow.port_id;
+
+        println!("Flow {:?} to port {}", flow.key, flow.port_id);
+    }
+
+    let mut conf = Conf {
+        mode: args.mode,
+        enabled_port_mask: args.enabled_port_mask,
+        ports_eth_addr: [ether::EtherAddr::zeroed(); RTE_MAX_ETHPORTS as usize],
+        lpm,
+        lpm6,
+        em,
+        em_ports,
+        lcores: (0..RTE_MAX_LCORE).map(|_| LcoreConf::default()).collect(),
+    };
+    let mut nb_fwd_lcores: u16 = 0;
+
+    // Assign the RX queues to the lcores on the socket of their port.
+    let mut planner = placement::Planner::new(placement::Policy::Warn, args.rx_queue_per_lcore as usize);
+
+    for dev in &enabled_devices {
+        planner.port(dev.portid(), args.rx_queue_per_port);
+    }
+
+    let placement = planner.plan().expect("fail to place the RX queues");
+
+    for a in &placement.assignments {
+        let qconf = &mut conf.lcores[*a.lcore_id as usize];
+
+        if qconf.rx_queues.is_empty() {
+            // Each logical core is assigned a dedicated TX queue on each port.
+            qconf.tx_queue_id = nb_fwd_lcores;
+            nb_fwd_lcores += 1;
+        }
+
+        qconf.rx_queues.push((a.port_id, a.queue_id));
+
+        println!(
+            "Lcore {}: RX port {} queue {}, TX queue {}, socket {}{}",
+            a.lcore_id,
+            a.port_id,
+            a.queue_id,
+            qconf.tx_queue_id,
+            a.socket_id,
+            if a.remote { " (remote port)" } else { "" }
+        );
+    }
+
+    // create one mbuf pool on each socket of the forwarding lcores
+    let mut pools = placement
+        .create_pools(
+            "mbuf_pool",
+            NB_MBUF,
+            MEMPOOL_CACHE_SIZE,
+            0,
+            mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16,
+        )
+        .unwrap();
+
+    // Initialise each port
+    for dev in &enabled_devices {
+        let portid = dev.portid();
+
+        print!("Initializing port {}... ", portid);
+
+        let info = dev.info();
+
+        if args.rx_queue_per_port > info.max_rx_queues || nb_fwd_lcores > info.max_tx_queues {
+            eal::exit(
+                EXIT_FAILURE,
+                &format!(
+                    "port {} supports at most {} RX and {} TX queues\n",
+                    portid, info.max_rx_queues, info.max_tx_queues
+                ),
+            );
+        }
+
+        let mut port_conf = ethdev::EthConf::default();
+
+        if args.rx_queue_per_port > 1 {
+            let rss_hf =
+                (ethdev::RssHashFunc::ETH_RSS_IP | ethdev::RssHashFunc::ETH_RSS_TCP | ethdev::RssHashFunc::ETH_RSS_UDP)
+                    & info.rss_offloads();
+
+            port_conf.rxmode = Some(ethdev::EthRxMode {
+                mq_mode: if rss_hf.is_empty() {
+                    ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_NONE
+                } else {
+                    ffi::rte_eth_rx_mq_mode::ETH_MQ_RX_RSS
+                },
+                ..Default::default()
+            });
+            port_conf.rx_adv_conf = Some(ethdev::RxAdvConf {
+                rss_conf: Some(ethdev::EthRssConf {
+                    key: None,
+                    hash: rss_hf,
+                }),
+                ..Default::default()
+            });
+        }
+
+        dev.configure(args.rx_queue_per_port, nb_fwd_lcores, &port_conf)
+            .expect(&format!("fail to configure device: port={}", portid));
+
+        conf.ports_eth_addr[portid as usize] = dev.mac_addr();
+
+        // init the RX queues, from the mbuf pool of the socket of their lcore
+        for a in placement.assignments.iter().filter(|a| a.port_id == portid) {
+            let pool = pools.for_queue(a).unwrap();
+
+            dev.rx_queue_setup(a.queue_id, RTE_TEST_RX_DESC_DEFAULT, None, pool)
+                .expect(&format!(
+                    "fail to setup device rx queue: port={} queue={}",
+                    portid, a.queue_id
+                ));
+        }
+
+        // init one TX queue per forwarding lcore
+        for queueid in 0..nb_fwd_lcores {
+            dev.tx_queue_setup(queueid, RTE_TEST_TX_DESC_DEFAULT, None)
+                .expect(&format!(
+                    "fail to setup device tx queue: port={} queue={}",
+                    portid, queueid
+                ));
+        }
+
+        dev.start().expect(&format!("fail to start device: port={}", portid));
+
+        println!("Done: ");
+
+        dev.promiscuous_enable();
+
+        println!(
+            "  Port {}, MAC address: {}",
+            portid, conf.ports_eth_addr[portid as usize]
+        );
+    }
+
+    check_all_ports_link_status(&enabled_devices);
+
+    // sample the counters on a control thread, out of the forwarding lcores
+    let telemetry = args.telemetry.as_ref().map(|path| {
+        let mut sampler = telemetry::Sampler::new();
+
+        for dev in &enabled_devices {
+            sampler
+                .xstats(dev.portid(), &[] as &[&str])
+                .expect(&format!("fail to sample the xstats of port {}", dev.portid()))
+                .queues(dev.portid(), args.rx_queue_per_port as usize, nb_fwd_lcores as usize);
+        }
+        for pool in pools.iter() {
+            // the pools are freed after the telemetry is stopped
+            unsafe { sampler.mempool(pool) };
+        }
+        for socket_id in (0..lcore::socket_count()).filter_map(|idx| lcore::socket_id_by_idx(idx).ok()) {
+            sampler.heap(socket_id);
+        }
+
+        let mut telemetry = sampler
+            .spawn(Duration::from_secs(1))
+            .expect("fail to start the telemetry");
+
+        telemetry
+            .serve(path)
+            .expect(&format!("fail to serve the telemetry on {}", path));
+
+        println!("Telemetry served on {}", path);
+
+        telemetry
+    });
+
+    // the taps are flushed when the lcores exit their main loop
+    let capture = args.capture.as_ref().map(|prefix| {
+        let lcores = placement.lcores();
+        let mut capture = pcap::Capture::new(prefix, &lcores, CAPTURE_SNAPLEN, CAPTURE_BATCH_LEN)
+            .expect("fail to create the capture");
+
+        for &lcore_id in &lcores {
+            *conf.lcores[*lcore_id as usize].tap.lock().unwrap() = capture.tap(lcore_id);
+        }
+
+        println!("Capture to {}-<lcore>.pcap", prefix);
+
+        capture
+    });
+
+    // launch per-lcore init on every lcore
+    launch::mp_remote_launch(l3fwd_main_loop, Some(&conf), false).unwrap();
+
+    launch::mp_wait_lcore();
+
+    if let Some(capture) = capture {
+        for stats in capture.stats() {
+            println!(
+                "Lcore {}: {} packets captured, {} dropped from the capture",
+                stats.lcore_id, stats.packets, stats.dropped
+            );
+        }
+
+        capture.stop();
+    }
+
+    if let Some(telemetry) = telemetry {
+        telemetry.stop();
+    }
+
+    for lcore_id in placement.lcores() {
+        let qconf = &conf.lcores[*lcore_id as usize];
+
+        println!(
+            "Lcore {}: {} packets forwarded, {} dropped",
+            lcore_id,
+            qconf.forwarded.load(Ordering::Relaxed),
+            qconf.dropped.load(Ordering::Relaxed)
+        );
+    }
+
+    for dev in &enabled_devices {
+        print!("Closing port {}...", dev.portid());
+        dev.stop();
+        dev.close();
+        println!(" Done");
+    }
+
+    conf.lpm.free();
+    conf.lpm6.free();
+    conf.em.free();
+
+    println!("Bye...");
+}
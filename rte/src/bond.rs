@@ -1,4 +1,5 @@
 use std::mem;
+use std::ptr;
 
 use anyhow::Result;
 
@@ -95,11 +96,11 @@ impl From<u8> for BondMode {
 #[derive(Copy, Clone, Eq, PartialEq)]
 pub enum TransmitPolicy {
     /// Layer 2 (Ethernet MAC)
-    Layer2,
+    Layer2 = ffi::BALANCE_XMIT_POLICY_LAYER2 as u8,
     /// Layer 2+3 (Ethernet MAC + IP Addresses) transmit load balancing
-    Layer23,
+    Layer23 = ffi::BALANCE_XMIT_POLICY_LAYER23 as u8,
     /// Layer 3+4 (IP Addresses + UDP Ports) transmit load balancing
-    Layer34,
+    Layer34 = ffi::BALANCE_XMIT_POLICY_LAYER34 as u8,
 }
 
 impl From<u8> for TransmitPolicy {
@@ -108,11 +109,32 @@ impl From<u8> for TransmitPolicy {
     }
 }
 
+/// Aggregator selection policy of the 802.3ad mode
+#[repr(u32)]
+#[derive(Copy, Clone, Debug, Eq, PartialEq)]
+pub enum AggSelection {
+    /// Select the aggregator with the highest bandwidth
+    Bandwidth = ffi::rte_bond_8023ad_agg_selection::AGG_BANDWIDTH,
+    /// Select the aggregator with the most ports
+    Count = ffi::rte_bond_8023ad_agg_selection::AGG_COUNT,
+    /// Keep the selected aggregator while it has ports
+    Stable = ffi::rte_bond_8023ad_agg_selection::AGG_STABLE,
+}
+
+impl From<u32> for AggSelection {
+    fn from(v: u32) -> Self {
+        unsafe { mem::transmute(v) }
+    }
+}
+
+/// The 802.3ad mode parameters, LACP timers in milliseconds and the aggregator selection.
+pub type LacpConf = ffi::rte_eth_bond_8023ad_conf;
+
 /// Create a bonded rte_eth_dev device
 pub fn create(name: &str, mode: BondMode, socket_id: SocketId) -> Result<ethdev::PortId> {
     let port_id = unsafe { ffi::rte_eth_bond_create(try!(to_cptr!(name)), mode as u8, socket_id as u8) };
 
-    rte_check!(port_id; ok => { port_id as ethdev::PortId })
+    rte_check!(port_id, NonNegative; ok => { port_id as ethdev::PortId })
 }
 
 /// Free a bonded rte_eth_dev device
@@ -157,6 +179,28 @@ pub trait BondedDevice {
     /// Set the transmit policy for bonded device to use when it is operating in balance mode,
     /// this parameter is otherwise ignored in other modes of operation.
     fn set_xmit_policy(&self, policy: TransmitPolicy) -> Result<&Self>;
+
+    /// Get the 802.3ad mode parameters of bonded device
+    fn lacp_conf(&self) -> Result<LacpConf>;
+
+    /// Set the 802.3ad mode parameters of bonded device, or restore the defaults.
+    fn setup_lacp(&self, conf: Option<&LacpConf>) -> Result<&Self>;
+
+    /// Steer the LACP control frames of the slaves to a dedicated RX and TX queue,
+    /// so they are no longer received and sent through the data path bursts.
+    ///
+    /// The bonded device must be in 802.3ad mode and stopped,
+    /// an extra queue is added to each slave when the bonded device is started.
+    fn enable_dedicated_queues(&self) -> Result<&Self>;
+
+    /// Handle the LACP control frames in the data path bursts again.
+    fn disable_dedicated_queues(&self) -> Result<&Self>;
+
+    /// Get the aggregator selection policy of bonded device in 802.3ad mode
+    fn agg_selection(&self) -> Result<AggSelection>;
+
+    /// Set the aggregator selection policy of bonded device in 802.3ad mode
+    fn set_agg_selection(&self, policy: AggSelection) -> Result<&Self>;
 }
 
 impl BondedDevice for ethdev::PortId {
@@ -175,7 +219,7 @@ impl BondedDevice for ethdev::PortId {
     fn mode(&self) -> Result<BondMode> {
         let mode = unsafe { ffi::rte_eth_bond_mode_get(*self) };
 
-        rte_check!(mode; ok => { BondMode::from(mode as u8) })
+        rte_check!(mode, NonNegative; ok => { BondMode::from(mode as u8) })
     }
 
     fn set_mode(&self, mode: BondMode) -> Result<&Self> {
@@ -187,7 +231,7 @@ impl BondedDevice for ethdev::PortId {
     fn primary(&self) -> Result<ethdev::PortId> {
         let portid = unsafe { ffi::rte_eth_bond_primary_get(*self) };
 
-        rte_check!(portid; ok => { portid as ethdev::PortId })
+        rte_check!(portid, NonNegative; ok => { portid as ethdev::PortId })
     }
 
     fn set_primary(&self, dev: ethdev::PortId) -> Result<&Self> {
@@ -201,19 +245,15 @@ impl BondedDevice for ethdev::PortId {
 
         let num = unsafe { ffi::rte_eth_bond_slaves_get(*self, slaves.as_mut_ptr(), slaves.len() as u16) };
 
-        rte_check!(num; ok => {
-            Vec::from(&slaves[..num as usize])
-        })
+        rte_check!(num, NonNegative; ok => { Vec::from(&slaves[..num as usize]) })
     }
 
     fn active_slaves(&self) -> Result<Vec<ethdev::PortId>> {
         let mut slaves = [0u16; ffi::RTE_MAX_ETHPORTS as usize];
 
-        let num = unsafe { ffi::rte_eth_bond_slaves_get(*self, slaves.as_mut_ptr(), slaves.len() as u16) };
+        let num = unsafe { ffi::rte_eth_bond_active_slaves_get(*self, slaves.as_mut_ptr(), slaves.len() as u16) };
 
-        rte_check!(num; ok => {
-            Vec::from(&slaves[..num as usize])
-        })
+        rte_check!(num, NonNegative; ok => { Vec::from(&slaves[..num as usize]) })
     }
 
     fn set_mac_addr(&self, mac_addr: &ether::EtherAddr) -> Result<&Self> {
@@ -231,7 +271,7 @@ impl BondedDevice for ethdev::PortId {
     fn xmit_policy(&self) -> Result<TransmitPolicy> {
         let policy = unsafe { ffi::rte_eth_bond_xmit_policy_get(*self) };
 
-        rte_check!(policy; ok => { TransmitPolicy::from(policy as u8) })
+        rte_check!(policy, NonNegative; ok => { TransmitPolicy::from(policy as u8) })
     }
 
     fn set_xmit_policy(&self, policy: TransmitPolicy) -> Result<&Self> {
@@ -239,4 +279,44 @@ impl BondedDevice for ethdev::PortId {
             ffi::rte_eth_bond_xmit_policy_set(*self, policy as u8)
         }; ok => { self })
     }
+
+    fn lacp_conf(&self) -> Result<LacpConf> {
+        let mut conf = LacpConf::default();
+
+        rte_check!(unsafe {
+            ffi::rte_eth_bond_8023ad_conf_get(*self, &mut conf)
+        }; ok => { conf })
+    }
+
+    fn setup_lacp(&self, conf: Option<&LacpConf>) -> Result<&Self> {
+        let mut conf = conf.cloned();
+
+        rte_check!(unsafe {
+            ffi::rte_eth_bond_8023ad_setup(*self, conf.as_mut().map_or(ptr::null_mut(), |conf| conf as *mut _))
+        }; ok => { self })
+    }
+
+    fn enable_dedicated_queues(&self) -> Result<&Self> {
+        rte_check!(unsafe {
+            ffi::rte_eth_bond_8023ad_dedicated_queues_enable(*self)
+        }; ok => { self })
+    }
+
+    fn disable_dedicated_queues(&self) -> Result<&Self> {
+        rte_check!(unsafe {
+            ffi::rte_eth_bond_8023ad_dedicated_queues_disable(*self)
+        }; ok => { self })
+    }
+
+    fn agg_selection(&self) -> Result<AggSelection> {
+        let policy = unsafe { ffi::rte_eth_bond_8023ad_agg_selection_get(*self) };
+
+        rte_check!(policy, NonNegative; ok => { AggSelection::from(policy as u32) })
+    }
+
+    fn set_agg_selection(&self, policy: AggSelection) -> Result<&Self> {
+        rte_check!(unsafe {
+            ffi::rte_eth_bond_8023ad_agg_selection_set(*self, policy as u32)
+        }; ok => { self })
+    }
 }
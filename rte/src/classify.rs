@@ -0,0 +1,378 @@
+//!
+//! Classify the packets of a burst at once, into a struct of arrays of their header offsets,
+//! protocols and flow hashes.
+//!
+//! The packet types set by the device are trusted when they locate the headers,
+//! so only the IP header is read, the other packets are parsed by a `PacketView`.
+//! The flow hash is the RSS hash of the device when it is set, or a CRC32 of the 5-tuple.
+//!
+//! The classification runs in stages over the whole burst, rather than packet by packet,
+//! so the lookups run down the arrays and the next headers are prefetched while a stage runs.
+//! The stages over the arrays are dispatched to the SIMD level of the host.
+//!
+use std::mem;
+
+use libc;
+
+use ffi;
+
+use ether::{EtherHdr, VlanHdr};
+use hash;
+use ip::{Ipv4Hdr, Ipv6Hdr};
+use mbuf::{MBuf, MbufBurst};
+use packet::{self, PacketView, L3, L4};
+
+/// The packet type families classified.
+pub const PTYPE_MASK: u32 = ffi::RTE_PTYPE_L2_MASK | ffi::RTE_PTYPE_L3_MASK | ffi::RTE_PTYPE_L4_MASK;
+
+/// The initial value of the software flow hash.
+const HASH_INIT: u32 = 0xffff_ffff;
+
+/// The Ethernet header length of the L2 packet types, or 0 when the headers are not located.
+const L2_LENS: [u8; 16] = {
+    let mut lens = [0; 16];
+
+    lens[ffi::RTE_PTYPE_L2_ETHER as usize] = ETHER_HDR_LEN as u8;
+    lens[ffi::RTE_PTYPE_L2_ETHER_VLAN as usize] = (ETHER_HDR_LEN + VLAN_HDR_LEN) as u8;
+    lens[ffi::RTE_PTYPE_L2_ETHER_QINQ as usize] = (ETHER_HDR_LEN + 2 * VLAN_HDR_LEN) as u8;
+    lens
+};
+
+const ETHER_HDR_LEN: usize = mem::size_of::<EtherHdr>();
+const VLAN_HDR_LEN: usize = mem::size_of::<VlanHdr>();
+
+const IPPROTO_TCP: u8 = libc::IPPROTO_TCP as u8;
+const IPPROTO_UDP: u8 = libc::IPPROTO_UDP as u8;
+const IPPROTO_SCTP: u8 = libc::IPPROTO_SCTP as u8;
+const IPPROTO_ICMP: u8 = libc::IPPROTO_ICMP as u8;
+const IPPROTO_ICMPV6: u8 = libc::IPPROTO_ICMPV6 as u8;
+const IPPROTO_IGMP: u8 = libc::IPPROTO_IGMP as u8;
+
+/// The headers of the packets of a burst, as a struct of arrays.
+///
+/// The offsets are from the start of the packet, an offset of 0 means the header is not present:
+/// the L3 offset of the non IP packets, and the L4 offset of the fragments and unknown protocols.
+pub struct Classified<const N: usize> {
+    len: usize,
+    software: usize,
+    ptypes: [u32; N],
+    l3_offsets: [u16; N],
+    l4_offsets: [u16; N],
+    protos: [u8; N],
+    hashes: [u32; N],
+}
+
+impl<const N: usize> Default for Classified<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<const N: usize> Classified<N> {
+    /// Create an empty classification.
+    pub fn new() -> Self {
+        Classified {
+            len: 0,
+            software: 0,
+            ptypes: [0; N],
+            l3_offsets: [0; N],
+            l4_offsets: [0; N],
+            protos: [0; N],
+            hashes: [0; N],
+        }
+    }
+
+    /// Classify the packets of a burst, replacing the previous classification.
+    pub fn classify(&mut self, pkts: &MbufBurst<N>) -> &mut Self {
+        let mut rss = [false; N];
+
+        self.len = pkts.len();
+        self.software = 0;
+
+        // the packet types and hashes set by the device, while the headers are prefetched
+        for (i, m) in pkts.iter().enumerate() {
+            let hash = m.rss_hash();
+
+            m.prefetch_data();
+
+            self.ptypes[i] = m.packet_type() & PTYPE_MASK;
+            self.hashes[i] = hash.unwrap_or_default();
+            rss[i] = hash.is_some();
+        }
+
+        // the IP header offsets from the packet types
+        l3_offsets(&self.ptypes[..self.len], &mut self.l3_offsets[..self.len]);
+
+        // the transport headers, from the IP header when it is located, or by a software parser
+        for (i, m) in pkts.iter().enumerate() {
+            if !self.classify_ip(i, m) {
+                self.classify_software(i, m);
+                self.software += 1;
+            }
+        }
+
+        // the 5-tuple hashes the device didn't compute
+        for (i, m) in pkts.iter().enumerate() {
+            if !rss[i] {
+                self.hashes[i] = self.flow_hash(i, m);
+            }
+        }
+
+        self
+    }
+
+    /// Locate the transport header from the IP header located by the device,
+    /// return `false` if the packet must be parsed in software.
+    #[inline]
+    fn classify_ip(&mut self, i: usize, m: &MBuf) -> bool {
+        let l3_off = self.l3_offsets[i] as usize;
+        let ptype = self.ptypes[i];
+
+        if l3_off == 0 {
+            return false;
+        }
+
+        let (l3_len, proto) = match ptype & ffi::RTE_PTYPE_L3_MASK {
+            ffi::RTE_PTYPE_L3_IPV4 | ffi::RTE_PTYPE_L3_IPV4_EXT | ffi::RTE_PTYPE_L3_IPV4_EXT_UNKNOWN => {
+                match packet::header::<Ipv4Hdr>(m, l3_off) {
+                    Some(ip) => (
+                        (ip.version_ihl & ffi::RTE_IPV4_HDR_IHL_MASK as u8) as usize * 4,
+                        ip.next_proto_id,
+                    ),
+                    None => return false,
+                }
+            }
+            // the extension headers are walked in software
+            ffi::RTE_PTYPE_L3_IPV6 => match packet::header::<Ipv6Hdr>(m, l3_off) {
+                Some(ip) => (mem::size_of::<Ipv6Hdr>(), ip.proto),
+                None => return false,
+            },
+            _ => return false,
+        };
+
+        self.protos[i] = proto;
+        self.l4_offsets[i] = if ptype & ffi::RTE_PTYPE_L4_MASK == ffi::RTE_PTYPE_L4_FRAG {
+            0
+        } else {
+            (l3_off + l3_len) as u16
+        };
+
+        true
+    }
+
+    /// Parse the headers of a packet the device didn't classify, and set its packet types.
+    #[inline]
+    fn classify_software(&mut self, i: usize, m: &MBuf) {
+        let view = match PacketView::parse(m) {
+            Some(view) => view,
+            None => {
+                self.ptypes[i] = ffi::RTE_PTYPE_UNKNOWN;
+                self.l3_offsets[i] = 0;
+                self.l4_offsets[i] = 0;
+                self.protos[i] = 0;
+
+                return;
+            }
+        };
+
+        let l2 = match (view.l2_len() - ETHER_HDR_LEN) / VLAN_HDR_LEN {
+            0 => ffi::RTE_PTYPE_L2_ETHER,
+            1 => ffi::RTE_PTYPE_L2_ETHER_VLAN,
+            _ => ffi::RTE_PTYPE_L2_ETHER_QINQ,
+        };
+        let l3 = match view.l3() {
+            Some(L3::Ipv4) if view.l3_len() > mem::size_of::<Ipv4Hdr>() => ffi::RTE_PTYPE_L3_IPV4_EXT,
+            Some(L3::Ipv4) => ffi::RTE_PTYPE_L3_IPV4,
+            Some(L3::Ipv6) if view.l3_len() > mem::size_of::<Ipv6Hdr>() => ffi::RTE_PTYPE_L3_IPV6_EXT,
+            Some(L3::Ipv6) => ffi::RTE_PTYPE_L3_IPV6,
+            None => ffi::RTE_PTYPE_UNKNOWN,
+        };
+        let proto = match view.l4() {
+            Some(L4::Tcp) => IPPROTO_TCP,
+            Some(L4::Udp) => IPPROTO_UDP,
+            Some(L4::Other(proto)) => proto,
+            None => view.ipv4().map_or(0, |ip| ip.next_proto_id),
+        };
+        let l4 = if view.is_fragment() {
+            ffi::RTE_PTYPE_L4_FRAG
+        } else if view.l3().is_some() {
+            l4_ptype(proto)
+        } else {
+            ffi::RTE_PTYPE_UNKNOWN
+        };
+
+        self.ptypes[i] = l2 | l3 | l4;
+        self.protos[i] = proto;
+        self.l3_offsets[i] = if view.l3().is_some() { view.l2_len() as u16 } else { 0 };
+        self.l4_offsets[i] = if view.l3().is_some() && !view.is_fragment() {
+            (view.l2_len() + view.l3_len()) as u16
+        } else {
+            0
+        };
+    }
+
+    /// The CRC32 hash of the addresses, protocol and ports of a packet.
+    #[inline]
+    fn flow_hash(&self, i: usize, m: &MBuf) -> u32 {
+        let l3_off = self.l3_offsets[i] as usize;
+        let l4_off = self.l4_offsets[i] as usize;
+        let mut key = [0u8; 37];
+
+        if l3_off == 0 {
+            return 0;
+        }
+
+        // the source and destination addresses end the fixed IP headers
+        let len = if is_ipv4(self.ptypes[i]) {
+            match packet::header::<[u8; 8]>(m, l3_off + mem::size_of::<Ipv4Hdr>() - 8) {
+                Some(addrs) => key[..8].copy_from_slice(&addrs[..]),
+                None => return 0,
+            }
+
+            8
+        } else {
+            match packet::header::<[u8; 32]>(m, l3_off + mem::size_of::<Ipv6Hdr>() - 32) {
+                Some(addrs) => key[..32].copy_from_slice(&addrs[..]),
+                None => return 0,
+            }
+
+            32
+        };
+
+        // the fragments of a datagram hash the same, though the protocol of the IPv6 ones is only known in the first
+        if self.ptypes[i] & ffi::RTE_PTYPE_L4_MASK != ffi::RTE_PTYPE_L4_FRAG {
+            key[len] = self.protos[i];
+        }
+
+        // the source and destination ports lead both the TCP, UDP and SCTP headers
+        let ports = match self.protos[i] {
+            IPPROTO_TCP | IPPROTO_UDP | IPPROTO_SCTP if l4_off != 0 => packet::header::<[u8; 4]>(m, l4_off),
+            _ => None,
+        };
+
+        if let Some(ports) = ports {
+            key[len + 1..len + 5].copy_from_slice(&ports[..]);
+        }
+
+        hash::crc(&key[..len + 5], HASH_INIT)
+    }
+
+    /// The number of classified packets.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// No packet is classified.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// The number of packets parsed in software, because the device didn't locate their headers.
+    #[inline]
+    pub fn software(&self) -> usize {
+        self.software
+    }
+
+    /// The L2, L3 and L4 packet types, as `RTE_PTYPE_*` flags.
+    #[inline]
+    pub fn ptypes(&self) -> &[u32] {
+        &self.ptypes[..self.len]
+    }
+
+    /// The offsets of the IP headers.
+    #[inline]
+    pub fn l3_offsets(&self) -> &[u16] {
+        &self.l3_offsets[..self.len]
+    }
+
+    /// The offsets of the transport headers.
+    #[inline]
+    pub fn l4_offsets(&self) -> &[u16] {
+        &self.l4_offsets[..self.len]
+    }
+
+    /// The IP protocols.
+    #[inline]
+    pub fn protos(&self) -> &[u8] {
+        &self.protos[..self.len]
+    }
+
+    /// The flow hashes.
+    ///
+    /// The RSS hash of the device and the software hash differ,
+    /// so the hashes of a flow are only consistent when its packets are received on the same port.
+    #[inline]
+    pub fn hashes(&self) -> &[u32] {
+        &self.hashes[..self.len]
+    }
+}
+
+simd_dispatch! {
+    /// The offsets of the IP headers located by the packet types, without branch.
+    fn l3_offsets(ptypes: &[u32], offsets: &mut [u16]) -> () {
+        for (offset, &ptype) in offsets.iter_mut().zip(ptypes) {
+            let is_ip = ptype & (ffi::RTE_PTYPE_L3_IPV4 | ffi::RTE_PTYPE_L3_IPV6) != 0;
+
+            *offset = L2_LENS[(ptype & ffi::RTE_PTYPE_L2_MASK) as usize] as u16 & (is_ip as u16).wrapping_neg();
+        }
+    }
+}
+
+/// The packet is an IPv4 packet.
+#[inline]
+pub fn is_ipv4(ptype: u32) -> bool {
+    ptype & ffi::RTE_PTYPE_L3_IPV4 != 0 && ptype & ffi::RTE_PTYPE_L3_IPV6 == 0
+}
+
+/// The packet is an IPv6 packet.
+#[inline]
+pub fn is_ipv6(ptype: u32) -> bool {
+    ptype & ffi::RTE_PTYPE_L3_IPV6 != 0
+}
+
+/// The L4 packet type of an IP protocol.
+fn l4_ptype(proto: u8) -> u32 {
+    match proto {
+        IPPROTO_TCP => ffi::RTE_PTYPE_L4_TCP,
+        IPPROTO_UDP => ffi::RTE_PTYPE_L4_UDP,
+        IPPROTO_SCTP => ffi::RTE_PTYPE_L4_SCTP,
+        IPPROTO_ICMP | IPPROTO_ICMPV6 => ffi::RTE_PTYPE_L4_ICMP,
+        IPPROTO_IGMP => ffi::RTE_PTYPE_L4_IGMP,
+        _ => ffi::RTE_PTYPE_L4_NONFRAG,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_ptypes() {
+        assert_eq!(L2_LENS[ffi::RTE_PTYPE_L2_ETHER as usize], 14);
+        assert_eq!(L2_LENS[ffi::RTE_PTYPE_L2_ETHER_QINQ as usize], 22);
+        assert_eq!(L2_LENS[ffi::RTE_PTYPE_L2_ETHER_ARP as usize], 0);
+
+        for &ptype in &[
+            ffi::RTE_PTYPE_L3_IPV4,
+            ffi::RTE_PTYPE_L3_IPV4_EXT,
+            ffi::RTE_PTYPE_L3_IPV4_EXT_UNKNOWN,
+        ] {
+            assert!(is_ipv4(ptype));
+            assert!(!is_ipv6(ptype));
+        }
+
+        for &ptype in &[
+            ffi::RTE_PTYPE_L3_IPV6,
+            ffi::RTE_PTYPE_L3_IPV6_EXT,
+            ffi::RTE_PTYPE_L3_IPV6_EXT_UNKNOWN,
+        ] {
+            assert!(!is_ipv4(ptype));
+            assert!(is_ipv6(ptype));
+        }
+
+        assert_eq!(l4_ptype(IPPROTO_UDP), ffi::RTE_PTYPE_L4_UDP);
+        assert_eq!(l4_ptype(0), ffi::RTE_PTYPE_L4_NONFRAG);
+    }
+}
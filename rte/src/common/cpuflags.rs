@@ -0,0 +1,160 @@
+//!
+//! The SIMD level of the host, detected once at `eal::init` from CPUID,
+//! to select the multi-versioned data path kernels.
+//!
+//! A kernel defined by `simd_dispatch!` is compiled for each level, and the best version the host supports
+//! is called, so a binary built for a generic target still uses AVX2 or AVX-512 where they are available.
+//!
+use std::fmt;
+use std::sync::atomic::{AtomicU8, Ordering};
+
+/// The instruction set extensions a kernel is compiled for.
+#[repr(u8)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord)]
+pub enum SimdLevel {
+    /// The baseline of the target.
+    Generic = 1,
+    /// SSE4.2 and POPCNT.
+    Sse42,
+    /// AVX2, BMI1/2 and FMA.
+    Avx2,
+    /// AVX-512 F/BW/VL.
+    Avx512,
+}
+
+impl fmt::Display for SimdLevel {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.write_str(match *self {
+            SimdLevel::Generic => "generic",
+            SimdLevel::Sse42 => "sse4.2",
+            SimdLevel::Avx2 => "avx2",
+            SimdLevel::Avx512 => "avx512",
+        })
+    }
+}
+
+/// The selected level, 0 until it is detected.
+static SIMD_LEVEL: AtomicU8 = AtomicU8::new(0);
+
+/// Detect the best level supported by the host.
+pub fn detect_simd_level() -> SimdLevel {
+    #[cfg(target_arch = "x86_64")]
+    {
+        if is_x86_feature_detected!("avx512f")
+            && is_x86_feature_detected!("avx512bw")
+            && is_x86_feature_detected!("avx512vl")
+        {
+            return SimdLevel::Avx512;
+        }
+        if is_x86_feature_detected!("avx2")
+            && is_x86_feature_detected!("bmi1")
+            && is_x86_feature_detected!("bmi2")
+            && is_x86_feature_detected!("fma")
+        {
+            return SimdLevel::Avx2;
+        }
+        if is_x86_feature_detected!("sse4.2") && is_x86_feature_detected!("popcnt") {
+            return SimdLevel::Sse42;
+        }
+    }
+
+    SimdLevel::Generic
+}
+
+/// The level the kernels are dispatched to, detected on first use.
+#[inline]
+pub fn simd_level() -> SimdLevel {
+    match SIMD_LEVEL.load(Ordering::Relaxed) {
+        2 => SimdLevel::Sse42,
+        3 => SimdLevel::Avx2,
+        4 => SimdLevel::Avx512,
+        1 => SimdLevel::Generic,
+        _ => set_simd_level(SimdLevel::Avx512),
+    }
+}
+
+/// Limit the level the kernels are dispatched to, return the level selected.
+///
+/// The level is capped by the one the host supports, lowering it helps to compare the kernels.
+pub fn set_simd_level(level: SimdLevel) -> SimdLevel {
+    let level = level.min(detect_simd_level());
+
+    SIMD_LEVEL.store(level as u8, Ordering::Relaxed);
+
+    level
+}
+
+/// Define a kernel compiled for each `SimdLevel`, dispatched to the best version supported by the host.
+///
+/// The body is written once and inlined into each version, so the compiler vectorizes it for the level.
+///
+/// ```ignore
+/// simd_dispatch! {
+///     /// Sum the bytes.
+///     pub fn sum(data: &[u8]) -> u64 {
+///         data.iter().map(|&b| b as u64).sum()
+///     }
+/// }
+/// ```
+#[macro_export]
+macro_rules! simd_dispatch {
+    ($(#[$attr:meta])* $vis:vis fn $name:ident($($arg:ident: $ty:ty),* $(,)*) -> $ret:ty $body:block) => {
+        $(#[$attr])*
+        #[inline]
+        $vis fn $name($($arg: $ty),*) -> $ret {
+            #[inline(always)]
+            fn generic($($arg: $ty),*) -> $ret $body
+
+            #[cfg(target_arch = "x86_64")]
+            #[target_feature(enable = "sse4.2,popcnt")]
+            unsafe fn sse42($($arg: $ty),*) -> $ret {
+                generic($($arg),*)
+            }
+
+            #[cfg(target_arch = "x86_64")]
+            #[target_feature(enable = "avx2,bmi1,bmi2,fma")]
+            unsafe fn avx2($($arg: $ty),*) -> $ret {
+                generic($($arg),*)
+            }
+
+            #[cfg(target_arch = "x86_64")]
+            #[target_feature(enable = "avx512f,avx512bw,avx512vl,avx2,bmi1,bmi2,fma")]
+            unsafe fn avx512($($arg: $ty),*) -> $ret {
+                generic($($arg),*)
+            }
+
+            match $crate::cpuflags::simd_level() {
+                #[cfg(target_arch = "x86_64")]
+                $crate::cpuflags::SimdLevel::Avx512 => unsafe { avx512($($arg),*) },
+                #[cfg(target_arch = "x86_64")]
+                $crate::cpuflags::SimdLevel::Avx2 => unsafe { avx2($($arg),*) },
+                #[cfg(target_arch = "x86_64")]
+                $crate::cpuflags::SimdLevel::Sse42 => unsafe { sse42($($arg),*) },
+                _ => generic($($arg),*),
+            }
+        }
+    };
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    simd_dispatch! {
+        fn sum(data: &[u32]) -> u32 {
+            data.iter().sum()
+        }
+    }
+
+    #[test]
+    fn test_dispatch() {
+        let data = (0..1000).collect::<Vec<u32>>();
+        let detected = detect_simd_level();
+
+        for &level in &[SimdLevel::Generic, SimdLevel::Sse42, SimdLevel::Avx2, SimdLevel::Avx512] {
+            assert_eq!(set_simd_level(level), level.min(detected));
+            assert_eq!(simd_level(), level.min(detected));
+            assert_eq!(sum(&data), 499500);
+        }
+    }
+}
@@ -9,7 +9,9 @@ use anyhow::Result;
 
 use ffi::{self, rte_proc_type_t::*};
 
+use cpuflags;
 use errors::{AsResult};
+use malloc;
 use utils::AsCString;
 
 // pub use common::config;
@@ -116,11 +118,21 @@ pub fn init<S: fmt::Debug + AsRef<str>>(args: &[S]) -> Result<i32> {
 
     debug!("EAL parsed {} arguments", parsed);
 
-    parsed.as_result().map(|_| parsed)
+    parsed.as_result().map(|_| {
+        malloc::set_heap_ready(true);
+
+        info!("dispatch the data path kernels to {}", cpuflags::simd_level());
+
+        parsed
+    })
 }
 
 /// Clean up the Environment Abstraction Layer (EAL)
+///
+/// The values allocated by `malloc::HugepageAlloc` must be dropped before.
 pub fn cleanup() -> Result<()> {
+    malloc::set_heap_ready(false);
+
     unsafe { ffi::rte_eal_cleanup() }.as_result().map(|_| ())
 }
 
@@ -0,0 +1,37 @@
+//! Epoll based waiting for the interrupts of the EAL, such as the RX interrupts of the ethdev queues.
+use std::os::unix::io::RawFd;
+
+use anyhow::{anyhow, Result};
+
+use ffi;
+
+use errors::os_error;
+
+/// The epoll instance of the calling thread, created on its first use.
+pub const EPOLL_PER_THREAD: RawFd = ffi::RTE_EPOLL_PER_THREAD;
+
+/// The operation on an interrupt vector of an epoll instance.
+#[repr(i32)]
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum IntrEvent {
+    /// Add the interrupt vector to the epoll instance.
+    Add = ffi::RTE_INTR_EVENT_ADD as i32,
+    /// Remove the interrupt vector from the epoll instance.
+    Del = ffi::RTE_INTR_EVENT_DEL as i32,
+}
+
+pub type EpollEvent = ffi::rte_epoll_event;
+
+/// Wait for the events of an epoll instance.
+///
+/// Returns the number of ready events, or 0 when the `timeout` in milliseconds expired,
+/// a negative `timeout` waits forever.
+pub fn epoll_wait(epfd: RawFd, events: &mut [EpollEvent], timeout: i32) -> Result<usize> {
+    let n = unsafe { ffi::rte_epoll_wait(epfd, events.as_mut_ptr(), events.len() as i32, timeout) };
+
+    if n < 0 {
+        Err(anyhow!(os_error()))
+    } else {
+        Ok(n as usize)
+    }
+}
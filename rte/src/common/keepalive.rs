@@ -1,6 +1,8 @@
+use std::fmt;
 use std::mem;
 use std::os::raw::{c_int, c_void};
 use std::ptr::{self, NonNull};
+use std::sync::Mutex;
 
 use anyhow::Result;
 
@@ -46,37 +48,65 @@ pub type RelayCallback<T> = fn(Option<T>, lcore::Id, State, u64);
 pub type RawKeepalive = ffi::rte_keepalive;
 pub type RawKeepalivePtr = *mut ffi::rte_keepalive;
 
-#[repr(transparent)]
-#[derive(Debug)]
-pub struct Keepalive(NonNull<RawKeepalive>);
+pub struct Keepalive {
+    raw: NonNull<RawKeepalive>,
+    /// The contexts of the callbacks, locked while the pings are dispatched.
+    contexts: Mutex<Vec<Box<dyn Send>>>,
+}
+
+// Each core marks its own slot, and the pings are dispatched under the lock of the contexts.
+unsafe impl Send for Keepalive {}
+unsafe impl Sync for Keepalive {}
+
+impl fmt::Debug for Keepalive {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        f.debug_tuple("Keepalive").field(&self.raw).finish()
+    }
+}
+
+impl Drop for Keepalive {
+    fn drop(&mut self) {
+        // `rte_keepalive_create` allocates the keepalive from the heap, without a matching destroy,
+        // no callback may run once it is freed, the contexts are dropped after it.
+        unsafe { ffi::rte_free(self.raw.as_ptr() as *mut c_void) }
+    }
+}
 
 impl AsRaw for Keepalive {
     type Raw = RawKeepalive;
 
     fn as_raw(&self) -> *const Self::Raw {
-        self.0.as_ptr()
+        self.raw.as_ptr()
     }
 
     fn as_raw_mut(&self) -> *mut Self::Raw {
-        self.0.as_ptr()
+        self.raw.as_ptr()
     }
 }
 
-pub fn create<T>(callback: FailureCallback<T>, arg: Option<T>) -> Result<Keepalive> {
+pub fn create<T: Clone + Send + 'static>(callback: FailureCallback<T>, arg: Option<T>) -> Result<Keepalive> {
     Keepalive::new(callback, arg)
 }
 
 impl Keepalive {
-    pub fn new<T>(callback: FailureCallback<T>, arg: Option<T>) -> Result<Self> {
-        let ctxt = Box::into_raw(Box::new(FailureContext { callback, arg }));
+    pub fn new<T: Clone + Send + 'static>(callback: FailureCallback<T>, arg: Option<T>) -> Result<Self> {
+        let ctxt = Box::new(FailureContext { callback, arg });
+        let data = &*ctxt as *const FailureContext<T> as *mut c_void;
 
-        unsafe { ffi::rte_keepalive_create(Some(failure_stub::<T>), ctxt as *mut _) }
+        unsafe { ffi::rte_keepalive_create(Some(failure_stub::<T>), data) }
             .as_result()
-            .map(Keepalive)
+            .map(|raw| Keepalive {
+                raw,
+                contexts: Mutex::new(vec![ctxt as Box<dyn Send>]),
+            })
     }
 
     /// Checks & handles keepalive state of monitored cores.
+    ///
+    /// The callbacks run on the calling thread, the concurrent dispatches wait for each other.
     pub fn dispatch_pings(&self) {
+        let _contexts = self.contexts.lock().unwrap();
+
         unsafe { ffi::rte_keepalive_dispatch_pings(ptr::null_mut(), self.as_raw() as *mut _) }
     }
 
@@ -106,10 +136,15 @@ impl Keepalive {
     /// The complement of the 'dead core' callback. This is called when a
     /// core is known to be alive, and is intended for cases when an app
     /// needs to know 'liveness' beyond just knowing when a core has died.
-    pub fn register_relay_callback<T>(&self, callback: RelayCallback<T>, arg: Option<T>) {
-        let ctxt = Box::into_raw(Box::new(RelayContext { callback, arg }));
+    pub fn register_relay_callback<T: Clone + Send + 'static>(&self, callback: RelayCallback<T>, arg: Option<T>) {
+        let ctxt = Box::new(RelayContext { callback, arg });
+        let data = &*ctxt as *const RelayContext<T> as *mut c_void;
+        let mut contexts = self.contexts.lock().unwrap();
+
+        unsafe { ffi::rte_keepalive_register_relay_callback(self.as_raw_mut(), Some(relay_stub::<T>), data) }
 
-        unsafe { ffi::rte_keepalive_register_relay_callback(self.as_raw_mut(), Some(relay_stub::<T>), ctxt as *mut _) }
+        // the replaced context is only freed with the keepalive
+        contexts.push(ctxt);
     }
 }
 
@@ -118,10 +153,11 @@ struct FailureContext<T> {
     arg: Option<T>,
 }
 
-unsafe extern "C" fn failure_stub<T>(data: *mut c_void, id_core: c_int) {
-    let ctxt = Box::from_raw(data as *mut FailureContext<T>);
+// The context lives as long as the keepalive, the callback runs each time a core fails.
+unsafe extern "C" fn failure_stub<T: Clone>(data: *mut c_void, id_core: c_int) {
+    let ctxt = &*(data as *const FailureContext<T>);
 
-    (ctxt.callback)(ctxt.arg, lcore::id(id_core as u32))
+    (ctxt.callback)(ctxt.arg.clone(), lcore::id(id_core as u32))
 }
 
 struct RelayContext<T> {
@@ -129,13 +165,18 @@ struct RelayContext<T> {
     arg: Option<T>,
 }
 
-unsafe extern "C" fn relay_stub<T>(
+unsafe extern "C" fn relay_stub<T: Clone>(
     data: *mut c_void,
     id_core: c_int,
     core_state: rte_keepalive_state::Type,
     last_seen: u64,
 ) {
-    let ctxt = Box::from_raw(data as *mut RelayContext<T>);
-
-    (ctxt.callback)(ctxt.arg, lcore::id(id_core as u32), core_state.into(), last_seen)
+    let ctxt = &*(data as *const RelayContext<T>);
+
+    (ctxt.callback)(
+        ctxt.arg.clone(),
+        lcore::id(id_core as u32),
+        core_state.into(),
+        last_seen,
+    )
 }
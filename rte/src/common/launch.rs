@@ -1,13 +1,16 @@
 //! Launch tasks on other lcores
 //!
 use std::os::raw::{c_int, c_void};
+use std::ptr;
 
-use anyhow::Result;
+use anyhow::{anyhow, Result};
 use ffi;
+use libc;
 use num_traits::FromPrimitive;
 
-use errors::AsResult;
+use errors::{AsResult, RteError};
 use lcore;
+use utils::AsCString;
 
 /// State of an lcore.
 #[repr(u32)]
@@ -102,3 +105,55 @@ pub enum JobState {
 pub fn mp_wait_lcore() {
     unsafe { ffi::rte_eal_mp_wait_lcore() }
 }
+
+/// A control thread, for the management work which must not run on the lcores.
+///
+/// It is pinned to the CPUs of the process affinity which are not used by the lcores,
+/// so it never preempts the datapath.
+pub struct CtrlThread(ffi::pthread_t);
+
+unsafe extern "C" fn ctrl_thread_stub<F: FnOnce()>(arg: *mut c_void) -> *mut c_void {
+    let f = Box::from_raw(arg as *mut F);
+
+    f();
+
+    ptr::null_mut()
+}
+
+/// Create a control thread named name running `f`.
+///
+/// To be executed after `eal::init`.
+pub fn ctrl_thread<S, F>(name: S, f: F) -> Result<CtrlThread>
+where
+    S: AsRef<str>,
+    F: FnOnce() + Send + 'static,
+{
+    let name = name.as_cstring();
+    let arg = Box::into_raw(Box::new(f));
+    let mut thread = 0;
+
+    let ret = unsafe {
+        ffi::rte_ctrl_thread_create(
+            &mut thread,
+            name.as_ptr(),
+            ptr::null(),
+            Some(ctrl_thread_stub::<F>),
+            arg as *mut c_void,
+        )
+    };
+
+    if ret == 0 {
+        Ok(CtrlThread(thread))
+    } else {
+        drop(unsafe { Box::from_raw(arg) });
+
+        Err(anyhow!(RteError(ret)))
+    }
+}
+
+impl CtrlThread {
+    /// Wait until the control thread returns.
+    pub fn join(self) {
+        unsafe { libc::pthread_join(self.0, ptr::null_mut()) };
+    }
+}
@@ -1,12 +1,21 @@
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::cmp;
 use std::mem;
 use std::os::raw::c_void;
 use std::os::unix::io::AsRawFd;
-use std::ptr;
+use std::ptr::{self, NonNull};
+use std::slice;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 
+use anyhow::Result;
 use cfile;
 
 use ffi;
 
+use errors::AsResult;
+use memory::{SocketId, SOCKET_ID_ANY};
+
 #[macro_export]
 macro_rules! rte_new {
     ($t:ty) => {
@@ -134,3 +143,263 @@ pub fn dump_stats<S: AsRawFd>(s: &S, tag: Option<&str>) {
         }
     }
 }
+
+/// The hugepage heap is usable, between `eal::init` and `eal::cleanup`.
+static HEAP_READY: AtomicBool = AtomicBool::new(false);
+
+const MAX_HEAP_LISTS: usize = ffi::RTE_MAX_MEMSEG_LISTS as usize;
+
+/// The virtual address ranges reserved for the internal memseg lists, which the heaps allocate from.
+///
+/// The lists are not contiguous, the libc heap may map memory in between.
+/// The ranges are cleared by `eal::cleanup`, before the lists are unmapped.
+static HEAP_LISTS: AtomicUsize = AtomicUsize::new(0);
+const NO_ADDR: AtomicUsize = AtomicUsize::new(0);
+static HEAP_START: [AtomicUsize; MAX_HEAP_LISTS] = [NO_ADDR; MAX_HEAP_LISTS];
+static HEAP_END: [AtomicUsize; MAX_HEAP_LISTS] = [NO_ADDR; MAX_HEAP_LISTS];
+
+pub(crate) fn set_heap_ready(ready: bool) {
+    if ready {
+        unsafe extern "C" fn walk(msl: *const ffi::rte_memseg_list, arg: *mut c_void) -> i32 {
+            let msl = &*msl;
+            let n = &mut *(arg as *mut usize);
+
+            if msl.external == 0 && msl.len != 0 && *n < MAX_HEAP_LISTS {
+                let start = msl.__bindgen_anon_1.base_va as usize;
+
+                HEAP_START[*n].store(start, Ordering::Relaxed);
+                HEAP_END[*n].store(start + msl.len, Ordering::Relaxed);
+
+                *n += 1;
+            }
+
+            0
+        }
+
+        let mut n = 0usize;
+
+        // the memseg lists reserve their address space at init, even when the memory is allocated on demand
+        unsafe { ffi::rte_memseg_list_walk(Some(walk), &mut n as *mut _ as *mut c_void) };
+
+        HEAP_LISTS.store(n, Ordering::Release);
+        HEAP_READY.store(true, Ordering::Release);
+    } else {
+        HEAP_READY.store(false, Ordering::Release);
+        HEAP_LISTS.store(0, Ordering::Release);
+    }
+}
+
+/// Test if the memory is allocated from the hugepage heap.
+#[inline]
+fn is_heap_memory(ptr: *const u8) -> bool {
+    let addr = ptr as usize;
+
+    (0..HEAP_LISTS.load(Ordering::Acquire))
+        .any(|i| HEAP_START[i].load(Ordering::Relaxed) <= addr && addr < HEAP_END[i].load(Ordering::Relaxed))
+}
+
+/// A global allocator backed by the hugepage heap.
+///
+/// The `Vec`, `Box` or `HashMap` of the lcores are allocated on hugepages of their NUMA socket,
+/// instead of the 4K pages of the libc heap. The memory is allocated from the system allocator
+/// before `eal::init` and after `eal::cleanup`, and given back to the allocator it comes from.
+///
+/// The hugepage allocations must not outlive `eal::cleanup`, which unmaps their memory:
+/// a value dropped after the cleanup would be handed to the system allocator.
+///
+/// Each allocation takes the heap lock, so the transient allocations of a burst belong in an `Arena`.
+///
+/// ```no_run
+/// #[global_allocator]
+/// static ALLOC: rte::malloc::HugepageAlloc = rte::malloc::HugepageAlloc::new();
+/// ```
+pub struct HugepageAlloc {
+    socket_id: SocketId,
+}
+
+impl HugepageAlloc {
+    /// An allocator on the socket of the calling lcore, or any socket if it is exhausted.
+    pub const fn new() -> Self {
+        HugepageAlloc {
+            socket_id: SOCKET_ID_ANY,
+        }
+    }
+
+    /// An allocator on a socket.
+    pub const fn on_socket(socket_id: SocketId) -> Self {
+        HugepageAlloc { socket_id }
+    }
+}
+
+impl Default for HugepageAlloc {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+unsafe impl GlobalAlloc for HugepageAlloc {
+    #[inline]
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        if HEAP_READY.load(Ordering::Acquire) {
+            ffi::rte_malloc_socket(ptr::null(), layout.size(), layout.align() as u32, self.socket_id) as *mut u8
+        } else {
+            System.alloc(layout)
+        }
+    }
+
+    #[inline]
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        if HEAP_READY.load(Ordering::Acquire) {
+            ffi::rte_zmalloc_socket(ptr::null(), layout.size(), layout.align() as u32, self.socket_id) as *mut u8
+        } else {
+            System.alloc_zeroed(layout)
+        }
+    }
+
+    #[inline]
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        if is_heap_memory(ptr) {
+            ffi::rte_free(ptr as *mut c_void)
+        } else {
+            System.dealloc(ptr, layout)
+        }
+    }
+
+    #[inline]
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        if is_heap_memory(ptr) {
+            ffi::rte_realloc_socket(ptr as *mut c_void, new_size, layout.align() as u32, self.socket_id) as *mut u8
+        } else if !HEAP_READY.load(Ordering::Acquire) {
+            System.realloc(ptr, layout, new_size)
+        } else {
+            // move the memory allocated before `eal::init` to the hugepage heap
+            let new_layout = Layout::from_size_align_unchecked(new_size, layout.align());
+            let new_ptr = self.alloc(new_layout);
+
+            if !new_ptr.is_null() {
+                ptr::copy_nonoverlapping(ptr, new_ptr, cmp::min(layout.size(), new_size));
+                System.dealloc(ptr, layout);
+            }
+
+            new_ptr
+        }
+    }
+}
+
+/// A bump arena on the hugepage heap, for the transient allocations of an lcore.
+///
+/// The allocations only bump an offset, without lock, and are all released at once by `reset`,
+/// typically at each iteration of the poll loop. An arena is owned by a single lcore.
+///
+/// Only `Copy` values are allocated, since nothing is dropped on `reset`.
+pub struct Arena {
+    base: NonNull<u8>,
+    capacity: usize,
+    pos: Cell<usize>,
+    peak: Cell<usize>,
+}
+
+unsafe impl Send for Arena {}
+
+impl Drop for Arena {
+    fn drop(&mut self) {
+        unsafe { ffi::rte_free(self.base.as_ptr() as *mut c_void) }
+    }
+}
+
+impl Arena {
+    /// Allocate an arena of `capacity` bytes on a socket.
+    pub fn new(capacity: usize, socket_id: SocketId) -> Result<Self> {
+        unsafe { ffi::rte_malloc_socket(ptr::null(), capacity, ffi::RTE_CACHE_LINE_SIZE, socket_id) }
+            .as_result()
+            .map(|base| Arena {
+                base: base.cast(),
+                capacity,
+                pos: Cell::new(0),
+                peak: Cell::new(0),
+            })
+    }
+
+    /// Allocate memory for a layout, return `None` if the arena is exhausted.
+    #[inline]
+    pub fn alloc_layout(&self, layout: Layout) -> Option<NonNull<u8>> {
+        let base = self.base.as_ptr() as usize;
+        let start = (base + self.pos.get() + layout.align() - 1) & !(layout.align() - 1);
+        let end = start.checked_add(layout.size())?;
+
+        if end > base + self.capacity {
+            None
+        } else {
+            self.pos.set(end - base);
+
+            NonNull::new(start as *mut u8)
+        }
+    }
+
+    /// Move a value into the arena.
+    #[inline]
+    pub fn alloc<T: Copy>(&self, value: T) -> Option<&mut T> {
+        self.alloc_layout(Layout::new::<T>()).map(|p| unsafe {
+            let p = p.as_ptr() as *mut T;
+
+            p.write(value);
+
+            &mut *p
+        })
+    }
+
+    /// Allocate a slice of `len` values in the arena.
+    #[inline]
+    pub fn alloc_slice<T: Copy>(&self, len: usize, value: T) -> Option<&mut [T]> {
+        let layout = Layout::array::<T>(len).ok()?;
+
+        self.alloc_layout(layout).map(|p| unsafe {
+            let values = slice::from_raw_parts_mut(p.as_ptr() as *mut T, len);
+
+            for v in values.iter_mut() {
+                ptr::write(v, value);
+            }
+
+            values
+        })
+    }
+
+    /// Copy a slice into the arena.
+    #[inline]
+    pub fn alloc_slice_copy<T: Copy>(&self, src: &[T]) -> Option<&mut [T]> {
+        let layout = Layout::array::<T>(src.len()).ok()?;
+
+        self.alloc_layout(layout).map(|p| unsafe {
+            let p = p.as_ptr() as *mut T;
+
+            ptr::copy_nonoverlapping(src.as_ptr(), p, src.len());
+
+            slice::from_raw_parts_mut(p, src.len())
+        })
+    }
+
+    /// Release all the allocations.
+    #[inline]
+    pub fn reset(&mut self) {
+        self.peak.set(cmp::max(self.peak.get(), self.pos.get()));
+        self.pos.set(0);
+    }
+
+    /// The bytes allocated since the last reset.
+    #[inline]
+    pub fn used(&self) -> usize {
+        self.pos.get()
+    }
+
+    /// The size of the arena.
+    #[inline]
+    pub fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    /// The most bytes allocated between two resets, to size the arena.
+    #[inline]
+    pub fn peak(&self) -> usize {
+        cmp::max(self.peak.get(), self.pos.get())
+    }
+}
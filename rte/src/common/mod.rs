@@ -1,6 +1,9 @@
 pub mod bitmap;
+#[macro_use]
+pub mod cpuflags;
 // mod config;
 pub mod eal;
+pub mod interrupts;
 pub mod keepalive;
 pub mod launch;
 pub mod lcore;
@@ -19,6 +22,7 @@ pub mod byteorder;
 mod cycles;
 pub mod memory;
 pub mod memzone;
+pub mod poll_stats;
 
 // pub use self::config::{config};
 pub use self::cycles::*;
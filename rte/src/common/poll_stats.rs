@@ -0,0 +1,262 @@
+//! Cycle accounting of the poll loops.
+//!
+//! Each lcore owns a `PollStats` slot, which only it writes with relaxed stores,
+//! so the accounting needs neither a lock nor an atomic read-modify-write.
+//! Readers take a `Snapshot` from any thread.
+//!
+//! The slots are only compiled with the `poll-stats` feature, which also defines
+//! `RTE_POLL_STATS` for the C poll loops of the examples, see `examples/common/poll_stats.h`.
+//! Without it `current` and `lcore` return `None` and the accounting compiles out.
+use std::sync::atomic::{AtomicU64, Ordering};
+
+use lcore;
+use utils::add_counter;
+
+/// Number of buckets of the burst size histogram, bucket `i > 0` counts the bursts of `[2^(i-1), 2^i)` packets.
+pub const BURST_BUCKETS: usize = 16;
+
+/// Number of buckets of the cycles per burst histogram, with the same log2 scale.
+pub const CYCLE_BUCKETS: usize = 32;
+
+/// The cycle accounting of an lcore, mirrored by `struct poll_stats` in `poll_stats.h`.
+#[repr(C, align(64))]
+#[derive(Debug)]
+pub struct PollStats {
+    /// Number of RX polls.
+    pub polls: AtomicU64,
+    /// Number of RX polls which returned no packet.
+    pub empty_polls: AtomicU64,
+    /// Number of received packets.
+    pub packets: AtomicU64,
+    /// Cycles spent in the RX polls which returned packets.
+    pub rx_cycles: AtomicU64,
+    /// Cycles spent in the empty RX polls.
+    pub empty_cycles: AtomicU64,
+    /// Cycles spent processing the received packets.
+    pub proc_cycles: AtomicU64,
+    /// Cycles spent flushing the TX buffers.
+    pub tx_cycles: AtomicU64,
+    /// Histogram of the sizes of the RX bursts.
+    pub burst_sizes: [AtomicU64; BURST_BUCKETS],
+    /// Histogram of the cycles to receive and process a burst.
+    pub burst_cycles: [AtomicU64; CYCLE_BUCKETS],
+}
+
+const ZERO: AtomicU64 = AtomicU64::new(0);
+
+impl PollStats {
+    const INIT: PollStats = PollStats {
+        polls: ZERO,
+        empty_polls: ZERO,
+        packets: ZERO,
+        rx_cycles: ZERO,
+        empty_cycles: ZERO,
+        proc_cycles: ZERO,
+        tx_cycles: ZERO,
+        burst_sizes: [ZERO; BURST_BUCKETS],
+        burst_cycles: [ZERO; CYCLE_BUCKETS],
+    };
+
+    /// Account a RX poll which returned `nb_rx` packets in `cycles`.
+    #[inline(always)]
+    pub fn record_rx(&self, nb_rx: usize, cycles: u64) {
+        add_counter(&self.polls, 1);
+        add_counter(&self.burst_sizes[bucket(nb_rx as u64, BURST_BUCKETS)], 1);
+
+        if nb_rx == 0 {
+            add_counter(&self.empty_polls, 1);
+            add_counter(&self.empty_cycles, cycles);
+        } else {
+            add_counter(&self.packets, nb_rx as u64);
+            add_counter(&self.rx_cycles, cycles);
+        }
+    }
+
+    /// Account the processing of a burst in `cycles`, and the `burst_cycles` to receive and process it.
+    #[inline(always)]
+    pub fn record_proc(&self, cycles: u64, burst_cycles: u64) {
+        add_counter(&self.proc_cycles, cycles);
+        add_counter(&self.burst_cycles[bucket(burst_cycles, CYCLE_BUCKETS)], 1);
+    }
+
+    /// Account a flush of the TX buffers in `cycles`.
+    #[inline(always)]
+    pub fn record_tx(&self, cycles: u64) {
+        add_counter(&self.tx_cycles, cycles);
+    }
+
+    /// Read the counters.
+    pub fn snapshot(&self) -> Snapshot {
+        let load = |c: &AtomicU64| c.load(Ordering::Relaxed);
+        let mut snapshot = Snapshot {
+            polls: load(&self.polls),
+            empty_polls: load(&self.empty_polls),
+            packets: load(&self.packets),
+            rx_cycles: load(&self.rx_cycles),
+            empty_cycles: load(&self.empty_cycles),
+            proc_cycles: load(&self.proc_cycles),
+            tx_cycles: load(&self.tx_cycles),
+            ..Default::default()
+        };
+
+        for (v, c) in snapshot.burst_sizes.iter_mut().zip(&self.burst_sizes) {
+            *v = load(c);
+        }
+        for (v, c) in snapshot.burst_cycles.iter_mut().zip(&self.burst_cycles) {
+            *v = load(c);
+        }
+
+        snapshot
+    }
+}
+
+/// The log2 bucket of a value.
+#[inline(always)]
+fn bucket(v: u64, buckets: usize) -> usize {
+    ((64 - v.leading_zeros()) as usize).min(buckets - 1)
+}
+
+/// A copy of the counters of an lcore.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct Snapshot {
+    pub polls: u64,
+    pub empty_polls: u64,
+    pub packets: u64,
+    pub rx_cycles: u64,
+    pub empty_cycles: u64,
+    pub proc_cycles: u64,
+    pub tx_cycles: u64,
+    pub burst_sizes: [u64; BURST_BUCKETS],
+    pub burst_cycles: [u64; CYCLE_BUCKETS],
+}
+
+impl Snapshot {
+    /// The counters accumulated since an older snapshot.
+    ///
+    /// The slots are read without lock, a counter which looks older than in `prev` counts none.
+    pub fn since(&self, prev: &Snapshot) -> Snapshot {
+        let mut delta = Snapshot {
+            polls: self.polls.saturating_sub(prev.polls),
+            empty_polls: self.empty_polls.saturating_sub(prev.empty_polls),
+            packets: self.packets.saturating_sub(prev.packets),
+            rx_cycles: self.rx_cycles.saturating_sub(prev.rx_cycles),
+            empty_cycles: self.empty_cycles.saturating_sub(prev.empty_cycles),
+            proc_cycles: self.proc_cycles.saturating_sub(prev.proc_cycles),
+            tx_cycles: self.tx_cycles.saturating_sub(prev.tx_cycles),
+            ..Default::default()
+        };
+
+        for i in 0..BURST_BUCKETS {
+            delta.burst_sizes[i] = self.burst_sizes[i].saturating_sub(prev.burst_sizes[i]);
+        }
+        for i in 0..CYCLE_BUCKETS {
+            delta.burst_cycles[i] = self.burst_cycles[i].saturating_sub(prev.burst_cycles[i]);
+        }
+
+        delta
+    }
+
+    /// The ratio of RX polls which returned no packet.
+    pub fn empty_poll_ratio(&self) -> f64 {
+        ratio(self.empty_polls, self.polls)
+    }
+
+    /// The average number of packets of the non-empty RX bursts.
+    pub fn avg_burst_size(&self) -> f64 {
+        ratio(self.packets, self.polls.saturating_sub(self.empty_polls))
+    }
+
+    /// The cycles spent per received packet, in RX, processing and TX, without the empty polls.
+    pub fn cycles_per_packet(&self) -> f64 {
+        ratio(self.rx_cycles + self.proc_cycles + self.tx_cycles, self.packets)
+    }
+
+    /// The ratio of cycles wasted in empty polls.
+    pub fn empty_cycles_ratio(&self) -> f64 {
+        ratio(
+            self.empty_cycles,
+            self.rx_cycles + self.empty_cycles + self.proc_cycles + self.tx_cycles,
+        )
+    }
+}
+
+fn ratio(n: u64, total: u64) -> f64 {
+    if total == 0 {
+        0.0
+    } else {
+        n as f64 / total as f64
+    }
+}
+
+#[cfg(feature = "poll-stats")]
+static POLL_STATS: [PollStats; lcore::RTE_MAX_LCORE as usize] = [PollStats::INIT; lcore::RTE_MAX_LCORE as usize];
+
+/// The slot of an lcore, for the C poll loops.
+#[cfg(feature = "poll-stats")]
+#[no_mangle]
+pub extern "C" fn _rte_poll_stats(lcore_id: u32) -> *mut PollStats {
+    POLL_STATS
+        .get(lcore_id as usize)
+        .map_or(::std::ptr::null_mut(), |stats| stats as *const _ as *mut _)
+}
+
+/// The slot of the calling lcore, to account its poll loop.
+#[inline(always)]
+pub fn current() -> Option<&'static PollStats> {
+    if cfg!(feature = "poll-stats") {
+        lcore::current().and_then(slot)
+    } else {
+        None
+    }
+}
+
+/// The counters of an lcore.
+pub fn lcore(lcore_id: lcore::Id) -> Option<Snapshot> {
+    slot(lcore_id).map(PollStats::snapshot)
+}
+
+#[cfg(feature = "poll-stats")]
+fn slot(lcore_id: lcore::Id) -> Option<&'static PollStats> {
+    POLL_STATS.get(*lcore_id as usize)
+}
+
+#[cfg(not(feature = "poll-stats"))]
+fn slot(_lcore_id: lcore::Id) -> Option<&'static PollStats> {
+    None
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_poll_stats() {
+        let stats = PollStats::INIT;
+
+        stats.record_rx(0, 10);
+        stats.record_rx(32, 100);
+        stats.record_proc(300, 400);
+        stats.record_tx(50);
+
+        let s = stats.snapshot();
+
+        assert_eq!(s.polls, 2);
+        assert_eq!(s.empty_polls, 1);
+        assert_eq!(s.packets, 32);
+        assert_eq!(s.burst_sizes[0], 1);
+        assert_eq!(s.burst_sizes[6], 1);
+        assert_eq!(s.burst_cycles[9], 1);
+        assert_eq!(s.empty_poll_ratio(), 0.5);
+        assert_eq!(s.avg_burst_size(), 32.0);
+        assert_eq!(s.cycles_per_packet(), 450.0 / 32.0);
+
+        stats.record_rx(1, 10);
+
+        let d = stats.snapshot().since(&s);
+
+        assert_eq!(d.polls, 1);
+        assert_eq!(d.packets, 1);
+        assert_eq!(d.burst_sizes[1], 1);
+        assert_eq!(bucket(u64::max_value(), CYCLE_BUCKETS), CYCLE_BUCKETS - 1);
+    }
+}
@@ -81,6 +81,20 @@ macro_rules! rte_check {
         }
     }};
 
+    ( $ret:expr, NonNegative ) => {
+        rte_check!($ret, NonNegative; ok => {$ret})
+    };
+    ( $ret:expr, NonNegative; ok => $ok:block) => {
+        rte_check!($ret, NonNegative; ok => $ok; err => {anyhow::anyhow!($crate::errors::RteError($ret))})
+    };
+    ( $ret:expr, NonNegative; ok => $ok:block; err => $err:block ) => {{
+        if $ret >= 0 {
+            Ok($ok)
+        } else {
+            Err($err)
+        }
+    }};
+
     ( $ret:expr, NonNull ) => {
         rte_check!($ret, NonNull; ok => {$ret}; err => {anyhow::anyhow!($crate::errors::rte_error())})
     };
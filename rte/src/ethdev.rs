@@ -1,22 +1,25 @@
+use std::cmp;
 use std::ffi::CStr;
 use std::mem;
 use std::ops::Range;
 use std::os::raw::c_void;
+use std::os::unix::io::RawFd;
 use std::ptr;
 
-use anyhow::Result;
+use anyhow::{anyhow, Result};
 use libc;
 
 use ffi;
 
 use dev;
-use errors::{AsResult, ErrorKind::OsError};
+use errors::{AsResult, ErrorKind::OsError, RteError};
 use ether;
+use interrupts;
 use malloc;
 use mbuf;
 use memory::SocketId;
 use mempool;
-use utils::AsRaw;
+use utils::{AsCString, AsRaw};
 
 pub type PortId = u16;
 pub type QueueId = u16;
@@ -48,6 +51,23 @@ pub trait EthDevice {
     /// Reset the general I/O statistics of an Ethernet device.
     fn reset_stats(&self) -> &Self;
 
+    /// Retrieve the names of the extended statistics of an Ethernet device, indexed by their ID.
+    fn xstat_names(&self) -> Result<Vec<String>>;
+
+    /// Retrieve the ID of an extended statistic from its name.
+    fn xstat_id(&self, name: &str) -> Result<u64>;
+
+    /// Retrieve the values of the extended statistics selected by their IDs.
+    ///
+    /// Unlike `rte_eth_xstats_get`, only the selected counters are read from the device.
+    fn xstats_by_id(&self, ids: &[u64], values: &mut [u64]) -> Result<()>;
+
+    /// Reset the extended statistics of an Ethernet device.
+    fn reset_xstats(&self) -> Result<&Self>;
+
+    /// Retrieve the packet types recognized by an Ethernet device, among the `RTE_PTYPE_*_MASK` families of a mask.
+    fn supported_ptypes(&self, mask: u32) -> Result<Vec<u32>>;
+
     /// Retrieve the Ethernet address of an Ethernet device.
     fn mac_addr(&self) -> ether::EtherAddr;
 
@@ -152,10 +172,47 @@ pub trait EthDevice {
     fn close(&self) -> &Self;
 
     /// Retrieve a burst of input packets from a receive queue of an Ethernet device.
-    fn rx_burst(&self, queue_id: QueueId, rx_pkts: &mut [Option<mbuf::MBuf>]) -> usize;
+    ///
+    /// The received packets are appended to the burst, up to its remaining capacity.
+    fn rx_burst<const N: usize>(&self, queue_id: QueueId, rx_pkts: &mut mbuf::MbufBurst<N>) -> usize;
 
     /// Send a burst of output packets on a transmit queue of an Ethernet device.
-    fn tx_burst<T: AsRaw<Raw = mbuf::RawMBuf>>(&self, queue_id: QueueId, rx_pkts: &mut [T]) -> usize;
+    ///
+    /// The sent packets are taken from the front of the burst, the unsent packets stay in it.
+    fn tx_burst<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize;
+
+    /// Prepare a burst of output packets for the TX offloads of a transmit queue,
+    /// fixing up their headers, such as the pseudo header checksums, as required by the device.
+    ///
+    /// Return the number of packets prepared from the front of the burst,
+    /// if it is less than the length of the burst, `rte_errno` tells why the next packet is invalid.
+    fn tx_prepare<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize;
+
+    /// Prepare and send a burst of output packets on a transmit queue.
+    ///
+    /// The sent packets are taken from the front of the burst, the unsent packets stay in it,
+    /// and the packets rejected by `tx_prepare` are freed. Return the number of packets sent.
+    fn tx_prepare_burst<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize;
+
+    /// Enable the RX interrupt of a queue, the lcore could then sleep until a packet arrives.
+    ///
+    /// The device must be configured with `intr_conf.rxq` set.
+    fn rx_intr_enable(&self, rx_queue_id: QueueId) -> Result<&Self>;
+
+    /// Disable the RX interrupt of a queue, when the lcore returns to polling mode.
+    fn rx_intr_disable(&self, rx_queue_id: QueueId) -> Result<&Self>;
+
+    /// Add or remove the RX interrupts of all the queues to or from an epoll instance.
+    fn rx_intr_ctl(&self, epfd: RawFd, op: interrupts::IntrEvent, data: *mut c_void) -> Result<&Self>;
+
+    /// Add or remove the RX interrupt of a queue to or from an epoll instance.
+    fn rx_intr_ctl_q(
+        &self,
+        rx_queue_id: QueueId,
+        epfd: RawFd,
+        op: interrupts::IntrEvent,
+        data: *mut c_void,
+    ) -> Result<&Self>;
 
     /// Read VLAN Offload configuration from an Ethernet device
     fn vlan_offload(&self) -> Result<EthVlanOffloadMode>;
@@ -218,6 +275,78 @@ impl EthDevice for PortId {
         self
     }
 
+    fn xstat_names(&self) -> Result<Vec<String>> {
+        let n = unsafe { ffi::rte_eth_xstats_get_names(*self, ptr::null_mut(), 0) };
+
+        if n < 0 {
+            return Err(anyhow!(RteError(n)));
+        }
+
+        let mut names = vec![ffi::rte_eth_xstat_name { name: [0; 64] }; n as usize];
+        let n = unsafe { ffi::rte_eth_xstats_get_names(*self, names.as_mut_ptr(), names.len() as u32) };
+
+        if n < 0 {
+            Err(anyhow!(RteError(n)))
+        } else {
+            Ok(names[..cmp::min(n as usize, names.len())]
+                .iter()
+                .map(|xstat| {
+                    unsafe { CStr::from_ptr(xstat.name.as_ptr()) }
+                        .to_string_lossy()
+                        .into_owned()
+                })
+                .collect())
+        }
+    }
+
+    fn xstat_id(&self, name: &str) -> Result<u64> {
+        let name = name.as_cstring();
+        let mut id = 0;
+
+        rte_check!(unsafe { ffi::rte_eth_xstats_get_id_by_name(*self, name.as_ptr(), &mut id) }; ok => { id })
+    }
+
+    fn xstats_by_id(&self, ids: &[u64], values: &mut [u64]) -> Result<()> {
+        if ids.len() != values.len() {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let n = unsafe { ffi::rte_eth_xstats_get_by_id(*self, ids.as_ptr(), values.as_mut_ptr(), ids.len() as u32) };
+
+        if n < 0 {
+            Err(anyhow!(RteError(n)))
+        } else if n as usize != ids.len() {
+            Err(anyhow!(OsError(libc::EINVAL)))
+        } else {
+            Ok(())
+        }
+    }
+
+    fn reset_xstats(&self) -> Result<&Self> {
+        rte_check!(unsafe { ffi::rte_eth_xstats_reset(*self) }; ok => { self })
+    }
+
+    fn supported_ptypes(&self, mask: u32) -> Result<Vec<u32>> {
+        let n = unsafe { ffi::rte_eth_dev_get_supported_ptypes(*self, mask, ptr::null_mut(), 0) };
+
+        if n < 0 {
+            return Err(anyhow!(RteError(n)));
+        }
+
+        let mut ptypes = vec![0; n as usize];
+        let n = unsafe {
+            ffi::rte_eth_dev_get_supported_ptypes(*self, mask, ptypes.as_mut_ptr(), ptypes.len() as libc::c_int)
+        };
+
+        if n < 0 {
+            Err(anyhow!(RteError(n)))
+        } else {
+            ptypes.truncate(n as usize);
+
+            Ok(ptypes)
+        }
+    }
+
     fn mac_addr(&self) -> ether::EtherAddr {
         unsafe {
             let mut addr: ffi::rte_ether_addr = mem::zeroed();
@@ -378,20 +507,100 @@ impl EthDevice for PortId {
         self
     }
 
-    fn rx_burst(&self, queue_id: QueueId, rx_pkts: &mut [Option<mbuf::MBuf>]) -> usize {
+    #[inline]
+    fn rx_burst<const N: usize>(&self, queue_id: QueueId, rx_pkts: &mut mbuf::MbufBurst<N>) -> usize {
+        let len = rx_pkts.len();
+        let room = cmp::min(N - len, u16::max_value() as usize);
+
         unsafe {
-            ffi::_rte_eth_rx_burst(*self, queue_id, rx_pkts.as_mut_ptr() as *mut _, rx_pkts.len() as u16) as usize
+            let n = ffi::_rte_eth_rx_burst(*self, queue_id, rx_pkts.as_mut_ptr().add(len), room as u16) as usize;
+
+            rx_pkts.set_len(len + n);
+
+            n
         }
     }
 
-    fn tx_burst<T: AsRaw<Raw = mbuf::RawMBuf>>(&self, queue_id: QueueId, rx_pkts: &mut [T]) -> usize {
+    #[inline]
+    fn tx_burst<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize {
+        let len = cmp::min(tx_pkts.len(), u16::max_value() as usize);
+
         unsafe {
-            if rx_pkts.is_empty() {
-                ffi::_rte_eth_tx_burst(*self, queue_id, ptr::null_mut(), 0) as usize
-            } else {
-                ffi::_rte_eth_tx_burst(*self, queue_id, rx_pkts.as_mut_ptr() as *mut _, rx_pkts.len() as u16) as usize
+            let n = ffi::_rte_eth_tx_burst(*self, queue_id, tx_pkts.as_mut_ptr(), len as u16) as usize;
+
+            tx_pkts.forget_front(n);
+
+            n
+        }
+    }
+
+    #[inline]
+    fn tx_prepare<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize {
+        let len = cmp::min(tx_pkts.len(), u16::max_value() as usize);
+
+        unsafe { ffi::_rte_eth_tx_prepare(*self, queue_id, tx_pkts.as_mut_ptr(), len as u16) as usize }
+    }
+
+    #[inline]
+    fn tx_prepare_burst<const N: usize>(&self, queue_id: QueueId, tx_pkts: &mut mbuf::MbufBurst<N>) -> usize {
+        let mut sent = 0;
+
+        while !tx_pkts.is_empty() {
+            let nb_prep = self.tx_prepare(queue_id, tx_pkts);
+            let nb_tx = unsafe {
+                let n = ffi::_rte_eth_tx_burst(*self, queue_id, tx_pkts.as_mut_ptr(), nb_prep as u16) as usize;
+
+                tx_pkts.forget_front(n);
+
+                n
+            };
+
+            sent += nb_tx;
+
+            if nb_tx < nb_prep || nb_prep == tx_pkts.len() + nb_tx {
+                break;
+            }
+
+            // drop the invalid packet, now at the front of the burst
+            debug!(
+                "port {} queue {} drop invalid packet, {}",
+                self,
+                queue_id,
+                ::errors::rte_error()
+            );
+
+            unsafe {
+                drop(ptr::read(tx_pkts.as_ptr() as *const mbuf::MBuf));
+
+                tx_pkts.forget_front(1);
             }
         }
+
+        sent
+    }
+
+    fn rx_intr_enable(&self, rx_queue_id: QueueId) -> Result<&Self> {
+        rte_check!(unsafe { ffi::rte_eth_dev_rx_intr_enable(*self, rx_queue_id) }; ok => { self })
+    }
+
+    fn rx_intr_disable(&self, rx_queue_id: QueueId) -> Result<&Self> {
+        rte_check!(unsafe { ffi::rte_eth_dev_rx_intr_disable(*self, rx_queue_id) }; ok => { self })
+    }
+
+    fn rx_intr_ctl(&self, epfd: RawFd, op: interrupts::IntrEvent, data: *mut c_void) -> Result<&Self> {
+        rte_check!(unsafe { ffi::rte_eth_dev_rx_intr_ctl(*self, epfd, op as i32, data) }; ok => { self })
+    }
+
+    fn rx_intr_ctl_q(
+        &self,
+        rx_queue_id: QueueId,
+        epfd: RawFd,
+        op: interrupts::IntrEvent,
+        data: *mut c_void,
+    ) -> Result<&Self> {
+        rte_check!(unsafe {
+            ffi::rte_eth_dev_rx_intr_ctl_q(*self, rx_queue_id, epfd, op as i32, data)
+        }; ok => { self })
     }
 
     fn vlan_offload(&self) -> Result<EthVlanOffloadMode> {
@@ -412,6 +621,15 @@ pub trait EthDeviceInfo {
     fn driver_name(&self) -> &str;
 
     fn dev(&self) -> Option<dev::Device>;
+
+    /// Flow types the device is able to use for RSS hashing.
+    fn rss_offloads(&self) -> RssHashFunc;
+
+    /// TX offload capabilities of the device, per port and per queue.
+    fn tx_offloads(&self) -> TxOffload;
+
+    /// TX offload capabilities which could be enabled per queue.
+    fn tx_queue_offloads(&self) -> TxOffload;
 }
 
 pub type RawEthDeviceInfo = ffi::rte_eth_dev_info;
@@ -430,6 +648,21 @@ impl EthDeviceInfo for RawEthDeviceInfo {
             Some(self.device.into())
         }
     }
+
+    #[inline]
+    fn rss_offloads(&self) -> RssHashFunc {
+        RssHashFunc::from_bits_truncate(self.flow_type_rss_offloads)
+    }
+
+    #[inline]
+    fn tx_offloads(&self) -> TxOffload {
+        TxOffload::from_bits_truncate(self.tx_offload_capa)
+    }
+
+    #[inline]
+    fn tx_queue_offloads(&self) -> TxOffload {
+        TxOffload::from_bits_truncate(self.tx_queue_offload_capa)
+    }
 }
 
 pub trait EthDeviceStats {}
@@ -454,6 +687,109 @@ bitflags! {
     }
 }
 
+bitflags! {
+    /// TX offload capabilities of a device.
+    pub struct TxOffload: u64 {
+        const DEV_TX_OFFLOAD_VLAN_INSERT      = 0x0000_0001;
+        const DEV_TX_OFFLOAD_IPV4_CKSUM       = 0x0000_0002;
+        const DEV_TX_OFFLOAD_UDP_CKSUM        = 0x0000_0004;
+        const DEV_TX_OFFLOAD_TCP_CKSUM        = 0x0000_0008;
+        const DEV_TX_OFFLOAD_SCTP_CKSUM       = 0x0000_0010;
+        const DEV_TX_OFFLOAD_TCP_TSO          = 0x0000_0020;
+        const DEV_TX_OFFLOAD_UDP_TSO          = 0x0000_0040;
+        /// Used for tunneling packet.
+        const DEV_TX_OFFLOAD_OUTER_IPV4_CKSUM = 0x0000_0080;
+        const DEV_TX_OFFLOAD_QINQ_INSERT      = 0x0000_0100;
+        /// Used for tunneling packet.
+        const DEV_TX_OFFLOAD_VXLAN_TNL_TSO    = 0x0000_0200;
+        /// Used for tunneling packet.
+        const DEV_TX_OFFLOAD_GRE_TNL_TSO      = 0x0000_0400;
+        /// Used for tunneling packet.
+        const DEV_TX_OFFLOAD_IPIP_TNL_TSO     = 0x0000_0800;
+        /// Used for tunneling packet.
+        const DEV_TX_OFFLOAD_GENEVE_TNL_TSO   = 0x0000_1000;
+        const DEV_TX_OFFLOAD_MACSEC_INSERT    = 0x0000_2000;
+        /// Multiple threads can invoke rte_eth_tx_burst() concurrently on the same TX queue.
+        const DEV_TX_OFFLOAD_MT_LOCKFREE      = 0x0000_4000;
+        /// Device supports multi segment send.
+        const DEV_TX_OFFLOAD_MULTI_SEGS       = 0x0000_8000;
+        /// The mbufs of a queue come from the same pool and have a refcnt of 1.
+        const DEV_TX_OFFLOAD_MBUF_FAST_FREE   = 0x0001_0000;
+        const DEV_TX_OFFLOAD_SECURITY         = 0x0002_0000;
+        /// Generic UDP encapsulated tunnel TSO.
+        const DEV_TX_OFFLOAD_UDP_TNL_TSO      = 0x0004_0000;
+        /// Generic IP encapsulated tunnel TSO.
+        const DEV_TX_OFFLOAD_IP_TNL_TSO       = 0x0008_0000;
+        /// Outer UDP checksum of a tunnel packet.
+        const DEV_TX_OFFLOAD_OUTER_UDP_CKSUM  = 0x0010_0000;
+        /// Send the packets at the timestamp of their mbuf.
+        const DEV_TX_OFFLOAD_SEND_ON_TIMESTAMP = 0x0020_0000;
+    }
+}
+
+impl TxOffload {
+    /// The capabilities needed to honor the TX offload flags of a packet.
+    pub fn required_by(flags: mbuf::OffloadFlags) -> TxOffload {
+        use mbuf::OffloadFlags as F;
+
+        let mut capa = TxOffload::empty();
+
+        if flags.contains(F::PKT_TX_IP_CKSUM) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_IPV4_CKSUM;
+        }
+
+        match flags & F::PKT_TX_L4_MASK {
+            l4 if l4 == F::PKT_TX_TCP_CKSUM => capa |= TxOffload::DEV_TX_OFFLOAD_TCP_CKSUM,
+            l4 if l4 == F::PKT_TX_UDP_CKSUM => capa |= TxOffload::DEV_TX_OFFLOAD_UDP_CKSUM,
+            l4 if l4 == F::PKT_TX_SCTP_CKSUM => capa |= TxOffload::DEV_TX_OFFLOAD_SCTP_CKSUM,
+            _ => {}
+        }
+
+        if flags.contains(F::PKT_TX_OUTER_IP_CKSUM) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_OUTER_IPV4_CKSUM;
+        }
+        if flags.contains(F::PKT_TX_OUTER_UDP_CKSUM) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_OUTER_UDP_CKSUM;
+        }
+
+        if flags.intersects(F::PKT_TX_TCP_SEG | F::PKT_TX_UDP_SEG) {
+            let tunnel = flags & F::PKT_TX_TUNNEL_MASK;
+
+            capa |= if tunnel.is_empty() {
+                if flags.contains(F::PKT_TX_TCP_SEG) {
+                    TxOffload::DEV_TX_OFFLOAD_TCP_TSO
+                } else {
+                    TxOffload::DEV_TX_OFFLOAD_UDP_TSO
+                }
+            } else if tunnel == F::PKT_TX_TUNNEL_VXLAN {
+                TxOffload::DEV_TX_OFFLOAD_VXLAN_TNL_TSO
+            } else if tunnel == F::PKT_TX_TUNNEL_GRE {
+                TxOffload::DEV_TX_OFFLOAD_GRE_TNL_TSO
+            } else if tunnel == F::PKT_TX_TUNNEL_IPIP {
+                TxOffload::DEV_TX_OFFLOAD_IPIP_TNL_TSO
+            } else if tunnel == F::PKT_TX_TUNNEL_GENEVE {
+                TxOffload::DEV_TX_OFFLOAD_GENEVE_TNL_TSO
+            } else if tunnel == F::PKT_TX_TUNNEL_IP {
+                TxOffload::DEV_TX_OFFLOAD_IP_TNL_TSO
+            } else {
+                TxOffload::DEV_TX_OFFLOAD_UDP_TNL_TSO
+            };
+        }
+
+        if flags.intersects(F::PKT_TX_VLAN_PKT) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_VLAN_INSERT;
+        }
+        if flags.contains(F::PKT_TX_QINQ) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_QINQ_INSERT;
+        }
+        if flags.contains(F::PKT_TX_MACSEC) {
+            capa |= TxOffload::DEV_TX_OFFLOAD_MACSEC_INSERT;
+        }
+
+        capa
+    }
+}
+
 /// A set of values to identify what method is to be used to route packets to multiple queues.
 pub type EthRxMultiQueueMode = ffi::rte_eth_rx_mq_mode::Type;
 
@@ -799,6 +1135,10 @@ impl<'a> From<&'a EthConf> for RawEthConf {
     fn from(c: &EthConf) -> Self {
         let mut conf: ffi::rte_eth_conf = Default::default();
 
+        conf.link_speeds = c.link_speeds.bits;
+        conf.lpbk_mode = c.lpbk_mode;
+        conf.dcb_capability_en = c.dcb_capability_en;
+
         if let Some(ref rxmode) = c.rxmode {
             conf.rxmode = *rxmode
         }
@@ -811,6 +1151,7 @@ impl<'a> From<&'a EthConf> for RawEthConf {
             if let Some(ref rss_conf) = adv_conf.rss_conf {
                 let (rss_key, rss_key_len) = rss_conf
                     .key
+                    .as_ref()
                     .map_or_else(|| (ptr::null(), 0), |key| (key.as_ptr(), key.len() as u8));
 
                 conf.rx_adv_conf.rss_conf.rss_key = rss_key as *mut _;
@@ -819,6 +1160,14 @@ impl<'a> From<&'a EthConf> for RawEthConf {
             }
         }
 
+        if let Some(ref fdir_conf) = c.fdir_conf {
+            conf.fdir_conf = *fdir_conf
+        }
+
+        if let Some(ref intr_conf) = c.intr_conf {
+            conf.intr_conf = *intr_conf
+        }
+
         RawEthConf(conf)
     }
 }
@@ -235,6 +235,8 @@ pub const ETHER_TYPE_ARP_BE: u16 = rte_cpu_to_be_16!(ffi::RTE_ETHER_TYPE_ARP as
 pub const ETHER_TYPE_RARP_BE: u16 = rte_cpu_to_be_16!(ffi::RTE_ETHER_TYPE_RARP as u16);
 /// IEEE 802.1Q VLAN tagging.
 pub const ETHER_TYPE_VLAN_BE: u16 = rte_cpu_to_be_16!(ffi::RTE_ETHER_TYPE_VLAN as u16);
+/// IEEE 802.1ad QinQ tagging.
+pub const ETHER_TYPE_QINQ_BE: u16 = rte_cpu_to_be_16!(ffi::RTE_ETHER_TYPE_QINQ as u16);
 /// IEEE 802.1AS 1588 Precise Time Protocol.
 pub const ETHER_TYPE_1588_BE: u16 = rte_cpu_to_be_16!(ffi::RTE_ETHER_TYPE_1588 as u16);
 /// Slow protocols (LACP and Marker).
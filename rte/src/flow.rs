@@ -0,0 +1,591 @@
+//!
+//! Generic flow API, steering or dropping the packets matching a pattern in the device.
+//!
+//! ```ignore
+//! // steer a TCP/IPv4 flow to queue 3 and mark its packets
+//! let flow = flow::Rule::ingress()
+//!     .pattern(flow::Eth::new())
+//!     .pattern(flow::Ipv4::new().src(client, 32).dst(server, 32))
+//!     .pattern(flow::Tcp::new().dst_port(80))
+//!     .action(flow::Action::Queue(3))
+//!     .action(flow::Action::Mark(42))
+//!     .action(flow::Action::Count)
+//!     .create(port_id)?;
+//!
+//! // on the lcore polling queue 3
+//! if m.flow_mark() == Some(42) { ... }
+//! ```
+//!
+use std::ffi::CStr;
+use std::net::{Ipv4Addr, Ipv6Addr};
+use std::os::raw::c_void;
+use std::ptr::{self, NonNull};
+
+use anyhow::{anyhow, Result};
+
+use ffi;
+
+use ethdev::{PortId, QueueId, RssHashFunc};
+use ether;
+
+pub type RawFlowAttr = ffi::rte_flow_attr;
+pub type RawFlowItem = ffi::rte_flow_item;
+pub type RawFlowAction = ffi::rte_flow_action;
+pub type RawFlowError = ffi::rte_flow_error;
+
+/// An error reported by the flow API, with the part of the rule the device rejected.
+#[derive(Debug, thiserror::Error)]
+#[error("flow error, {message} (type {kind}, errno {errno})")]
+pub struct FlowError {
+    pub errno: i32,
+    pub kind: ffi::rte_flow_error_type::Type,
+    pub message: String,
+}
+
+impl FlowError {
+    fn new(ret: i32, err: &RawFlowError) -> Self {
+        FlowError {
+            errno: -ret,
+            kind: err.type_,
+            message: if err.message.is_null() {
+                String::from("unspecified")
+            } else {
+                unsafe { CStr::from_ptr(err.message).to_string_lossy().into_owned() }
+            },
+        }
+    }
+}
+
+fn raw_error() -> RawFlowError {
+    RawFlowError {
+        type_: ffi::rte_flow_error_type::RTE_FLOW_ERROR_TYPE_NONE,
+        cause: ptr::null(),
+        message: ptr::null(),
+    }
+}
+
+fn prefix_mask(prefix_len: u8, bytes: &mut [u8]) {
+    for (i, b) in bytes.iter_mut().enumerate() {
+        let bits = (prefix_len as usize).saturating_sub(i * 8).min(8);
+
+        *b = !(0xffu16 >> bits) as u8;
+    }
+}
+
+macro_rules! flow_item {
+    ($(#[$attr:meta])* $name:ident($raw:ty) = $ty:ident) => {
+        $(#[$attr])*
+        #[derive(Clone, Copy, Debug, Default)]
+        pub struct $name {
+            spec: $raw,
+            mask: $raw,
+        }
+
+        impl From<$name> for Item {
+            fn from(item: $name) -> Self {
+                Item::$name(item)
+            }
+        }
+
+        impl $name {
+            /// Match any header of this type.
+            pub fn new() -> Self {
+                Self::default()
+            }
+
+            fn as_raw(&self) -> RawFlowItem {
+                RawFlowItem {
+                    type_: ffi::rte_flow_item_type::$ty,
+                    spec: &self.spec as *const _ as *const c_void,
+                    last: ptr::null(),
+                    mask: &self.mask as *const _ as *const c_void,
+                }
+            }
+        }
+    };
+}
+
+flow_item!(
+    /// An Ethernet header.
+    Eth(ffi::rte_flow_item_eth) = RTE_FLOW_ITEM_TYPE_ETH
+);
+
+impl Eth {
+    /// Match the source MAC address.
+    pub fn src(mut self, addr: ether::EtherAddr) -> Self {
+        self.spec.src.addr_bytes = *addr.octets();
+        self.mask.src.addr_bytes = [0xff; ether::ETHER_ADDR_LEN];
+        self
+    }
+
+    /// Match the destination MAC address.
+    pub fn dst(mut self, addr: ether::EtherAddr) -> Self {
+        self.spec.dst.addr_bytes = *addr.octets();
+        self.mask.dst.addr_bytes = [0xff; ether::ETHER_ADDR_LEN];
+        self
+    }
+
+    /// Match the EtherType, or the TPID of a VLAN tagged frame.
+    pub fn ether_type(mut self, ether_type: u16) -> Self {
+        self.spec.type_ = ether_type.to_be();
+        self.mask.type_ = 0xffff;
+        self
+    }
+}
+
+flow_item!(
+    /// A 802.1Q VLAN tag.
+    Vlan(ffi::rte_flow_item_vlan) = RTE_FLOW_ITEM_TYPE_VLAN
+);
+
+impl Vlan {
+    /// Match the VLAN identifier.
+    pub fn vid(mut self, vid: u16) -> Self {
+        self.spec.tci = (vid & 0x0fff).to_be();
+        self.mask.tci = 0x0fffu16.to_be();
+        self
+    }
+
+    /// Match the EtherType of the encapsulated frame.
+    pub fn inner_type(mut self, ether_type: u16) -> Self {
+        self.spec.inner_type = ether_type.to_be();
+        self.mask.inner_type = 0xffff;
+        self
+    }
+}
+
+flow_item!(
+    /// An IPv4 header.
+    Ipv4(ffi::rte_flow_item_ipv4) = RTE_FLOW_ITEM_TYPE_IPV4
+);
+
+impl Ipv4 {
+    /// Match the source address prefix.
+    pub fn src(mut self, addr: Ipv4Addr, prefix_len: u8) -> Self {
+        let mut mask = [0; 4];
+
+        prefix_mask(prefix_len, &mut mask);
+
+        self.spec.hdr.src_addr = u32::from_ne_bytes(addr.octets());
+        self.mask.hdr.src_addr = u32::from_ne_bytes(mask);
+        self
+    }
+
+    /// Match the destination address prefix.
+    pub fn dst(mut self, addr: Ipv4Addr, prefix_len: u8) -> Self {
+        let mut mask = [0; 4];
+
+        prefix_mask(prefix_len, &mut mask);
+
+        self.spec.hdr.dst_addr = u32::from_ne_bytes(addr.octets());
+        self.mask.hdr.dst_addr = u32::from_ne_bytes(mask);
+        self
+    }
+
+    /// Match the next protocol, such as `libc::IPPROTO_TCP`.
+    pub fn proto(mut self, proto: u8) -> Self {
+        self.spec.hdr.next_proto_id = proto;
+        self.mask.hdr.next_proto_id = 0xff;
+        self
+    }
+}
+
+flow_item!(
+    /// An IPv6 header.
+    Ipv6(ffi::rte_flow_item_ipv6) = RTE_FLOW_ITEM_TYPE_IPV6
+);
+
+impl Ipv6 {
+    /// Match the source address prefix.
+    pub fn src(mut self, addr: Ipv6Addr, prefix_len: u8) -> Self {
+        self.spec.hdr.src_addr = addr.octets();
+        prefix_mask(prefix_len, &mut self.mask.hdr.src_addr);
+        self
+    }
+
+    /// Match the destination address prefix.
+    pub fn dst(mut self, addr: Ipv6Addr, prefix_len: u8) -> Self {
+        self.spec.hdr.dst_addr = addr.octets();
+        prefix_mask(prefix_len, &mut self.mask.hdr.dst_addr);
+        self
+    }
+
+    /// Match the next header.
+    pub fn proto(mut self, proto: u8) -> Self {
+        self.spec.hdr.proto = proto;
+        self.mask.hdr.proto = 0xff;
+        self
+    }
+}
+
+flow_item!(
+    /// An UDP header.
+    Udp(ffi::rte_flow_item_udp) = RTE_FLOW_ITEM_TYPE_UDP
+);
+
+impl Udp {
+    /// Match the source port.
+    pub fn src_port(mut self, port: u16) -> Self {
+        self.spec.hdr.src_port = port.to_be();
+        self.mask.hdr.src_port = 0xffff;
+        self
+    }
+
+    /// Match the destination port.
+    pub fn dst_port(mut self, port: u16) -> Self {
+        self.spec.hdr.dst_port = port.to_be();
+        self.mask.hdr.dst_port = 0xffff;
+        self
+    }
+}
+
+flow_item!(
+    /// A TCP header.
+    Tcp(ffi::rte_flow_item_tcp) = RTE_FLOW_ITEM_TYPE_TCP
+);
+
+impl Tcp {
+    /// Match the source port.
+    pub fn src_port(mut self, port: u16) -> Self {
+        self.spec.hdr.src_port = port.to_be();
+        self.mask.hdr.src_port = 0xffff;
+        self
+    }
+
+    /// Match the destination port.
+    pub fn dst_port(mut self, port: u16) -> Self {
+        self.spec.hdr.dst_port = port.to_be();
+        self.mask.hdr.dst_port = 0xffff;
+        self
+    }
+
+    /// Match the bits of the TCP flags set in `mask`.
+    pub fn flags(mut self, flags: u8, mask: u8) -> Self {
+        self.spec.hdr.tcp_flags = flags & mask;
+        self.mask.hdr.tcp_flags = mask;
+        self
+    }
+}
+
+/// A pattern item, matching a protocol header from the outermost one.
+#[derive(Clone, Copy, Debug)]
+pub enum Item {
+    Eth(Eth),
+    Vlan(Vlan),
+    Ipv4(Ipv4),
+    Ipv6(Ipv6),
+    Udp(Udp),
+    Tcp(Tcp),
+}
+
+impl Item {
+    fn as_raw(&self) -> RawFlowItem {
+        match self {
+            Item::Eth(item) => item.as_raw(),
+            Item::Vlan(item) => item.as_raw(),
+            Item::Ipv4(item) => item.as_raw(),
+            Item::Ipv6(item) => item.as_raw(),
+            Item::Udp(item) => item.as_raw(),
+            Item::Tcp(item) => item.as_raw(),
+        }
+    }
+}
+
+/// An action applied to the matching packets.
+#[derive(Clone, Debug, PartialEq)]
+pub enum Action {
+    /// Leave the packets to the next rules, or to the default behavior.
+    PassThru,
+    /// Continue the matching in another group.
+    Jump(u32),
+    /// Attach a 32 bits value to the packets, read by `MBuf::flow_mark`.
+    Mark(u32),
+    /// Flag the packets with `PKT_RX_FDIR`, without a mark.
+    Flag,
+    /// Steer the packets to a RX queue.
+    Queue(QueueId),
+    /// Drop the packets in the device.
+    Drop,
+    /// Count the packets and bytes, read by `Flow::query_count`.
+    Count,
+    /// Spread the packets over a set of RX queues.
+    Rss {
+        types: RssHashFunc,
+        queues: Vec<QueueId>,
+        key: Option<Vec<u8>>,
+    },
+}
+
+/// The configuration of an action, as pointed to by `rte_flow_action`.
+enum ActionConf {
+    None,
+    Jump(ffi::rte_flow_action_jump),
+    Mark(ffi::rte_flow_action_mark),
+    Queue(ffi::rte_flow_action_queue),
+    Count(ffi::rte_flow_action_count),
+    Rss(ffi::rte_flow_action_rss),
+}
+
+impl Action {
+    fn conf(&self) -> ActionConf {
+        match self {
+            Action::PassThru | Action::Flag | Action::Drop => ActionConf::None,
+            Action::Jump(group) => ActionConf::Jump(ffi::rte_flow_action_jump { group: *group }),
+            Action::Mark(id) => ActionConf::Mark(ffi::rte_flow_action_mark { id: *id }),
+            Action::Queue(index) => ActionConf::Queue(ffi::rte_flow_action_queue { index: *index }),
+            Action::Count => ActionConf::Count(Default::default()),
+            Action::Rss { types, queues, key } => ActionConf::Rss(ffi::rte_flow_action_rss {
+                func: ffi::rte_eth_hash_function::RTE_ETH_HASH_FUNCTION_DEFAULT,
+                level: 0,
+                types: types.bits(),
+                key_len: key.as_ref().map_or(0, |key| key.len() as u32),
+                queue_num: queues.len() as u32,
+                key: key.as_ref().map_or(ptr::null(), |key| key.as_ptr()),
+                queue: queues.as_ptr(),
+            }),
+        }
+    }
+
+    fn type_(&self) -> ffi::rte_flow_action_type::Type {
+        use ffi::rte_flow_action_type::*;
+
+        match self {
+            Action::PassThru => RTE_FLOW_ACTION_TYPE_PASSTHRU,
+            Action::Jump(_) => RTE_FLOW_ACTION_TYPE_JUMP,
+            Action::Mark(_) => RTE_FLOW_ACTION_TYPE_MARK,
+            Action::Flag => RTE_FLOW_ACTION_TYPE_FLAG,
+            Action::Queue(_) => RTE_FLOW_ACTION_TYPE_QUEUE,
+            Action::Drop => RTE_FLOW_ACTION_TYPE_DROP,
+            Action::Count => RTE_FLOW_ACTION_TYPE_COUNT,
+            Action::Rss { .. } => RTE_FLOW_ACTION_TYPE_RSS,
+        }
+    }
+}
+
+impl ActionConf {
+    fn as_ptr(&self) -> *const c_void {
+        match self {
+            ActionConf::None => ptr::null(),
+            ActionConf::Jump(conf) => conf as *const _ as *const _,
+            ActionConf::Mark(conf) => conf as *const _ as *const _,
+            ActionConf::Queue(conf) => conf as *const _ as *const _,
+            ActionConf::Count(conf) => conf as *const _ as *const _,
+            ActionConf::Rss(conf) => conf as *const _ as *const _,
+        }
+    }
+}
+
+/// A flow rule, with its attributes, pattern and actions.
+#[derive(Clone, Debug, Default)]
+pub struct Rule {
+    attr: RawFlowAttr,
+    pattern: Vec<Item>,
+    actions: Vec<Action>,
+}
+
+impl Rule {
+    /// A rule applied to the received packets.
+    pub fn ingress() -> Self {
+        let mut rule = Rule::default();
+
+        rule.attr.set_ingress(1);
+        rule
+    }
+
+    /// A rule applied to the transmitted packets.
+    pub fn egress() -> Self {
+        let mut rule = Rule::default();
+
+        rule.attr.set_egress(1);
+        rule
+    }
+
+    /// The group of the rule, only reached by a `Jump` when not 0.
+    pub fn group(mut self, group: u32) -> Self {
+        self.attr.group = group;
+        self
+    }
+
+    /// The priority of the rule within its group, 0 being the highest.
+    pub fn priority(mut self, priority: u32) -> Self {
+        self.attr.priority = priority;
+        self
+    }
+
+    /// Append an item to the pattern.
+    pub fn pattern<I: Into<Item>>(mut self, item: I) -> Self {
+        self.pattern.push(item.into());
+        self
+    }
+
+    /// Append an action.
+    pub fn action(mut self, action: Action) -> Self {
+        self.actions.push(action);
+        self
+    }
+
+    /// Call the flow API with the raw rule, which points into `self` and `confs`.
+    fn with_raw<T, F>(&self, f: F) -> T
+    where
+        F: FnOnce(&RawFlowAttr, *const RawFlowItem, *const RawFlowAction) -> T,
+    {
+        let end = RawFlowItem {
+            type_: ffi::rte_flow_item_type::RTE_FLOW_ITEM_TYPE_END,
+            spec: ptr::null(),
+            last: ptr::null(),
+            mask: ptr::null(),
+        };
+        let pattern: Vec<RawFlowItem> = self.pattern.iter().map(Item::as_raw).chain(Some(end)).collect();
+
+        let confs: Vec<ActionConf> = self.actions.iter().map(Action::conf).collect();
+        let actions: Vec<RawFlowAction> = self
+            .actions
+            .iter()
+            .zip(&confs)
+            .map(|(action, conf)| RawFlowAction {
+                type_: action.type_(),
+                conf: conf.as_ptr(),
+            })
+            .chain(Some(RawFlowAction {
+                type_: ffi::rte_flow_action_type::RTE_FLOW_ACTION_TYPE_END,
+                conf: ptr::null(),
+            }))
+            .collect();
+
+        f(&self.attr, pattern.as_ptr(), actions.as_ptr())
+    }
+
+    /// Check whether the device would accept the rule, without creating it.
+    pub fn validate(&self, port_id: PortId) -> Result<()> {
+        let mut err = raw_error();
+        let ret = self.with_raw(|attr, pattern, actions| unsafe {
+            ffi::rte_flow_validate(port_id, attr, pattern, actions, &mut err)
+        });
+
+        if ret == 0 {
+            Ok(())
+        } else {
+            Err(anyhow!(FlowError::new(ret, &err)))
+        }
+    }
+
+    /// Create the rule in the device.
+    pub fn create(&self, port_id: PortId) -> Result<Flow> {
+        let mut err = raw_error();
+        let flow = self.with_raw(|attr, pattern, actions| unsafe {
+            ffi::rte_flow_create(port_id, attr, pattern, actions, &mut err)
+        });
+
+        NonNull::new(flow)
+            .map(|flow| Flow { port_id, flow })
+            .ok_or_else(|| anyhow!(FlowError::new(-ffi::rte_errno(), &err)))
+    }
+}
+
+/// A flow rule created in a device, which stays until it is destroyed or the port flushed.
+#[derive(Debug)]
+pub struct Flow {
+    port_id: PortId,
+    flow: NonNull<ffi::rte_flow>,
+}
+
+unsafe impl Send for Flow {}
+
+impl Flow {
+    /// The port of the rule.
+    pub fn port_id(&self) -> PortId {
+        self.port_id
+    }
+
+    /// Destroy the rule.
+    pub fn destroy(self) -> Result<()> {
+        let mut err = raw_error();
+        let ret = unsafe { ffi::rte_flow_destroy(self.port_id, self.flow.as_ptr(), &mut err) };
+
+        if ret == 0 {
+            Ok(())
+        } else {
+            Err(anyhow!(FlowError::new(ret, &err)))
+        }
+    }
+
+    /// Read the hits and bytes of the `Count` action of the rule, and optionally reset them.
+    pub fn query_count(&self, reset: bool) -> Result<(u64, u64)> {
+        let mut err = raw_error();
+        let mut count: ffi::rte_flow_query_count = Default::default();
+        let action = RawFlowAction {
+            type_: ffi::rte_flow_action_type::RTE_FLOW_ACTION_TYPE_COUNT,
+            conf: ptr::null(),
+        };
+
+        count.set_reset(reset as u32);
+
+        let ret = unsafe {
+            ffi::rte_flow_query(
+                self.port_id,
+                self.flow.as_ptr(),
+                &action,
+                &mut count as *mut _ as *mut c_void,
+                &mut err,
+            )
+        };
+
+        if ret == 0 {
+            Ok((
+                if count.hits_set() != 0 { count.hits } else { 0 },
+                if count.bytes_set() != 0 { count.bytes } else { 0 },
+            ))
+        } else {
+            Err(anyhow!(FlowError::new(ret, &err)))
+        }
+    }
+}
+
+/// Destroy all the flow rules of a port.
+pub fn flush(port_id: PortId) -> Result<()> {
+    let mut err = raw_error();
+    let ret = unsafe { ffi::rte_flow_flush(port_id, &mut err) };
+
+    if ret == 0 {
+        Ok(())
+    } else {
+        Err(anyhow!(FlowError::new(ret, &err)))
+    }
+}
+
+/// Restrict the received packets to the ones matching the flow rules, before the port is started.
+pub fn isolate(port_id: PortId, isolate: bool) -> Result<()> {
+    let mut err = raw_error();
+    let ret = unsafe { ffi::rte_flow_isolate(port_id, isolate as i32, &mut err) };
+
+    if ret == 0 {
+        Ok(())
+    } else {
+        Err(anyhow!(FlowError::new(ret, &err)))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_prefix_mask() {
+        let mut mask = [0; 4];
+
+        prefix_mask(20, &mut mask);
+        assert_eq!(mask, [0xff, 0xff, 0xf0, 0]);
+
+        prefix_mask(32, &mut mask);
+        assert_eq!(mask, [0xff; 4]);
+
+        prefix_mask(0, &mut mask);
+        assert_eq!(mask, [0; 4]);
+
+        let ipv4 = Ipv4::new().dst(Ipv4Addr::new(10, 1, 2, 3), 8).proto(6);
+
+        assert_eq!({ ipv4.spec.hdr.dst_addr }.to_ne_bytes(), [10, 1, 2, 3]);
+        assert_eq!({ ipv4.mask.hdr.dst_addr }.to_ne_bytes(), [0xff, 0, 0, 0]);
+        assert_eq!({ Tcp::new().dst_port(80).spec.hdr.dst_port }, 80u16.to_be());
+    }
+}
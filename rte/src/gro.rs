@@ -0,0 +1,228 @@
+//!
+//! Generic Receive Offload, coalescing the TCP/UDP segments of a flow into large packets.
+//!
+//! The received packets must have their `packet_type` set, by the device or the application,
+//! and only the packets of the enabled types without IP fragment are merged.
+//!
+//! The lightweight mode merges the packets of a burst in place with `reassemble_burst`.
+//! The heavyweight mode keeps the packets in the reassembly tables of a `Context` across bursts,
+//! each polling lcore owns its `Context`, which `RxStage` wraps around `EthDevice::rx_burst`.
+//!
+use std::cmp;
+use std::os::raw::c_void;
+use std::ptr::NonNull;
+
+use anyhow::{anyhow, Result};
+
+use ffi;
+
+use errors::rte_error;
+use ethdev::{EthDevice, PortId, QueueId};
+use mbuf::{self, MbufBurst};
+use memory::SocketId;
+
+bitflags! {
+    /// The packet types to merge.
+    pub struct GroTypes: u64 {
+        const TCP_IPV4 = ffi::RTE_GRO_TCP_IPV4 as u64;
+        const IPV4_VXLAN_TCP_IPV4 = ffi::RTE_GRO_IPV4_VXLAN_TCP_IPV4 as u64;
+        const UDP_IPV4 = ffi::RTE_GRO_UDP_IPV4 as u64;
+        const IPV4_VXLAN_UDP_IPV4 = ffi::RTE_GRO_IPV4_VXLAN_UDP_IPV4 as u64;
+    }
+}
+
+/// The most packets `reassemble_burst` merges at a time, the others are left as is.
+pub const MAX_BURST_ITEM_NUM: usize = ffi::RTE_GRO_MAX_BURST_ITEM_NUM as usize;
+
+pub type RawGroParam = ffi::rte_gro_param;
+
+/// The parameters of the reassembly.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct GroParam {
+    /// The packet types to merge.
+    pub gro_types: GroTypes,
+    /// The most flows a reassembly table tracks.
+    pub max_flow_num: u16,
+    /// The most packets a flow keeps in a reassembly table.
+    pub max_item_per_flow: u16,
+    /// The socket to allocate the reassembly tables from.
+    pub socket_id: SocketId,
+}
+
+impl GroParam {
+    /// Parameters to merge the packets of a burst of `burst_size` packets, from up to `max_flow_num` flows.
+    pub fn new(gro_types: GroTypes, max_flow_num: u16, burst_size: u16) -> Self {
+        GroParam {
+            gro_types,
+            max_flow_num,
+            max_item_per_flow: burst_size,
+            socket_id: ::lcore::socket_id() as SocketId,
+        }
+    }
+
+    fn as_raw(&self) -> RawGroParam {
+        RawGroParam {
+            gro_types: self.gro_types.bits,
+            max_flow_num: self.max_flow_num,
+            max_item_per_flow: self.max_item_per_flow,
+            socket_id: self.socket_id as u16,
+        }
+    }
+}
+
+/// Merge the packets of a burst in place, the merged packets are chained onto the first packet of their flow.
+///
+/// Return the number of packets left in the burst.
+#[inline]
+pub fn reassemble_burst<const N: usize>(pkts: &mut MbufBurst<N>, param: &GroParam) -> usize {
+    let len = cmp::min(pkts.len(), u16::max_value() as usize);
+
+    unsafe {
+        let n = ffi::rte_gro_reassemble_burst(pkts.as_mut_ptr(), len as u16, &param.as_raw()) as usize;
+
+        pkts.set_len(n);
+
+        n
+    }
+}
+
+/// A GRO context, which keeps the packets to merge until they are flushed.
+///
+/// A context must only be used by one lcore at a time.
+pub struct Context {
+    ctx: NonNull<c_void>,
+    gro_types: GroTypes,
+}
+
+unsafe impl Send for Context {}
+
+impl Drop for Context {
+    fn drop(&mut self) {
+        // the reassembly tables don't free the packets they keep
+        let mut pkts = MbufBurst::<32>::new();
+
+        while self.flush(0, &mut pkts) > 0 {
+            pkts.clear();
+        }
+
+        unsafe { ffi::rte_gro_ctx_destroy(self.ctx.as_ptr()) }
+    }
+}
+
+impl Context {
+    /// Create a GRO context with its reassembly tables.
+    pub fn new(param: &GroParam) -> Result<Self> {
+        let ctx = unsafe { ffi::rte_gro_ctx_create(&param.as_raw()) };
+
+        NonNull::new(ctx)
+            .map(|ctx| Context {
+                ctx,
+                gro_types: param.gro_types,
+            })
+            .ok_or_else(|| anyhow!(rte_error()))
+    }
+
+    /// Merge the packets of a burst with the packets of the reassembly tables, or insert them in the tables.
+    ///
+    /// The packets which can't be merged stay in the burst, return their number.
+    #[inline]
+    pub fn reassemble<const N: usize>(&mut self, pkts: &mut MbufBurst<N>) -> usize {
+        let len = pkts.len();
+
+        unsafe {
+            let n = self.reassemble_raw(pkts.as_mut_ptr(), len);
+
+            pkts.set_len(n);
+
+            n
+        }
+    }
+
+    /// Merge a table of packets, the packets which can't be merged are moved to its front.
+    #[inline]
+    unsafe fn reassemble_raw(&mut self, pkts: *mut mbuf::RawMBufPtr, len: usize) -> usize {
+        let n = cmp::min(len, u16::max_value() as usize);
+        let nb = ffi::rte_gro_reassemble(pkts, n as u16, self.ctx.as_ptr()) as usize;
+
+        // the packets beyond `u16::MAX` were not processed
+        pkts.add(n).copy_to(pkts.add(nb), len - n);
+
+        nb + len - n
+    }
+
+    /// Append the packets kept for more than `timeout_cycles` TSC cycles to the burst, up to its remaining capacity.
+    #[inline]
+    pub fn flush<const N: usize>(&mut self, timeout_cycles: u64, pkts: &mut MbufBurst<N>) -> usize {
+        let len = pkts.len();
+        let room = cmp::min(N - len, u16::max_value() as usize);
+
+        unsafe {
+            let n = ffi::rte_gro_timeout_flush(
+                self.ctx.as_ptr(),
+                timeout_cycles,
+                self.gro_types.bits,
+                pkts.as_mut_ptr().add(len),
+                room as u16,
+            ) as usize;
+
+            pkts.set_len(len + n);
+
+            n
+        }
+    }
+
+    /// The number of packets kept in the reassembly tables.
+    pub fn pkt_count(&self) -> usize {
+        unsafe { ffi::rte_gro_get_pkt_count(self.ctx.as_ptr()) as usize }
+    }
+}
+
+/// A RX queue with a GRO context, owned by the lcore polling the queue.
+pub struct RxStage {
+    port_id: PortId,
+    queue_id: QueueId,
+    ctx: Context,
+    timeout_cycles: u64,
+}
+
+impl RxStage {
+    /// Merge the packets received from a queue, and keep them for at most `timeout_cycles` TSC cycles.
+    pub fn new(port_id: PortId, queue_id: QueueId, param: &GroParam, timeout_cycles: u64) -> Result<Self> {
+        Ok(RxStage {
+            port_id,
+            queue_id,
+            ctx: Context::new(param)?,
+            timeout_cycles,
+        })
+    }
+
+    /// The GRO context of the queue.
+    pub fn context(&mut self) -> &mut Context {
+        &mut self.ctx
+    }
+
+    /// Receive a burst from the queue, merge it, and append the packets which can't be merged
+    /// and the merged packets which timed out to the burst.
+    ///
+    /// Return the number of packets appended to the burst.
+    #[inline]
+    pub fn rx_burst<const N: usize>(&mut self, rx_pkts: &mut MbufBurst<N>) -> usize {
+        let len = rx_pkts.len();
+        let nb_rx = self.port_id.rx_burst(self.queue_id, rx_pkts);
+
+        if nb_rx > 0 {
+            // only merge the received packets, not the ones already in the burst
+            unsafe {
+                let n = self.ctx.reassemble_raw(rx_pkts.as_mut_ptr().add(len), nb_rx);
+
+                rx_pkts.set_len(len + n);
+            }
+        }
+
+        if self.ctx.pkt_count() > 0 {
+            self.ctx.flush(self.timeout_cycles, rx_pkts);
+        }
+
+        rx_pkts.len() - len
+    }
+}
@@ -0,0 +1,239 @@
+//!
+//! Generic Segmentation Offload, splitting the large TCP/UDP packets into MTU sized segments in software.
+//!
+//! The packets to segment must have `PKT_TX_TCP_SEG` or `PKT_TX_UDP_SEG` set in their offload flags,
+//! with the header lengths of their TX offload fields, the others go through untouched.
+//! Each segment is a direct mbuf holding a copy of the headers, chained to an indirect mbuf
+//! pointing to the payload of the original packet, so the device must accept multi-segment packets.
+//!
+//! Each transmitting lcore owns its `Context`, which `TxStage` wraps around `EthDevice::tx_burst`.
+//!
+use std::cmp;
+use std::ptr;
+
+use anyhow::{anyhow, Result};
+use libc;
+
+use ffi;
+
+use errors::ErrorKind::OsError;
+use ethdev::{EthDevice, PortId, QueueId, TxOffload};
+use mbuf::{MBuf, MbufBurst};
+use mempool::MemoryPool;
+use utils::AsRaw;
+
+bitflags! {
+    /// The packet types to segment, named after the TSO capabilities of the devices.
+    pub struct GsoTypes: u32 {
+        const TCP_TSO = TxOffload::DEV_TX_OFFLOAD_TCP_TSO.bits() as u32;
+        const VXLAN_TNL_TSO = TxOffload::DEV_TX_OFFLOAD_VXLAN_TNL_TSO.bits() as u32;
+        const GRE_TNL_TSO = TxOffload::DEV_TX_OFFLOAD_GRE_TNL_TSO.bits() as u32;
+        const UDP_TSO = TxOffload::DEV_TX_OFFLOAD_UDP_TSO.bits() as u32;
+    }
+}
+
+/// The smallest segment size, headers included.
+pub const SEG_SIZE_MIN: usize = ffi::RTE_GSO_SEG_SIZE_MIN as usize;
+
+pub type RawGsoContext = ffi::rte_gso_ctx;
+
+/// A GSO context, with the pools of the segments.
+#[derive(Clone, Copy, Debug)]
+pub struct Context(RawGsoContext);
+
+unsafe impl Send for Context {}
+
+impl Context {
+    /// Segment the packets of the given types into segments of at most `gso_size` bytes, headers included.
+    ///
+    /// The headers of the segments are allocated from `direct_pool`,
+    /// and the mbufs pointing to the payload from `indirect_pool`, which could have no data room.
+    pub fn new(
+        direct_pool: &MemoryPool,
+        indirect_pool: &MemoryPool,
+        gso_types: GsoTypes,
+        gso_size: u16,
+    ) -> Result<Self> {
+        if (gso_size as usize) < SEG_SIZE_MIN {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        Ok(Context(RawGsoContext {
+            direct_pool: direct_pool.as_raw_mut(),
+            indirect_pool: indirect_pool.as_raw_mut(),
+            flag: 0,
+            gso_types: gso_types.bits,
+            gso_size,
+        }))
+    }
+
+    /// Keep the IPv4 identifier of the original packet in all the segments, instead of incrementing it.
+    pub fn ipid_fixed(mut self, fixed: bool) -> Self {
+        if fixed {
+            self.0.flag |= u64::from(ffi::RTE_GSO_FLAG_IPID_FIXED);
+        } else {
+            self.0.flag &= !u64::from(ffi::RTE_GSO_FLAG_IPID_FIXED);
+        }
+        self
+    }
+
+    /// The largest segment size, headers included.
+    pub fn gso_size(&self) -> usize {
+        self.0.gso_size as usize
+    }
+
+    /// The most segments a packet could be split into.
+    pub fn max_segments(&self, m: &MBuf) -> usize {
+        let hdr_len = unsafe {
+            let tx = &m.__bindgen_anon_3.__bindgen_anon_1;
+
+            (tx.outer_l2_len() + tx.outer_l3_len() + tx.l2_len() + tx.l3_len() + tx.l4_len()) as usize
+        };
+        let payload = cmp::max(self.gso_size().saturating_sub(hdr_len), 1);
+
+        cmp::max(
+            ((m.pkt_len as usize).saturating_sub(hdr_len) + payload - 1) / payload,
+            1,
+        )
+    }
+
+    /// Segment a packet, and append the segments or the packet itself, when it doesn't need to be segmented,
+    /// to the burst.
+    ///
+    /// Return the number of packets appended to the burst, the packet is freed on error.
+    #[inline]
+    pub fn segment<const N: usize>(&self, m: MBuf, pkts: &mut MbufBurst<N>) -> Result<usize> {
+        let len = pkts.len();
+        let room = cmp::min(N - len, u16::max_value() as usize);
+
+        if room == 0 {
+            return Err(anyhow!(OsError(libc::ENOSPC)));
+        }
+
+        let ret = unsafe { ffi::rte_gso_segment(m.as_raw_mut(), &self.0, pkts.as_mut_ptr().add(len), room as u16) };
+
+        match ret {
+            0 => {
+                let _ = pkts.push(m);
+
+                Ok(1)
+            }
+            n if n > 0 => {
+                // the segments hold a reference on the payload of the packet
+                unsafe { pkts.set_len(len + n as usize) };
+
+                Ok(n as usize)
+            }
+            err => Err(anyhow!(OsError(-err))),
+        }
+    }
+}
+
+/// A TX queue with a GSO context, owned by the lcore sending on the queue.
+pub struct TxStage<const N: usize> {
+    port_id: PortId,
+    queue_id: QueueId,
+    ctx: Context,
+    segs: MbufBurst<N>,
+    dropped: usize,
+}
+
+impl<const N: usize> TxStage<N> {
+    /// Segment the packets sent to a queue, through a buffer of `N` segments.
+    pub fn new(port_id: PortId, queue_id: QueueId, ctx: Context) -> Self {
+        TxStage {
+            port_id,
+            queue_id,
+            ctx,
+            segs: MbufBurst::new(),
+            dropped: 0,
+        }
+    }
+
+    /// The GSO context of the queue.
+    pub fn context(&self) -> &Context {
+        &self.ctx
+    }
+
+    /// The number of packets which failed to be segmented, or had more segments than the buffer.
+    pub fn dropped(&self) -> usize {
+        self.dropped
+    }
+
+    /// The segments not sent yet.
+    pub fn pending(&self) -> usize {
+        self.segs.len()
+    }
+
+    /// Segment the packets taken from the front of the burst, and send the segments.
+    ///
+    /// The packets which don't fit in the segment buffer stay in the burst,
+    /// as the sent packets of `EthDevice::tx_burst`, return the number of packets taken.
+    #[inline]
+    pub fn tx_burst<const M: usize>(&mut self, tx_pkts: &mut MbufBurst<M>) -> usize {
+        let mut taken = 0;
+
+        for m in tx_pkts.iter() {
+            if self.ctx.max_segments(m) > N - self.segs.len() {
+                self.flush();
+
+                if !self.segs.is_empty() {
+                    break;
+                }
+                // the packet would never fit in the segment buffer
+                if self.ctx.max_segments(m) > N {
+                    drop(unsafe { ptr::read(m) });
+
+                    self.dropped += 1;
+                    taken += 1;
+
+                    continue;
+                }
+            }
+
+            // the packet is moved out of the burst, which forgets it below
+            let m = unsafe { ptr::read(m) };
+
+            if self.ctx.segment(m, &mut self.segs).is_err() {
+                self.dropped += 1;
+            }
+
+            taken += 1;
+        }
+
+        unsafe { tx_pkts.forget_front(taken) };
+
+        self.flush();
+
+        taken
+    }
+
+    /// Send the pending segments, return the number of segments sent.
+    #[inline]
+    pub fn flush(&mut self) -> usize {
+        if self.segs.is_empty() {
+            0
+        } else {
+            self.port_id.tx_burst(self.queue_id, &mut self.segs)
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_gso_types() {
+        // the DEV_TX_OFFLOAD_* values which rte_gso_segment checks the types against
+        assert_eq!(GsoTypes::TCP_TSO.bits(), 0x0000_0020);
+        assert_eq!(GsoTypes::UDP_TSO.bits(), 0x0000_0040);
+        assert_eq!(GsoTypes::VXLAN_TNL_TSO.bits(), 0x0000_0200);
+        assert_eq!(GsoTypes::GRE_TNL_TSO.bits(), 0x0000_0400);
+
+        // UDP_TSO used to be DEV_TX_OFFLOAD_SECURITY
+        assert!(
+            !GsoTypes::from_bits_truncate(TxOffload::DEV_TX_OFFLOAD_SECURITY.bits() as u32).contains(GsoTypes::UDP_TSO)
+        );
+    }
+}
@@ -0,0 +1,382 @@
+//!
+//! Cuckoo hash tables, to look up the fixed-size keys of the packets, such as MAC addresses or 5-tuples.
+//!
+//! A `Hash<K>` returns the position of a key in the table, which indexes the data of the application,
+//! or stores a `usize` value along each key.
+//!
+//! The keys are hashed and compared as raw bytes, so `K` must not have padding bytes,
+//! such as a `#[repr(C, packed)]` struct or an array of bytes.
+//!
+//! Lookups are multi-thread safe, while the table is updated through `&mut self`,
+//! unless it is created with the multi-writer or the read-write concurrency flags.
+//!
+use std::cmp;
+use std::ffi::CStr;
+use std::marker::PhantomData;
+use std::mem::{self, MaybeUninit};
+use std::os::raw::c_void;
+use std::ptr::{self, NonNull};
+use std::slice;
+
+use anyhow::{anyhow, Result};
+use libc;
+
+use ffi;
+
+use errors::{AsResult, ErrorKind::OsError};
+use mbuf::{MBuf, MbufBurst};
+use memory::SocketId;
+use utils::{AsCString, AsRaw};
+
+bitflags! {
+    /// Flags supplied at hash table creation.
+    pub struct HashFlags: u8 {
+        /// Use hardware transactional memory, if available.
+        const RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT = ffi::RTE_HASH_EXTRA_FLAGS_TRANS_MEM_SUPPORT as u8;
+        /// Several threads may add keys at the same time.
+        const RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD = ffi::RTE_HASH_EXTRA_FLAGS_MULTI_WRITER_ADD as u8;
+        /// The lookups may run concurrently with the updates, with a reader-writer lock.
+        const RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY = ffi::RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY as u8;
+        /// Chain the keys which don't fit in their buckets in an extendable table.
+        const RTE_HASH_EXTRA_FLAGS_EXT_TABLE = ffi::RTE_HASH_EXTRA_FLAGS_EXT_TABLE as u8;
+        /// Don't free the position of a deleted key, until `free_key_with_position`.
+        const RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL = ffi::RTE_HASH_EXTRA_FLAGS_NO_FREE_ON_DEL as u8;
+        /// The lookups may run concurrently with the updates, lock-free.
+        const RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF = ffi::RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF as u8;
+    }
+}
+
+/// The most keys looked up by a single call of the bulk lookup functions.
+pub const LOOKUP_BULK_MAX: usize = ffi::RTE_HASH_LOOKUP_BULK_MAX as usize;
+
+/// The function which hashes the keys.
+pub type HashFunc = unsafe extern "C" fn(key: *const c_void, key_len: u32, init_val: u32) -> u32;
+
+/// The hash signature of a key.
+pub type Signature = ffi::hash_sig_t;
+
+/// Calculate the CRC32 hash of the data, with the SSE4.2 or ARMv8 instructions when available.
+#[inline]
+pub fn crc(data: &[u8], init_val: u32) -> u32 {
+    unsafe { ffi::_rte_hash_crc(data.as_ptr() as *const _, data.len() as u32, init_val) }
+}
+
+/// Calculate the Jenkins hash of the data.
+#[inline]
+pub fn jhash(data: &[u8], init_val: u32) -> u32 {
+    unsafe { ffi::_rte_jhash(data.as_ptr() as *const _, data.len() as u32, init_val) }
+}
+
+pub type RawHash = ffi::rte_hash;
+pub type RawHashParameters = ffi::rte_hash_parameters;
+
+/// A hash table of `K` keys.
+pub struct Hash<K> {
+    raw: NonNull<RawHash>,
+    phantom: PhantomData<K>,
+}
+
+unsafe impl<K: Send> Send for Hash<K> {}
+unsafe impl<K: Sync> Sync for Hash<K> {}
+
+impl<K> AsRaw for Hash<K> {
+    type Raw = RawHash;
+
+    fn as_raw(&self) -> *const Self::Raw {
+        self.raw.as_ptr()
+    }
+
+    fn as_raw_mut(&self) -> *mut Self::Raw {
+        self.raw.as_ptr()
+    }
+}
+
+impl<K: Copy> Hash<K> {
+    const KEY_LEN: u32 = mem::size_of::<K>() as u32;
+
+    /// Create a hash table named name, with room for `entries` keys,
+    /// hashed with the CRC32 hash when available, or the Jenkins hash otherwise.
+    pub fn create<S: AsRef<str>>(name: S, entries: usize, socket_id: SocketId, flags: HashFlags) -> Result<Self> {
+        Self::create_with(name, entries, socket_id, flags, None, 0)
+    }
+
+    /// Create a hash table named name, with room for `entries` keys, hashed with `hash_func`.
+    pub fn create_with<S: AsRef<str>>(
+        name: S,
+        entries: usize,
+        socket_id: SocketId,
+        flags: HashFlags,
+        hash_func: Option<HashFunc>,
+        hash_func_init_val: u32,
+    ) -> Result<Self> {
+        if Self::KEY_LEN == 0 || entries > ffi::RTE_HASH_ENTRIES_MAX as usize {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let name = name.as_cstring();
+        let params = RawHashParameters {
+            name: name.as_ptr(),
+            entries: entries as u32,
+            key_len: Self::KEY_LEN,
+            hash_func,
+            hash_func_init_val,
+            socket_id,
+            extra_flag: flags.bits,
+            ..Default::default()
+        };
+
+        unsafe { ffi::rte_hash_create(&params) }.as_result().map(|raw| Hash {
+            raw,
+            phantom: PhantomData,
+        })
+    }
+
+    /// Search a hash table from its name.
+    ///
+    /// The table must have been created with the same key type.
+    pub fn find_existing<S: AsRef<str>>(name: S) -> Result<Self> {
+        let name = name.as_cstring();
+
+        unsafe { ffi::rte_hash_find_existing(name.as_ptr()) }
+            .as_result()
+            .map(|raw| Hash {
+                raw,
+                phantom: PhantomData,
+            })
+    }
+
+    /// De-allocate all memory used by the hash table.
+    pub fn free(self) {
+        unsafe { ffi::rte_hash_free(self.as_raw_mut()) }
+    }
+
+    /// Remove all the keys.
+    pub fn reset(&mut self) {
+        unsafe { ffi::rte_hash_reset(self.as_raw_mut()) }
+    }
+
+    /// The number of keys in the table.
+    pub fn count(&self) -> usize {
+        cmp::max(unsafe { ffi::rte_hash_count(self.as_raw()) }, 0) as usize
+    }
+
+    /// The signature of a key, to reuse across the `*_with_hash` functions.
+    #[inline]
+    pub fn hash(&self, key: &K) -> Signature {
+        unsafe { ffi::rte_hash_hash(self.as_raw(), key_ptr(key)) }
+    }
+
+    /// Add a key, and return its position, which is unique for the key.
+    pub fn add(&mut self, key: &K) -> Result<usize> {
+        position(unsafe { ffi::rte_hash_add_key(self.as_raw(), key_ptr(key)) })
+    }
+
+    /// Add a key with its precomputed signature, and return its position.
+    pub fn add_with_hash(&mut self, key: &K, sig: Signature) -> Result<usize> {
+        position(unsafe { ffi::rte_hash_add_key_with_hash(self.as_raw(), key_ptr(key), sig) })
+    }
+
+    /// Add a key with a value, or update the value of an existing key.
+    pub fn add_data(&mut self, key: &K, data: usize) -> Result<()> {
+        position(unsafe { ffi::rte_hash_add_key_data(self.as_raw(), key_ptr(key), data as *mut c_void) }).map(|_| ())
+    }
+
+    /// Remove a key, and return the position it had.
+    pub fn del(&mut self, key: &K) -> Result<usize> {
+        position(unsafe { ffi::rte_hash_del_key(self.as_raw(), key_ptr(key)) })
+    }
+
+    /// Find the position of a key.
+    #[inline]
+    pub fn lookup(&self, key: &K) -> Option<usize> {
+        position(unsafe { ffi::rte_hash_lookup(self.as_raw(), key_ptr(key)) }).ok()
+    }
+
+    /// Find the position of a key with its precomputed signature.
+    #[inline]
+    pub fn lookup_with_hash(&self, key: &K, sig: Signature) -> Option<usize> {
+        position(unsafe { ffi::rte_hash_lookup_with_hash(self.as_raw(), key_ptr(key), sig) }).ok()
+    }
+
+    /// Find the value of a key.
+    #[inline]
+    pub fn lookup_data(&self, key: &K) -> Option<usize> {
+        let mut data = ptr::null_mut();
+
+        position(unsafe { ffi::rte_hash_lookup_data(self.as_raw(), key_ptr(key), &mut data) })
+            .ok()
+            .map(|_| data as usize)
+    }
+
+    /// Find the positions of the keys, and return the number of keys found.
+    #[inline]
+    pub fn lookup_bulk(&self, keys: &[K], positions: &mut [Option<usize>]) -> usize {
+        let n = cmp::min(keys.len(), positions.len());
+        let mut hits = 0;
+
+        for (keys, positions) in keys[..n]
+            .chunks(LOOKUP_BULK_MAX)
+            .zip(positions[..n].chunks_mut(LOOKUP_BULK_MAX))
+        {
+            let mut ptrs = [ptr::null(); LOOKUP_BULK_MAX];
+            let mut pos = [0; LOOKUP_BULK_MAX];
+
+            for (p, key) in ptrs.iter_mut().zip(keys) {
+                *p = key_ptr(key);
+            }
+
+            unsafe { ffi::rte_hash_lookup_bulk(self.as_raw(), ptrs.as_mut_ptr(), keys.len() as u32, pos.as_mut_ptr()) };
+
+            for (p, &pos) in positions.iter_mut().zip(&pos[..]) {
+                *p = position(pos).ok();
+            }
+
+            hits += positions.iter().filter(|p| p.is_some()).count();
+        }
+
+        hits
+    }
+
+    /// Find the values of the keys, and return the number of keys found.
+    #[inline]
+    pub fn lookup_bulk_data(&self, keys: &[K], values: &mut [Option<usize>]) -> usize {
+        let n = cmp::min(keys.len(), values.len());
+        let mut hits = 0;
+
+        for (keys, values) in keys[..n]
+            .chunks(LOOKUP_BULK_MAX)
+            .zip(values[..n].chunks_mut(LOOKUP_BULK_MAX))
+        {
+            let mut ptrs = [ptr::null(); LOOKUP_BULK_MAX];
+            let mut data = [ptr::null_mut(); LOOKUP_BULK_MAX];
+            let mut hit_mask = 0u64;
+
+            for (p, key) in ptrs.iter_mut().zip(keys) {
+                *p = key_ptr(key);
+            }
+
+            let ret = unsafe {
+                ffi::rte_hash_lookup_bulk_data(
+                    self.as_raw(),
+                    ptrs.as_mut_ptr(),
+                    keys.len() as u32,
+                    &mut hit_mask,
+                    data.as_mut_ptr(),
+                )
+            };
+
+            for (i, v) in values.iter_mut().enumerate() {
+                *v = if ret > 0 && hit_mask & (1 << i) != 0 {
+                    Some(data[i] as usize)
+                } else {
+                    None
+                };
+            }
+
+            hits += cmp::max(ret, 0) as usize;
+        }
+
+        hits
+    }
+
+    /// Find the positions of the keys of the packets of a burst, extracted by `key`,
+    /// while prefetching the headers of the next packets.
+    ///
+    /// Return the number of keys found.
+    #[inline]
+    pub fn lookup_burst<F, const N: usize>(&self, pkts: &MbufBurst<N>, key: F, positions: &mut [Option<usize>]) -> usize
+    where
+        F: FnMut(&MBuf) -> K,
+    {
+        let mut keys = BurstKeys::<K, N>::new(pkts, key);
+
+        self.lookup_bulk(keys.as_slice(), positions)
+    }
+
+    /// Find the values of the keys of the packets of a burst, extracted by `key`,
+    /// while prefetching the headers of the next packets.
+    ///
+    /// Return the number of keys found.
+    #[inline]
+    pub fn lookup_burst_data<F, const N: usize>(
+        &self,
+        pkts: &MbufBurst<N>,
+        key: F,
+        values: &mut [Option<usize>],
+    ) -> usize
+    where
+        F: FnMut(&MBuf) -> K,
+    {
+        let mut keys = BurstKeys::<K, N>::new(pkts, key);
+
+        self.lookup_bulk_data(keys.as_slice(), values)
+    }
+
+    /// Iterate over the keys and their values.
+    pub fn iter(&self) -> Iter<'_, K> {
+        Iter { hash: self, next: 0 }
+    }
+}
+
+#[inline(always)]
+fn key_ptr<K>(key: &K) -> *const c_void {
+    key as *const K as *const c_void
+}
+
+#[inline(always)]
+fn position(ret: i32) -> Result<usize> {
+    if ret < 0 {
+        Err(anyhow!(OsError(-ret)))
+    } else {
+        Ok(ret as usize)
+    }
+}
+
+/// The keys of the packets of a burst, on the stack.
+struct BurstKeys<K, const N: usize> {
+    len: usize,
+    keys: [MaybeUninit<K>; N],
+}
+
+impl<K: Copy, const N: usize> BurstKeys<K, N> {
+    #[inline(always)]
+    fn new<F: FnMut(&MBuf) -> K>(pkts: &MbufBurst<N>, mut key: F) -> Self {
+        let mut keys = BurstKeys {
+            len: pkts.len(),
+            // an array of `MaybeUninit` doesn't need initialization
+            keys: unsafe { MaybeUninit::uninit().assume_init() },
+        };
+
+        pkts.for_each_prefetched(|i, m| keys.keys[i] = MaybeUninit::new(key(m)));
+
+        keys
+    }
+
+    #[inline(always)]
+    fn as_slice(&mut self) -> &[K] {
+        unsafe { slice::from_raw_parts(self.keys.as_ptr() as *const K, self.len) }
+    }
+}
+
+/// An iterator over the keys of a hash table and their values.
+pub struct Iter<'a, K: 'a> {
+    hash: &'a Hash<K>,
+    next: u32,
+}
+
+impl<'a, K: Copy> Iterator for Iter<'a, K> {
+    type Item = (K, usize);
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let mut key = ptr::null();
+        let mut data = ptr::null_mut();
+
+        let ret = unsafe { ffi::rte_hash_iterate(self.hash.as_raw(), &mut key, &mut data, &mut self.next) };
+
+        if ret < 0 {
+            None
+        } else {
+            Some((unsafe { ptr::read_unaligned(key as *const K) }, data as usize))
+        }
+    }
+}
@@ -1,3 +1,6 @@
+use std::mem;
+use std::slice;
+
 use ffi;
 
 /// IPv4 Header
@@ -5,3 +8,74 @@ pub type Ipv4Hdr = ffi::rte_ipv4_hdr;
 
 /// IPv6 Header
 pub type Ipv6Hdr = ffi::rte_ipv6_hdr;
+
+/// The bytes summed into a 32-bit accumulator, before the 16-bit words could overflow it.
+const CKSUM_BLOCK_LEN: usize = 2 << 16;
+
+simd_dispatch! {
+    /// The 16-bit ones' complement sum of the data, not complemented, as `rte_raw_cksum`.
+    ///
+    /// The words are summed in the byte order of the data, the sum is in the same byte order.
+    pub fn raw_cksum(data: &[u8]) -> u16 {
+        let mut sum = 0u64;
+
+        for block in data.chunks(CKSUM_BLOCK_LEN) {
+            let words = block.chunks_exact(2);
+            let tail = words.remainder();
+
+            sum += words.map(|w| u16::from_ne_bytes([w[0], w[1]]) as u32).sum::<u32>() as u64;
+
+            if let Some(&b) = tail.first() {
+                sum += u16::from_ne_bytes([b, 0]) as u64;
+            }
+        }
+
+        while sum >> 16 != 0 {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+
+        sum as u16
+    }
+}
+
+/// The checksum of an IPv4 header without options, as `rte_ipv4_cksum`.
+///
+/// The `hdr_checksum` field must be 0.
+#[inline]
+pub fn ipv4_cksum(hdr: &Ipv4Hdr) -> u16 {
+    let data = unsafe { slice::from_raw_parts(hdr as *const Ipv4Hdr as *const u8, mem::size_of::<Ipv4Hdr>()) };
+    let cksum = raw_cksum(data);
+
+    if cksum == 0xffff {
+        cksum
+    } else {
+        !cksum
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_cksum() {
+        // RFC 1071 example
+        let data = [0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7];
+
+        assert_eq!(u16::from_be(raw_cksum(&data)), 0xddf2);
+        assert_eq!(raw_cksum(&[]), 0);
+        assert_eq!(u16::from_be(raw_cksum(&[0x12, 0x34, 0x56])), 0x6834);
+
+        let mut hdr: Ipv4Hdr = unsafe { mem::zeroed() };
+
+        hdr.version_ihl = 0x45;
+        hdr.total_length = 0x73u16.to_be();
+        hdr.fragment_offset = 0x4000u16.to_be();
+        hdr.time_to_live = 64;
+        hdr.next_proto_id = 17;
+        hdr.src_addr = 0xc0a8_0001u32.to_be();
+        hdr.dst_addr = 0xc0a8_00c7u32.to_be();
+
+        assert_eq!(u16::from_be(ipv4_cksum(&hdr)), 0xb861);
+    }
+}
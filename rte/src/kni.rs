@@ -201,7 +201,7 @@ impl KniDevice {
     /// It handles allocating the mbufs for KNI interface alloc queue.
     ///
     pub fn tx_burst(&self, mbufs: &mut [mbuf::RawMBufPtr]) -> usize {
-        unsafe { ffi::rte_kni_rx_burst(self.0, mbufs.as_mut_ptr(), mbufs.len() as u32) as usize }
+        unsafe { ffi::rte_kni_tx_burst(self.0, mbufs.as_mut_ptr(), mbufs.len() as u32) as usize }
     }
 
     /// Register KNI request handling for a specified port,
@@ -43,14 +43,30 @@ pub mod mbuf;
 pub mod mempool;
 pub mod ring;
 
+pub mod hash;
+pub mod lpm;
+pub mod pcap;
+
 pub mod bond;
 pub mod ethdev;
+pub mod flow;
+pub mod gro;
+pub mod gso;
 pub mod kni;
 pub mod pci;
+pub mod pipeline;
+pub mod placement;
+pub mod supervisor;
+pub mod telemetry;
+pub mod timer;
 
 pub mod arp;
+pub mod classify;
 pub mod ether;
 pub mod ip;
+pub mod packet;
+pub mod tcp;
+pub mod udp;
 
 #[macro_use]
 pub mod cmdline;
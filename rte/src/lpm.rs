@@ -0,0 +1,300 @@
+//!
+//! Longest Prefix Match tables, to route the IPv4 and IPv6 packets.
+//!
+//! Each rule maps a prefix to a next hop, such as a port or an index of a next hop table,
+//! a lookup returns the next hop of the most specific rule matching the address.
+//! The IPv4 next hops are 24 bits wide.
+//!
+//! Lookups are multi-thread safe, while the rules are updated through `&mut self`.
+//!
+use std::cmp;
+use std::net::{Ipv4Addr, Ipv6Addr};
+use std::ptr::NonNull;
+
+use anyhow::{anyhow, Result};
+use libc;
+
+use ffi;
+
+use errors::{AsResult, ErrorKind::OsError};
+use mbuf::{MBuf, MbufBurst};
+use memory::SocketId;
+use utils::{AsCString, AsRaw};
+
+/// The longest IPv4 prefix.
+pub const MAX_DEPTH: u8 = ffi::RTE_LPM_MAX_DEPTH as u8;
+
+/// The longest IPv6 prefix.
+pub const MAX_DEPTH6: u8 = ffi::RTE_LPM6_MAX_DEPTH as u8;
+
+/// The largest IPv4 next hop.
+pub const MAX_NEXT_HOP: u32 = ffi::RTE_LPM_LOOKUP_SUCCESS - 1;
+
+/// The addresses looked up at a time by `Lpm::lookup_bulk`.
+const BULK_SIZE: usize = 64;
+
+pub type RawLpm = ffi::rte_lpm;
+pub type RawLpmConfig = ffi::rte_lpm_config;
+
+/// An IPv4 LPM table.
+pub struct Lpm(NonNull<RawLpm>);
+
+unsafe impl Send for Lpm {}
+unsafe impl Sync for Lpm {}
+
+impl AsRaw for Lpm {
+    type Raw = RawLpm;
+
+    fn as_raw(&self) -> *const Self::Raw {
+        self.0.as_ptr()
+    }
+
+    fn as_raw_mut(&self) -> *mut Self::Raw {
+        self.0.as_ptr()
+    }
+}
+
+impl Lpm {
+    /// Create an LPM table named name, with room for `max_rules` rules,
+    /// and `number_tbl8s` groups of 256 entries for the prefixes longer than 24 bits.
+    pub fn create<S: AsRef<str>>(name: S, socket_id: SocketId, max_rules: u32, number_tbl8s: u32) -> Result<Self> {
+        let name = name.as_cstring();
+        let config = RawLpmConfig {
+            max_rules,
+            number_tbl8s,
+            flags: 0,
+        };
+
+        unsafe { ffi::rte_lpm_create(name.as_ptr(), socket_id, &config) }
+            .as_result()
+            .map(Lpm)
+    }
+
+    /// De-allocate all memory used by the table.
+    pub fn free(self) {
+        unsafe { ffi::rte_lpm_free(self.as_raw_mut()) }
+    }
+
+    /// Add a rule, or update the next hop of an existing rule.
+    pub fn add(&mut self, addr: Ipv4Addr, depth: u8, next_hop: u32) -> Result<()> {
+        if next_hop > MAX_NEXT_HOP {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        rte_check!(unsafe { ffi::rte_lpm_add(self.as_raw_mut(), u32::from(addr), depth, next_hop) })
+    }
+
+    /// Delete a rule.
+    pub fn delete(&mut self, addr: Ipv4Addr, depth: u8) -> Result<()> {
+        rte_check!(unsafe { ffi::rte_lpm_delete(self.as_raw_mut(), u32::from(addr), depth) })
+    }
+
+    /// Delete all the rules.
+    pub fn delete_all(&mut self) {
+        unsafe { ffi::rte_lpm_delete_all(self.as_raw_mut()) }
+    }
+
+    /// The next hop of a rule, if it exists.
+    pub fn rule(&self, addr: Ipv4Addr, depth: u8) -> Option<u32> {
+        let mut next_hop = 0;
+
+        if unsafe { ffi::rte_lpm_is_rule_present(self.as_raw_mut(), u32::from(addr), depth, &mut next_hop) } == 1 {
+            Some(next_hop)
+        } else {
+            None
+        }
+    }
+
+    /// The next hop of an address.
+    #[inline]
+    pub fn lookup(&self, addr: Ipv4Addr) -> Option<u32> {
+        let mut next_hop = 0;
+
+        if unsafe { ffi::_rte_lpm_lookup(self.as_raw_mut(), u32::from(addr), &mut next_hop) } == 0 {
+            Some(next_hop)
+        } else {
+            None
+        }
+    }
+
+    /// The next hops of addresses in host byte order, return the number of addresses found.
+    #[inline]
+    pub fn lookup_bulk(&self, addrs: &[u32], next_hops: &mut [Option<u32>]) -> usize {
+        let n = cmp::min(addrs.len(), next_hops.len());
+        let mut hits = 0;
+
+        for (addrs, next_hops) in addrs[..n].chunks(BULK_SIZE).zip(next_hops[..n].chunks_mut(BULK_SIZE)) {
+            let mut hops = [0; BULK_SIZE];
+
+            unsafe { ffi::_rte_lpm_lookup_bulk(self.as_raw(), addrs.as_ptr(), hops.as_mut_ptr(), addrs.len() as u32) };
+
+            for (next_hop, &hop) in next_hops.iter_mut().zip(&hops[..]) {
+                *next_hop = if hop & ffi::RTE_LPM_LOOKUP_SUCCESS != 0 {
+                    hits += 1;
+
+                    Some(hop & MAX_NEXT_HOP)
+                } else {
+                    None
+                };
+            }
+        }
+
+        hits
+    }
+
+    /// The next hops of the packets of a burst, from their address in host byte order extracted by `addr`,
+    /// while prefetching the headers of the next packets.
+    ///
+    /// Return the number of addresses found.
+    #[inline]
+    pub fn lookup_burst<F, const N: usize>(
+        &self,
+        pkts: &MbufBurst<N>,
+        mut addr: F,
+        next_hops: &mut [Option<u32>],
+    ) -> usize
+    where
+        F: FnMut(&MBuf) -> u32,
+    {
+        let mut addrs = [0; N];
+
+        pkts.for_each_prefetched(|i, m| addrs[i] = addr(m));
+
+        self.lookup_bulk(&addrs[..pkts.len()], next_hops)
+    }
+}
+
+pub type RawLpm6 = ffi::rte_lpm6;
+pub type RawLpm6Config = ffi::rte_lpm6_config;
+
+/// An IPv6 LPM table.
+pub struct Lpm6(NonNull<RawLpm6>);
+
+unsafe impl Send for Lpm6 {}
+unsafe impl Sync for Lpm6 {}
+
+impl AsRaw for Lpm6 {
+    type Raw = RawLpm6;
+
+    fn as_raw(&self) -> *const Self::Raw {
+        self.0.as_ptr()
+    }
+
+    fn as_raw_mut(&self) -> *mut Self::Raw {
+        self.0.as_ptr()
+    }
+}
+
+impl Lpm6 {
+    /// Create an LPM table named name, with room for `max_rules` rules,
+    /// and `number_tbl8s` groups of 256 entries for the prefixes longer than 24 bits,
+    /// a prefix taking one more group for each further 8 bits, up to /128.
+    pub fn create<S: AsRef<str>>(name: S, socket_id: SocketId, max_rules: u32, number_tbl8s: u32) -> Result<Self> {
+        let name = name.as_cstring();
+        let config = RawLpm6Config {
+            max_rules,
+            number_tbl8s,
+            flags: 0,
+        };
+
+        unsafe { ffi::rte_lpm6_create(name.as_ptr(), socket_id, &config) }
+            .as_result()
+            .map(Lpm6)
+    }
+
+    /// De-allocate all memory used by the table.
+    pub fn free(self) {
+        unsafe { ffi::rte_lpm6_free(self.as_raw_mut()) }
+    }
+
+    /// Add a rule, or update the next hop of an existing rule.
+    pub fn add(&mut self, addr: Ipv6Addr, depth: u8, next_hop: u32) -> Result<()> {
+        rte_check!(unsafe { ffi::rte_lpm6_add(self.as_raw_mut(), addr.octets().as_ptr(), depth, next_hop) })
+    }
+
+    /// Delete a rule.
+    pub fn delete(&mut self, addr: Ipv6Addr, depth: u8) -> Result<()> {
+        rte_check!(unsafe { ffi::rte_lpm6_delete(self.as_raw_mut(), addr.octets().as_ptr(), depth) })
+    }
+
+    /// Delete all the rules.
+    pub fn delete_all(&mut self) {
+        unsafe { ffi::rte_lpm6_delete_all(self.as_raw_mut()) }
+    }
+
+    /// The next hop of a rule, if it exists.
+    pub fn rule(&self, addr: Ipv6Addr, depth: u8) -> Option<u32> {
+        let mut next_hop = 0;
+
+        if unsafe { ffi::rte_lpm6_is_rule_present(self.as_raw_mut(), addr.octets().as_ptr(), depth, &mut next_hop) }
+            == 1
+        {
+            Some(next_hop)
+        } else {
+            None
+        }
+    }
+
+    /// The next hop of an address.
+    #[inline]
+    pub fn lookup(&self, addr: &Ipv6Addr) -> Option<u32> {
+        let mut next_hop = 0;
+
+        if unsafe { ffi::rte_lpm6_lookup(self.as_raw(), addr.octets().as_ptr(), &mut next_hop) } == 0 {
+            Some(next_hop)
+        } else {
+            None
+        }
+    }
+
+    /// The next hops of addresses, return the number of addresses found.
+    #[inline]
+    pub fn lookup_bulk(&self, addrs: &mut [[u8; 16]], next_hops: &mut [Option<u32>]) -> usize {
+        let n = cmp::min(addrs.len(), next_hops.len());
+        let mut hits = 0;
+
+        for (addrs, next_hops) in addrs[..n]
+            .chunks_mut(BULK_SIZE)
+            .zip(next_hops[..n].chunks_mut(BULK_SIZE))
+        {
+            let mut hops = [0; BULK_SIZE];
+
+            unsafe {
+                ffi::rte_lpm6_lookup_bulk_func(self.as_raw(), addrs.as_mut_ptr(), hops.as_mut_ptr(), addrs.len() as u32)
+            };
+
+            for (next_hop, &hop) in next_hops.iter_mut().zip(&hops[..]) {
+                *next_hop = if hop >= 0 {
+                    hits += 1;
+
+                    Some(hop as u32)
+                } else {
+                    None
+                };
+            }
+        }
+
+        hits
+    }
+
+    /// The next hops of the packets of a burst, from their address extracted by `addr`,
+    /// while prefetching the headers of the next packets.
+    ///
+    /// Return the number of addresses found.
+    #[inline]
+    pub fn lookup_burst<F, const N: usize>(
+        &self,
+        pkts: &MbufBurst<N>,
+        mut addr: F,
+        next_hops: &mut [Option<u32>],
+    ) -> usize
+    where
+        F: FnMut(&MBuf) -> [u8; 16],
+    {
+        let mut addrs = [[0; 16]; N];
+
+        pkts.for_each_prefetched(|i, m| addrs[i] = addr(m));
+
+        self.lookup_bulk(&mut addrs[..pkts.len()], next_hops)
+    }
+}
@@ -22,17 +22,25 @@
 //! http://www.kohala.com/start/tcpipiv2.html
 //!
 use std::ffi::CStr;
+use std::marker::PhantomData;
+use std::mem::{self, MaybeUninit};
+use std::ops::{Deref, DerefMut, Range};
 use std::os::raw::c_void;
 use std::os::unix::io::AsRawFd;
+use std::panic::{self, AssertUnwindSafe};
 use std::ptr::{self, NonNull};
 use std::slice;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
-use anyhow::Result;
+use anyhow::{anyhow, Result};
 use cfile;
+use libc;
 
 use ffi;
 
-use errors::AsResult;
+use errors::{AsResult, ErrorKind::OsError};
+use ethdev;
+use memory::SocketId;
 use mempool;
 use utils::{AsCString, AsRaw, CallbackContext, IntoRaw};
 
@@ -309,9 +317,8 @@ impl Clone for MBuf {
 
 impl Drop for MBuf {
     fn drop(&mut self) {
-        if self.refcnt_update(-1) == 0 {
-            self.free()
-        }
+        // `rte_pktmbuf_free` drops a reference itself and only returns the segments to the pool once unused.
+        unsafe { ffi::_rte_pktmbuf_free(self.as_raw_mut()) }
     }
 }
 
@@ -327,6 +334,17 @@ impl MBuf {
         unsafe { ffi::_rte_mbuf_prefetch_part2(self.as_raw_mut()) }
     }
 
+    /// Prefetch the first cache line of the packet data, where the headers are.
+    #[inline(always)]
+    pub fn prefetch_data(&self) {
+        #[cfg(target_arch = "x86_64")]
+        unsafe {
+            use std::arch::x86_64::{_mm_prefetch, _MM_HINT_T0};
+
+            _mm_prefetch::<_MM_HINT_T0>(self.mtod::<i8>().as_ptr())
+        }
+    }
+
     /// Return the mbuf owning the data buffer address of an indirect mbuf.
     pub fn from_indirect(other: &MBuf) -> Self {
         unsafe { ffi::_rte_mbuf_from_indirect(other.as_raw_mut()) }.into()
@@ -352,6 +370,34 @@ impl MBuf {
         OffloadFlags::from_bits_truncate(self.ol_flags)
     }
 
+    /// The mark of a received packet, set by a `flow::Action::Mark` of the device.
+    #[inline]
+    pub fn flow_mark(&self) -> Option<u32> {
+        if self.ol_flags & OffloadFlags::PKT_RX_FDIR_ID.bits != 0 {
+            Some(unsafe { self.__bindgen_anon_2.hash.fdir.hi })
+        } else {
+            None
+        }
+    }
+
+    /// The RSS hash of a received packet, computed by the device.
+    #[inline]
+    pub fn rss_hash(&self) -> Option<u32> {
+        if self.ol_flags & OffloadFlags::PKT_RX_RSS_HASH.bits != 0 {
+            Some(unsafe { self.__bindgen_anon_2.hash.rss })
+        } else {
+            None
+        }
+    }
+
+    /// The L2/L3/L4 and tunnel types of a received packet, as `RTE_PTYPE_*` flags.
+    ///
+    /// The types are only set by the devices supporting them, see `EthDevice::supported_ptypes`.
+    #[inline]
+    pub fn packet_type(&self) -> u32 {
+        unsafe { self.__bindgen_anon_1.packet_type }
+    }
+
     /// The mbuf is cloned by mbuf indirection.
     #[inline]
     pub fn has_cloned(&self) -> bool {
@@ -388,26 +434,26 @@ impl MBuf {
     }
 
     /// Free a segment of a packet mbuf into its original mempool.
-    pub fn free_seg(&mut self) {
-        unsafe { ffi::_rte_pktmbuf_free_seg(self.as_raw_mut()) }
+    pub fn free_seg(self) {
+        unsafe { ffi::_rte_pktmbuf_free_seg(self.into_raw()) }
     }
 
     /// Free a packet mbuf back into its original mempool.
     ///
     /// Free an mbuf, and all its segments in case of chained buffers.
     /// Each segment is added back into its original mempool.
-    pub fn free(&mut self) {
-        unsafe { ffi::_rte_pktmbuf_free(self.as_raw_mut()) }
+    pub fn free(self) {
+        unsafe { ffi::_rte_pktmbuf_free(self.into_raw()) }
     }
 
     /// Put mbuf back into its original mempool.
-    pub fn raw_free(&mut self) {
+    pub fn raw_free(self) {
         debug_assert!(self.is_direct());
         debug_assert_eq!(self.refcnt_read(), 1);
         debug_assert!(self.next.is_null());
         debug_assert_eq!(self.nb_segs, 1);
 
-        unsafe { ffi::_rte_mbuf_raw_free(self.as_raw_mut()) }
+        unsafe { ffi::_rte_mbuf_raw_free(self.into_raw()) }
     }
 
     /// Reads the value of an mbuf's refcnt.
@@ -541,6 +587,19 @@ impl MBuf {
         unsafe { ffi::_rte_pktmbuf_is_contiguous(self.as_raw()) != 0 }
     }
 
+    /// The data of the first segment.
+    pub fn data(&self) -> &[u8] {
+        unsafe { slice::from_raw_parts(self.mtod::<u8>().as_ptr(), self.data_len()) }
+    }
+
+    /// Iterate the data of the segments of the packet, without copying them.
+    pub fn segments(&self) -> Segments<'_> {
+        Segments {
+            seg: self.as_raw(),
+            phantom: PhantomData,
+        }
+    }
+
     /// Read len data bytes in a mbuf at specified offset.
     pub fn read(&self, off: usize, buf: &mut [u8]) -> Option<&[u8]> {
         unsafe {
@@ -568,6 +627,64 @@ impl MBuf {
             .map(|_| ())
     }
 
+    #[inline]
+    fn tx_offload_fields(&self) -> &ffi::rte_mbuf__bindgen_ty_3__bindgen_ty_1 {
+        unsafe { &self.__bindgen_anon_3.__bindgen_anon_1 }
+    }
+
+    /// L2 (MAC) header length, of the inner header for a tunnel packet.
+    #[inline]
+    pub fn l2_len(&self) -> usize {
+        self.tx_offload_fields().l2_len() as usize
+    }
+
+    /// L3 (IP) header length, of the inner header for a tunnel packet.
+    #[inline]
+    pub fn l3_len(&self) -> usize {
+        self.tx_offload_fields().l3_len() as usize
+    }
+
+    /// L4 (TCP/UDP) header length, of the inner header for a tunnel packet.
+    #[inline]
+    pub fn l4_len(&self) -> usize {
+        self.tx_offload_fields().l4_len() as usize
+    }
+
+    /// TCP TSO segment size.
+    #[inline]
+    pub fn tso_segsz(&self) -> usize {
+        self.tx_offload_fields().tso_segsz() as usize
+    }
+
+    /// Outer L2 (MAC) header length of a tunnel packet.
+    #[inline]
+    pub fn outer_l2_len(&self) -> usize {
+        self.tx_offload_fields().outer_l2_len() as usize
+    }
+
+    /// Outer L3 (IP) header length of a tunnel packet.
+    #[inline]
+    pub fn outer_l3_len(&self) -> usize {
+        self.tx_offload_fields().outer_l3_len() as usize
+    }
+
+    /// Request checksum or segmentation offloads for the packet.
+    ///
+    /// The offloads are only written to the mbuf by `TxOffloadBuilder::apply`.
+    #[inline]
+    pub fn tx_offload(&mut self) -> TxOffloadBuilder<'_> {
+        TxOffloadBuilder {
+            m: self,
+            flags: OffloadFlags::empty(),
+            l2_len: 0,
+            l3_len: 0,
+            l4_len: 0,
+            tso_segsz: 0,
+            outer_l2_len: 0,
+            outer_l3_len: 0,
+        }
+    }
+
     /// Linearize data in mbuf.
     ///
     /// This function moves the mbuf data in the first segment if there is enough tailroom.
@@ -588,6 +705,187 @@ impl MBuf {
     }
 }
 
+/// A typed builder of the TX offload flags and header lengths of a packet.
+///
+/// ```ignore
+/// // TCP/IPv4 with the IP and TCP checksums computed by the device
+/// m.tx_offload().ether().ipv4(true).tcp(tcp_hdr_len).apply()?;
+/// ```
+///
+/// As required by the devices, the IPv4 checksum must be zeroed and the TCP/UDP checksum set
+/// to the pseudo header checksum, which `EthDevice::tx_prepare` does for the drivers needing it.
+pub struct TxOffloadBuilder<'a> {
+    m: &'a mut MBuf,
+    flags: OffloadFlags,
+    l2_len: u16,
+    l3_len: u16,
+    l4_len: u16,
+    tso_segsz: u16,
+    outer_l2_len: u16,
+    outer_l3_len: u16,
+}
+
+impl<'a> TxOffloadBuilder<'a> {
+    /// The checksum, segmentation and tunnel flags set by the builder,
+    /// the other TX flags of the packet, like `PKT_TX_VLAN_PKT`, are kept by `apply`.
+    fn owned_flags() -> OffloadFlags {
+        OffloadFlags::PKT_TX_IPV4
+            | OffloadFlags::PKT_TX_IPV6
+            | OffloadFlags::PKT_TX_IP_CKSUM
+            | OffloadFlags::PKT_TX_L4_MASK
+            | OffloadFlags::PKT_TX_TCP_SEG
+            | OffloadFlags::PKT_TX_UDP_SEG
+            | OffloadFlags::PKT_TX_TUNNEL_MASK
+            | OffloadFlags::PKT_TX_OUTER_IPV4
+            | OffloadFlags::PKT_TX_OUTER_IPV6
+            | OffloadFlags::PKT_TX_OUTER_IP_CKSUM
+            | OffloadFlags::PKT_TX_OUTER_UDP_CKSUM
+    }
+
+    /// An Ethernet header without VLAN.
+    pub fn ether(self) -> Self {
+        self.l2(mem::size_of::<ffi::rte_ether_hdr>() as u16)
+    }
+
+    /// The length of the L2 header, VLAN tags included.
+    pub fn l2(mut self, len: u16) -> Self {
+        self.l2_len = len;
+        self
+    }
+
+    /// An IPv4 header of 20 bytes, with its checksum computed by the device.
+    pub fn ipv4(self, cksum: bool) -> Self {
+        self.ipv4_with_len(mem::size_of::<ffi::rte_ipv4_hdr>() as u16, cksum)
+    }
+
+    /// An IPv4 header with options.
+    pub fn ipv4_with_len(mut self, len: u16, cksum: bool) -> Self {
+        self.flags.insert(OffloadFlags::PKT_TX_IPV4);
+        self.flags.set(OffloadFlags::PKT_TX_IP_CKSUM, cksum);
+        self.l3_len = len;
+        self
+    }
+
+    /// An IPv6 header, extension headers included.
+    pub fn ipv6(mut self, len: u16) -> Self {
+        self.flags.insert(OffloadFlags::PKT_TX_IPV6);
+        self.l3_len = len;
+        self
+    }
+
+    /// A TCP header with its checksum computed by the device.
+    pub fn tcp(mut self, len: u16) -> Self {
+        self.flags.remove(OffloadFlags::PKT_TX_L4_MASK);
+        self.flags.insert(OffloadFlags::PKT_TX_TCP_CKSUM);
+        self.l4_len = len;
+        self
+    }
+
+    /// An UDP header with its checksum computed by the device.
+    pub fn udp(mut self) -> Self {
+        self.flags.remove(OffloadFlags::PKT_TX_L4_MASK);
+        self.flags.insert(OffloadFlags::PKT_TX_UDP_CKSUM);
+        self.l4_len = mem::size_of::<ffi::rte_udp_hdr>() as u16;
+        self
+    }
+
+    /// A SCTP header with its CRC computed by the device.
+    pub fn sctp(mut self) -> Self {
+        self.flags.remove(OffloadFlags::PKT_TX_L4_MASK);
+        self.flags.insert(OffloadFlags::PKT_TX_SCTP_CKSUM);
+        self.l4_len = mem::size_of::<ffi::rte_sctp_hdr>() as u16;
+        self
+    }
+
+    /// Segment a TCP packet in segments of `mss` bytes of payload, which implies the TCP checksum.
+    pub fn tcp_seg(mut self, len: u16, mss: u16) -> Self {
+        self = self.tcp(len);
+        self.flags.insert(OffloadFlags::PKT_TX_TCP_SEG);
+        self.tso_segsz = mss;
+        self
+    }
+
+    /// Fragment an UDP packet in fragments of `mss` bytes of payload.
+    pub fn udp_seg(mut self, mss: u16) -> Self {
+        self = self.udp();
+        self.flags.insert(OffloadFlags::PKT_TX_UDP_SEG);
+        self.tso_segsz = mss;
+        self
+    }
+
+    /// The outer headers of a tunnel packet, the other lengths and flags being for the inner headers.
+    ///
+    /// For a VXLAN packet, `l2` is the length of the outer UDP and VXLAN headers followed by the inner L2 header.
+    pub fn tunnel(mut self, tunnel: OffloadFlags, outer_l2_len: u16, outer_l3_len: u16) -> Self {
+        self.flags.remove(OffloadFlags::PKT_TX_TUNNEL_MASK);
+        self.flags.insert(tunnel & OffloadFlags::PKT_TX_TUNNEL_MASK);
+        self.outer_l2_len = outer_l2_len;
+        self.outer_l3_len = outer_l3_len;
+        self
+    }
+
+    /// An outer IPv4 header, with its checksum computed by the device.
+    pub fn outer_ipv4(mut self, cksum: bool) -> Self {
+        self.flags.insert(OffloadFlags::PKT_TX_OUTER_IPV4);
+        self.flags.set(OffloadFlags::PKT_TX_OUTER_IP_CKSUM, cksum);
+        self
+    }
+
+    /// An outer IPv6 header.
+    pub fn outer_ipv6(mut self) -> Self {
+        self.flags.insert(OffloadFlags::PKT_TX_OUTER_IPV6);
+        self
+    }
+
+    /// Compute the outer UDP checksum of a tunnel packet in the device.
+    pub fn outer_udp_cksum(mut self) -> Self {
+        self.flags.insert(OffloadFlags::PKT_TX_OUTER_UDP_CKSUM);
+        self
+    }
+
+    /// The requested offload flags.
+    pub fn flags(&self) -> OffloadFlags {
+        self.flags
+    }
+
+    /// Check the device supports the requested offloads, given its `tx_offload_capa`.
+    pub fn check(&self, capa: ethdev::TxOffload) -> Result<()> {
+        if capa.contains(ethdev::TxOffload::required_by(self.flags)) {
+            Ok(())
+        } else {
+            Err(anyhow!(OsError(libc::ENOTSUP)))
+        }
+    }
+
+    /// Write the offload flags and header lengths to the mbuf, and validate them.
+    pub fn apply(self) -> Result<()> {
+        // the widths of the mbuf bitfields
+        if self.l2_len >= 1 << 7
+            || self.l3_len >= 1 << 9
+            || self.l4_len >= 1 << 8
+            || self.outer_l2_len >= 1 << 7
+            || self.outer_l3_len >= 1 << 9
+        {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        {
+            let tx = unsafe { &mut self.m.__bindgen_anon_3.__bindgen_anon_1 };
+
+            tx.set_l2_len(self.l2_len.into());
+            tx.set_l3_len(self.l3_len.into());
+            tx.set_l4_len(self.l4_len.into());
+            tx.set_tso_segsz(self.tso_segsz.into());
+            tx.set_outer_l2_len(self.outer_l2_len.into());
+            tx.set_outer_l3_len(self.outer_l3_len.into());
+        }
+
+        self.m.ol_flags = (self.m.ol_flags & !Self::owned_flags().bits) | self.flags.bits;
+
+        self.m.validate_tx_offload()
+    }
+}
+
 pub type RawExtSharedInfo = ffi::rte_mbuf_ext_shared_info;
 pub type RawExtSharedInfoPtr = *mut ffi::rte_mbuf_ext_shared_info;
 
@@ -686,6 +984,523 @@ impl MBuf {
     }
 }
 
+/// An iterator over the data of the segments of a packet.
+pub struct Segments<'a> {
+    seg: *const RawMBuf,
+    phantom: PhantomData<&'a MBuf>,
+}
+
+impl<'a> Iterator for Segments<'a> {
+    type Item = &'a [u8];
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let seg = unsafe { self.seg.as_ref()? };
+
+        self.seg = seg.next;
+
+        Some(unsafe {
+            slice::from_raw_parts(
+                (seg.buf_addr as *const u8).add(seg.data_off as usize),
+                seg.data_len as usize,
+            )
+        })
+    }
+}
+
+/// The longest segment of an external buffer a mbuf could point to, its `buf_len` being 16 bits.
+pub const EXTBUF_MAX_SEG_LEN: usize = u16::max_value() as usize;
+
+/// The shared info of an `ExtBuf`, stored behind its data in the same memzone.
+struct ExtBufShared {
+    shinfo: RawExtSharedInfo,
+    mz: *const ffi::rte_memzone,
+    on_free: Option<Box<dyn FnOnce() + Send>>,
+}
+
+/// A reference counted, IOVA-contiguous hugepage buffer, which mbufs point to without copying it.
+///
+/// The handle and each attached mbuf hold a reference on the shared info of the buffer,
+/// the memory is released, and the `on_free` callback called, when the last of them is freed.
+/// It could happen on any lcore, when the driver frees the transmitted mbufs.
+pub struct ExtBuf {
+    shared: NonNull<ExtBufShared>,
+    buf: NonNull<u8>,
+    len: usize,
+    iova: ffi::rte_iova_t,
+}
+
+unsafe impl Send for ExtBuf {}
+unsafe impl Sync for ExtBuf {}
+
+impl Drop for ExtBuf {
+    fn drop(&mut self) {
+        unsafe {
+            if ffi::_rte_mbuf_ext_refcnt_update(self.shinfo(), -1) == 0 {
+                extbuf_free_stub(self.buf.as_ptr() as *mut _, self.shared.as_ptr() as *mut _)
+            }
+        }
+    }
+}
+
+impl Clone for ExtBuf {
+    fn clone(&self) -> Self {
+        unsafe { ffi::_rte_mbuf_ext_refcnt_update(self.shinfo(), 1) };
+
+        ExtBuf { ..*self }
+    }
+}
+
+impl Deref for ExtBuf {
+    type Target = [u8];
+
+    fn deref(&self) -> &Self::Target {
+        unsafe { slice::from_raw_parts(self.buf.as_ptr(), self.len) }
+    }
+}
+
+impl ExtBuf {
+    /// Reserve a zeroed buffer of `len` bytes on a socket.
+    pub fn new(len: usize, socket_id: SocketId) -> Result<Self> {
+        static NEXT_ID: AtomicUsize = AtomicUsize::new(0);
+
+        if len == 0 {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let name = format!("extbuf_{}", NEXT_ID.fetch_add(1, Ordering::Relaxed));
+        let off = (len + mem::align_of::<ExtBufShared>() - 1) & !(mem::align_of::<ExtBufShared>() - 1);
+
+        unsafe {
+            let mz = ffi::rte_memzone_reserve_aligned(
+                name.as_cstring().as_ptr(),
+                off + mem::size_of::<ExtBufShared>(),
+                socket_id,
+                ffi::RTE_MEMZONE_IOVA_CONTIG,
+                ffi::RTE_CACHE_LINE_SIZE,
+            );
+
+            if mz.is_null() {
+                return Err(anyhow!(::errors::rte_error()));
+            }
+
+            let buf = (*mz).__bindgen_anon_1.addr as *mut u8;
+            let shared = buf.add(off) as *mut ExtBufShared;
+
+            ptr::write_bytes(buf, 0, len);
+            ptr::write(
+                shared,
+                ExtBufShared {
+                    shinfo: RawExtSharedInfo {
+                        free_cb: Some(extbuf_free_stub),
+                        fcb_opaque: shared as *mut _,
+                        refcnt: 0,
+                    },
+                    mz,
+                    on_free: None,
+                },
+            );
+            ffi::_rte_mbuf_ext_refcnt_set(&mut (*shared).shinfo, 1);
+
+            Ok(ExtBuf {
+                shared: NonNull::new_unchecked(shared),
+                buf: NonNull::new_unchecked(buf),
+                len,
+                iova: (*mz).iova,
+            })
+        }
+    }
+
+    /// Copy a payload once into a new buffer on a socket, to transmit it many times.
+    pub fn from_slice(data: &[u8], socket_id: SocketId) -> Result<Self> {
+        let mut buf = Self::new(data.len(), socket_id)?;
+
+        buf.get_mut().unwrap().copy_from_slice(data);
+
+        Ok(buf)
+    }
+
+    fn shinfo(&self) -> *mut RawExtSharedInfo {
+        unsafe { &mut (*self.shared.as_ptr()).shinfo }
+    }
+
+    /// The length of the buffer.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Test if the buffer is empty.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// The IO address of the buffer.
+    pub fn iova(&self) -> ffi::rte_iova_t {
+        self.iova
+    }
+
+    /// The number of references on the buffer, from the handles and the attached mbufs.
+    pub fn refcnt(&self) -> u16 {
+        unsafe { ffi::_rte_mbuf_ext_refcnt_read(self.shinfo()) }
+    }
+
+    /// A mutable access to the buffer, unless other handles or mbufs may read it.
+    pub fn get_mut(&mut self) -> Option<&mut [u8]> {
+        if self.refcnt() == 1 {
+            Some(unsafe { slice::from_raw_parts_mut(self.buf.as_ptr(), self.len) })
+        } else {
+            None
+        }
+    }
+
+    /// Set a callback called once the buffer is released, unless other handles or mbufs refer to it.
+    ///
+    /// The callback runs in the mbuf free path of DPDK, a panic in it is caught and logged.
+    pub fn on_free<F: FnOnce() + Send + 'static>(&mut self, f: F) -> Result<()> {
+        if self.refcnt() == 1 {
+            unsafe { (*self.shared.as_ptr()).on_free = Some(Box::new(f)) };
+
+            Ok(())
+        } else {
+            Err(anyhow!(OsError(libc::EBUSY)))
+        }
+    }
+
+    /// Attach a range of the buffer to a direct mbuf, which then holds a reference on it.
+    ///
+    /// The data of the mbuf is the whole range, of at most `EXTBUF_MAX_SEG_LEN` bytes.
+    pub fn attach(&self, m: &mut MBuf, range: Range<usize>) -> Result<()> {
+        if range.start > range.end || range.end > self.len || range.len() > EXTBUF_MAX_SEG_LEN {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+        if !m.is_direct() || m.refcnt_read() != 1 {
+            return Err(anyhow!(OsError(libc::EBUSY)));
+        }
+
+        unsafe {
+            ffi::_rte_mbuf_ext_refcnt_update(self.shinfo(), 1);
+            ffi::_rte_pktmbuf_attach_extbuf(
+                m.as_raw_mut(),
+                self.buf.as_ptr().add(range.start) as *mut _,
+                self.iova + range.start as u64,
+                range.len() as u16,
+                self.shinfo(),
+            );
+        }
+
+        m.data_len = range.len() as u16;
+        m.pkt_len = range.len() as u32;
+
+        Ok(())
+    }
+
+    /// Build a packet over a range of the buffer, with a chain of mbufs from a pool pointing to it.
+    pub fn packet<P: MBufPool>(&self, pool: &mut P, range: Range<usize>) -> Result<MBuf> {
+        if range.start >= range.end || range.end > self.len {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let mut head = pool.alloc()?;
+
+        self.attach(&mut head, range.start..range.end.min(range.start + EXTBUF_MAX_SEG_LEN))?;
+
+        let mut off = range.start + head.data_len as usize;
+
+        while off < range.end {
+            let mut seg = pool.alloc()?;
+            let end = range.end.min(off + EXTBUF_MAX_SEG_LEN);
+
+            self.attach(&mut seg, off..end)?;
+
+            rte_check!(unsafe { ffi::_rte_pktmbuf_chain(head.as_raw_mut(), seg.as_raw_mut()) })?;
+
+            mem::forget(seg);
+
+            off = end;
+        }
+
+        Ok(head)
+    }
+}
+
+unsafe extern "C" fn extbuf_free_stub(_addr: *mut c_void, opaque: *mut c_void) {
+    let shared = ptr::read(opaque as *mut ExtBufShared);
+
+    // called from the mbuf free path of DPDK, a panic must not unwind across it
+    if let Some(on_free) = shared.on_free {
+        if panic::catch_unwind(AssertUnwindSafe(on_free)).is_err() {
+            error!("the on_free callback of an external buffer panicked");
+        }
+    }
+
+    ffi::rte_memzone_free(shared.mz);
+}
+
+/// How many packets ahead `MbufBurst::for_each_prefetched` prefetches.
+pub const PREFETCH_OFFSET: usize = 3;
+
+/// A fixed-capacity burst of packets, without heap allocation.
+///
+/// `EthDevice::rx_burst` appends the received packets to the burst,
+/// and `EthDevice::tx_burst` takes the sent packets from its front, leaving the unsent ones in it.
+/// The packets still in the burst are freed when it is dropped.
+pub struct MbufBurst<const N: usize> {
+    len: usize,
+    pkts: [MaybeUninit<MBuf>; N],
+}
+
+impl<const N: usize> Default for MbufBurst<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<const N: usize> Drop for MbufBurst<N> {
+    fn drop(&mut self) {
+        self.clear()
+    }
+}
+
+impl<const N: usize> Deref for MbufBurst<N> {
+    type Target = [MBuf];
+
+    fn deref(&self) -> &Self::Target {
+        unsafe { slice::from_raw_parts(self.pkts.as_ptr() as *const MBuf, self.len) }
+    }
+}
+
+impl<const N: usize> DerefMut for MbufBurst<N> {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        unsafe { slice::from_raw_parts_mut(self.pkts.as_mut_ptr() as *mut MBuf, self.len) }
+    }
+}
+
+impl<const N: usize> MbufBurst<N> {
+    /// Create an empty burst.
+    #[inline]
+    pub fn new() -> Self {
+        MbufBurst {
+            len: 0,
+            // an array of `MaybeUninit` doesn't need initialization
+            pkts: unsafe { MaybeUninit::uninit().assume_init() },
+        }
+    }
+
+    /// The maximum number of packets in the burst.
+    #[inline]
+    pub fn capacity(&self) -> usize {
+        N
+    }
+
+    /// The number of packets in the burst.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// The burst contains no packet.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// The burst is full.
+    #[inline]
+    pub fn is_full(&self) -> bool {
+        self.len == N
+    }
+
+    /// Append a packet to the back of the burst, or give it back if the burst is full.
+    #[inline]
+    pub fn push(&mut self, m: MBuf) -> ::std::result::Result<(), MBuf> {
+        if self.is_full() {
+            Err(m)
+        } else {
+            self.pkts[self.len] = MaybeUninit::new(m);
+            self.len += 1;
+
+            Ok(())
+        }
+    }
+
+    /// Remove the last packet from the burst.
+    #[inline]
+    pub fn pop(&mut self) -> Option<MBuf> {
+        if self.is_empty() {
+            None
+        } else {
+            self.len -= 1;
+
+            Some(unsafe { ptr::read(self.pkts[self.len].as_ptr()) })
+        }
+    }
+
+    /// Shorten the burst to `len` packets, freeing the rest in bulk.
+    pub fn truncate(&mut self, len: usize) {
+        if len < self.len {
+            let n = self.len - len;
+
+            self.len = len;
+
+            unsafe { free_bulk_raw(slice::from_raw_parts_mut(self.as_mut_ptr().add(len), n)) }
+        }
+    }
+
+    /// Free all the packets in the burst.
+    pub fn clear(&mut self) {
+        self.truncate(0)
+    }
+
+    /// Remove all the packets from the burst, front to back.
+    ///
+    /// The packets not consumed by the iterator are freed when it is dropped.
+    pub fn drain(&mut self) -> Drain<'_, N> {
+        let end = mem::replace(&mut self.len, 0);
+
+        Drain {
+            burst: self,
+            pos: 0,
+            end,
+        }
+    }
+
+    /// The packet table, as expected by the burst oriented DPDK API.
+    #[inline]
+    pub fn as_ptr(&self) -> *const RawMBufPtr {
+        self.pkts.as_ptr() as *const _
+    }
+
+    /// The mutable packet table, as expected by the burst oriented DPDK API.
+    #[inline]
+    pub fn as_mut_ptr(&mut self) -> *mut RawMBufPtr {
+        self.pkts.as_mut_ptr() as *mut _
+    }
+
+    /// Visit the packets front to back, while prefetching the data of the packets `PREFETCH_OFFSET` ahead,
+    /// so the lookups of a burst don't stall on the headers of each packet.
+    #[inline]
+    pub fn for_each_prefetched<F: FnMut(usize, &MBuf)>(&self, mut f: F) {
+        for m in self.iter().take(PREFETCH_OFFSET) {
+            m.prefetch_data();
+        }
+
+        for (i, m) in self.iter().enumerate() {
+            if let Some(next) = self.get(i + PREFETCH_OFFSET) {
+                next.prefetch_data();
+            }
+
+            f(i, m)
+        }
+    }
+
+    /// Force the number of packets in the burst.
+    ///
+    /// # Safety
+    ///
+    /// The first `len` slots of the packet table must hold valid mbufs owned by the burst.
+    #[inline]
+    pub unsafe fn set_len(&mut self, len: usize) {
+        debug_assert!(len <= N);
+
+        self.len = len;
+    }
+
+    /// Drop the ownership of the first `n` packets, and move the remaining ones to the front.
+    ///
+    /// # Safety
+    ///
+    /// The first `n` packets must have been handed over, for example sent by a driver.
+    #[inline]
+    pub unsafe fn forget_front(&mut self, n: usize) {
+        debug_assert!(n <= self.len);
+
+        let remaining = self.len - n;
+
+        if remaining > 0 && n > 0 {
+            ptr::copy(self.pkts.as_ptr().add(n), self.pkts.as_mut_ptr(), remaining);
+        }
+
+        self.len = remaining;
+    }
+}
+
+/// A draining iterator over the packets of a `MbufBurst`.
+pub struct Drain<'a, const N: usize> {
+    burst: &'a mut MbufBurst<N>,
+    pos: usize,
+    end: usize,
+}
+
+impl<'a, const N: usize> Iterator for Drain<'a, N> {
+    type Item = MBuf;
+
+    #[inline]
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.pos == self.end {
+            None
+        } else {
+            let m = unsafe { ptr::read(self.burst.pkts[self.pos].as_ptr()) };
+
+            self.pos += 1;
+
+            Some(m)
+        }
+    }
+
+    #[inline]
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        let n = self.end - self.pos;
+
+        (n, Some(n))
+    }
+}
+
+impl<'a, const N: usize> ExactSizeIterator for Drain<'a, N> {}
+
+impl<'a, const N: usize> Drop for Drain<'a, N> {
+    fn drop(&mut self) {
+        let n = self.end - self.pos;
+
+        if n > 0 {
+            unsafe { free_bulk_raw(slice::from_raw_parts_mut(self.burst.as_mut_ptr().add(self.pos), n)) }
+        }
+    }
+}
+
+/// Free packet mbufs back into their original mempools.
+///
+/// The segments are returned with one `rte_mempool_put_bulk` per run of segments from the same mempool,
+/// and their reference counters and chains are handled like `MBuf::free`.
+pub fn free_bulk<I: IntoIterator<Item = MBuf>>(mbufs: I) {
+    const FREE_BATCH: usize = 64;
+
+    let mut pkts = [ptr::null_mut(); FREE_BATCH];
+    let mut n = 0;
+
+    for m in mbufs {
+        pkts[n] = m.into_raw();
+        n += 1;
+
+        if n == FREE_BATCH {
+            unsafe { free_bulk_raw(&mut pkts[..n]) };
+            n = 0;
+        }
+    }
+
+    if n > 0 {
+        unsafe { free_bulk_raw(&mut pkts[..n]) }
+    }
+}
+
+/// Free a table of packet mbufs back into their original mempools, the null entries are skipped.
+///
+/// # Safety
+///
+/// The mbufs are owned by the table, and must not be used after.
+#[inline]
+pub unsafe fn free_bulk_raw(mbufs: &mut [RawMBufPtr]) {
+    ffi::rte_pktmbuf_free_bulk(mbufs.as_mut_ptr(), mbufs.len() as u32)
+}
+
 pub trait MBufPool {
     /// Get the data room size of mbufs stored in a pktmbuf_pool
     fn data_room_size(&self) -> usize;
@@ -731,6 +1546,95 @@ impl MBufPool for mempool::MemoryPool {
     }
 }
 
+/// Allocate the mbufs through a cache of the calling lcore, instead of the default cache of the pool.
+impl MBufPool for mempool::LcoreCache {
+    fn data_room_size(&self) -> usize {
+        self.pool().data_room_size()
+    }
+
+    fn priv_size(&self) -> usize {
+        self.pool().priv_size()
+    }
+
+    fn alloc(&mut self) -> Result<MBuf> {
+        let mut m = ptr::null_mut();
+
+        unsafe {
+            self.get_raw(&mut m, 1)?;
+
+            ffi::_rte_pktmbuf_reset(m as *mut _);
+        }
+
+        Ok(MBuf(unsafe { NonNull::new_unchecked(m as *mut _) }))
+    }
+
+    fn alloc_bulk(&mut self, mbufs: &mut [Option<MBuf>]) -> Result<()> {
+        unsafe {
+            self.get_raw(mbufs.as_mut_ptr() as *mut _, mbufs.len())?;
+
+            for m in mbufs.iter() {
+                ffi::_rte_pktmbuf_reset(m.as_ref().unwrap().as_raw_mut());
+            }
+        }
+
+        Ok(())
+    }
+
+    fn clone(&mut self, mbuf: &MBuf) -> Result<MBuf> {
+        unsafe { ffi::_rte_pktmbuf_clone(mbuf.as_raw_mut(), self.pool().as_raw_mut()) }
+            .as_result()
+            .map(MBuf)
+    }
+}
+
+impl mempool::LcoreCache {
+    /// Free a packet mbuf back into the cache.
+    pub fn free(&mut self, m: MBuf) {
+        self.free_bulk(Some(m))
+    }
+
+    /// Free packet mbufs back into the cache.
+    ///
+    /// The segments which belong to another mempool are freed into their own pool.
+    pub fn free_bulk<I: IntoIterator<Item = MBuf>>(&mut self, mbufs: I) {
+        const FREE_BATCH: usize = 32;
+
+        let mut objs = [ptr::null_mut(); FREE_BATCH];
+        let mut n = 0;
+
+        for m in mbufs {
+            let mut seg = m.into_raw();
+
+            while !seg.is_null() {
+                unsafe {
+                    let next = (*seg).next;
+                    let m = ffi::_rte_pktmbuf_prefree_seg(seg);
+
+                    if !m.is_null() {
+                        if (*m).pool == self.pool().as_raw_mut() {
+                            objs[n] = m as *mut c_void;
+                            n += 1;
+
+                            if n == FREE_BATCH {
+                                self.put_raw(objs.as_ptr(), n);
+                                n = 0;
+                            }
+                        } else {
+                            ffi::_rte_mempool_put((*m).pool, m as *mut c_void);
+                        }
+                    }
+
+                    seg = next;
+                }
+            }
+        }
+
+        if n > 0 {
+            unsafe { self.put_raw(objs.as_ptr(), n) }
+        }
+    }
+}
+
 /// Create a mbuf pool.
 ///
 /// This function creates and initializes a packet mbuf pool.
@@ -29,20 +29,21 @@ use std::os::raw::{c_uint, c_void};
 use std::os::unix::io::AsRawFd;
 use std::ptr::{self, NonNull};
 
-use anyhow::Result;
+use anyhow::{anyhow, Result};
 use cfile;
 use ffi;
 use libc;
 
-use errors::AsResult;
+use errors::{AsResult, ErrorKind::OsError};
 use lcore;
 use memory::SocketId;
 use ring;
 use utils::{AsCString, AsRaw, CallbackContext, FromRaw, IntoRaw, Raw};
 
 pub use ffi::{
-    MEMPOOL_PG_NUM_DEFAULT, RTE_MEMPOOL_ALIGN, RTE_MEMPOOL_ALIGN_MASK, RTE_MEMPOOL_HEADER_COOKIE1,
-    RTE_MEMPOOL_HEADER_COOKIE2, RTE_MEMPOOL_MZ_FORMAT, RTE_MEMPOOL_MZ_PREFIX, RTE_MEMPOOL_TRAILER_COOKIE,
+    MEMPOOL_PG_NUM_DEFAULT, RTE_MEMPOOL_ALIGN, RTE_MEMPOOL_ALIGN_MASK, RTE_MEMPOOL_CACHE_MAX_SIZE,
+    RTE_MEMPOOL_HEADER_COOKIE1, RTE_MEMPOOL_HEADER_COOKIE2, RTE_MEMPOOL_MZ_FORMAT, RTE_MEMPOOL_MZ_PREFIX,
+    RTE_MEMPOOL_TRAILER_COOKIE,
 };
 
 lazy_static! {
@@ -388,6 +389,159 @@ impl Cache {
     fn free(self) {
         unsafe { ffi::rte_mempool_cache_free(self.as_raw_mut()) }
     }
+
+    /// The size of the cache.
+    pub fn size(&self) -> usize {
+        self.size as usize
+    }
+
+    /// The number of objects above which the cache flushes to the common pool.
+    pub fn flush_threshold(&self) -> usize {
+        self.flushthresh as usize
+    }
+
+    /// The current number of objects in the cache.
+    pub fn len(&self) -> usize {
+        self.len as usize
+    }
+
+    /// Test if the cache is empty.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+}
+
+/// Hit and miss counters of a `LcoreCache`.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    /// Number of gets served from the cache only.
+    pub get_hits: u64,
+    /// Number of gets which had to dequeue objects from the common pool.
+    pub get_misses: u64,
+    /// Number of puts kept in the cache.
+    pub put_hits: u64,
+    /// Number of puts which had to flush objects to the common pool.
+    pub put_misses: u64,
+}
+
+impl CacheStats {
+    /// The ratio of gets and puts which didn't touch the common pool.
+    pub fn hit_ratio(&self) -> f64 {
+        let hits = self.get_hits + self.put_hits;
+        let total = hits + self.get_misses + self.put_misses;
+
+        if total == 0 {
+            0.0
+        } else {
+            hits as f64 / total as f64
+        }
+    }
+}
+
+/// A mempool cache bound to the calling lcore.
+///
+/// It either borrows the per-lcore default cache of the mempool, or owns a user cache
+/// which is flushed and freed when dropped. The handle is not `Send`,
+/// the cache must only be used from the thread which got it.
+#[derive(Debug)]
+pub struct LcoreCache {
+    pool: MemoryPool,
+    cache: Cache,
+    owned: bool,
+    stats: CacheStats,
+}
+
+impl Drop for LcoreCache {
+    fn drop(&mut self) {
+        if self.owned {
+            self.flush();
+
+            Cache(self.cache.0).free();
+        }
+    }
+}
+
+impl LcoreCache {
+    /// The mempool of the cache.
+    pub fn pool(&self) -> &MemoryPool {
+        &self.pool
+    }
+
+    /// The underlying mempool cache.
+    pub fn cache(&self) -> &Cache {
+        &self.cache
+    }
+
+    /// Test if the cache is a user-owned cache.
+    pub fn is_owned(&self) -> bool {
+        self.owned
+    }
+
+    /// The hit and miss counters since the cache was created or the counters reset.
+    pub fn stats(&self) -> CacheStats {
+        self.stats
+    }
+
+    /// Reset the hit and miss counters.
+    pub fn reset_stats(&mut self) {
+        self.stats = CacheStats::default();
+    }
+
+    /// Flush all the objects of the cache to the common pool.
+    pub fn flush(&mut self) {
+        unsafe { ffi::_rte_mempool_cache_flush(self.cache.as_raw_mut(), self.pool.as_raw_mut()) }
+    }
+
+    /// Flush the cache and change its size, a size of 0 disables the caching.
+    ///
+    /// The flush threshold follows the size like for the caches created by DPDK.
+    pub fn resize(&mut self, size: usize) -> Result<()> {
+        if size > RTE_MEMPOOL_CACHE_MAX_SIZE as usize {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        self.flush();
+
+        // the object table of a cache is sized for the largest cache, see `rte_mempool_cache_init`
+        self.cache.size = size as u32;
+        self.cache.flushthresh = (size * 3 / 2) as u32;
+
+        Ok(())
+    }
+
+    /// Get several objects through the cache.
+    pub fn get_bulk<T: Pooled<R>, R>(&mut self, objs: &mut [T]) -> Result<()> {
+        unsafe { self.get_raw(objs.as_mut_ptr() as *mut _, objs.len()) }
+    }
+
+    /// Put several objects back through the cache.
+    pub fn put_bulk<T: Pooled<R>, R>(&mut self, objs: &[T]) {
+        unsafe { self.put_raw(objs.as_ptr() as *const _, objs.len()) }
+    }
+
+    pub(crate) unsafe fn get_raw(&mut self, objs: *mut *mut c_void, n: usize) -> Result<()> {
+        // the same conditions as `__mempool_generic_get` to dequeue from the common pool
+        if n < self.cache.size() && n <= self.cache.len() {
+            self.stats.get_hits += 1;
+        } else {
+            self.stats.get_misses += 1;
+        }
+
+        ffi::_rte_mempool_generic_get(self.pool.as_raw_mut(), objs, n as u32, self.cache.as_raw_mut())
+            .as_result()
+            .map(|_| ())
+    }
+
+    pub(crate) unsafe fn put_raw(&mut self, objs: *const *mut c_void, n: usize) {
+        // the same conditions as `__mempool_generic_put` to enqueue to the common pool
+        if n <= RTE_MEMPOOL_CACHE_MAX_SIZE as usize && self.cache.len() + n < self.cache.flush_threshold() {
+            self.stats.put_hits += 1;
+        } else {
+            self.stats.put_misses += 1;
+        }
+
+        ffi::_rte_mempool_generic_put(self.pool.as_raw_mut(), objs, n as u32, self.cache.as_raw_mut())
+    }
 }
 
 impl MemoryPool {
@@ -403,6 +557,36 @@ impl MemoryPool {
         })
     }
 
+    /// Get a handle on the default cache of the calling lcore.
+    ///
+    /// Return `None` on a non-EAL thread or when the mempool was created without cache.
+    pub fn lcore_cache(&self) -> Option<LcoreCache> {
+        self.default_cache().map(|cache| LcoreCache {
+            pool: MemoryPool(self.0),
+            cache,
+            owned: false,
+            stats: CacheStats::default(),
+        })
+    }
+
+    /// Create a user cache of `size` objects for the calling thread.
+    ///
+    /// Unlike the default caches, its size doesn't depend on the mempool creation.
+    pub fn user_cache(&self, size: usize, socket_id: SocketId) -> Result<LcoreCache> {
+        if size > RTE_MEMPOOL_CACHE_MAX_SIZE as usize {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        unsafe { ffi::rte_mempool_cache_create(size as u32, socket_id as i32) }
+            .as_result()
+            .map(|cache| LcoreCache {
+                pool: MemoryPool(self.0),
+                cache: Cache(cache),
+                owned: true,
+                stats: CacheStats::default(),
+            })
+    }
+
     /// Put several objects back in the mempool.
     pub fn generic_put<T: Pooled<R>, R>(&mut self, objs: &[T], cache: Option<Cache>) {
         unsafe {
@@ -0,0 +1,320 @@
+//!
+//! A zero-copy view of the headers of a packet, which may span several segments.
+//!
+//! `PacketView::parse` walks the Ether, VLAN, IPv4 or IPv6 and TCP or UDP headers of a packet.
+//! A header is referenced in place when a segment holds it whole and aligned,
+//! it is only copied out when it straddles a segment boundary,
+//! so the jumbo frames received in scattered segments are parsed without `linearize`.
+//!
+use std::borrow::Cow;
+use std::mem;
+use std::ptr;
+use std::slice;
+
+use libc;
+
+use ffi;
+
+use ether::{EtherHdr, VlanHdr, ETHER_TYPE_IPV4_BE, ETHER_TYPE_IPV6_BE, ETHER_TYPE_QINQ_BE, ETHER_TYPE_VLAN_BE};
+use ip::{Ipv4Hdr, Ipv6Hdr};
+use mbuf::MBuf;
+use tcp::TcpHdr;
+use udp::UdpHdr;
+
+/// The most VLAN tags parsed, for QinQ.
+pub const MAX_VLANS: usize = 2;
+
+/// The most IPv6 extension headers parsed before the upper layer.
+const MAX_IPV6_EXT_HDRS: usize = 4;
+
+const IPV4_MIN_HDR_LEN: usize = mem::size_of::<Ipv4Hdr>();
+const IPV4_FRAG_MASK: u16 = (ffi::RTE_IPV4_HDR_MF_FLAG | ffi::RTE_IPV4_HDR_OFFSET_MASK) as u16;
+const IPV6_FRAG_OFFSET_MASK: u16 = !0x07;
+
+const IPPROTO_TCP: u8 = libc::IPPROTO_TCP as u8;
+const IPPROTO_UDP: u8 = libc::IPPROTO_UDP as u8;
+const IPPROTO_HOPOPTS: u8 = libc::IPPROTO_HOPOPTS as u8;
+const IPPROTO_ROUTING: u8 = libc::IPPROTO_ROUTING as u8;
+const IPPROTO_DSTOPTS: u8 = libc::IPPROTO_DSTOPTS as u8;
+const IPPROTO_FRAGMENT: u8 = libc::IPPROTO_FRAGMENT as u8;
+
+/// The network layer of a packet.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum L3 {
+    Ipv4,
+    Ipv6,
+}
+
+/// The transport layer of a packet.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum L4 {
+    Tcp,
+    Udp,
+    /// Another protocol, which header is not parsed.
+    Other(u8),
+}
+
+/// Read a header at an offset of a packet.
+///
+/// The header is borrowed from the segment holding it, unless it straddles a segment boundary
+/// or is misaligned in the segment, then it is copied out.
+/// Return `None` if the packet is too short.
+#[inline]
+pub fn header<T: Copy>(m: &MBuf, off: usize) -> Option<Cow<'_, T>> {
+    let len = mem::size_of::<T>();
+
+    if off + len > m.pkt_len() {
+        return None;
+    }
+
+    let mut seg_off = off;
+
+    for data in m.segments() {
+        if seg_off < data.len() {
+            if seg_off + len <= data.len() {
+                let p = data[seg_off..].as_ptr();
+
+                if p as usize % mem::align_of::<T>() == 0 {
+                    return Some(Cow::Borrowed(unsafe { &*(p as *const T) }));
+                }
+            }
+
+            break;
+        }
+
+        seg_off -= data.len();
+    }
+
+    let mut hdr: T = unsafe { mem::zeroed() };
+    let buf = unsafe { slice::from_raw_parts_mut(&mut hdr as *mut T as *mut u8, len) };
+    let data = m.read(off, buf)?;
+
+    if data.as_ptr() != buf.as_ptr() {
+        hdr = unsafe { ptr::read_unaligned(data.as_ptr() as *const T) };
+    }
+
+    Some(Cow::Owned(hdr))
+}
+
+/// The headers parsed from a packet.
+#[derive(Clone, Copy)]
+pub struct PacketView<'a> {
+    m: &'a MBuf,
+    vlans: usize,
+    ether_type: u16,
+    l3: Option<L3>,
+    l3_len: usize,
+    l4: Option<L4>,
+    l4_len: usize,
+    fragment: bool,
+}
+
+impl<'a> PacketView<'a> {
+    /// Parse the headers of a packet, return `None` if they are truncated or malformed.
+    ///
+    /// The upper layers are only parsed when they are known,
+    /// the transport layer of the non-first fragments is not parsed.
+    pub fn parse(m: &'a MBuf) -> Option<Self> {
+        let mut view = PacketView {
+            m,
+            vlans: 0,
+            ether_type: header::<EtherHdr>(m, 0)?.ether_type,
+            l3: None,
+            l3_len: 0,
+            l4: None,
+            l4_len: 0,
+            fragment: false,
+        };
+
+        while (view.ether_type == ETHER_TYPE_VLAN_BE || view.ether_type == ETHER_TYPE_QINQ_BE) && view.vlans < MAX_VLANS
+        {
+            view.ether_type = header::<VlanHdr>(m, view.l2_len())?.eth_proto;
+            view.vlans += 1;
+        }
+
+        let l3_off = view.l2_len();
+        let mut first_fragment = true;
+        let proto = match view.ether_type {
+            ETHER_TYPE_IPV4_BE => {
+                let ip = header::<Ipv4Hdr>(m, l3_off)?;
+                let frag = u16::from_be(ip.fragment_offset);
+
+                view.l3_len = (ip.version_ihl & ffi::RTE_IPV4_HDR_IHL_MASK as u8) as usize * 4;
+
+                if view.l3_len < IPV4_MIN_HDR_LEN {
+                    return None;
+                }
+
+                view.fragment = frag & IPV4_FRAG_MASK != 0;
+                first_fragment = frag & ffi::RTE_IPV4_HDR_OFFSET_MASK as u16 == 0;
+                view.l3 = Some(L3::Ipv4);
+
+                ip.next_proto_id
+            }
+            ETHER_TYPE_IPV6_BE => {
+                let mut proto = header::<Ipv6Hdr>(m, l3_off)?.proto;
+
+                view.l3_len = mem::size_of::<Ipv6Hdr>();
+
+                for _ in 0..MAX_IPV6_EXT_HDRS {
+                    match proto {
+                        IPPROTO_HOPOPTS | IPPROTO_ROUTING | IPPROTO_DSTOPTS => {
+                            let ext = header::<[u8; 2]>(m, l3_off + view.l3_len)?;
+
+                            proto = ext[0];
+                            view.l3_len += (ext[1] as usize + 1) * 8;
+                        }
+                        IPPROTO_FRAGMENT => {
+                            let ext = header::<[u8; 8]>(m, l3_off + view.l3_len)?;
+
+                            proto = ext[0];
+                            view.l3_len += ext.len();
+                            view.fragment = true;
+                            first_fragment = u16::from_be_bytes([ext[2], ext[3]]) & IPV6_FRAG_OFFSET_MASK == 0;
+                        }
+                        _ => break,
+                    }
+                }
+
+                view.l3 = Some(L3::Ipv6);
+
+                proto
+            }
+            _ => return Some(view),
+        };
+
+        if first_fragment {
+            let l4_off = l3_off + view.l3_len;
+
+            view.l4 = Some(match proto {
+                IPPROTO_TCP => {
+                    view.l4_len = (header::<TcpHdr>(m, l4_off)?.data_off >> 4) as usize * 4;
+
+                    if view.l4_len < mem::size_of::<TcpHdr>() {
+                        return None;
+                    }
+
+                    L4::Tcp
+                }
+                IPPROTO_UDP => {
+                    header::<UdpHdr>(m, l4_off)?;
+
+                    view.l4_len = mem::size_of::<UdpHdr>();
+
+                    L4::Udp
+                }
+                proto => L4::Other(proto),
+            });
+        }
+
+        Some(view)
+    }
+
+    /// The parsed packet.
+    pub fn mbuf(&self) -> &'a MBuf {
+        self.m
+    }
+
+    /// The Ethernet header.
+    pub fn ether(&self) -> Cow<'a, EtherHdr> {
+        header(self.m, 0).unwrap()
+    }
+
+    /// The VLAN tags, from the outer one.
+    pub fn vlans(&self) -> impl Iterator<Item = Cow<'a, VlanHdr>> + 'a {
+        let m = self.m;
+
+        (0..self.vlans).map(move |i| header(m, mem::size_of::<EtherHdr>() + i * mem::size_of::<VlanHdr>()).unwrap())
+    }
+
+    /// The Ethernet type of the network layer, in big endian.
+    pub fn ether_type(&self) -> u16 {
+        self.ether_type
+    }
+
+    /// The network layer, if it is parsed.
+    pub fn l3(&self) -> Option<L3> {
+        self.l3
+    }
+
+    /// The transport layer, if it is parsed.
+    pub fn l4(&self) -> Option<L4> {
+        self.l4
+    }
+
+    /// Test if the packet is an IP fragment.
+    pub fn is_fragment(&self) -> bool {
+        self.fragment
+    }
+
+    /// The length of the Ethernet header and VLAN tags.
+    pub fn l2_len(&self) -> usize {
+        mem::size_of::<EtherHdr>() + self.vlans * mem::size_of::<VlanHdr>()
+    }
+
+    /// The length of the IP header, with its options or extension headers.
+    pub fn l3_len(&self) -> usize {
+        self.l3_len
+    }
+
+    /// The length of the TCP header with its options, or of the UDP header.
+    pub fn l4_len(&self) -> usize {
+        self.l4_len
+    }
+
+    /// The IPv4 header.
+    pub fn ipv4(&self) -> Option<Cow<'a, Ipv4Hdr>> {
+        match self.l3 {
+            Some(L3::Ipv4) => header(self.m, self.l2_len()),
+            _ => None,
+        }
+    }
+
+    /// The IPv6 header, without its extension headers.
+    pub fn ipv6(&self) -> Option<Cow<'a, Ipv6Hdr>> {
+        match self.l3 {
+            Some(L3::Ipv6) => header(self.m, self.l2_len()),
+            _ => None,
+        }
+    }
+
+    /// The TCP header, without its options.
+    pub fn tcp(&self) -> Option<Cow<'a, TcpHdr>> {
+        match self.l4 {
+            Some(L4::Tcp) => header(self.m, self.l2_len() + self.l3_len),
+            _ => None,
+        }
+    }
+
+    /// The UDP header.
+    pub fn udp(&self) -> Option<Cow<'a, UdpHdr>> {
+        match self.l4 {
+            Some(L4::Udp) => header(self.m, self.l2_len() + self.l3_len),
+            _ => None,
+        }
+    }
+
+    /// The offset of the payload of the innermost parsed layer.
+    pub fn payload_offset(&self) -> usize {
+        self.l2_len() + self.l3_len + self.l4_len
+    }
+
+    /// The payload of the innermost parsed layer, over the segments of the packet.
+    pub fn payload(&self) -> impl Iterator<Item = &'a [u8]> + 'a {
+        let mut skip = self.payload_offset();
+
+        self.m.segments().filter_map(move |data| {
+            if skip >= data.len() {
+                skip -= data.len();
+
+                None
+            } else {
+                let data = &data[skip..];
+
+                skip = 0;
+
+                Some(data)
+            }
+        })
+    }
+}
@@ -0,0 +1,845 @@
+//!
+//! Capture and replay of pcap files, for the offline benchmarks of the forwarders.
+//!
+//! - A `PcapFile` maps a capture in memory, its records are parsed while they are iterated.
+//! - A `Trace` preloads the packets of a capture into hugepage `ExtBuf`s once,
+//!   then each replay attaches them to mbufs without copying them.
+//! - A `Replay` sends a trace with `EthDevice::tx_burst`, paced by the TSC on the recorded timestamps.
+//! - A `Capture` gives each lcore a `Tap`, which copies its packets into batches handed to a control thread
+//!   through a single-producer ring, the control thread writes the batches to a pcap file per lcore.
+//!   A tap never blocks, the packets are dropped from the capture when the writer is late.
+//!
+use std::cmp;
+use std::fs::File;
+use std::hint;
+use std::io::{self, Write};
+use std::os::unix::io::AsRawFd;
+use std::path::Path;
+use std::ptr::{self, NonNull};
+use std::slice;
+use std::sync::atomic::{AtomicBool, AtomicU64, AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use anyhow::{anyhow, Result};
+use libc;
+
+use errors::ErrorKind::OsError;
+use ethdev::{EthDevice, PortId, QueueId};
+use launch::{self, CtrlThread};
+use lcore;
+use mbuf::{ExtBuf, MBuf, MBufPool, MbufBurst};
+use memory::SocketId;
+use ring::{Ring, RingFlags};
+use utils::add_counter;
+use {get_tsc_hz, rdtsc};
+
+/// The magic of the pcap files with microsecond timestamps.
+pub const MAGIC_USEC: u32 = 0xa1b2_c3d4;
+
+/// The magic of the pcap files with nanosecond timestamps.
+pub const MAGIC_NSEC: u32 = 0xa1b2_3c4d;
+
+/// The link type of the Ethernet captures.
+pub const LINKTYPE_ETHERNET: u32 = 1;
+
+const VERSION_MAJOR: u16 = 2;
+const VERSION_MINOR: u16 = 4;
+
+const FILE_HEADER_LEN: usize = 24;
+const RECORD_HEADER_LEN: usize = 16;
+
+/// The largest `ExtBuf` of a trace, the packets are spread over as many buffers as needed.
+pub const TRACE_CHUNK_LEN: usize = 64 << 20;
+
+/// The packets sent at a time by a replay.
+const REPLAY_BURST: usize = 32;
+
+/// The batches in flight between a tap and the writer.
+const TAP_BATCHES: usize = 8;
+
+/// How long the writer sleeps when no batch is ready.
+const WRITER_IDLE: Duration = Duration::from_millis(1);
+
+/// A record of a capture.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct Record<'a> {
+    /// The capture time since the epoch.
+    pub timestamp: Duration,
+    /// The length of the packet on the wire.
+    pub orig_len: usize,
+    /// The captured bytes, up to the snapshot length.
+    pub data: &'a [u8],
+}
+
+/// A pcap capture in memory.
+#[derive(Clone, Copy, Debug)]
+pub struct Pcap<'a> {
+    data: &'a [u8],
+    swapped: bool,
+    nanos: bool,
+    snaplen: u32,
+    linktype: u32,
+}
+
+impl<'a> Pcap<'a> {
+    /// Parse the file header of a capture.
+    pub fn parse(data: &'a [u8]) -> Result<Self> {
+        if data.len() < FILE_HEADER_LEN {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let magic = read_u32(data, 0, false);
+        let (swapped, nanos) = match magic {
+            MAGIC_USEC => (false, false),
+            MAGIC_NSEC => (false, true),
+            _ if magic.swap_bytes() == MAGIC_USEC => (true, false),
+            _ if magic.swap_bytes() == MAGIC_NSEC => (true, true),
+            _ => return Err(anyhow!(OsError(libc::EINVAL))),
+        };
+
+        Ok(Pcap {
+            data,
+            swapped,
+            nanos,
+            snaplen: read_u32(data, 16, swapped),
+            linktype: read_u32(data, 20, swapped),
+        })
+    }
+
+    /// The longest record of the capture.
+    pub fn snaplen(&self) -> usize {
+        self.snaplen as usize
+    }
+
+    /// The link type of the capture, such as `LINKTYPE_ETHERNET`.
+    pub fn linktype(&self) -> u32 {
+        self.linktype
+    }
+
+    /// Iterate the records, a truncated record ends the iteration.
+    pub fn records(&self) -> Records<'a> {
+        Records {
+            data: &self.data[FILE_HEADER_LEN..],
+            swapped: self.swapped,
+            nanos: self.nanos,
+        }
+    }
+}
+
+/// An iterator over the records of a capture.
+pub struct Records<'a> {
+    data: &'a [u8],
+    swapped: bool,
+    nanos: bool,
+}
+
+impl<'a> Iterator for Records<'a> {
+    type Item = Record<'a>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.data.len() < RECORD_HEADER_LEN {
+            return None;
+        }
+
+        let secs = read_u32(self.data, 0, self.swapped) as u64;
+        let frac = read_u32(self.data, 4, self.swapped) as u64;
+        let incl_len = read_u32(self.data, 8, self.swapped) as usize;
+        let orig_len = read_u32(self.data, 12, self.swapped) as usize;
+
+        if self.data.len() < RECORD_HEADER_LEN + incl_len {
+            debug!("truncated pcap record of {} bytes", incl_len);
+
+            self.data = &[];
+
+            return None;
+        }
+
+        let (record, rest) = self.data[RECORD_HEADER_LEN..].split_at(incl_len);
+
+        self.data = rest;
+
+        Some(Record {
+            // a corrupted fraction may hold more than a second
+            timestamp: Duration::from_secs(secs) + Duration::from_nanos(if self.nanos { frac } else { frac * 1000 }),
+            orig_len,
+            data: record,
+        })
+    }
+}
+
+#[inline]
+fn read_u32(data: &[u8], off: usize, swapped: bool) -> u32 {
+    let v = u32::from_ne_bytes([data[off], data[off + 1], data[off + 2], data[off + 3]]);
+
+    if swapped {
+        v.swap_bytes()
+    } else {
+        v
+    }
+}
+
+/// Write the header of a pcap file with nanosecond timestamps, in the native byte order.
+pub fn write_header(buf: &mut Vec<u8>, snaplen: usize, linktype: u32) {
+    buf.extend_from_slice(&MAGIC_NSEC.to_ne_bytes());
+    buf.extend_from_slice(&VERSION_MAJOR.to_ne_bytes());
+    buf.extend_from_slice(&VERSION_MINOR.to_ne_bytes());
+    buf.extend_from_slice(&0i32.to_ne_bytes());
+    buf.extend_from_slice(&0u32.to_ne_bytes());
+    buf.extend_from_slice(&(snaplen as u32).to_ne_bytes());
+    buf.extend_from_slice(&linktype.to_ne_bytes());
+}
+
+/// Write a record with a nanosecond timestamp, in the native byte order.
+pub fn write_record(buf: &mut Vec<u8>, timestamp: Duration, orig_len: usize, data: &[u8]) {
+    buf.extend_from_slice(&(timestamp.as_secs() as u32).to_ne_bytes());
+    buf.extend_from_slice(&timestamp.subsec_nanos().to_ne_bytes());
+    buf.extend_from_slice(&(data.len() as u32).to_ne_bytes());
+    buf.extend_from_slice(&(orig_len as u32).to_ne_bytes());
+    buf.extend_from_slice(data);
+}
+
+/// A pcap file mapped in memory.
+pub struct PcapFile {
+    addr: NonNull<u8>,
+    len: usize,
+}
+
+unsafe impl Send for PcapFile {}
+unsafe impl Sync for PcapFile {}
+
+impl Drop for PcapFile {
+    fn drop(&mut self) {
+        unsafe { libc::munmap(self.addr.as_ptr() as *mut _, self.len) };
+    }
+}
+
+impl PcapFile {
+    /// Map a pcap file, the pages are read in as the records are iterated.
+    pub fn open<P: AsRef<Path>>(path: P) -> Result<Self> {
+        let f = File::open(path)?;
+        let len = f.metadata()?.len() as usize;
+
+        if len < FILE_HEADER_LEN {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let addr = unsafe {
+            libc::mmap(
+                ptr::null_mut(),
+                len,
+                libc::PROT_READ,
+                libc::MAP_PRIVATE,
+                f.as_raw_fd(),
+                0,
+            )
+        };
+
+        if addr == libc::MAP_FAILED {
+            return Err(io::Error::last_os_error().into());
+        }
+
+        unsafe { libc::madvise(addr, len, libc::MADV_SEQUENTIAL) };
+
+        let file = PcapFile {
+            addr: unsafe { NonNull::new_unchecked(addr as *mut u8) },
+            len,
+        };
+
+        Pcap::parse(file.as_bytes())?;
+
+        Ok(file)
+    }
+
+    /// The content of the file.
+    pub fn as_bytes(&self) -> &[u8] {
+        unsafe { slice::from_raw_parts(self.addr.as_ptr(), self.len) }
+    }
+
+    /// The capture of the file.
+    pub fn pcap(&self) -> Pcap<'_> {
+        Pcap::parse(self.as_bytes()).unwrap()
+    }
+}
+
+struct TracePacket {
+    chunk: u32,
+    off: u32,
+    len: u32,
+    /// The time since the first packet, in nanoseconds.
+    timestamp: u64,
+}
+
+/// The packets of a capture, preloaded in hugepage memory.
+pub struct Trace {
+    chunks: Vec<ExtBuf>,
+    packets: Vec<TracePacket>,
+    bytes: usize,
+}
+
+impl Trace {
+    /// Copy the packets of a capture into `ExtBuf`s on a socket.
+    pub fn load(pcap: &Pcap, socket_id: SocketId) -> Result<Self> {
+        let mut packets = vec![];
+        let mut chunk_lens = vec![0];
+        let mut first = None;
+
+        for record in pcap.records().filter(|record| !record.data.is_empty()) {
+            let len = record.data.len();
+
+            if chunk_lens.last().unwrap() + len > TRACE_CHUNK_LEN {
+                chunk_lens.push(0);
+            }
+
+            let chunk = chunk_lens.len() - 1;
+            let chunk_len = &mut chunk_lens[chunk];
+            let first = *first.get_or_insert(record.timestamp);
+
+            packets.push(TracePacket {
+                chunk: chunk as u32,
+                off: *chunk_len as u32,
+                len: len as u32,
+                timestamp: record.timestamp.checked_sub(first).unwrap_or_default().as_nanos() as u64,
+            });
+
+            *chunk_len += len;
+        }
+
+        if packets.is_empty() {
+            return Err(anyhow!(OsError(libc::ENODATA)));
+        }
+
+        let mut chunks = chunk_lens
+            .iter()
+            .map(|&len| ExtBuf::new(len, socket_id))
+            .collect::<Result<Vec<_>>>()?;
+
+        for (p, record) in packets
+            .iter()
+            .zip(pcap.records().filter(|record| !record.data.is_empty()))
+        {
+            let off = p.off as usize;
+
+            chunks[p.chunk as usize].get_mut().unwrap()[off..off + record.data.len()].copy_from_slice(record.data);
+        }
+
+        Ok(Trace {
+            bytes: chunk_lens.iter().sum(),
+            chunks,
+            packets,
+        })
+    }
+
+    /// The number of packets.
+    pub fn len(&self) -> usize {
+        self.packets.len()
+    }
+
+    /// Test if the trace has no packet.
+    pub fn is_empty(&self) -> bool {
+        self.packets.is_empty()
+    }
+
+    /// The captured bytes of all the packets.
+    pub fn bytes(&self) -> usize {
+        self.bytes
+    }
+
+    /// The time between the first and the last packet.
+    pub fn duration(&self) -> Duration {
+        Duration::from_nanos(self.packets.last().map_or(0, |p| p.timestamp))
+    }
+
+    /// Build a packet from a pool, pointing to the trace without copying it.
+    pub fn packet<P: MBufPool>(&self, pool: &mut P, i: usize) -> Result<MBuf> {
+        let p = self.packets.get(i).ok_or_else(|| anyhow!(OsError(libc::EINVAL)))?;
+        let off = p.off as usize;
+
+        self.chunks[p.chunk as usize].packet(pool, off..off + p.len as usize)
+    }
+}
+
+/// How a replay paces the packets.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum Pacing {
+    /// Send as fast as the queue accepts the packets.
+    Unpaced,
+    /// Keep the recorded gaps between the packets, divided by a speed-up factor.
+    Recorded(f64),
+}
+
+/// The counters of a replay.
+#[derive(Clone, Copy, Debug, Default, PartialEq)]
+pub struct ReplayStats {
+    /// The packets sent.
+    pub packets: u64,
+    /// The bytes sent.
+    pub bytes: u64,
+    /// The complete replays of the trace.
+    pub loops: usize,
+    /// The `tx_burst` calls which sent no packet.
+    pub stalls: u64,
+    /// The allocations which failed, retried once mbufs return to the pool.
+    pub nombuf: u64,
+    /// The time of the replay.
+    pub elapsed: Duration,
+}
+
+impl ReplayStats {
+    /// The packets sent per second.
+    pub fn pps(&self) -> f64 {
+        self.packets as f64 / self.elapsed.as_secs_f64()
+    }
+
+    /// The bits sent per second.
+    pub fn bps(&self) -> f64 {
+        self.bytes as f64 * 8.0 / self.elapsed.as_secs_f64()
+    }
+}
+
+/// A replay of a trace on a transmit queue.
+pub struct Replay<'a> {
+    trace: &'a Trace,
+    port_id: PortId,
+    queue_id: QueueId,
+    pacing: Pacing,
+    loops: usize,
+}
+
+impl<'a> Replay<'a> {
+    /// Replay a trace once on a transmit queue, as fast as possible.
+    pub fn new(trace: &'a Trace, port_id: PortId, queue_id: QueueId) -> Self {
+        Replay {
+            trace,
+            port_id,
+            queue_id,
+            pacing: Pacing::Unpaced,
+            loops: 1,
+        }
+    }
+
+    /// Set the pacing of the packets.
+    pub fn pacing(&mut self, pacing: Pacing) -> &mut Self {
+        self.pacing = pacing;
+        self
+    }
+
+    /// Set the number of replays of the trace, each one is paced from its own start.
+    pub fn loops(&mut self, loops: usize) -> &mut Self {
+        self.loops = loops;
+        self
+    }
+
+    /// Send the trace until the replays are done or `quit` is set, from the lcore owning the queue.
+    ///
+    /// The mbufs are allocated from `pool`, which should hold enough of them to fill the TX ring.
+    pub fn run<P: MBufPool>(&self, pool: &mut P, quit: &AtomicBool) -> ReplayStats {
+        let ticks_per_ns = match self.pacing {
+            Pacing::Unpaced => None,
+            Pacing::Recorded(speedup) => Some(get_tsc_hz() as f64 / 1e9 / speedup),
+        };
+        let packets = &self.trace.packets;
+        let mut burst = MbufBurst::<REPLAY_BURST>::new();
+        let mut stats = ReplayStats::default();
+        let started = rdtsc();
+
+        'replay: for _ in 0..self.loops {
+            let start = rdtsc();
+            let mut i = 0;
+
+            while i < packets.len() || !burst.is_empty() {
+                if quit.load(Ordering::Relaxed) {
+                    break 'replay;
+                }
+
+                let now = rdtsc();
+
+                while i < packets.len() && !burst.is_full() {
+                    if let Some(ticks_per_ns) = ticks_per_ns {
+                        if start + (packets[i].timestamp as f64 * ticks_per_ns) as u64 > now {
+                            break;
+                        }
+                    }
+
+                    match self.trace.packet(pool, i) {
+                        Ok(m) => {
+                            let _ = burst.push(m);
+
+                            i += 1;
+                        }
+                        Err(_) => {
+                            stats.nombuf += 1;
+
+                            break;
+                        }
+                    }
+                }
+
+                if burst.is_empty() {
+                    hint::spin_loop();
+
+                    continue;
+                }
+
+                let bytes = burst_bytes(&burst);
+                let sent = self.port_id.tx_burst(self.queue_id, &mut burst);
+
+                if sent == 0 {
+                    stats.stalls += 1;
+                } else {
+                    stats.packets += sent as u64;
+                    stats.bytes += (bytes - burst_bytes(&burst)) as u64;
+                }
+            }
+
+            stats.loops += 1;
+        }
+
+        stats.elapsed =
+            Duration::from_nanos(((rdtsc() - started) as u128 * 1_000_000_000 / get_tsc_hz() as u128) as u64);
+
+        stats
+    }
+}
+
+#[inline]
+fn burst_bytes<const N: usize>(burst: &MbufBurst<N>) -> usize {
+    burst.iter().map(|m| m.pkt_len()).sum()
+}
+
+/// A batch of pcap records.
+struct Batch {
+    buf: Vec<u8>,
+    records: u64,
+}
+
+/// The rings between a tap and the writer, and the counters of the tap.
+struct TapQueue {
+    lcore_id: lcore::Id,
+    /// The batches ready to be written.
+    full: Option<Ring<Box<Batch>>>,
+    /// The batches written, given back to the tap.
+    free: Option<Ring<Box<Batch>>>,
+    packets: AtomicU64,
+    dropped: AtomicU64,
+}
+
+impl Drop for TapQueue {
+    fn drop(&mut self) {
+        self.full.take().map(Ring::free);
+        self.free.take().map(Ring::free);
+    }
+}
+
+impl TapQueue {
+    fn full(&self) -> &Ring<Box<Batch>> {
+        self.full.as_ref().unwrap()
+    }
+
+    fn free(&self) -> &Ring<Box<Batch>> {
+        self.free.as_ref().unwrap()
+    }
+}
+
+/// The counters of a tap.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct TapStats {
+    pub lcore_id: lcore::Id,
+    /// The packets captured.
+    pub packets: u64,
+    /// The packets dropped from the capture, when no batch was free.
+    pub dropped: u64,
+}
+
+/// A capture of the packets of some lcores, each one to its own pcap file.
+pub struct Capture {
+    queues: Vec<Arc<TapQueue>>,
+    taps: Vec<Option<Tap>>,
+    quit: Arc<AtomicBool>,
+    writer: Option<CtrlThread>,
+}
+
+impl Capture {
+    /// Create the files `<prefix>-<lcore>.pcap` of the lcores, with records of at most `snaplen` bytes,
+    /// and the writer of their batches of `batch_len` bytes.
+    pub fn new<P: AsRef<Path>>(prefix: P, lcores: &[lcore::Id], snaplen: usize, batch_len: usize) -> Result<Self> {
+        static NEXT_ID: AtomicUsize = AtomicUsize::new(0);
+
+        if snaplen == 0 || batch_len < RECORD_HEADER_LEN + snaplen {
+            return Err(anyhow!(OsError(libc::EINVAL)));
+        }
+
+        let id = NEXT_ID.fetch_add(1, Ordering::Relaxed);
+        let flags = RingFlags::RING_F_EXACT_SZ;
+        let mut queues = vec![];
+        let mut files = vec![];
+
+        for &lcore_id in lcores {
+            let socket_id = lcore_id.socket_id();
+            let queue = TapQueue {
+                lcore_id,
+                full: Some(Ring::create(
+                    format!("tap{}_{}_full", id, lcore_id),
+                    TAP_BATCHES,
+                    socket_id,
+                    flags,
+                )?),
+                free: Some(Ring::create(
+                    format!("tap{}_{}_free", id, lcore_id),
+                    TAP_BATCHES,
+                    socket_id,
+                    flags,
+                )?),
+                packets: AtomicU64::new(0),
+                dropped: AtomicU64::new(0),
+            };
+
+            for _ in 0..TAP_BATCHES {
+                let batch = Box::new(Batch {
+                    buf: Vec::with_capacity(batch_len),
+                    records: 0,
+                });
+
+                if queue.free().enqueue(batch).is_err() {
+                    return Err(anyhow!(OsError(libc::ENOBUFS)));
+                }
+            }
+
+            let mut header = vec![];
+            let mut file = File::create(format!("{}-{}.pcap", prefix.as_ref().display(), lcore_id))?;
+
+            write_header(&mut header, snaplen, LINKTYPE_ETHERNET);
+            file.write_all(&header)?;
+
+            queues.push(Arc::new(queue));
+            files.push(file);
+        }
+
+        let quit = Arc::new(AtomicBool::new(false));
+        let writer = {
+            let queues = queues.clone();
+            let quit = quit.clone();
+
+            launch::ctrl_thread("pcap-writer", move || write_batches(&queues, &mut files, &quit))?
+        };
+        let (wall, tsc) = (SystemTime::now().duration_since(UNIX_EPOCH)?, rdtsc());
+        let taps = queues
+            .iter()
+            .map(|queue| {
+                Some(Tap {
+                    queue: queue.clone(),
+                    batch: None,
+                    batch_len,
+                    snaplen,
+                    scratch: vec![0; snaplen],
+                    wall,
+                    tsc,
+                    hz: get_tsc_hz(),
+                })
+            })
+            .collect();
+
+        Ok(Capture {
+            queues,
+            taps,
+            quit,
+            writer: Some(writer),
+        })
+    }
+
+    /// Take the tap of an lcore, to capture its packets on it.
+    pub fn tap(&mut self, lcore_id: lcore::Id) -> Option<Tap> {
+        let i = self.queues.iter().position(|queue| queue.lcore_id == lcore_id)?;
+
+        self.taps[i].take()
+    }
+
+    /// The counters of the taps.
+    pub fn stats(&self) -> Vec<TapStats> {
+        self.queues
+            .iter()
+            .map(|queue| TapStats {
+                lcore_id: queue.lcore_id,
+                packets: queue.packets.load(Ordering::Relaxed),
+                dropped: queue.dropped.load(Ordering::Relaxed),
+            })
+            .collect()
+    }
+
+    /// Write the pending batches and close the files, once the taps are dropped.
+    pub fn stop(self) {}
+}
+
+impl Drop for Capture {
+    fn drop(&mut self) {
+        self.quit.store(true, Ordering::Relaxed);
+
+        if let Some(writer) = self.writer.take() {
+            writer.join();
+        }
+    }
+}
+
+fn write_batches(queues: &[Arc<TapQueue>], files: &mut [File], quit: &AtomicBool) {
+    loop {
+        let mut idle = true;
+
+        for (queue, file) in queues.iter().zip(files.iter_mut()) {
+            while let Some(mut batch) = queue.full().dequeue() {
+                if let Err(err) = file.write_all(&batch.buf) {
+                    warn!("fail to write the capture of lcore {}, {}", queue.lcore_id, err);
+                }
+
+                batch.buf.clear();
+                batch.records = 0;
+
+                let _ = queue.free().enqueue(batch);
+
+                idle = false;
+            }
+        }
+
+        if idle {
+            // the last batches are queued before the taps are dropped
+            if quit.load(Ordering::Relaxed) {
+                break;
+            }
+
+            thread::sleep(WRITER_IDLE);
+        }
+    }
+}
+
+/// The capture of an lcore, it copies the packets into batches without blocking.
+///
+/// The partial batch is handed to the writer on `flush`, or when the tap is dropped.
+pub struct Tap {
+    queue: Arc<TapQueue>,
+    batch: Option<Box<Batch>>,
+    batch_len: usize,
+    snaplen: usize,
+    scratch: Vec<u8>,
+    /// The time and TSC of the start of the capture.
+    wall: Duration,
+    tsc: u64,
+    hz: u64,
+}
+
+impl Drop for Tap {
+    fn drop(&mut self) {
+        self.flush()
+    }
+}
+
+impl Tap {
+    /// Capture a burst of packets, timestamped when the burst is captured.
+    #[inline]
+    pub fn capture<const N: usize>(&mut self, pkts: &MbufBurst<N>) {
+        if pkts.is_empty() {
+            return;
+        }
+
+        let timestamp =
+            self.wall + Duration::from_nanos(((rdtsc() - self.tsc) as u128 * 1_000_000_000 / self.hz as u128) as u64);
+
+        for m in pkts.iter() {
+            self.capture_one(m, timestamp);
+        }
+    }
+
+    /// Capture a packet.
+    #[inline]
+    pub fn capture_one(&mut self, m: &MBuf, timestamp: Duration) {
+        let caplen = cmp::min(m.pkt_len(), self.snaplen);
+
+        if self.batch.as_ref().map_or(true, |batch| {
+            batch.buf.len() + RECORD_HEADER_LEN + caplen > self.batch_len
+        }) {
+            self.flush();
+
+            if self.batch.is_none() {
+                self.batch = self.queue.free().dequeue();
+            }
+        }
+
+        match self.batch {
+            Some(ref mut batch) => {
+                if let Some(data) = m.read(0, &mut self.scratch[..caplen]) {
+                    write_record(&mut batch.buf, timestamp, m.pkt_len(), data);
+
+                    batch.records += 1;
+
+                    add_counter(&self.queue.packets, 1);
+                }
+            }
+            None => add_counter(&self.queue.dropped, 1),
+        }
+    }
+
+    /// Hand the partial batch to the writer.
+    pub fn flush(&mut self) {
+        if let Some(batch) = self.batch.take() {
+            if batch.records == 0 {
+                self.batch = Some(batch);
+            } else if let Err(mut batch) = self.queue.full().enqueue(batch) {
+                add_counter(&self.queue.dropped, batch.records);
+
+                batch.buf.clear();
+                batch.records = 0;
+
+                self.batch = Some(batch);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_records() {
+        let mut buf = vec![];
+
+        write_header(&mut buf, 128, LINKTYPE_ETHERNET);
+        write_record(&mut buf, Duration::new(1, 500), 60, &[1; 60]);
+        write_record(&mut buf, Duration::new(2, 999_999_999), 1514, &[2; 128]);
+
+        let pcap = Pcap::parse(&buf).unwrap();
+
+        assert_eq!(pcap.snaplen(), 128);
+        assert_eq!(pcap.linktype(), LINKTYPE_ETHERNET);
+
+        let records = pcap.records().collect::<Vec<_>>();
+
+        assert_eq!(records.len(), 2);
+        assert_eq!(records[0].timestamp, Duration::new(1, 500));
+        assert_eq!(records[0].orig_len, 60);
+        assert_eq!(records[0].data, &[1; 60][..]);
+        assert_eq!(records[1].timestamp, Duration::new(2, 999_999_999));
+        assert_eq!(records[1].orig_len, 1514);
+        assert_eq!(records[1].data.len(), 128);
+
+        // a truncated record ends the capture
+        assert_eq!(Pcap::parse(&buf[..buf.len() - 1]).unwrap().records().count(), 1);
+
+        // a microsecond capture in the other byte order
+        let mut swapped = vec![];
+
+        for &v in &[MAGIC_USEC, 0x0004_0002, 0, 0, 64, LINKTYPE_ETHERNET, 3, 250, 4, 4] {
+            swapped.extend_from_slice(&v.swap_bytes().to_ne_bytes());
+        }
+        swapped.extend_from_slice(&[0xff; 4]);
+
+        let pcap = Pcap::parse(&swapped).unwrap();
+        let records = pcap.records().collect::<Vec<_>>();
+
+        assert_eq!(pcap.snaplen(), 64);
+        assert_eq!(records.len(), 1);
+        assert_eq!(records[0].timestamp, Duration::new(3, 250_000));
+        assert_eq!(records[0].data, &[0xff; 4][..]);
+
+        assert!(Pcap::parse(&[0; FILE_HEADER_LEN]).is_err());
+    }
+}
@@ -0,0 +1,634 @@
+//!
+//! A RX → workers → TX pipeline over the lcores, connected by rings of packets.
+//!
+//! - The RX lcores poll their queues, and dispatch each packet to a worker through an indirection table
+//!   indexed by its RSS hash, so the packets of a flow go to the same worker.
+//! - The workers run the handler on each packet, which returns the port to send it to or drops it,
+//!   and enqueue the packets on the ring of the TX lcore of the port.
+//! - The TX lcores send the packets of their rings on their queues.
+//!
+//! A stage stops taking packets while the next stage is full, instead of dropping them,
+//! so a slow worker or a busy port backs up to the RX lcores, which stop polling the full queues
+//! and let the devices drop the excess.
+//!
+//! An idle worker steals bursts from the backlog of the most loaded worker, and `Running::rebalance`
+//! moves the buckets of the indirection table from the loaded workers to the idle ones, without stopping
+//! the pipeline. Both may reorder the packets of a flow in transit, stealing can be disabled.
+//!
+use std::cmp;
+use std::sync::atomic::{AtomicBool, AtomicU16, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use anyhow::{anyhow, Result};
+use libc;
+
+use ffi;
+
+use errors::ErrorKind::OsError;
+use ethdev::{EthDevice, PortId, QueueId};
+use launch;
+use lcore;
+use mbuf::{MBuf, MbufBurst};
+use ring::{Ring, RingFlags, SyncMode};
+use utils::add_counter;
+
+/// The packets moved at a time between the stages.
+pub const BURST_SIZE: usize = 32;
+
+/// The number of buckets of the indirection table.
+pub const RETA_SIZE: usize = 256;
+
+/// The packets buffered by a RX lcore for each worker, up to two bursts.
+const STAGE_SIZE: usize = 2 * BURST_SIZE;
+
+/// The most buckets moved by a rebalancing.
+const MAX_MOVES: usize = RETA_SIZE / 8;
+
+/// Process a packet, and return the port to send it to, or `None` to drop it.
+pub type Handler = dyn Fn(&mut MBuf) -> Option<PortId> + Send + Sync;
+
+/// The counters of a stage, only written by its lcore.
+#[repr(align(64))]
+#[derive(Debug, Default)]
+struct Counters {
+    packets: AtomicU64,
+    stalls: AtomicU64,
+    stolen: AtomicU64,
+    dropped: AtomicU64,
+}
+
+impl Counters {
+    fn snapshot(&self, backlog: usize) -> Stats {
+        Stats {
+            packets: self.packets.load(Ordering::Relaxed),
+            stalls: self.stalls.load(Ordering::Relaxed),
+            stolen: self.stolen.load(Ordering::Relaxed),
+            dropped: self.dropped.load(Ordering::Relaxed),
+            backlog,
+        }
+    }
+}
+
+/// The counters of a stage.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct Stats {
+    /// The packets received, processed or sent.
+    pub packets: u64,
+    /// The loops skipped because the next stage was full.
+    pub stalls: u64,
+    /// The packets a worker stole from the other workers.
+    pub stolen: u64,
+    /// The packets dropped by the handler, or sent to a port without TX stage.
+    pub dropped: u64,
+    /// The packets waiting in the ring of the stage.
+    pub backlog: usize,
+}
+
+/// The counters of all the stages.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct PipelineStats {
+    pub rx: Vec<Stats>,
+    pub workers: Vec<Stats>,
+    pub tx: Vec<Stats>,
+}
+
+struct RxStage {
+    lcore_id: lcore::Id,
+    queues: Vec<(PortId, QueueId)>,
+    counters: Counters,
+    /// The packets dispatched to each bucket, for the rebalancing.
+    buckets: Vec<AtomicU64>,
+}
+
+struct WorkerStage {
+    lcore_id: lcore::Id,
+    ring: Ring<MBuf>,
+    counters: Counters,
+}
+
+struct TxStage {
+    lcore_id: lcore::Id,
+    port_id: PortId,
+    queue_id: QueueId,
+    ring: Ring<MBuf>,
+    counters: Counters,
+}
+
+struct Shared {
+    handler: Box<Handler>,
+    rx: Vec<RxStage>,
+    workers: Vec<WorkerStage>,
+    tx: Vec<TxStage>,
+    /// The TX stage of each port.
+    tx_ports: Vec<Option<usize>>,
+    reta: Vec<AtomicU16>,
+    steal_threshold: Option<usize>,
+    quit: AtomicBool,
+}
+
+impl Drop for Shared {
+    fn drop(&mut self) {
+        // the packets still in the rings are freed with them
+        for w in self.workers.drain(..) {
+            w.ring.free();
+        }
+        for tx in self.tx.drain(..) {
+            tx.ring.free();
+        }
+    }
+}
+
+#[derive(Clone, Copy, Debug)]
+enum Role {
+    Rx(usize),
+    Worker(usize),
+    Tx(usize),
+}
+
+/// Collect the stages of a pipeline.
+pub struct Pipeline {
+    name: String,
+    ring_size: usize,
+    steal_threshold: Option<usize>,
+    rx: Vec<(lcore::Id, Vec<(PortId, QueueId)>)>,
+    workers: Vec<lcore::Id>,
+    tx: Vec<(lcore::Id, PortId, QueueId)>,
+}
+
+impl Pipeline {
+    /// A pipeline named after its rings, with rings of 1024 packets, and work stealing enabled.
+    pub fn new<S: Into<String>>(name: S) -> Self {
+        Pipeline {
+            name: name.into(),
+            ring_size: 1024,
+            steal_threshold: Some(BURST_SIZE),
+            rx: vec![],
+            workers: vec![],
+            tx: vec![],
+        }
+    }
+
+    /// The size of the rings of the workers and TX lcores, a power of 2.
+    pub fn ring_size(&mut self, size: usize) -> &mut Self {
+        self.ring_size = size;
+        self
+    }
+
+    /// Let an idle worker steal from another worker with at least `threshold` packets in its backlog,
+    /// or disable the stealing to keep the order of the packets of a flow.
+    pub fn steal(&mut self, threshold: Option<usize>) -> &mut Self {
+        self.steal_threshold = threshold;
+        self
+    }
+
+    /// Poll a RX queue on an lcore, which may poll several queues.
+    pub fn rx(&mut self, lcore_id: lcore::Id, port_id: PortId, queue_id: QueueId) -> &mut Self {
+        if let Some(&mut (_, ref mut queues)) = self.rx.iter_mut().find(|&&mut (id, _)| id == lcore_id) {
+            queues.push((port_id, queue_id));
+        } else {
+            self.rx.push((lcore_id, vec![(port_id, queue_id)]));
+        }
+        self
+    }
+
+    /// Run a worker on an lcore.
+    pub fn worker(&mut self, lcore_id: lcore::Id) -> &mut Self {
+        self.workers.push(lcore_id);
+        self
+    }
+
+    /// Send the packets of a port on a TX queue from an lcore, one lcore per port.
+    pub fn tx(&mut self, lcore_id: lcore::Id, port_id: PortId, queue_id: QueueId) -> &mut Self {
+        self.tx.push((lcore_id, port_id, queue_id));
+        self
+    }
+
+    fn check(&self) -> Result<()> {
+        let mut lcores = self
+            .rx
+            .iter()
+            .map(|&(id, _)| id)
+            .chain(self.workers.iter().cloned())
+            .chain(self.tx.iter().map(|&(id, _, _)| id))
+            .map(|id| *id)
+            .collect::<Vec<_>>();
+        let nb_lcores = lcores.len();
+
+        lcores.sort();
+        lcores.dedup();
+
+        let mut ports = self.tx.iter().map(|&(_, port_id, _)| port_id).collect::<Vec<_>>();
+        let nb_ports = ports.len();
+
+        ports.sort();
+        ports.dedup();
+
+        // each lcore runs one stage, and each port is sent by one lcore
+        if self.rx.is_empty()
+            || self.workers.is_empty()
+            || self.workers.len() > u16::max_value() as usize
+            || lcores.len() != nb_lcores
+            || ports.len() != nb_ports
+            || ports.iter().any(|&port_id| port_id as u32 >= ffi::RTE_MAX_ETHPORTS)
+        {
+            Err(anyhow!(OsError(libc::EINVAL)))
+        } else {
+            Ok(())
+        }
+    }
+
+    /// Create the rings and launch the stages on their lcores.
+    ///
+    /// To be executed on the MASTER lcore only, the pipeline runs until the returned handle is dropped.
+    pub fn launch<F>(&self, handler: F) -> Result<Running>
+    where
+        F: Fn(&mut MBuf) -> Option<PortId> + Send + Sync + 'static,
+    {
+        self.check()?;
+
+        let mut workers = vec![];
+
+        for (i, &lcore_id) in self.workers.iter().enumerate() {
+            workers.push(WorkerStage {
+                lcore_id,
+                // the RX lcores enqueue, the worker and the stealers dequeue
+                ring: Ring::create(
+                    format!("{}_w{}", self.name, i),
+                    self.ring_size,
+                    lcore_id.socket_id(),
+                    RingFlags::empty(),
+                )?,
+                counters: Counters::default(),
+            });
+        }
+
+        let mut tx = vec![];
+        let mut tx_ports = vec![None; ffi::RTE_MAX_ETHPORTS as usize];
+
+        for (i, &(lcore_id, port_id, queue_id)) in self.tx.iter().enumerate() {
+            tx_ports[port_id as usize] = Some(i);
+            tx.push(TxStage {
+                lcore_id,
+                port_id,
+                queue_id,
+                ring: Ring::create(
+                    format!("{}_t{}", self.name, i),
+                    self.ring_size,
+                    lcore_id.socket_id(),
+                    SyncMode::SingleThread.dequeue_flags(),
+                )?,
+                counters: Counters::default(),
+            });
+        }
+
+        let shared = Arc::new(Shared {
+            handler: Box::new(handler),
+            rx: self
+                .rx
+                .iter()
+                .map(|&(lcore_id, ref queues)| RxStage {
+                    lcore_id,
+                    queues: queues.clone(),
+                    counters: Counters::default(),
+                    buckets: (0..RETA_SIZE).map(|_| AtomicU64::new(0)).collect(),
+                })
+                .collect(),
+            workers,
+            tx,
+            tx_ports,
+            reta: (0..RETA_SIZE)
+                .map(|b| AtomicU16::new((b % self.workers.len()) as u16))
+                .collect(),
+            steal_threshold: self.steal_threshold,
+            quit: AtomicBool::new(false),
+        });
+
+        let mut running = Running {
+            shared: shared.clone(),
+            lcores: vec![],
+            loads: vec![0; RETA_SIZE],
+        };
+
+        let roles = (0..shared.rx.len())
+            .map(|i| (shared.rx[i].lcore_id, Role::Rx(i)))
+            .chain((0..shared.workers.len()).map(|i| (shared.workers[i].lcore_id, Role::Worker(i))))
+            .chain((0..shared.tx.len()).map(|i| (shared.tx[i].lcore_id, Role::Tx(i))));
+
+        // the running handle stops the launched stages if a launch fails
+        for (lcore_id, role) in roles {
+            launch::remote_launch(lcore_main, Some((shared.clone(), role)), lcore_id)?;
+
+            running.lcores.push(lcore_id);
+        }
+
+        Ok(running)
+    }
+}
+
+/// A running pipeline, stopped when dropped.
+pub struct Running {
+    shared: Arc<Shared>,
+    lcores: Vec<lcore::Id>,
+    /// The packets dispatched to each bucket at the last rebalancing.
+    loads: Vec<u64>,
+}
+
+impl Drop for Running {
+    fn drop(&mut self) {
+        self.shared.quit.store(true, Ordering::Release);
+
+        for lcore_id in self.lcores.drain(..) {
+            lcore_id.wait();
+        }
+    }
+}
+
+impl Running {
+    /// The counters of the stages.
+    pub fn stats(&self) -> PipelineStats {
+        PipelineStats {
+            rx: self.shared.rx.iter().map(|rx| rx.counters.snapshot(0)).collect(),
+            workers: self
+                .shared
+                .workers
+                .iter()
+                .map(|w| w.counters.snapshot(w.ring.count()))
+                .collect(),
+            tx: self
+                .shared
+                .tx
+                .iter()
+                .map(|tx| tx.counters.snapshot(tx.ring.count()))
+                .collect(),
+        }
+    }
+
+    /// Move the buckets of the indirection table from the most loaded workers to the least loaded ones,
+    /// after the packets dispatched since the last rebalancing.
+    ///
+    /// Return the number of buckets moved, the RX lcores dispatch to the new workers from their next burst.
+    pub fn rebalance(&mut self) -> usize {
+        let shared = &self.shared;
+        let mut loads = vec![0; RETA_SIZE];
+
+        for (b, load) in loads.iter_mut().enumerate() {
+            let total = shared
+                .rx
+                .iter()
+                .map(|rx| rx.buckets[b].load(Ordering::Relaxed))
+                .sum::<u64>();
+
+            *load = total.wrapping_sub(self.loads[b]);
+            self.loads[b] = total;
+        }
+
+        let mut reta = shared
+            .reta
+            .iter()
+            .map(|w| w.load(Ordering::Relaxed))
+            .collect::<Vec<_>>();
+        let moved = plan_rebalance(&mut reta, &loads, shared.workers.len(), MAX_MOVES);
+
+        for (w, &new) in shared.reta.iter().zip(&reta) {
+            w.store(new, Ordering::Relaxed);
+        }
+
+        moved
+    }
+
+    /// Stop the stages, and free the packets left in the pipeline.
+    pub fn stop(self) {}
+}
+
+/// Move up to `max_moves` buckets between the workers to even their loads, return the number of buckets moved.
+///
+/// Each move takes a bucket from the most loaded worker to the least loaded one, picking the bucket
+/// which narrows their gap the most, so the loads converge without moving a bucket back and forth.
+fn plan_rebalance(reta: &mut [u16], loads: &[u64], nb_workers: usize, max_moves: usize) -> usize {
+    let mut worker_loads = vec![0u64; nb_workers];
+
+    for (&w, &load) in reta.iter().zip(loads) {
+        worker_loads[w as usize] += load;
+    }
+
+    let mut moved = 0;
+
+    while moved < max_moves {
+        let (max_w, max_load) = worker_loads
+            .iter()
+            .cloned()
+            .enumerate()
+            .max_by_key(|&(_, load)| load)
+            .unwrap();
+        let (min_w, min_load) = worker_loads
+            .iter()
+            .cloned()
+            .enumerate()
+            .min_by_key(|&(_, load)| load)
+            .unwrap();
+        let gap = max_load - min_load;
+
+        // moving a bucket of load `l` narrows the gap when `0 < l < gap`, and the most at `gap / 2`
+        let best = reta
+            .iter()
+            .enumerate()
+            .filter(|&(b, &w)| w as usize == max_w && loads[b] > 0 && loads[b] < gap)
+            .max_by_key(|&(b, _)| loads[b] * (gap - loads[b]))
+            .map(|(b, _)| b);
+
+        match best {
+            Some(b) => {
+                reta[b] = min_w as u16;
+                worker_loads[max_w] -= loads[b];
+                worker_loads[min_w] += loads[b];
+                moved += 1;
+            }
+            None => break,
+        }
+    }
+
+    moved
+}
+
+fn lcore_main(arg: Option<(Arc<Shared>, Role)>) -> i32 {
+    let (shared, role) = arg.unwrap();
+
+    debug!("lcore {} running pipeline stage {:?}", lcore::current().unwrap(), role);
+
+    match role {
+        Role::Rx(i) => rx_loop(&shared, &shared.rx[i]),
+        Role::Worker(i) => worker_loop(&shared, i),
+        Role::Tx(i) => tx_loop(&shared, &shared.tx[i]),
+    }
+
+    0
+}
+
+fn rx_loop(shared: &Shared, rx: &RxStage) {
+    let mut pkts = MbufBurst::<BURST_SIZE>::new();
+    let mut staged = (0..shared.workers.len())
+        .map(|_| MbufBurst::<STAGE_SIZE>::new())
+        .collect::<Vec<_>>();
+    // spread the packets without RSS hash over the buckets
+    let mut next_bucket = 0;
+
+    while !shared.quit.load(Ordering::Acquire) {
+        for &(port_id, queue_id) in &rx.queues {
+            // leave the packets in the device while a worker can't take a full burst
+            if staged.iter().any(|s| s.len() > STAGE_SIZE - BURST_SIZE) {
+                add_counter(&rx.counters.stalls, 1);
+            } else {
+                let nb_rx = port_id.rx_burst(queue_id, &mut pkts);
+
+                add_counter(&rx.counters.packets, nb_rx as u64);
+
+                for m in pkts.drain() {
+                    let b = m.rss_hash().map_or_else(
+                        || {
+                            next_bucket = (next_bucket + 1) % RETA_SIZE;
+                            next_bucket
+                        },
+                        |hash| hash as usize % RETA_SIZE,
+                    );
+                    let w = shared.reta[b].load(Ordering::Relaxed) as usize;
+
+                    add_counter(&rx.buckets[b], 1);
+
+                    let _ = staged[w].push(m);
+                }
+            }
+
+            for (w, s) in staged.iter_mut().enumerate() {
+                if !s.is_empty() {
+                    shared.workers[w].ring.enqueue_mbufs(s);
+                }
+            }
+        }
+    }
+}
+
+fn worker_loop(shared: &Shared, i: usize) {
+    let worker = &shared.workers[i];
+    let mut pkts = MbufBurst::<BURST_SIZE>::new();
+    let mut out = (0..shared.tx.len())
+        .map(|_| MbufBurst::<BURST_SIZE>::new())
+        .collect::<Vec<_>>();
+
+    while !shared.quit.load(Ordering::Acquire) {
+        // don't take more packets while a TX lcore is full
+        if flush(shared, &mut out) {
+            add_counter(&worker.counters.stalls, 1);
+
+            continue;
+        }
+
+        if worker.ring.dequeue_mbufs(&mut pkts) == 0 {
+            if let Some(threshold) = shared.steal_threshold {
+                let victim = shared
+                    .workers
+                    .iter()
+                    .enumerate()
+                    .filter(|&(w, _)| w != i)
+                    .map(|(_, w)| (w.ring.count(), w))
+                    .max_by_key(|&(count, _)| count);
+
+                if let Some((count, victim)) = victim {
+                    if count >= cmp::max(threshold, 1) {
+                        let n = victim.ring.dequeue_mbufs(&mut pkts);
+
+                        add_counter(&worker.counters.stolen, n as u64);
+                    }
+                }
+            }
+
+            if pkts.is_empty() {
+                continue;
+            }
+        }
+
+        add_counter(&worker.counters.packets, pkts.len() as u64);
+
+        // the TX buffers were flushed, so each one has room for the whole burst
+        for mut m in pkts.drain() {
+            match (shared.handler)(&mut m).and_then(|port_id| shared.tx_ports.get(port_id as usize).cloned()) {
+                Some(Some(t)) => {
+                    let _ = out[t].push(m);
+                }
+                _ => add_counter(&worker.counters.dropped, 1),
+            }
+        }
+
+        flush(shared, &mut out);
+    }
+}
+
+/// Enqueue the packets of the workers to the TX lcores, return true if some packets are left.
+#[inline]
+fn flush(shared: &Shared, out: &mut [MbufBurst<BURST_SIZE>]) -> bool {
+    let mut pending = false;
+
+    for (tx, pkts) in shared.tx.iter().zip(out.iter_mut()) {
+        if !pkts.is_empty() {
+            tx.ring.enqueue_mbufs(pkts);
+
+            pending |= !pkts.is_empty();
+        }
+    }
+
+    pending
+}
+
+fn tx_loop(shared: &Shared, tx: &TxStage) {
+    let mut pkts = MbufBurst::<BURST_SIZE>::new();
+
+    while !shared.quit.load(Ordering::Acquire) {
+        // the packets the device didn't take stay in the burst
+        // the TX lcore is the only consumer of its ring
+        if unsafe { tx.ring.sc_dequeue_mbufs(&mut pkts) } == 0 && pkts.is_empty() {
+            continue;
+        }
+
+        let nb_tx = tx.port_id.tx_burst(tx.queue_id, &mut pkts);
+
+        add_counter(&tx.counters.packets, nb_tx as u64);
+
+        if !pkts.is_empty() {
+            add_counter(&tx.counters.stalls, 1);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_plan_rebalance() {
+        // two workers, with all the traffic in the buckets of the first one
+        let mut reta = (0..RETA_SIZE).map(|b| (b % 2) as u16).collect::<Vec<_>>();
+        let mut loads = vec![0; RETA_SIZE];
+
+        loads[0] = 300;
+        loads[2] = 300;
+        loads[4] = 200;
+        loads[6] = 200;
+
+        assert_eq!(plan_rebalance(&mut reta, &loads, 2, MAX_MOVES), 2);
+        assert_eq!(&reta[..8], &[0, 1, 1, 1, 0, 1, 1, 1]);
+
+        // already balanced
+        assert_eq!(plan_rebalance(&mut reta, &loads, 2, MAX_MOVES), 0);
+
+        // a single elephant flow can't be split
+        let mut loads = vec![0; RETA_SIZE];
+
+        loads[1] = 1000;
+
+        assert_eq!(plan_rebalance(&mut reta, &loads, 2, MAX_MOVES), 0);
+
+        // the moves are bounded
+        let mut reta = vec![0; RETA_SIZE];
+
+        assert_eq!(plan_rebalance(&mut reta, &[1; RETA_SIZE], 4, 3), 3);
+    }
+}
@@ -0,0 +1,347 @@
+//!
+//! NUMA-aware placement of the port queues on the lcores.
+//!
+//! An lcore polling a port attached to a remote socket, or allocating the mbufs
+//! of its queues from a remote pool, pays a cross-socket access for every packet.
+//! The planner assigns each RX queue to an lcore on the socket of its port,
+//! and creates one pktmbuf pool per socket the lcores run on.
+//!
+use std::fmt;
+
+use anyhow::{anyhow, Result};
+
+use ethdev::{EthDevice, PortId, QueueId};
+use lcore;
+use mbuf;
+use memory::{SocketId, SOCKET_ID_ANY};
+use mempool::MemoryPool;
+
+/// What to do when a queue can't be polled by an lcore on the socket of its port.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Policy {
+    /// Assign the queue to a remote lcore and log a warning.
+    Warn,
+    /// Fail the planning.
+    Strict,
+}
+
+/// A port and its number of RX queues to place.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct PortSpec {
+    pub port_id: PortId,
+    pub socket_id: SocketId,
+    pub nb_queues: QueueId,
+}
+
+/// An lcore which may poll queues.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct LcoreSpec {
+    pub lcore_id: lcore::Id,
+    pub socket_id: SocketId,
+}
+
+/// A RX queue assigned to an lcore.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct Assignment {
+    pub port_id: PortId,
+    pub queue_id: QueueId,
+    pub lcore_id: lcore::Id,
+    /// The socket of the lcore, where the mbufs of the queue should come from.
+    pub socket_id: SocketId,
+    /// The port is attached to another socket than the lcore.
+    pub remote: bool,
+}
+
+impl fmt::Display for Assignment {
+    fn fmt(&self, f: &mut fmt::Formatter) -> fmt::Result {
+        write!(
+            f,
+            "port {} queue {} on lcore {} (socket {}{})",
+            self.port_id,
+            self.queue_id,
+            self.lcore_id,
+            self.socket_id,
+            if self.remote { ", remote" } else { "" }
+        )
+    }
+}
+
+/// Collect the ports and lcores to place.
+pub struct Planner {
+    policy: Policy,
+    queues_per_lcore: usize,
+    ports: Vec<PortSpec>,
+    lcores: Vec<LcoreSpec>,
+}
+
+impl Planner {
+    /// A planner over all the enabled lcores, each one polling at most `queues_per_lcore` queues.
+    pub fn new(policy: Policy, queues_per_lcore: usize) -> Self {
+        Planner {
+            policy,
+            queues_per_lcore,
+            ports: vec![],
+            lcores: lcore::enabled()
+                .into_iter()
+                .map(|lcore_id| LcoreSpec {
+                    lcore_id,
+                    socket_id: lcore_id.socket_id(),
+                })
+                .collect(),
+        }
+    }
+
+    /// Place `nb_queues` RX queues of a port.
+    ///
+    /// A port without socket, such as a virtual device, is local to every lcore.
+    pub fn port(&mut self, port_id: PortId, nb_queues: QueueId) -> &mut Self {
+        let socket_id = port_id.socket_id();
+        let known = sockets().contains(&socket_id);
+
+        self.ports.push(PortSpec {
+            port_id,
+            socket_id: if known { socket_id } else { SOCKET_ID_ANY },
+            nb_queues,
+        });
+        self
+    }
+
+    /// Assign the queues of the ports to the lcores.
+    pub fn plan(&self) -> Result<Placement> {
+        let assignments = assign(&self.ports, &self.lcores, self.queues_per_lcore, self.policy)?;
+
+        for a in assignments.iter().filter(|a| a.remote) {
+            warn!("{} is on another socket than the port", a);
+        }
+
+        Ok(Placement { assignments })
+    }
+}
+
+/// The detected physical sockets.
+pub fn sockets() -> Vec<SocketId> {
+    (0..lcore::socket_count())
+        .filter_map(|idx| lcore::socket_id_by_idx(idx).ok())
+        .collect()
+}
+
+/// Assign the queues queue-major, the queue 0 of every port before the queues 1,
+/// each to the first lcore of the socket of the port with less than `queues_per_lcore` queues.
+///
+/// An lcore is filled before the next one is used, so the RSS queues of a port
+/// only spread over several lcores when `queues_per_lcore` is smaller than its queues.
+pub fn assign(
+    ports: &[PortSpec],
+    lcores: &[LcoreSpec],
+    queues_per_lcore: usize,
+    policy: Policy,
+) -> Result<Vec<Assignment>> {
+    let mut load = vec![0; lcores.len()];
+    let mut assignments = vec![];
+    let max_queues = ports.iter().map(|port| port.nb_queues).max().unwrap_or(0);
+
+    for queue_id in 0..max_queues {
+        for port in ports.iter().filter(|port| queue_id < port.nb_queues) {
+            let is_local = |lcore: &LcoreSpec| port.socket_id == SOCKET_ID_ANY || lcore.socket_id == port.socket_id;
+            let free = |idx: &usize| load[*idx] < queues_per_lcore;
+
+            let idx = match (0..lcores.len()).filter(free).find(|&idx| is_local(&lcores[idx])) {
+                Some(idx) => idx,
+                None if policy == Policy::Strict => {
+                    return Err(anyhow!(
+                        "no free lcore on socket {} for port {} queue {}",
+                        port.socket_id,
+                        port.port_id,
+                        queue_id
+                    ));
+                }
+                None => (0..lcores.len())
+                    .find(free)
+                    .ok_or_else(|| anyhow!("not enough lcores for port {} queue {}", port.port_id, queue_id))?,
+            };
+
+            load[idx] += 1;
+
+            assignments.push(Assignment {
+                port_id: port.port_id,
+                queue_id,
+                lcore_id: lcores[idx].lcore_id,
+                socket_id: lcores[idx].socket_id,
+                remote: !is_local(&lcores[idx]),
+            });
+        }
+    }
+
+    Ok(assignments)
+}
+
+/// The queues assigned to the lcores.
+#[derive(Debug)]
+pub struct Placement {
+    pub assignments: Vec<Assignment>,
+}
+
+impl Placement {
+    /// The queues polled by an lcore.
+    pub fn lcore_queues(&self, lcore_id: lcore::Id) -> impl Iterator<Item = &Assignment> {
+        self.assignments.iter().filter(move |a| a.lcore_id == lcore_id)
+    }
+
+    /// The lcores polling at least one queue, in assignment order.
+    pub fn lcores(&self) -> Vec<lcore::Id> {
+        let mut lcores: Vec<lcore::Id> = vec![];
+
+        for a in &self.assignments {
+            if !lcores.contains(&a.lcore_id) {
+                lcores.push(a.lcore_id);
+            }
+        }
+
+        lcores
+    }
+
+    /// The sockets of the lcores polling at least one queue.
+    pub fn sockets(&self) -> Vec<SocketId> {
+        let mut sockets: Vec<SocketId> = self.assignments.iter().map(|a| a.socket_id).collect();
+
+        sockets.sort();
+        sockets.dedup();
+        sockets
+    }
+
+    /// The number of queues polled by an lcore on another socket than their port.
+    pub fn remote_queues(&self) -> usize {
+        self.assignments.iter().filter(|a| a.remote).count()
+    }
+
+    /// Create a pktmbuf pool named `<prefix>_<socket>` on each socket of the lcores.
+    pub fn create_pools<S: AsRef<str>>(
+        &self,
+        prefix: S,
+        n: u32,
+        cache_size: u32,
+        priv_size: u16,
+        data_room_size: u16,
+    ) -> Result<SocketPools> {
+        let mut pools = vec![];
+
+        for socket_id in self.sockets() {
+            let name = format!("{}_{}", prefix.as_ref(), socket_id);
+            let pool = mbuf::pool_create(&name, n, cache_size, priv_size, data_room_size, socket_id)
+                .map_err(|err| anyhow!("fail to create mbuf pool {}: {}", name, err))?;
+
+            pools.push((socket_id, pool));
+        }
+
+        Ok(SocketPools { pools })
+    }
+}
+
+/// One pktmbuf pool per socket.
+#[derive(Debug)]
+pub struct SocketPools {
+    pools: Vec<(SocketId, MemoryPool)>,
+}
+
+impl SocketPools {
+    /// The pool of a socket.
+    pub fn get(&self, socket_id: SocketId) -> Option<&MemoryPool> {
+        self.pools
+            .iter()
+            .find(|&&(id, _)| id == socket_id)
+            .map(|(_, pool)| pool)
+    }
+
+    /// The pool of a socket.
+    pub fn get_mut(&mut self, socket_id: SocketId) -> Option<&mut MemoryPool> {
+        self.pools
+            .iter_mut()
+            .find(|&&mut (id, _)| id == socket_id)
+            .map(|(_, pool)| pool)
+    }
+
+    /// The pools of all the sockets.
+    pub fn iter(&self) -> impl Iterator<Item = &MemoryPool> {
+        self.pools.iter().map(|(_, pool)| pool)
+    }
+
+    /// The pool for the queue of an assignment.
+    pub fn for_queue(&mut self, a: &Assignment) -> Option<&mut MemoryPool> {
+        self.get_mut(a.socket_id)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn lcores(sockets: &[SocketId]) -> Vec<LcoreSpec> {
+        sockets
+            .iter()
+            .enumerate()
+            .map(|(id, &socket_id)| LcoreSpec {
+                lcore_id: lcore::id(id as u32),
+                socket_id,
+            })
+            .collect()
+    }
+
+    fn port(port_id: PortId, socket_id: SocketId, nb_queues: QueueId) -> PortSpec {
+        PortSpec {
+            port_id,
+            socket_id,
+            nb_queues,
+        }
+    }
+
+    #[test]
+    fn test_assign() {
+        let lcores = lcores(&[0, 0, 1, 1]);
+        let ports = [port(0, 0, 2), port(1, 1, 2)];
+
+        let assignments = assign(&ports, &lcores, 1, Policy::Strict).unwrap();
+
+        assert_eq!(assignments.len(), 4);
+        assert!(assignments.iter().all(|a| !a.remote));
+        assert_eq!(
+            assignments
+                .iter()
+                .map(|a| (a.port_id, a.queue_id, *a.lcore_id))
+                .collect::<Vec<_>>(),
+            vec![(0, 0, 0), (1, 0, 2), (0, 1, 1), (1, 1, 3)]
+        );
+
+        // the lcores are filled before the next one is used
+        let assignments = assign(&ports[..1], &lcores, 2, Policy::Strict).unwrap();
+
+        assert!(assignments.iter().all(|a| a.lcore_id == 0));
+
+        // a port without socket is local to every lcore
+        let assignments = assign(&[port(0, SOCKET_ID_ANY, 3)], &lcores, 1, Policy::Strict).unwrap();
+
+        assert_eq!(
+            assignments.iter().map(|a| *a.lcore_id).collect::<Vec<_>>(),
+            vec![0, 1, 2]
+        );
+        assert!(assignments.iter().all(|a| !a.remote));
+    }
+
+    #[test]
+    fn test_assign_remote() {
+        let lcores = lcores(&[0, 1]);
+        let ports = [port(0, 0, 2)];
+
+        assert!(assign(&ports, &lcores, 1, Policy::Strict).is_err());
+
+        let assignments = assign(&ports, &lcores, 1, Policy::Warn).unwrap();
+
+        assert_eq!(assignments[0].lcore_id, 0);
+        assert!(!assignments[0].remote);
+        assert_eq!(assignments[1].lcore_id, 1);
+        assert_eq!(assignments[1].socket_id, 1);
+        assert!(assignments[1].remote);
+
+        // not enough lcores whatever the policy
+        assert!(assign(&[port(0, 0, 3)], &lcores, 1, Policy::Warn).is_err());
+    }
+}
@@ -1,5 +1,805 @@
+//!
+//! RTE Ring
+//!
+//! The Ring Manager is a fixed-size queue, implemented as a table of
+//! objects. Head and tail pointers are modified atomically, allowing
+//! concurrent access to it. It has the following features:
+//!
+//! - FIFO (First In First Out)
+//! - Maximum size is fixed; the objects are stored in a table.
+//! - Lockless implementation.
+//! - Multi- or single-consumer dequeue.
+//! - Multi- or single-producer enqueue.
+//! - Bulk dequeue.
+//! - Bulk enqueue.
+//! - Ability to select different sync modes for producer/consumer.
+//! - Dequeue start/finish (depending on consumer sync modes).
+//! - Enqueue start/finish (depending on producer sync mode).
+//!
+//! A `Ring<T>` stores the values of `T` directly in the ring table, so the size of `T`
+//! must be a multiple of 4 bytes, and `Option<T>` must have the same layout as `T`
+//! (pointers, `MBuf`, `Box`, `NonNull`, ...). The enqueue and dequeue functions move
+//! the values in and out of `Option<T>` slots, like `rx_burst` does for the packets,
+//! the objects are only enqueued up to the first empty slot.
+//!
+//! A `Ring<T>` may be shared by the threads, so the safe functions never use the `SingleThread` mode:
+//! a side created with `RING_F_SP_ENQ` or `RING_F_SC_DEQ` falls back to the multi-thread functions,
+//! and the single thread fast path is only reached through the unsafe `sp_*` and `sc_*` functions.
+//!
+use std::ffi::CStr;
+use std::marker::PhantomData;
+use std::mem;
+use std::ops::Deref;
+use std::os::raw::{c_uint, c_void};
+use std::os::unix::io::AsRawFd;
+use std::ptr::{self, NonNull};
+use std::result;
+use std::slice;
+
+use anyhow::{anyhow, Result};
+use cfile;
+use libc;
+
 use ffi;
 
+use errors::{AsResult, ErrorKind::OsError};
+use mbuf::{MBuf, MbufBurst};
+use memory::SocketId;
+use utils::{AsCString, AsRaw};
+
 lazy_static! {
     pub static ref RTE_RING_NAMESIZE: usize = ffi::RTE_MEMZONE_NAMESIZE as usize - ffi::RTE_RING_MZ_PREFIX.len() + 1;
 }
+
+bitflags! {
+    /// Flags supplied at ring creation.
+    pub struct RingFlags: u32 {
+        /// The default enqueue is "single-producer".
+        const RING_F_SP_ENQ     = ffi::RING_F_SP_ENQ;
+        /// The default dequeue is "single-consumer".
+        const RING_F_SC_DEQ     = ffi::RING_F_SC_DEQ;
+        /// Ring holds exactly the requested number of entries.
+        const RING_F_EXACT_SZ   = ffi::RING_F_EXACT_SZ;
+        /// The default enqueue is "MP RTS".
+        const RING_F_MP_RTS_ENQ = ffi::RING_F_MP_RTS_ENQ;
+        /// The default dequeue is "MC RTS".
+        const RING_F_MC_RTS_DEQ = ffi::RING_F_MC_RTS_DEQ;
+        /// The default enqueue is "MP HTS".
+        const RING_F_MP_HTS_ENQ = ffi::RING_F_MP_HTS_ENQ;
+        /// The default dequeue is "MC HTS".
+        const RING_F_MC_HTS_DEQ = ffi::RING_F_MC_HTS_DEQ;
+    }
+}
+
+/// The producer or consumer synchronization mode of a ring.
+#[repr(u32)]
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub enum SyncMode {
+    /// Multi-thread safe (default mode).
+    MultiThread = ffi::rte_ring_sync_type::RTE_RING_SYNC_MT,
+    /// Single thread only.
+    SingleThread = ffi::rte_ring_sync_type::RTE_RING_SYNC_ST,
+    /// Multi-thread relaxed tail sync.
+    RelaxedTail = ffi::rte_ring_sync_type::RTE_RING_SYNC_MT_RTS,
+    /// Multi-thread head/tail sync.
+    HeadTail = ffi::rte_ring_sync_type::RTE_RING_SYNC_MT_HTS,
+}
+
+impl From<ffi::rte_ring_sync_type::Type> for SyncMode {
+    fn from(t: ffi::rte_ring_sync_type::Type) -> Self {
+        match t {
+            ffi::rte_ring_sync_type::RTE_RING_SYNC_ST => SyncMode::SingleThread,
+            ffi::rte_ring_sync_type::RTE_RING_SYNC_MT_RTS => SyncMode::RelaxedTail,
+            ffi::rte_ring_sync_type::RTE_RING_SYNC_MT_HTS => SyncMode::HeadTail,
+            _ => SyncMode::MultiThread,
+        }
+    }
+}
+
+impl SyncMode {
+    /// The ring creation flags which select this mode for the producers.
+    pub fn enqueue_flags(self) -> RingFlags {
+        match self {
+            SyncMode::MultiThread => RingFlags::empty(),
+            SyncMode::SingleThread => RingFlags::RING_F_SP_ENQ,
+            SyncMode::RelaxedTail => RingFlags::RING_F_MP_RTS_ENQ,
+            SyncMode::HeadTail => RingFlags::RING_F_MP_HTS_ENQ,
+        }
+    }
+
+    /// The ring creation flags which select this mode for the consumers.
+    pub fn dequeue_flags(self) -> RingFlags {
+        match self {
+            SyncMode::MultiThread => RingFlags::empty(),
+            SyncMode::SingleThread => RingFlags::RING_F_SC_DEQ,
+            SyncMode::RelaxedTail => RingFlags::RING_F_MC_RTS_DEQ,
+            SyncMode::HeadTail => RingFlags::RING_F_MC_HTS_DEQ,
+        }
+    }
+}
+
+pub type RawRing = ffi::rte_ring;
+pub type RawRingPtr = *mut ffi::rte_ring;
+
+type EnqueueFn = unsafe extern "C" fn(
+    r: RawRingPtr,
+    obj_table: *const c_void,
+    esize: c_uint,
+    n: c_uint,
+    free: *mut c_uint,
+) -> c_uint;
+
+type DequeueFn =
+    unsafe extern "C" fn(r: RawRingPtr, obj_table: *mut c_void, esize: c_uint, n: c_uint, avail: *mut c_uint) -> c_uint;
+
+/// A ring of `T` values.
+pub struct Ring<T> {
+    raw: NonNull<RawRing>,
+    /// The producers use the `SingleThread` mode by default.
+    sp: bool,
+    /// The consumers use the `SingleThread` mode by default.
+    sc: bool,
+    phantom: PhantomData<T>,
+}
+
+// The safe functions are multi-thread safe whatever the sync modes, see `Ring::from_raw`.
+unsafe impl<T: Send> Send for Ring<T> {}
+unsafe impl<T: Send> Sync for Ring<T> {}
+
+impl<T> Deref for Ring<T> {
+    type Target = RawRing;
+
+    fn deref(&self) -> &Self::Target {
+        unsafe { self.raw.as_ref() }
+    }
+}
+
+impl<T> AsRaw for Ring<T> {
+    type Raw = RawRing;
+
+    fn as_raw(&self) -> *const Self::Raw {
+        self.raw.as_ptr()
+    }
+
+    fn as_raw_mut(&self) -> *mut Self::Raw {
+        self.raw.as_ptr()
+    }
+}
+
+impl<T> Ring<T> {
+    const ESIZE: c_uint = mem::size_of::<T>() as c_uint;
+
+    fn check_layout() -> Result<()> {
+        if Self::ESIZE == 0 || Self::ESIZE % 4 != 0 || mem::size_of::<Option<T>>() != mem::size_of::<T>() {
+            Err(anyhow!(OsError(libc::EINVAL)))
+        } else {
+            Ok(())
+        }
+    }
+
+    fn from_raw(raw: NonNull<RawRing>) -> Self {
+        let (prod, cons) = unsafe {
+            (
+                SyncMode::from(ffi::_rte_ring_get_prod_sync_type(raw.as_ptr())),
+                SyncMode::from(ffi::_rte_ring_get_cons_sync_type(raw.as_ptr())),
+            )
+        };
+
+        Ring {
+            raw,
+            sp: prod == SyncMode::SingleThread,
+            sc: cons == SyncMode::SingleThread,
+            phantom: PhantomData,
+        }
+    }
+
+    /// Create a new ring named name in memory.
+    ///
+    /// The real usable ring size is count-1 instead of count to differentiate
+    /// a free ring from an empty ring, unless `RING_F_EXACT_SZ` is set.
+    /// The sync modes of the producers and consumers are selected with the flags,
+    /// see `SyncMode::enqueue_flags` and `SyncMode::dequeue_flags`.
+    pub fn create<S: AsRef<str>>(name: S, count: usize, socket_id: SocketId, flags: RingFlags) -> Result<Self> {
+        Self::check_layout()?;
+
+        let name = name.as_cstring();
+
+        unsafe { ffi::rte_ring_create_elem(name.as_ptr(), Self::ESIZE, count as u32, socket_id, flags.bits) }
+            .as_result()
+            .map(Self::from_raw)
+    }
+
+    /// Search a ring from its name.
+    ///
+    /// The ring must have been created with the same element type.
+    pub fn lookup<S: AsRef<str>>(name: S) -> Result<Self> {
+        Self::check_layout()?;
+
+        let name = name.as_cstring();
+
+        unsafe { ffi::rte_ring_lookup(name.as_ptr()) }
+            .as_result()
+            .map(Self::from_raw)
+    }
+
+    /// De-allocate all memory used by the ring.
+    ///
+    /// The objects still in the ring are dequeued and dropped first.
+    pub fn free(self) {
+        let mut objs: [Option<T>; 1] = [None];
+
+        while self.dequeue_burst(&mut objs) > 0 {
+            objs[0].take();
+        }
+
+        unsafe { ffi::rte_ring_free(self.raw.as_ptr()) }
+    }
+
+    /// Name of the ring.
+    pub fn name(&self) -> &str {
+        unsafe { CStr::from_ptr((&self.name[..]).as_ptr()).to_str().unwrap() }
+    }
+
+    /// Return the number of entries in the ring.
+    pub fn count(&self) -> usize {
+        unsafe { ffi::_rte_ring_count(self.as_raw()) as usize }
+    }
+
+    /// Return the number of free entries in the ring.
+    pub fn free_count(&self) -> usize {
+        unsafe { ffi::_rte_ring_free_count(self.as_raw()) as usize }
+    }
+
+    /// Test if the ring is full.
+    pub fn is_full(&self) -> bool {
+        unsafe { ffi::_rte_ring_full(self.as_raw()) != 0 }
+    }
+
+    /// Test if the ring is empty.
+    pub fn is_empty(&self) -> bool {
+        unsafe { ffi::_rte_ring_empty(self.as_raw()) != 0 }
+    }
+
+    /// Return the size of the data store used by the ring.
+    pub fn size(&self) -> usize {
+        unsafe { ffi::_rte_ring_get_size(self.as_raw()) as usize }
+    }
+
+    /// Return the number of elements which can be stored in the ring.
+    pub fn capacity(&self) -> usize {
+        unsafe { ffi::_rte_ring_get_capacity(self.as_raw()) as usize }
+    }
+
+    /// Return the sync mode used by the producers of the ring.
+    pub fn prod_sync_mode(&self) -> SyncMode {
+        unsafe { ffi::_rte_ring_get_prod_sync_type(self.as_raw()) }.into()
+    }
+
+    /// Return the sync mode used by the consumers of the ring.
+    pub fn cons_sync_mode(&self) -> SyncMode {
+        unsafe { ffi::_rte_ring_get_cons_sync_type(self.as_raw()) }.into()
+    }
+
+    /// Dump the status of the ring to a file.
+    pub fn dump<S: AsRawFd>(&self, s: &S) -> Result<()> {
+        let mut f = cfile::fdopen(s, "w")?;
+
+        unsafe { ffi::rte_ring_dump(&mut **f as *mut _ as *mut _, self.as_raw()) };
+
+        Ok(())
+    }
+
+    #[inline(always)]
+    fn enqueue_with(&self, objs: &mut [Option<T>], f: EnqueueFn) -> usize {
+        // an empty slot would be stored as the niche of `T` and dequeued as a value
+        let objs = match objs.iter().position(Option::is_none) {
+            Some(len) => &mut objs[..len],
+            None => objs,
+        };
+
+        let n = unsafe {
+            f(
+                self.as_raw_mut(),
+                objs.as_ptr() as *const c_void,
+                Self::ESIZE,
+                objs.len() as c_uint,
+                ptr::null_mut(),
+            )
+        } as usize;
+
+        // the ring owns the enqueued objects now
+        for obj in &mut objs[..n] {
+            mem::forget(obj.take());
+        }
+
+        n
+    }
+
+    #[inline(always)]
+    fn dequeue_with(&self, objs: &mut [Option<T>], f: DequeueFn) -> usize {
+        debug_assert!(objs.iter().all(Option::is_none));
+
+        unsafe {
+            f(
+                self.as_raw_mut(),
+                objs.as_mut_ptr() as *mut c_void,
+                Self::ESIZE,
+                objs.len() as c_uint,
+                ptr::null_mut(),
+            ) as usize
+        }
+    }
+
+    /// Enqueue one object on the ring, giving it back if the ring is full.
+    #[inline]
+    pub fn enqueue(&self, obj: T) -> result::Result<(), T> {
+        let mut objs = [Some(obj)];
+
+        if self.enqueue_bulk(&mut objs) == 1 {
+            Ok(())
+        } else {
+            Err(objs[0].take().unwrap())
+        }
+    }
+
+    /// Dequeue one object from the ring.
+    #[inline]
+    pub fn dequeue(&self) -> Option<T> {
+        let mut objs = [None];
+
+        self.dequeue_bulk(&mut objs);
+
+        objs[0].take()
+    }
+
+    /// Enqueue all the objects on the ring, or none of them.
+    ///
+    /// The enqueued objects are taken out of their slots.
+    /// This function uses the producer sync mode that was specified at ring creation time,
+    /// or the multi-producers mode instead of `SingleThread`.
+    #[inline]
+    pub fn enqueue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        if self.sp {
+            self.enqueue_with(objs, ffi::_rte_ring_mp_enqueue_bulk_elem)
+        } else {
+            self.enqueue_with(objs, ffi::_rte_ring_enqueue_bulk_elem)
+        }
+    }
+
+    /// Enqueue as many objects as possible on the ring, starting from the first one.
+    ///
+    /// The enqueued objects are taken out of their slots.
+    /// This function uses the producer sync mode that was specified at ring creation time,
+    /// or the multi-producers mode instead of `SingleThread`.
+    #[inline]
+    pub fn enqueue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        if self.sp {
+            self.enqueue_with(objs, ffi::_rte_ring_mp_enqueue_burst_elem)
+        } else {
+            self.enqueue_with(objs, ffi::_rte_ring_enqueue_burst_elem)
+        }
+    }
+
+    /// Dequeue exactly `objs.len()` objects from the ring, or none of them, into empty slots.
+    ///
+    /// This function uses the consumer sync mode that was specified at ring creation time,
+    /// or the multi-consumers mode instead of `SingleThread`.
+    #[inline]
+    pub fn dequeue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        if self.sc {
+            self.dequeue_with(objs, ffi::_rte_ring_mc_dequeue_bulk_elem)
+        } else {
+            self.dequeue_with(objs, ffi::_rte_ring_dequeue_bulk_elem)
+        }
+    }
+
+    /// Dequeue up to `objs.len()` objects from the ring into empty slots.
+    ///
+    /// This function uses the consumer sync mode that was specified at ring creation time,
+    /// or the multi-consumers mode instead of `SingleThread`.
+    #[inline]
+    pub fn dequeue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        if self.sc {
+            self.dequeue_with(objs, ffi::_rte_ring_mc_dequeue_burst_elem)
+        } else {
+            self.dequeue_with(objs, ffi::_rte_ring_dequeue_burst_elem)
+        }
+    }
+
+    /// Enqueue all the objects on the ring, or none of them (multi-producers safe).
+    ///
+    /// # Safety
+    ///
+    /// The producers of the ring must use the `MultiThread` or `SingleThread` sync mode.
+    #[inline]
+    pub unsafe fn mp_enqueue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        self.enqueue_with(objs, ffi::_rte_ring_mp_enqueue_bulk_elem)
+    }
+
+    /// Enqueue as many objects as possible on the ring (multi-producers safe).
+    ///
+    /// # Safety
+    ///
+    /// The producers of the ring must use the `MultiThread` or `SingleThread` sync mode.
+    #[inline]
+    pub unsafe fn mp_enqueue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        self.enqueue_with(objs, ffi::_rte_ring_mp_enqueue_burst_elem)
+    }
+
+    /// Enqueue all the objects on the ring, or none of them (NOT multi-producers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may enqueue on the ring at the same time.
+    #[inline]
+    pub unsafe fn sp_enqueue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        self.enqueue_with(objs, ffi::_rte_ring_sp_enqueue_bulk_elem)
+    }
+
+    /// Enqueue as many objects as possible on the ring (NOT multi-producers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may enqueue on the ring at the same time.
+    #[inline]
+    pub unsafe fn sp_enqueue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        self.enqueue_with(objs, ffi::_rte_ring_sp_enqueue_burst_elem)
+    }
+
+    /// Dequeue exactly `objs.len()` objects from the ring, or none of them (multi-consumers safe).
+    ///
+    /// # Safety
+    ///
+    /// The consumers of the ring must use the `MultiThread` or `SingleThread` sync mode.
+    #[inline]
+    pub unsafe fn mc_dequeue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        self.dequeue_with(objs, ffi::_rte_ring_mc_dequeue_bulk_elem)
+    }
+
+    /// Dequeue up to `objs.len()` objects from the ring (multi-consumers safe).
+    ///
+    /// # Safety
+    ///
+    /// The consumers of the ring must use the `MultiThread` or `SingleThread` sync mode.
+    #[inline]
+    pub unsafe fn mc_dequeue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        self.dequeue_with(objs, ffi::_rte_ring_mc_dequeue_burst_elem)
+    }
+
+    /// Dequeue exactly `objs.len()` objects from the ring, or none of them (NOT multi-consumers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may dequeue from the ring at the same time.
+    #[inline]
+    pub unsafe fn sc_dequeue_bulk(&self, objs: &mut [Option<T>]) -> usize {
+        self.dequeue_with(objs, ffi::_rte_ring_sc_dequeue_bulk_elem)
+    }
+
+    /// Dequeue up to `objs.len()` objects from the ring (NOT multi-consumers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may dequeue from the ring at the same time.
+    #[inline]
+    pub unsafe fn sc_dequeue_burst(&self, objs: &mut [Option<T>]) -> usize {
+        self.dequeue_with(objs, ffi::_rte_ring_sc_dequeue_burst_elem)
+    }
+
+    /// Reserve up to `n` entries of the ring storage, to be filled in place.
+    ///
+    /// The pushed objects are published when the returned guard is dropped.
+    /// Only available when the producers use the `HeadTail` sync mode.
+    pub fn enqueue_zc<'a>(&'a self, n: usize) -> Result<ZcEnqueue<'a, T>> {
+        if self.prod_sync_mode() != SyncMode::HeadTail {
+            return Err(anyhow!(OsError(libc::ENOTSUP)));
+        }
+
+        unsafe { self.enqueue_zc_start(n) }
+    }
+
+    /// Reserve up to `n` entries of the ring storage, to be filled in place (NOT multi-producers safe).
+    ///
+    /// Only available when the producers use the `SingleThread` sync mode.
+    ///
+    /// # Safety
+    ///
+    /// No other thread may enqueue on the ring until the returned guard is dropped.
+    pub unsafe fn sp_enqueue_zc<'a>(&'a self, n: usize) -> Result<ZcEnqueue<'a, T>> {
+        if !self.sp {
+            return Err(anyhow!(OsError(libc::ENOTSUP)));
+        }
+
+        self.enqueue_zc_start(n)
+    }
+
+    unsafe fn enqueue_zc_start<'a>(&'a self, n: usize) -> Result<ZcEnqueue<'a, T>> {
+        let mut zcd = ffi::rte_ring_zc_data::default();
+
+        let reserved = ffi::_rte_ring_enqueue_zc_burst_elem_start(
+            self.as_raw_mut(),
+            Self::ESIZE,
+            n as c_uint,
+            &mut zcd,
+            ptr::null_mut(),
+        ) as usize;
+
+        Ok(ZcEnqueue {
+            ring: self,
+            zcd,
+            reserved,
+            len: 0,
+        })
+    }
+
+    /// Peek at up to `n` objects in the ring storage, without copying them out.
+    ///
+    /// Only the objects popped from the returned guard are removed from the ring,
+    /// the others stay at the head of the ring.
+    /// Only available when the consumers use the `HeadTail` sync mode.
+    pub fn dequeue_zc<'a>(&'a self, n: usize) -> Result<ZcDequeue<'a, T>> {
+        if self.cons_sync_mode() != SyncMode::HeadTail {
+            return Err(anyhow!(OsError(libc::ENOTSUP)));
+        }
+
+        unsafe { self.dequeue_zc_start(n) }
+    }
+
+    /// Peek at up to `n` objects in the ring storage, without copying them out (NOT multi-consumers safe).
+    ///
+    /// Only available when the consumers use the `SingleThread` sync mode.
+    ///
+    /// # Safety
+    ///
+    /// No other thread may dequeue from the ring until the returned guard is dropped.
+    pub unsafe fn sc_dequeue_zc<'a>(&'a self, n: usize) -> Result<ZcDequeue<'a, T>> {
+        if !self.sc {
+            return Err(anyhow!(OsError(libc::ENOTSUP)));
+        }
+
+        self.dequeue_zc_start(n)
+    }
+
+    unsafe fn dequeue_zc_start<'a>(&'a self, n: usize) -> Result<ZcDequeue<'a, T>> {
+        let mut zcd = ffi::rte_ring_zc_data::default();
+
+        let avail = ffi::_rte_ring_dequeue_zc_burst_elem_start(
+            self.as_raw_mut(),
+            Self::ESIZE,
+            n as c_uint,
+            &mut zcd,
+            ptr::null_mut(),
+        ) as usize;
+
+        Ok(ZcDequeue {
+            ring: self,
+            zcd,
+            avail,
+            consumed: 0,
+        })
+    }
+}
+
+impl Ring<MBuf> {
+    #[inline(always)]
+    fn enqueue_mbufs_with<const N: usize>(&self, pkts: &mut MbufBurst<N>, f: EnqueueFn) -> usize {
+        let n = unsafe {
+            f(
+                self.as_raw_mut(),
+                pkts.as_ptr() as *const c_void,
+                Self::ESIZE,
+                pkts.len() as c_uint,
+                ptr::null_mut(),
+            )
+        } as usize;
+
+        // the ring owns the enqueued packets now
+        unsafe { pkts.forget_front(n) };
+
+        n
+    }
+
+    #[inline(always)]
+    fn dequeue_mbufs_with<const N: usize>(&self, pkts: &mut MbufBurst<N>, f: DequeueFn) -> usize {
+        let len = pkts.len();
+
+        unsafe {
+            let n = f(
+                self.as_raw_mut(),
+                pkts.as_mut_ptr().add(len) as *mut c_void,
+                Self::ESIZE,
+                (N - len) as c_uint,
+                ptr::null_mut(),
+            ) as usize;
+
+            pkts.set_len(len + n);
+
+            n
+        }
+    }
+
+    /// Enqueue as many packets as possible from the front of the burst,
+    /// the packets which don't fit stay in the burst, as for `EthDevice::tx_burst`.
+    ///
+    /// This function uses the producer sync mode that was specified at ring creation time,
+    /// or the multi-producers mode instead of `SingleThread`.
+    #[inline]
+    pub fn enqueue_mbufs<const N: usize>(&self, pkts: &mut MbufBurst<N>) -> usize {
+        if self.sp {
+            self.enqueue_mbufs_with(pkts, ffi::_rte_ring_mp_enqueue_burst_elem)
+        } else {
+            self.enqueue_mbufs_with(pkts, ffi::_rte_ring_enqueue_burst_elem)
+        }
+    }
+
+    /// Enqueue as many packets as possible from the front of the burst (NOT multi-producers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may enqueue on the ring at the same time.
+    #[inline]
+    pub unsafe fn sp_enqueue_mbufs<const N: usize>(&self, pkts: &mut MbufBurst<N>) -> usize {
+        self.enqueue_mbufs_with(pkts, ffi::_rte_ring_sp_enqueue_burst_elem)
+    }
+
+    /// Dequeue packets at the back of the burst, up to its remaining capacity, as for `EthDevice::rx_burst`.
+    ///
+    /// This function uses the consumer sync mode that was specified at ring creation time,
+    /// or the multi-consumers mode instead of `SingleThread`.
+    #[inline]
+    pub fn dequeue_mbufs<const N: usize>(&self, pkts: &mut MbufBurst<N>) -> usize {
+        if self.sc {
+            self.dequeue_mbufs_with(pkts, ffi::_rte_ring_mc_dequeue_burst_elem)
+        } else {
+            self.dequeue_mbufs_with(pkts, ffi::_rte_ring_dequeue_burst_elem)
+        }
+    }
+
+    /// Dequeue packets at the back of the burst, up to its remaining capacity (NOT multi-consumers safe).
+    ///
+    /// # Safety
+    ///
+    /// No other thread may dequeue from the ring at the same time.
+    #[inline]
+    pub unsafe fn sc_dequeue_mbufs<const N: usize>(&self, pkts: &mut MbufBurst<N>) -> usize {
+        self.dequeue_mbufs_with(pkts, ffi::_rte_ring_sc_dequeue_burst_elem)
+    }
+}
+
+/// Locate an entry of a zero-copy reservation, which may wrap around the end of the ring storage.
+#[inline(always)]
+fn zc_slot<T>(zcd: &ffi::rte_ring_zc_data, idx: usize) -> *mut T {
+    let n1 = zcd.n1 as usize;
+
+    unsafe {
+        if idx < n1 {
+            (zcd.ptr1 as *mut T).add(idx)
+        } else {
+            (zcd.ptr2 as *mut T).add(idx - n1)
+        }
+    }
+}
+
+/// Entries reserved in the ring storage by `Ring::enqueue_zc`.
+pub struct ZcEnqueue<'a, T: 'a> {
+    ring: &'a Ring<T>,
+    zcd: ffi::rte_ring_zc_data,
+    reserved: usize,
+    len: usize,
+}
+
+impl<'a, T> ZcEnqueue<'a, T> {
+    /// The number of reserved entries.
+    pub fn capacity(&self) -> usize {
+        self.reserved
+    }
+
+    /// The number of objects written so far.
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Test if no object has been written yet.
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Write an object in the next reserved entry, giving it back if all the entries are used.
+    #[inline]
+    pub fn push(&mut self, obj: T) -> result::Result<(), T> {
+        if self.len == self.reserved {
+            Err(obj)
+        } else {
+            unsafe { ptr::write(zc_slot(&self.zcd, self.len), obj) };
+
+            self.len += 1;
+
+            Ok(())
+        }
+    }
+
+    /// Publish the written objects to the consumers.
+    pub fn finish(self) {}
+}
+
+impl<'a, T> Drop for ZcEnqueue<'a, T> {
+    fn drop(&mut self) {
+        unsafe { ffi::_rte_ring_enqueue_zc_finish(self.ring.as_raw_mut(), self.len as c_uint) }
+    }
+}
+
+/// Objects peeked in the ring storage by `Ring::dequeue_zc`.
+pub struct ZcDequeue<'a, T: 'a> {
+    ring: &'a Ring<T>,
+    zcd: ffi::rte_ring_zc_data,
+    avail: usize,
+    consumed: usize,
+}
+
+impl<'a, T> ZcDequeue<'a, T> {
+    /// The number of objects not popped yet.
+    pub fn len(&self) -> usize {
+        self.avail - self.consumed
+    }
+
+    /// Test if all the objects have been popped.
+    pub fn is_empty(&self) -> bool {
+        self.avail == self.consumed
+    }
+
+    /// The objects not popped yet, in one or two parts when they wrap around the end of the ring storage.
+    pub fn as_slices(&self) -> (&[T], &[T]) {
+        let n1 = self.zcd.n1 as usize;
+        let (from, to) = (self.consumed, self.avail);
+
+        unsafe {
+            if from == to {
+                (&[], &[])
+            } else if to <= n1 {
+                (slice::from_raw_parts(zc_slot(&self.zcd, from), to - from), &[])
+            } else if from >= n1 {
+                (slice::from_raw_parts(zc_slot(&self.zcd, from), to - from), &[])
+            } else {
+                (
+                    slice::from_raw_parts(zc_slot(&self.zcd, from), n1 - from),
+                    slice::from_raw_parts(self.zcd.ptr2 as *const T, to - n1),
+                )
+            }
+        }
+    }
+
+    /// Move the next object out of the ring.
+    #[inline]
+    pub fn pop(&mut self) -> Option<T> {
+        if self.consumed == self.avail {
+            None
+        } else {
+            let obj = unsafe { ptr::read(zc_slot(&self.zcd, self.consumed)) };
+
+            self.consumed += 1;
+
+            Some(obj)
+        }
+    }
+
+    /// Remove the popped objects from the ring, the others stay in it.
+    pub fn finish(self) {}
+}
+
+impl<'a, T> Iterator for ZcDequeue<'a, T> {
+    type Item = T;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.pop()
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.len(), Some(self.len()))
+    }
+}
+
+impl<'a, T> Drop for ZcDequeue<'a, T> {
+    fn drop(&mut self) {
+        unsafe { ffi::_rte_ring_dequeue_zc_finish(self.ring.as_raw_mut(), self.consumed as c_uint) }
+    }
+}
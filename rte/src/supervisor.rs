@@ -0,0 +1,633 @@
+//!
+//! A supervisor of the lcores polling the RX queues, which fails over the queues of a stalled lcore
+//! and rebalances the queues by their measured busy cycles.
+//!
+//! The lcores poll the queues they own in a shared `QueueTable`, and mark themselves alive in a `Keepalive`
+//! on each iteration of their loop. The supervisor, ticked from a control thread, dispatches the pings.
+//! When an lcore misses the pings of two periods, its queues are handed over to the healthy lcores
+//! with the least load, and it gets queues back from the rebalancing once it is alive again.
+//!
+//! ```ignore
+//! let mut queues = LcoreQueues::new(&table, lcore_id);
+//!
+//! while running() {
+//!     supervisor.mark_alive();
+//!     queues.refresh(&table);
+//!
+//!     for q in queues.iter(&table) {
+//!         let start = rdtsc();
+//!         let n = q.port_id.rx_burst(q.queue_id, &mut pkts);
+//!
+//!         if n > 0 {
+//!             process(&mut pkts);
+//!             q.record(n, rdtsc() - start);
+//!         }
+//!     }
+//! }
+//! ```
+use std::cmp;
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use anyhow::Result;
+
+use ethdev::{EthDevice, PortId, QueueId};
+use keepalive::{Keepalive, State};
+use launch::{self, CtrlThread};
+use lcore;
+use placement::Placement;
+use rdtsc;
+use utils::add_counter;
+
+/// The owner of a queue changing hands.
+const NO_OWNER: u32 = lcore::LCORE_ID_ANY;
+
+/// How long a healthy lcore has to acknowledge the release of a queue.
+const RELEASE_TIMEOUT: Duration = Duration::from_millis(100);
+
+/// A RX queue and the lcore polling it.
+#[derive(Debug)]
+pub struct Queue {
+    pub port_id: PortId,
+    pub queue_id: QueueId,
+    owner: AtomicU32,
+    busy_cycles: AtomicU64,
+    packets: AtomicU64,
+}
+
+impl Queue {
+    /// The lcore polling the queue, `LCORE_ID_ANY` while it changes hands.
+    pub fn owner(&self) -> lcore::Id {
+        lcore::id(self.owner.load(Ordering::Acquire))
+    }
+
+    /// Account a burst received from the queue and the cycles spent on it, from its owner.
+    #[inline]
+    pub fn record(&self, packets: usize, cycles: u64) {
+        add_counter(&self.packets, packets as u64);
+        add_counter(&self.busy_cycles, cycles);
+    }
+
+    /// The packets received from the queue.
+    pub fn packets(&self) -> u64 {
+        self.packets.load(Ordering::Relaxed)
+    }
+
+    /// The cycles spent on the bursts of the queue.
+    pub fn busy_cycles(&self) -> u64 {
+        self.busy_cycles.load(Ordering::Relaxed)
+    }
+}
+
+/// The ownership of the RX queues, shared by the lcores and the supervisor.
+#[derive(Debug)]
+pub struct QueueTable {
+    queues: Vec<Queue>,
+    lcores: Vec<lcore::Id>,
+    stalled: Vec<AtomicBool>,
+    /// The last version seen by each lcore.
+    seen: Vec<AtomicU64>,
+    /// Bumped each time a queue changes hands.
+    version: AtomicU64,
+}
+
+impl QueueTable {
+    /// A table of the queues polled by `lcores`, each queue with its initial owner.
+    pub fn new<I>(lcores: Vec<lcore::Id>, queues: I) -> Self
+    where
+        I: IntoIterator<Item = (PortId, QueueId, lcore::Id)>,
+    {
+        QueueTable {
+            queues: queues
+                .into_iter()
+                .map(|(port_id, queue_id, lcore_id)| Queue {
+                    port_id,
+                    queue_id,
+                    owner: AtomicU32::new(*lcore_id),
+                    busy_cycles: AtomicU64::new(0),
+                    packets: AtomicU64::new(0),
+                })
+                .collect(),
+            stalled: lcores.iter().map(|_| AtomicBool::new(false)).collect(),
+            seen: lcores.iter().map(|_| AtomicU64::new(0)).collect(),
+            lcores,
+            version: AtomicU64::new(1),
+        }
+    }
+
+    /// A table of the queues placed on the lcores.
+    pub fn from_placement(placement: &Placement) -> Self {
+        Self::new(
+            placement.lcores(),
+            placement
+                .assignments
+                .iter()
+                .map(|a| (a.port_id, a.queue_id, a.lcore_id)),
+        )
+    }
+
+    pub fn queues(&self) -> &[Queue] {
+        &self.queues
+    }
+
+    /// The lcores which may poll the queues.
+    pub fn lcores(&self) -> &[lcore::Id] {
+        &self.lcores
+    }
+
+    /// The version of the ownership, bumped each time a queue changes hands.
+    #[inline]
+    pub fn version(&self) -> u64 {
+        self.version.load(Ordering::Acquire)
+    }
+
+    /// Whether an lcore missed its heartbeats.
+    pub fn is_stalled(&self, lcore_id: lcore::Id) -> bool {
+        self.index(lcore_id)
+            .map_or(false, |idx| self.stalled[idx].load(Ordering::Relaxed))
+    }
+
+    /// The queues owned by an lcore.
+    pub fn owned_by(&self, lcore_id: lcore::Id) -> impl Iterator<Item = &Queue> {
+        self.queues
+            .iter()
+            .filter(move |q| q.owner.load(Ordering::Acquire) == *lcore_id)
+    }
+
+    /// Hand over a queue to an lcore.
+    pub fn assign(&self, idx: usize, lcore_id: lcore::Id) {
+        self.queues[idx].owner.store(*lcore_id, Ordering::Release);
+        self.version.fetch_add(1, Ordering::AcqRel);
+    }
+
+    /// Take a queue from its owner, return the version it has to see.
+    fn release(&self, idx: usize) -> u64 {
+        self.queues[idx].owner.store(NO_OWNER, Ordering::Release);
+        self.version.fetch_add(1, Ordering::AcqRel) + 1
+    }
+
+    /// Mark an lcore stalled or alive, return whether it changed.
+    fn set_stalled(&self, lcore_id: lcore::Id, stalled: bool) -> bool {
+        self.index(lcore_id).map_or(false, |idx| {
+            self.stalled[idx].swap(stalled, Ordering::Relaxed) != stalled
+        })
+    }
+
+    fn index(&self, lcore_id: lcore::Id) -> Option<usize> {
+        self.lcores.iter().position(|&id| id == lcore_id)
+    }
+
+    /// The index of the owner of each queue, `lcores.len()` for a queue without owner.
+    fn owners(&self) -> Vec<usize> {
+        self.queues
+            .iter()
+            .map(|q| self.index(q.owner()).unwrap_or(self.lcores.len()))
+            .collect()
+    }
+
+    /// The lcores not stalled, and a last `false` for the queues without owner.
+    fn healthy(&self) -> Vec<bool> {
+        self.stalled
+            .iter()
+            .map(|stalled| !stalled.load(Ordering::Relaxed))
+            .chain(Some(false))
+            .collect()
+    }
+}
+
+/// The queues of an lcore, cached by its poll loop and reloaded when the table changes.
+#[derive(Debug)]
+pub struct LcoreQueues {
+    lcore_id: lcore::Id,
+    slot: usize,
+    version: u64,
+    queues: Vec<usize>,
+}
+
+impl LcoreQueues {
+    pub fn new(table: &QueueTable, lcore_id: lcore::Id) -> Self {
+        LcoreQueues {
+            lcore_id,
+            slot: table.index(lcore_id).expect("lcore not in the queue table"),
+            version: 0,
+            queues: vec![],
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.queues.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.queues.is_empty()
+    }
+
+    /// Reload the queues owned by the lcore if the table changed, return whether it did.
+    ///
+    /// To be called on each iteration, it acknowledges the queues taken from the lcore.
+    #[inline]
+    pub fn refresh(&mut self, table: &QueueTable) -> bool {
+        let version = table.version();
+
+        if version == self.version {
+            return false;
+        }
+
+        let lcore_id = *self.lcore_id;
+
+        self.version = version;
+        self.queues.clear();
+        self.queues.extend(
+            table
+                .queues
+                .iter()
+                .enumerate()
+                .filter(|(_, q)| q.owner.load(Ordering::Acquire) == lcore_id)
+                .map(|(idx, _)| idx),
+        );
+
+        table.seen[self.slot].store(version, Ordering::Release);
+
+        true
+    }
+
+    /// The queues to poll, the owner of each one is checked again, so a queue taken since the last refresh is skipped.
+    #[inline]
+    pub fn iter<'a>(&'a self, table: &'a QueueTable) -> impl Iterator<Item = &'a Queue> + 'a {
+        let lcore_id = *self.lcore_id;
+
+        self.queues
+            .iter()
+            .map(move |&idx| &table.queues[idx])
+            .filter(move |q| q.owner.load(Ordering::Acquire) == lcore_id)
+    }
+}
+
+/// The load measured between two checks.
+#[derive(Debug, Default)]
+struct Sample {
+    tsc: u64,
+    elapsed: u64,
+    busy_cycles: Vec<u64>,
+    /// The busy cycles of each queue.
+    queue_loads: Vec<u64>,
+    /// The busy fraction of the cycles of each lcore.
+    lcore_loads: Vec<f64>,
+}
+
+/// Watch the heartbeats of the lcores and move their queues.
+pub struct Supervisor {
+    table: Arc<QueueTable>,
+    keepalive: Keepalive,
+    sample: Mutex<Sample>,
+    quit: AtomicBool,
+}
+
+impl Supervisor {
+    /// Supervise the lcores of a queue table.
+    pub fn new(table: Arc<QueueTable>) -> Result<Self> {
+        let keepalive = Keepalive::new(on_failure, Some(table.clone()))?;
+
+        keepalive.register_relay_callback(on_relay, Some(table.clone()));
+
+        for &lcore_id in table.lcores() {
+            keepalive.register_core(lcore_id);
+        }
+
+        let sample = Sample {
+            tsc: rdtsc(),
+            busy_cycles: table.queues().iter().map(Queue::busy_cycles).collect(),
+            queue_loads: vec![0; table.queues().len()],
+            lcore_loads: vec![0.0; table.lcores().len()],
+            ..Sample::default()
+        };
+
+        Ok(Supervisor {
+            table,
+            keepalive,
+            sample: Mutex::new(sample),
+            quit: AtomicBool::new(false),
+        })
+    }
+
+    pub fn table(&self) -> &Arc<QueueTable> {
+        &self.table
+    }
+
+    /// Report the heartbeat of the calling lcore, from its poll loop.
+    #[inline]
+    pub fn mark_alive(&self) {
+        self.keepalive.mark_alive()
+    }
+
+    /// Report that the calling lcore goes idle, so it is not taken for stalled.
+    #[inline]
+    pub fn mark_sleep(&self) {
+        self.keepalive.mark_sleep()
+    }
+
+    /// Dispatch the pings, measure the load and fail over the queues of the stalled lcores,
+    /// return the number of queues moved.
+    pub fn check(&self) -> usize {
+        let mut sample = self.sample.lock().unwrap();
+
+        // the failures are handled before the queues of the stalled lcores are measured
+        self.keepalive.dispatch_pings();
+
+        self.measure(&mut sample);
+
+        let moves = plan_failover(&self.table.owners(), &sample.queue_loads, &self.table.healthy());
+
+        for &(idx, lcore_idx) in &moves {
+            self.move_queue(idx, self.table.lcores[lcore_idx]);
+        }
+
+        moves.len()
+    }
+
+    /// Move a queue from the busiest lcore to the least loaded one,
+    /// when their busy fractions differ by more than `threshold`, return whether a queue moved.
+    pub fn rebalance(&self, threshold: f64) -> bool {
+        let sample = self.sample.lock().unwrap();
+        let min_gap = (threshold * sample.elapsed as f64) as u64;
+
+        match plan_rebalance(
+            &self.table.owners(),
+            &sample.queue_loads,
+            &self.table.healthy(),
+            min_gap,
+        ) {
+            Some((idx, lcore_idx)) => {
+                self.move_queue(idx, self.table.lcores[lcore_idx]);
+
+                true
+            }
+            None => false,
+        }
+    }
+
+    /// The busy fraction of the cycles of each lcore, measured by the last check.
+    pub fn loads(&self) -> Vec<(lcore::Id, f64)> {
+        let sample = self.sample.lock().unwrap();
+
+        self.table
+            .lcores()
+            .iter()
+            .cloned()
+            .zip(sample.lcore_loads.iter().cloned())
+            .collect()
+    }
+
+    /// The busy fraction of the cycles of an lcore, measured by the last check.
+    pub fn load(&self, lcore_id: lcore::Id) -> Option<f64> {
+        self.loads()
+            .into_iter()
+            .find(|&(id, _)| id == lcore_id)
+            .map(|(_, load)| load)
+    }
+
+    /// Check the lcores every `period` on a control thread, and rebalance the queues
+    /// with the `threshold` if any, until `stop` is called.
+    ///
+    /// An lcore is taken for stalled after missing the pings of two periods.
+    pub fn spawn(self: Arc<Self>, period: Duration, threshold: Option<f64>) -> Result<CtrlThread> {
+        launch::ctrl_thread("supervisor", move || {
+            while !self.quit.load(Ordering::Relaxed) {
+                thread::sleep(period);
+
+                self.check();
+
+                if let Some(threshold) = threshold {
+                    self.rebalance(threshold);
+                }
+            }
+        })
+    }
+
+    /// Stop the control thread.
+    pub fn stop(&self) {
+        self.quit.store(true, Ordering::Relaxed)
+    }
+
+    fn measure(&self, sample: &mut Sample) {
+        let now = rdtsc();
+
+        sample.elapsed = now - sample.tsc;
+        sample.tsc = now;
+
+        for (idx, q) in self.table.queues().iter().enumerate() {
+            let busy_cycles = q.busy_cycles();
+
+            sample.queue_loads[idx] = busy_cycles.saturating_sub(sample.busy_cycles[idx]);
+            sample.busy_cycles[idx] = busy_cycles;
+        }
+
+        let owners = self.table.owners();
+
+        for (lcore_idx, load) in sample.lcore_loads.iter_mut().enumerate() {
+            let busy_cycles: u64 = owners
+                .iter()
+                .zip(&sample.queue_loads)
+                .filter(|&(&owner, _)| owner == lcore_idx)
+                .map(|(_, &load)| load)
+                .sum();
+
+            *load = if sample.elapsed == 0 {
+                0.0
+            } else {
+                busy_cycles as f64 / sample.elapsed as f64
+            };
+        }
+    }
+
+    /// Hand over a queue to an lcore.
+    ///
+    /// A healthy owner acknowledges the release before the queue is assigned, so no burst straddles the two owners.
+    /// The queue is stopped while it changes hands, on the devices supporting it.
+    fn move_queue(&self, idx: usize, lcore_id: lcore::Id) {
+        let q = &self.table.queues[idx];
+        let from = q.owner();
+        let version = self.table.release(idx);
+
+        if let Some(slot) = self.table.index(from) {
+            let started = Instant::now();
+
+            while self.table.seen[slot].load(Ordering::Acquire) < version
+                && !self.table.stalled[slot].load(Ordering::Relaxed)
+                && started.elapsed() < RELEASE_TIMEOUT
+            {
+                thread::yield_now();
+            }
+        }
+
+        if let Err(err) = q.port_id.rx_queue_stop(q.queue_id) {
+            debug!("fail to stop port {} queue {}, {}", q.port_id, q.queue_id, err);
+        }
+
+        self.table.assign(idx, lcore_id);
+
+        if let Err(err) = q.port_id.rx_queue_start(q.queue_id) {
+            debug!("fail to start port {} queue {}, {}", q.port_id, q.queue_id, err);
+        }
+
+        info!(
+            "port {} queue {} moved from lcore {} to lcore {}",
+            q.port_id, q.queue_id, from, lcore_id
+        );
+    }
+}
+
+fn on_failure(table: Option<Arc<QueueTable>>, lcore_id: lcore::Id) {
+    if let Some(table) = table {
+        if table.set_stalled(lcore_id, true) {
+            warn!("lcore {} missed its heartbeats", lcore_id);
+        }
+    }
+}
+
+// The pings turn an alive lcore into a missing one, so both mean it marked itself alive since the last dispatch.
+fn on_relay(table: Option<Arc<QueueTable>>, lcore_id: lcore::Id, state: State, _last_seen: u64) {
+    if let Some(table) = table {
+        if (state == State::Alive || state == State::Missing) && table.set_stalled(lcore_id, false) {
+            info!("lcore {} is alive again", lcore_id);
+        }
+    }
+}
+
+/// The busy cycles of the queues of each lcore, and their number.
+fn totals(owners: &[usize], loads: &[u64], nb_lcores: usize) -> Vec<(u64, usize)> {
+    let mut totals = vec![(0, 0); nb_lcores];
+
+    for (&owner, &load) in owners.iter().zip(loads) {
+        if let Some(total) = totals.get_mut(owner) {
+            total.0 += load;
+            total.1 += 1;
+        }
+    }
+
+    totals
+}
+
+/// Hand the queues of the lcores which are not healthy over to the healthy lcores with the least load,
+/// the busiest queues first, return the queues and their new lcore.
+fn plan_failover(owners: &[usize], loads: &[u64], healthy: &[bool]) -> Vec<(usize, usize)> {
+    let mut totals = totals(owners, loads, healthy.len());
+    let mut orphans = (0..owners.len())
+        .filter(|&idx| !healthy.get(owners[idx]).cloned().unwrap_or(false))
+        .collect::<Vec<_>>();
+
+    orphans.sort_by_key(|&idx| cmp::Reverse(loads[idx]));
+
+    orphans
+        .into_iter()
+        .filter_map(|idx| {
+            let lcore_idx = (0..healthy.len()).filter(|&i| healthy[i]).min_by_key(|&i| totals[i])?;
+
+            totals[lcore_idx].0 += loads[idx];
+            totals[lcore_idx].1 += 1;
+
+            Some((idx, lcore_idx))
+        })
+        .collect()
+}
+
+/// Find the queue of the busiest healthy lcore which, moved to the least loaded one,
+/// narrows their gap the most, when the gap is larger than `min_gap`.
+fn plan_rebalance(owners: &[usize], loads: &[u64], healthy: &[bool], min_gap: u64) -> Option<(usize, usize)> {
+    let totals = totals(owners, loads, healthy.len());
+    let lcores = (0..healthy.len()).filter(|&i| healthy[i]);
+    let busiest = lcores.clone().max_by_key(|&i| totals[i].0)?;
+    let idlest = lcores.min_by_key(|&i| totals[i])?;
+    let gap = totals[busiest].0 - totals[idlest].0;
+
+    if busiest == idlest || gap <= min_gap {
+        return None;
+    }
+
+    (0..owners.len())
+        .filter(|&idx| owners[idx] == busiest && 0 < loads[idx] && loads[idx] < gap)
+        .min_by_key(|&idx| (gap / 2).max(loads[idx]) - (gap / 2).min(loads[idx]))
+        .map(|idx| (idx, idlest))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_failover() {
+        // lcore 1 stalled with 3 queues, lcore 0 already busy
+        let owners = [0, 1, 1, 1];
+        let loads = [500, 300, 100, 200];
+
+        let moves = plan_failover(&owners, &loads, &[true, false, true]);
+
+        assert_eq!(moves, vec![(1, 2), (3, 2), (2, 0)]);
+
+        // nobody to take them
+        assert!(plan_failover(&owners, &loads, &[false, false]).is_empty());
+
+        // without any load the queues are spread by count
+        let moves = plan_failover(&[2, 2, 2, 2], &[0; 4], &[true, true, false]);
+
+        assert_eq!(moves.iter().filter(|&&(_, lcore)| lcore == 0).count(), 2);
+        assert_eq!(moves.iter().filter(|&&(_, lcore)| lcore == 1).count(), 2);
+    }
+
+    #[test]
+    fn test_rebalance() {
+        let owners = [0, 0, 0, 1];
+        let loads = [400, 250, 100, 50];
+
+        // gap of 700, the queue closest to 350 narrows it the most
+        assert_eq!(plan_rebalance(&owners, &loads, &[true, true], 100), Some((0, 1)));
+        assert_eq!(plan_rebalance(&owners, &loads, &[true, true], 700), None);
+
+        // a single queue heavier than the gap stays
+        assert_eq!(plan_rebalance(&[0, 1], &[500, 100], &[true, true], 0), None);
+
+        // the stalled lcores are out of the picture
+        assert_eq!(plan_rebalance(&owners, &loads, &[true, false], 0), None);
+    }
+
+    #[test]
+    fn test_queue_table() {
+        let lcores = vec![lcore::id(1), lcore::id(2)];
+        let table = QueueTable::new(
+            lcores,
+            vec![(0, 0, lcore::id(1)), (0, 1, lcore::id(2)), (1, 0, lcore::id(1))],
+        );
+        let mut lcore1 = LcoreQueues::new(&table, lcore::id(1));
+        let mut lcore2 = LcoreQueues::new(&table, lcore::id(2));
+
+        assert!(lcore1.refresh(&table));
+        assert!(!lcore1.refresh(&table));
+        assert!(lcore2.refresh(&table));
+        assert_eq!(lcore1.len(), 2);
+        assert_eq!(lcore2.len(), 1);
+
+        let version = table.release(2);
+
+        // skipped before the refresh
+        assert_eq!(lcore1.iter(&table).count(), 1);
+        assert!(table.seen[0].load(Ordering::Relaxed) < version);
+        assert!(lcore1.refresh(&table));
+        assert_eq!(table.seen[0].load(Ordering::Relaxed), version);
+
+        table.assign(2, lcore::id(2));
+
+        assert!(lcore2.refresh(&table));
+        assert_eq!(
+            lcore2.iter(&table).map(|q| (q.port_id, q.queue_id)).collect::<Vec<_>>(),
+            vec![(0, 1), (1, 0)]
+        );
+        assert_eq!(table.owners(), vec![0, 1, 1]);
+
+        assert!(table.set_stalled(lcore::id(2), true));
+        assert!(!table.set_stalled(lcore::id(2), true));
+        assert!(table.is_stalled(lcore::id(2)));
+        assert_eq!(table.healthy(), vec![true, false, false]);
+    }
+}
@@ -0,0 +1,9 @@
+use ffi;
+
+pub use ffi::{
+    RTE_TCP_ACK_FLAG, RTE_TCP_CWR_FLAG, RTE_TCP_ECE_FLAG, RTE_TCP_FIN_FLAG, RTE_TCP_PSH_FLAG, RTE_TCP_RST_FLAG,
+    RTE_TCP_SYN_FLAG, RTE_TCP_URG_FLAG,
+};
+
+/// TCP Header
+pub type TcpHdr = ffi::rte_tcp_hdr;
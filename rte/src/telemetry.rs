@@ -0,0 +1,545 @@
+//!
+//! Telemetry of the ports, mempools, rings and hugepage heaps, sampled off the datapath.
+//!
+//! A `Sampler` reads the extended statistics of the ports selected by ID, their per-queue counters,
+//! the depletion of the mempools, the fill level of the rings and the usage of the hugepage heaps.
+//! It runs on a control thread, out of the CPUs of the lcores, so monitoring never touches the worker lcores.
+//!
+//! Each sample is published to a `Board` under a sequence lock, the sampler never waits for the readers,
+//! which retry until they copy a consistent sample. The board may be served on a Unix socket,
+//! each connection receives the last sample as `name value` lines.
+//!
+//! ```no_run
+//! # use std::time::Duration;
+//! # use rte::telemetry::Sampler;
+//! # fn f(pool: &rte::mempool::MemoryPool) -> anyhow::Result<()> {
+//! let mut sampler = Sampler::new();
+//!
+//! sampler.xstats(0, &["rx_good_packets", "rx_missed_errors"])?.queues(0, 4, 4);
+//!
+//! // the pool outlives the telemetry
+//! unsafe { sampler.mempool(pool) };
+//!
+//! let mut telemetry = sampler.spawn(Duration::from_secs(1))?;
+//!
+//! telemetry.serve("/var/run/l3fwd.telemetry")?;
+//! # Ok(())
+//! # }
+//! ```
+//!
+use std::fs;
+use std::hint;
+use std::io::{self, Write};
+use std::os::unix::fs::FileTypeExt;
+use std::os::unix::net::{UnixListener, UnixStream};
+use std::path::{Path, PathBuf};
+use std::ptr::NonNull;
+use std::sync::atomic::{fence, AtomicBool, AtomicU64, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use anyhow::Result;
+
+use ffi;
+
+use ethdev::{EthDevice, PortId};
+use launch::{self, CtrlThread};
+use malloc;
+use memory::SocketId;
+use mempool::{MemoryPool, RawMemoryPool};
+use ring::{RawRing, Ring};
+use utils::AsRaw;
+
+/// The number of per-queue counters of `rte_eth_stats`.
+pub const QUEUE_STAT_CNTRS: usize = ffi::RTE_ETHDEV_QUEUE_STAT_CNTRS as usize;
+
+/// How often the server checks for new connections, and the telemetry for a stop.
+const POLL_INTERVAL: Duration = Duration::from_millis(100);
+
+enum Source {
+    /// The extended statistics of a port, selected by ID.
+    Xstats { port_id: PortId, ids: Vec<u64> },
+    /// The packets, bytes and errors of the queues of a port.
+    Queues { port_id: PortId, rx: usize, tx: usize },
+    /// The available and in use objects of a mempool.
+    Mempool(NonNull<RawMemoryPool>),
+    /// The used and free entries of a ring.
+    Ring(NonNull<RawRing>),
+    /// The allocated and free bytes of the hugepage heap of a socket.
+    Heap(SocketId),
+}
+
+/// Reads the selected counters, and publishes them to its board.
+pub struct Sampler {
+    sources: Vec<Source>,
+    names: Vec<String>,
+    values: Vec<u64>,
+    board: Option<Arc<Board>>,
+}
+
+unsafe impl Send for Sampler {}
+
+impl Default for Sampler {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Sampler {
+    /// Create a sampler without counter.
+    pub fn new() -> Self {
+        Sampler {
+            sources: vec![],
+            names: vec![],
+            values: vec![],
+            board: None,
+        }
+    }
+
+    fn add(&mut self, source: Source, names: Vec<String>) -> &mut Self {
+        assert!(self.board.is_none(), "the counters are sampled");
+
+        self.values.resize(self.values.len() + names.len(), 0);
+        self.names.extend(names);
+        self.sources.push(source);
+
+        self
+    }
+
+    /// Sample the extended statistics `names` of a port, or all of them if `names` is empty.
+    ///
+    /// They are read by ID, so only the selected counters are read from the device.
+    pub fn xstats<S: AsRef<str>>(&mut self, port_id: PortId, names: &[S]) -> Result<&mut Self> {
+        let (ids, names) = if names.is_empty() {
+            let names = port_id.xstat_names()?;
+
+            ((0..names.len() as u64).collect::<Vec<_>>(), names)
+        } else {
+            let ids = names
+                .iter()
+                .map(|name| port_id.xstat_id(name.as_ref()))
+                .collect::<Result<Vec<_>>>()?;
+
+            (ids, names.iter().map(|name| name.as_ref().to_owned()).collect())
+        };
+        let names = names
+            .into_iter()
+            .map(|name| format!("port.{}.{}", port_id, name))
+            .collect();
+
+        Ok(self.add(Source::Xstats { port_id, ids }, names))
+    }
+
+    /// Sample the packets, bytes and errors of the first `rx` RX and `tx` TX queues of a port.
+    ///
+    /// The device keeps at most `QUEUE_STAT_CNTRS` counters of each direction,
+    /// some devices need a queue stats mapping to fill them.
+    pub fn queues(&mut self, port_id: PortId, rx: usize, tx: usize) -> &mut Self {
+        let rx = rx.min(QUEUE_STAT_CNTRS);
+        let tx = tx.min(QUEUE_STAT_CNTRS);
+        let mut names = vec![];
+
+        for q in 0..rx {
+            names.push(format!("port.{}.rxq.{}.packets", port_id, q));
+            names.push(format!("port.{}.rxq.{}.bytes", port_id, q));
+            names.push(format!("port.{}.rxq.{}.errors", port_id, q));
+        }
+        for q in 0..tx {
+            names.push(format!("port.{}.txq.{}.packets", port_id, q));
+            names.push(format!("port.{}.txq.{}.bytes", port_id, q));
+        }
+
+        self.add(Source::Queues { port_id, rx, tx }, names)
+    }
+
+    /// Sample the available and in use objects of a mempool.
+    ///
+    /// # Safety
+    ///
+    /// The mempool is read from the sampler thread, it must not be freed
+    /// until the sampler, or the `Telemetry` it is spawned to, is dropped.
+    pub unsafe fn mempool(&mut self, pool: &MemoryPool) -> &mut Self {
+        let names = vec![
+            format!("mempool.{}.avail", pool.name()),
+            format!("mempool.{}.in_use", pool.name()),
+        ];
+
+        self.add(Source::Mempool(NonNull::new(pool.as_raw_mut()).unwrap()), names)
+    }
+
+    /// Sample the used and free entries of a ring.
+    ///
+    /// # Safety
+    ///
+    /// The ring is read from the sampler thread, it must not be freed
+    /// until the sampler, or the `Telemetry` it is spawned to, is dropped.
+    pub unsafe fn ring<T>(&mut self, ring: &Ring<T>) -> &mut Self {
+        let names = vec![
+            format!("ring.{}.count", ring.name()),
+            format!("ring.{}.free", ring.name()),
+        ];
+
+        self.add(Source::Ring(NonNull::new(ring.as_raw_mut()).unwrap()), names)
+    }
+
+    /// Sample the allocated and free bytes, and the allocated elements, of the hugepage heap of a socket.
+    pub fn heap(&mut self, socket_id: SocketId) -> &mut Self {
+        let names = vec![
+            format!("heap.{}.alloc_bytes", socket_id),
+            format!("heap.{}.free_bytes", socket_id),
+            format!("heap.{}.greatest_free", socket_id),
+            format!("heap.{}.alloc_count", socket_id),
+        ];
+
+        self.add(Source::Heap(socket_id), names)
+    }
+
+    /// The board the samples are published to, no counter could be added once it is taken.
+    pub fn board(&mut self) -> Arc<Board> {
+        let names = &self.names;
+
+        self.board
+            .get_or_insert_with(|| Arc::new(Board::new(names.clone())))
+            .clone()
+    }
+
+    /// Read all the counters, and publish them to the board.
+    ///
+    /// A port which fails to report its statistics keeps its previous values.
+    pub fn sample(&mut self) {
+        let board = self.board();
+        let mut values = &mut self.values[..];
+
+        for source in &self.sources {
+            let (head, tail) = values.split_at_mut(match *source {
+                Source::Xstats { ref ids, .. } => ids.len(),
+                Source::Queues { rx, tx, .. } => rx * 3 + tx * 2,
+                Source::Mempool(_) | Source::Ring(_) => 2,
+                Source::Heap(_) => 4,
+            });
+
+            match *source {
+                Source::Xstats { port_id, ref ids } => {
+                    if let Err(err) = port_id.xstats_by_id(ids, head) {
+                        debug!("fail to read the xstats of port {}, {}", port_id, err);
+                    }
+                }
+                Source::Queues { port_id, rx, tx } => match port_id.stats() {
+                    Ok(stats) => {
+                        for q in 0..rx {
+                            head[q * 3] = stats.q_ipackets[q];
+                            head[q * 3 + 1] = stats.q_ibytes[q];
+                            head[q * 3 + 2] = stats.q_errors[q];
+                        }
+                        for q in 0..tx {
+                            head[rx * 3 + q * 2] = stats.q_opackets[q];
+                            head[rx * 3 + q * 2 + 1] = stats.q_obytes[q];
+                        }
+                    }
+                    Err(err) => debug!("fail to read the stats of port {}, {}", port_id, err),
+                },
+                Source::Mempool(pool) => unsafe {
+                    head[0] = ffi::rte_mempool_avail_count(pool.as_ptr()) as u64;
+                    head[1] = ffi::rte_mempool_in_use_count(pool.as_ptr()) as u64;
+                },
+                Source::Ring(ring) => unsafe {
+                    head[0] = ffi::_rte_ring_count(ring.as_ptr()) as u64;
+                    head[1] = ffi::_rte_ring_free_count(ring.as_ptr()) as u64;
+                },
+                Source::Heap(socket_id) => match malloc::get_socket_stats(socket_id) {
+                    Some(stats) => {
+                        head[0] = stats.heap_allocsz_bytes as u64;
+                        head[1] = stats.heap_freesz_bytes as u64;
+                        head[2] = stats.greatest_free_size as u64;
+                        head[3] = stats.alloc_count as u64;
+                    }
+                    None => debug!("fail to read the stats of heap {}", socket_id),
+                },
+            }
+
+            values = tail;
+        }
+
+        board.publish(&self.values);
+    }
+
+    /// Sample the counters every `interval` on a control thread.
+    pub fn spawn(mut self, interval: Duration) -> Result<Telemetry> {
+        let board = self.board();
+        let quit = Arc::new(AtomicBool::new(false));
+        let sampler = {
+            let quit = quit.clone();
+
+            launch::ctrl_thread("telemetry", move || {
+                while !quit.load(Ordering::Relaxed) {
+                    self.sample();
+
+                    thread::sleep(interval);
+                }
+            })?
+        };
+
+        Ok(Telemetry {
+            board,
+            quit,
+            threads: vec![sampler],
+            sockets: vec![],
+        })
+    }
+}
+
+/// The last sample of the counters, published under a sequence lock.
+pub struct Board {
+    names: Vec<String>,
+    /// Odd while a sample is being published.
+    seq: AtomicU64,
+    /// The time of the sample, in nanoseconds since the epoch.
+    timestamp: AtomicU64,
+    values: Box<[AtomicU64]>,
+}
+
+/// A consistent copy of the counters.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct Sample {
+    /// The number of samples published before this one, zero before any sample.
+    pub seq: u64,
+    /// The time of the sample since the epoch.
+    pub timestamp: Duration,
+    /// The values of the counters, in the order of `Board::names`.
+    pub values: Vec<u64>,
+}
+
+impl Board {
+    fn new(names: Vec<String>) -> Self {
+        let values = names.iter().map(|_| AtomicU64::new(0)).collect();
+
+        Board {
+            names,
+            seq: AtomicU64::new(0),
+            timestamp: AtomicU64::new(0),
+            values,
+        }
+    }
+
+    /// Only the sampler publishes to its board.
+    fn publish(&self, values: &[u64]) {
+        let seq = self.seq.load(Ordering::Relaxed);
+        let timestamp = SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_or(0, |d| d.as_nanos() as u64);
+
+        self.seq.store(seq + 1, Ordering::Relaxed);
+        fence(Ordering::Release);
+
+        for (v, &value) in self.values.iter().zip(values) {
+            v.store(value, Ordering::Relaxed);
+        }
+        self.timestamp.store(timestamp, Ordering::Relaxed);
+
+        self.seq.store(seq + 2, Ordering::Release);
+    }
+
+    /// The names of the counters.
+    pub fn names(&self) -> &[String] {
+        &self.names
+    }
+
+    /// Copy the last sample, without blocking the sampler.
+    pub fn read(&self) -> Sample {
+        let mut values = vec![0; self.values.len()];
+
+        loop {
+            let seq = self.seq.load(Ordering::Acquire);
+
+            if seq & 1 == 0 {
+                for (value, v) in values.iter_mut().zip(self.values.iter()) {
+                    *value = v.load(Ordering::Relaxed);
+                }
+                let timestamp = self.timestamp.load(Ordering::Relaxed);
+
+                fence(Ordering::Acquire);
+
+                if self.seq.load(Ordering::Relaxed) == seq {
+                    return Sample {
+                        seq: seq / 2,
+                        timestamp: Duration::from_nanos(timestamp),
+                        values,
+                    };
+                }
+            }
+
+            hint::spin_loop();
+        }
+    }
+
+    /// The last sampled value of a counter.
+    pub fn get(&self, name: &str) -> Option<u64> {
+        let i = self.names.iter().position(|n| n == name)?;
+
+        Some(self.read().values[i])
+    }
+
+    /// Write the last sample as `name value` lines, after a `# seq timestamp` header.
+    pub fn dump<W: Write>(&self, w: &mut W) -> io::Result<()> {
+        let sample = self.read();
+
+        writeln!(w, "# {} {}", sample.seq, sample.timestamp.as_nanos())?;
+
+        for (name, value) in self.names.iter().zip(&sample.values) {
+            writeln!(w, "{} {}", name, value)?;
+        }
+
+        w.flush()
+    }
+}
+
+/// The counters sampled on a control thread, stopped on drop.
+pub struct Telemetry {
+    board: Arc<Board>,
+    quit: Arc<AtomicBool>,
+    threads: Vec<CtrlThread>,
+    sockets: Vec<PathBuf>,
+}
+
+impl Telemetry {
+    /// The board the samples are published to.
+    pub fn board(&self) -> &Arc<Board> {
+        &self.board
+    }
+
+    /// Serve the last sample on a Unix socket from another control thread,
+    /// each connection receives the sample then is closed.
+    ///
+    /// A socket left at `path` by a previous run is replaced, unless it is still served,
+    /// and the socket is removed when the telemetry is stopped.
+    pub fn serve<P: AsRef<Path>>(&mut self, path: P) -> Result<&mut Self> {
+        let path = path.as_ref();
+
+        remove_stale_socket(path)?;
+
+        let listener = UnixListener::bind(path)?;
+
+        self.sockets.push(path.to_owned());
+
+        listener.set_nonblocking(true)?;
+
+        let board = self.board.clone();
+        let quit = self.quit.clone();
+        let server = launch::ctrl_thread("telemetry-srv", move || {
+            while !quit.load(Ordering::Relaxed) {
+                match listener.accept() {
+                    Ok((mut stream, _)) => {
+                        if let Err(err) = stream.set_nonblocking(false).and_then(|_| board.dump(&mut stream)) {
+                            debug!("fail to send the telemetry, {}", err);
+                        }
+                    }
+                    Err(ref err) if err.kind() == io::ErrorKind::WouldBlock => thread::sleep(POLL_INTERVAL),
+                    Err(err) => {
+                        warn!("fail to accept a telemetry connection, {}", err);
+
+                        thread::sleep(POLL_INTERVAL);
+                    }
+                }
+            }
+        })?;
+
+        self.threads.push(server);
+
+        Ok(self)
+    }
+
+    /// Stop sampling and serving, and wait for the control threads.
+    pub fn stop(self) {}
+}
+
+impl Drop for Telemetry {
+    fn drop(&mut self) {
+        self.quit.store(true, Ordering::Relaxed);
+
+        for thread in self.threads.drain(..) {
+            thread.join();
+        }
+
+        for path in self.sockets.drain(..) {
+            if let Err(err) = fs::remove_file(&path) {
+                debug!("fail to remove the telemetry socket {}, {}", path.display(), err);
+            }
+        }
+    }
+}
+
+/// Remove the socket at `path` if nobody listens on it anymore.
+fn remove_stale_socket(path: &Path) -> io::Result<()> {
+    match fs::symlink_metadata(path) {
+        Ok(meta) if meta.file_type().is_socket() => match UnixStream::connect(path) {
+            Ok(_) => Err(io::ErrorKind::AddrInUse.into()),
+            Err(ref err) if err.kind() == io::ErrorKind::ConnectionRefused => fs::remove_file(path),
+            Err(err) => Err(err),
+        },
+        _ => Ok(()),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::env;
+    use std::process;
+    use std::sync::Arc;
+    use std::thread;
+
+    use super::*;
+
+    #[test]
+    fn test_board() {
+        let board = Arc::new(Board::new(vec!["a".to_owned(), "b".to_owned()]));
+
+        assert_eq!(board.read().seq, 0);
+        assert_eq!(board.get("b"), Some(0));
+        assert_eq!(board.get("c"), None);
+
+        let writer = {
+            let board = board.clone();
+
+            thread::spawn(move || {
+                for i in 1..=10000 {
+                    board.publish(&[i, i * 2]);
+                }
+            })
+        };
+
+        for _ in 0..10000 {
+            let sample = board.read();
+
+            assert_eq!(sample.values[1], sample.values[0] * 2);
+        }
+
+        writer.join().unwrap();
+
+        assert_eq!(board.read().seq, 10000);
+        assert_eq!(board.get("b"), Some(20000));
+
+        let mut buf = vec![];
+
+        board.dump(&mut buf).unwrap();
+
+        assert!(String::from_utf8(buf).unwrap().ends_with("a 10000\nb 20000\n"));
+    }
+
+    #[test]
+    fn test_stale_socket() {
+        let path = env::temp_dir().join(format!("rte-telemetry-{}.sock", process::id()));
+
+        assert!(remove_stale_socket(&path).is_ok());
+
+        let listener = UnixListener::bind(&path).unwrap();
+
+        assert_eq!(remove_stale_socket(&path).unwrap_err().kind(), io::ErrorKind::AddrInUse);
+
+        drop(listener);
+
+        assert!(path.exists());
+        assert!(remove_stale_socket(&path).is_ok());
+        assert!(!path.exists());
+    }
+}
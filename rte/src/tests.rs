@@ -1,22 +1,33 @@
 extern crate num_cpus;
 extern crate pretty_env_logger;
 
+use std::alloc::{GlobalAlloc, Layout};
+use std::borrow::Cow;
+use std::mem;
 use std::os::raw::c_void;
+use std::ptr;
+use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::{Arc, Mutex};
 
 use cfile;
+use libc;
 use log::Level::Debug;
 
 use ffi;
 
+use classify::Classified;
 use common::memory::SOCKET_ID_ANY;
 use eal::{self, ProcType};
+use ethdev;
 use launch;
 use lcore;
-use mbuf;
+use malloc::{self, Arena, HugepageAlloc};
+use mbuf::{self, MBufPool};
 use memory::AsMutRef;
 use mempool::{self, MemoryPool, MemoryPoolFlags};
-use utils::AsRaw;
+use packet::{PacketView, L3, L4};
+use ring::{Ring, RingFlags, SyncMode};
+use utils::{AsRaw, FromRaw};
 
 #[test]
 fn test_eal() {
@@ -47,7 +58,15 @@ fn test_eal() {
 
     test_mempool();
 
+    test_malloc();
+
     test_mbuf();
+
+    test_packet_view();
+
+    test_classify();
+
+    test_ring();
 }
 
 // fn test_config() {
@@ -221,13 +240,76 @@ fn test_mempool() {
     }
 }
 
+fn test_malloc() {
+    let socket_id = lcore::socket_id() as i32;
+    let stats = malloc::get_socket_stats(socket_id).unwrap();
+
+    {
+        let alloc = HugepageAlloc::on_socket(socket_id);
+        let layout = Layout::from_size_align(1000, 256).unwrap();
+
+        unsafe {
+            let p = alloc.alloc_zeroed(layout);
+
+            assert!(!p.is_null());
+            assert_eq!(p as usize % 256, 0);
+            assert_eq!(*p.add(999), 0);
+            assert_eq!(malloc::get_socket_stats(socket_id).unwrap().alloc_count, stats.alloc_count + 1);
+
+            let p = alloc.realloc(p, layout, 2000);
+
+            assert!(!p.is_null());
+
+            alloc.dealloc(p, Layout::from_size_align(2000, 256).unwrap());
+        }
+
+        // the memory allocated before `eal::init` is given back to the system allocator
+        unsafe {
+            let layout = Layout::new::<u64>();
+            let p = ::std::alloc::System.alloc(layout);
+
+            alloc.dealloc(p, layout);
+        }
+    }
+
+    {
+        let mut arena = Arena::new(256, socket_id).unwrap();
+
+        assert_eq!(arena.capacity(), 256);
+
+        {
+            let n = arena.alloc(1u8).unwrap();
+            let v = arena.alloc(2u64).unwrap();
+
+            assert_eq!(*n, 1);
+            assert_eq!(*v, 2);
+            assert_eq!(v as *mut u64 as usize % mem::align_of::<u64>(), 0);
+            assert_eq!(arena.used(), 16);
+
+            let s = arena.alloc_slice_copy(&[1u32, 2, 3]).unwrap();
+
+            assert_eq!(s, &[1, 2, 3]);
+            assert_eq!(arena.used(), 28);
+            assert!(arena.alloc_slice(1000, 0u8).is_none());
+        }
+
+        arena.reset();
+
+        assert_eq!(arena.used(), 0);
+        assert_eq!(arena.peak(), 28);
+        assert_eq!(arena.alloc_slice(256, 0xffu8).unwrap().len(), 256);
+    }
+
+    assert_eq!(malloc::get_socket_stats(socket_id).unwrap().alloc_count, stats.alloc_count);
+}
+
 fn test_mbuf() {
     const NB_MBUF: u32 = 1024;
     const CACHE_SIZE: u32 = 32;
     const PRIV_SIZE: u32 = 0;
     const MBUF_SIZE: u32 = 128;
 
-    let p = mbuf::pool_create(
+    let mut p = mbuf::pool_create(
         "mbuf_pool",
         NB_MBUF,
         CACHE_SIZE,
@@ -250,5 +332,347 @@ fn test_mbuf() {
     assert!(p.is_full());
     assert!(!p.is_empty());
 
+    {
+        let mut burst = mbuf::MbufBurst::<4>::new();
+
+        assert!(burst.is_empty());
+        assert_eq!(burst.capacity(), 4);
+
+        while !burst.is_full() {
+            assert!(burst.push(p.alloc().unwrap()).is_ok());
+        }
+
+        assert!(burst.push(p.alloc().unwrap()).is_err());
+        assert_eq!(p.in_use_count(), 4);
+
+        drop(burst.pop());
+        assert_eq!(burst.len(), 3);
+        assert_eq!(p.in_use_count(), 3);
+
+        unsafe {
+            let m = mbuf::MBuf::from_raw(*burst.as_ptr()).unwrap();
+
+            burst.forget_front(1);
+            drop(m);
+        }
+        assert_eq!(burst.len(), 2);
+        assert_eq!(p.in_use_count(), 2);
+
+        assert_eq!(burst.drain().take(1).count(), 1);
+        assert!(burst.is_empty());
+        assert_eq!(p.in_use_count(), 0);
+    }
+
+    {
+        let mut mbufs: Vec<Option<mbuf::MBuf>> = (0..100).map(|_| None).collect();
+
+        p.alloc_bulk(&mut mbufs).unwrap();
+        assert_eq!(p.in_use_count(), 100);
+
+        mbuf::free_bulk(mbufs.drain(..).flatten());
+        assert_eq!(p.in_use_count(), 0);
+    }
+
+    {
+        let mut cache = p.user_cache(8, lcore::socket_id() as i32).unwrap();
+
+        assert!(cache.is_owned());
+        assert_eq!(cache.cache().size(), 8);
+        assert_eq!(cache.cache().flush_threshold(), 12);
+
+        let mut mbufs: Vec<Option<mbuf::MBuf>> = (0..4).map(|_| None).collect();
+
+        // an empty cache is refilled with size + n objects
+        cache.alloc_bulk(&mut mbufs).unwrap();
+        assert_eq!(cache.stats().get_misses, 1);
+        assert_eq!(cache.cache().len(), 8);
+
+        // reaching the flush threshold flushes the cache back to its size
+        cache.free_bulk(mbufs.drain(..).flatten());
+        assert_eq!(cache.cache().len(), 8);
+        assert_eq!(cache.stats().put_misses, 1);
+
+        let m = cache.alloc().unwrap();
+        assert_eq!(cache.stats().get_hits, 1);
+        assert_eq!(cache.cache().len(), 7);
+
+        cache.free_bulk(vec![m]);
+        assert_eq!(cache.stats().put_hits, 1);
+        assert_eq!(cache.cache().len(), 8);
+
+        cache.resize(16).unwrap();
+        assert!(cache.cache().is_empty());
+        assert_eq!(cache.cache().size(), 16);
+        assert!(cache.resize(mempool::RTE_MEMPOOL_CACHE_MAX_SIZE as usize + 1).is_err());
+
+        assert!(p.lcore_cache().is_some());
+    }
+    assert_eq!(p.in_use_count(), 0);
+
+    {
+        let mut m = p.alloc().unwrap();
+
+        // the flags the builder doesn't own are kept
+        m.ol_flags |= mbuf::OffloadFlags::PKT_TX_VLAN_PKT.bits();
+        m.tx_offload().ether().ipv4(true).tcp_seg(20, 1460).apply().unwrap();
+
+        assert!(m.offload().contains(mbuf::OffloadFlags::PKT_TX_VLAN_PKT));
+
+        assert_eq!((m.l2_len(), m.l3_len(), m.l4_len(), m.tso_segsz()), (14, 20, 20, 1460));
+        assert!(m.offload().contains(
+            mbuf::OffloadFlags::PKT_TX_IPV4
+                | mbuf::OffloadFlags::PKT_TX_IP_CKSUM
+                | mbuf::OffloadFlags::PKT_TX_TCP_CKSUM
+                | mbuf::OffloadFlags::PKT_TX_TCP_SEG
+        ));
+        assert_eq!(
+            ethdev::TxOffload::required_by(m.offload()),
+            ethdev::TxOffload::DEV_TX_OFFLOAD_IPV4_CKSUM
+                | ethdev::TxOffload::DEV_TX_OFFLOAD_TCP_CKSUM
+                | ethdev::TxOffload::DEV_TX_OFFLOAD_TCP_TSO
+        );
+
+        let offload = m.tx_offload().ether().ipv6(40).udp();
+
+        assert!(offload.check(ethdev::TxOffload::DEV_TX_OFFLOAD_TCP_CKSUM).is_err());
+        assert!(offload.check(ethdev::TxOffload::DEV_TX_OFFLOAD_UDP_CKSUM).is_ok());
+        assert!(m.tx_offload().l2(128).apply().is_err());
+    }
+
+    {
+        let freed = Arc::new(AtomicBool::new(false));
+        let mut buf = mbuf::ExtBuf::from_slice(&[0xAB; 100_000], lcore::socket_id() as i32).unwrap();
+
+        {
+            let freed = freed.clone();
+
+            buf.on_free(move || freed.store(true, Ordering::SeqCst)).unwrap();
+        }
+
+        let m = buf.packet(&mut p, 0..buf.len()).unwrap();
+
+        assert_eq!(buf.refcnt(), 3);
+        assert_eq!(m.nb_segs, 2);
+        assert_eq!(m.pkt_len, 100_000);
+        assert_eq!(m.data_len as usize, mbuf::EXTBUF_MAX_SEG_LEN);
+        assert!(!m.is_direct());
+        assert!(buf.clone().get_mut().is_none());
+
+        drop(buf);
+        assert!(!freed.load(Ordering::SeqCst));
+
+        drop(m);
+        assert!(freed.load(Ordering::SeqCst));
+    }
+    assert_eq!(p.in_use_count(), 0);
+
     p.audit();
 }
+
+/// A small pool of default-sized mbufs for the parsing tests.
+fn packet_pool(name: &str) -> MemoryPool {
+    mbuf::pool_create(
+        name,
+        16,
+        0,
+        0,
+        mbuf::RTE_MBUF_DEFAULT_BUF_SIZE as u16,
+        lcore::socket_id() as i32,
+    )
+    .unwrap()
+}
+
+/// Copy `data` to a new mbuf from the pool.
+fn packet_from<P: MBufPool>(p: &mut P, data: &[u8]) -> mbuf::MBuf {
+    let mut m = p.alloc().unwrap();
+
+    unsafe { ptr::copy_nonoverlapping(data.as_ptr(), m.append(data.len()).unwrap().as_ptr(), data.len()) };
+
+    m
+}
+
+fn test_packet_view() {
+    let mut p = packet_pool("packet_view_pool");
+
+    // Ether (14) + IPv4 (20) + TCP (20) + payload (16)
+    let mut pkt = vec![0u8; 70];
+
+    pkt[12..14].copy_from_slice(&[0x08, 0x00]);
+    pkt[14] = 0x45;
+    pkt[23] = libc::IPPROTO_TCP as u8;
+    pkt[26..30].copy_from_slice(&[10, 0, 0, 1]);
+    pkt[30..34].copy_from_slice(&[10, 0, 0, 2]);
+    pkt[34..36].copy_from_slice(&1234u16.to_be_bytes());
+    pkt[36..38].copy_from_slice(&80u16.to_be_bytes());
+    pkt[46] = 5 << 4;
+    for (i, b) in pkt[54..].iter_mut().enumerate() {
+        *b = i as u8;
+    }
+
+    // the IPv4 header straddles the first two segments, the TCP header lies in the second one
+    let mut segs = [&pkt[..24], &pkt[24..64], &pkt[64..]]
+        .iter()
+        .map(|data| packet_from(&mut p, data))
+        .collect::<Vec<_>>()
+        .into_iter();
+    let m = segs.next().unwrap();
+
+    for seg in segs {
+        m.chain(&seg).unwrap();
+        mem::forget(seg);
+    }
+
+    assert_eq!(m.pkt_len(), pkt.len());
+    assert_eq!(m.segments().map(<[u8]>::len).collect::<Vec<_>>(), vec![24, 40, 6]);
+
+    {
+        let view = PacketView::parse(&m).unwrap();
+
+        assert_eq!(view.l3(), Some(L3::Ipv4));
+        assert_eq!(view.l4(), Some(L4::Tcp));
+        assert!(!view.is_fragment());
+        assert_eq!(view.payload_offset(), 54);
+
+        let ip = view.ipv4().unwrap();
+
+        assert!(match ip {
+            Cow::Owned(_) => true,
+            Cow::Borrowed(_) => false,
+        });
+        assert_eq!(u32::from_be(ip.src_addr), 0x0a00_0001);
+        assert_eq!(u32::from_be(ip.dst_addr), 0x0a00_0002);
+
+        let tcp = view.tcp().unwrap();
+
+        assert!(match tcp {
+            Cow::Borrowed(_) => true,
+            Cow::Owned(_) => false,
+        });
+        assert_eq!(u16::from_be(tcp.src_port), 1234);
+        assert_eq!(u16::from_be(tcp.dst_port), 80);
+
+        assert!(view.udp().is_none());
+        assert_eq!(view.payload().flatten().cloned().collect::<Vec<_>>(), &pkt[54..]);
+    }
+
+    m.free();
+    assert_eq!(p.in_use_count(), 0);
+}
+
+fn test_classify() {
+    let mut p = packet_pool("classify_pool");
+
+    // Ether + VLAN + IPv4 + UDP, and an ARP packet
+    let mut udp = vec![0u8; 60];
+
+    udp[12..14].copy_from_slice(&[0x81, 0x00]);
+    udp[16..18].copy_from_slice(&[0x08, 0x00]);
+    udp[18] = 0x45;
+    udp[27] = libc::IPPROTO_UDP as u8;
+    udp[38..42].copy_from_slice(&[0x30, 0x39, 0x00, 0x35]);
+
+    let mut arp = vec![0u8; 60];
+
+    arp[12..14].copy_from_slice(&[0x08, 0x06]);
+
+    let mut burst = mbuf::MbufBurst::<4>::new();
+
+    for pkt in &[udp, arp] {
+        assert!(burst.push(packet_from(&mut p, pkt)).is_ok());
+    }
+
+    let mut classified = Classified::<4>::new();
+
+    classified.classify(&burst);
+
+    assert_eq!(classified.len(), 2);
+    assert_eq!(classified.software(), 2);
+    assert_eq!(
+        classified.ptypes(),
+        &[
+            ffi::RTE_PTYPE_L2_ETHER_VLAN | ffi::RTE_PTYPE_L3_IPV4 | ffi::RTE_PTYPE_L4_UDP,
+            ffi::RTE_PTYPE_L2_ETHER
+        ]
+    );
+    assert_eq!(classified.l3_offsets(), &[18, 0]);
+    assert_eq!(classified.l4_offsets(), &[38, 0]);
+    assert_eq!(classified.protos(), &[libc::IPPROTO_UDP as u8, 0]);
+    assert_ne!(classified.hashes()[0], 0);
+    assert_eq!(classified.hashes()[1], 0);
+
+    burst.clear();
+    assert_eq!(p.in_use_count(), 0);
+}
+
+fn test_ring() {
+    let r = Ring::<Box<usize>>::create(
+        "test_ring",
+        16,
+        SOCKET_ID_ANY,
+        SyncMode::SingleThread.enqueue_flags() | SyncMode::HeadTail.dequeue_flags(),
+    )
+    .unwrap();
+
+    assert_eq!(r.name(), "test_ring");
+    assert_eq!(r.size(), 16);
+    assert_eq!(r.capacity(), 15);
+    assert_eq!(r.prod_sync_mode(), SyncMode::SingleThread);
+    assert_eq!(r.cons_sync_mode(), SyncMode::HeadTail);
+    assert!(r.is_empty());
+
+    let mut objs: Vec<Option<Box<usize>>> = (0..10).map(|i| Some(Box::new(i))).collect();
+
+    assert_eq!(r.enqueue_bulk(&mut objs[..8]), 8);
+    assert!(objs[..8].iter().all(Option::is_none));
+    assert_eq!(r.enqueue_bulk(&mut objs[8..]), 2);
+    assert_eq!(r.count(), 10);
+    assert_eq!(r.free_count(), 5);
+
+    // the objects after an empty slot are not enqueued
+    let mut objs = vec![None, Some(Box::new(10))];
+
+    assert_eq!(r.enqueue_burst(&mut objs), 0);
+    assert!(objs[1].is_some());
+
+    let mut objs: Vec<Option<Box<usize>>> = (0..20).map(|_| None).collect();
+
+    assert_eq!(r.dequeue_bulk(&mut objs[..11]), 0);
+    assert_eq!(r.dequeue_burst(&mut objs[..4]), 4);
+    assert_eq!(
+        objs[..4].iter().map(|obj| **obj.as_ref().unwrap()).collect::<Vec<_>>(),
+        vec![0, 1, 2, 3]
+    );
+
+    {
+        let mut zc = r.dequeue_zc(4).unwrap();
+
+        assert_eq!(zc.len(), 4);
+        assert_eq!(*zc.pop().unwrap(), 4);
+    }
+
+    assert_eq!(r.count(), 5);
+
+    // the single producer can only reserve through the unsafe API
+    assert!(r.enqueue_zc(2).is_err());
+
+    {
+        let mut zc = unsafe { r.sp_enqueue_zc(2) }.unwrap();
+
+        assert_eq!(zc.capacity(), 2);
+        assert!(zc.push(Box::new(10)).is_ok());
+    }
+
+    assert_eq!(r.count(), 6);
+    assert_eq!(r.dequeue().map(|obj| *obj), Some(5));
+    assert!(r.enqueue(Box::new(11)).is_ok());
+
+    assert_eq!(Ring::<Box<usize>>::lookup("test_ring").unwrap().as_raw(), r.as_raw());
+
+    if log_enabled!(Debug) {
+        let stdout = cfile::tmpfile().unwrap();
+
+        r.dump(&*stdout).unwrap();
+    }
+
+    r.free();
+}
@@ -0,0 +1,653 @@
+//!
+//! A hierarchical timer wheel, owned by an lcore which advances it with the TSC.
+//!
+//! Arming and cancelling a timer are O(1): a timer lives in a slab, linked in the slot of the wheel level
+//! covering its expiry, and a tick only visits the slot of the current tick, the slots of the upper levels
+//! are cascaded down once per turn of the level below.
+//!
+//! The other lcores arm timers on a wheel, or hand over a timer to it, through a `Remote`,
+//! which pushes them to a lock-free inbox drained by the next tick.
+//!
+//! ```ignore
+//! let mut wheel = TimerWheel::new(Duration::from_millis(1));
+//!
+//! let id = wheel.arm(Duration::from_secs(30), move || expire(flow));
+//!
+//! loop {
+//!     poll();
+//!
+//!     wheel.tick(rdtsc());
+//! }
+//! ```
+use std::mem;
+use std::ptr;
+use std::sync::atomic::{AtomicPtr, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
+
+use {get_tsc_hz, rdtsc};
+
+/// The slot bits of a level.
+const SLOT_BITS: u32 = 8;
+/// The slots of a level.
+const SLOTS: usize = 1 << SLOT_BITS;
+const SLOT_MASK: u64 = SLOTS as u64 - 1;
+/// The levels of the wheel, they cover 2^32 ticks.
+const LEVELS: usize = 4;
+/// The longest delay, in ticks.
+const MAX_TICKS: u64 = (1 << (SLOT_BITS * LEVELS as u32)) - 1;
+
+const NIL: u32 = u32::max_value();
+
+/// A timer callback.
+pub type Callback = Box<dyn FnMut() + Send>;
+
+/// The handle of an armed timer, it is stale once the timer fired or was cancelled.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
+pub struct TimerId {
+    index: u32,
+    gen: u32,
+}
+
+struct Entry {
+    /// The expiry, in ticks.
+    expire: u64,
+    /// The period in ticks, 0 for a single shot timer.
+    period: u64,
+    callback: Option<Callback>,
+    /// The generation of the entry, bumped when it is released.
+    gen: u32,
+    /// The slot the entry is linked in, as `level * SLOTS + slot`.
+    slot: u32,
+    prev: u32,
+    next: u32,
+}
+
+/// A timer pushed by another lcore.
+struct Migrated {
+    /// The expiry, in TSC cycles.
+    expire_tsc: u64,
+    /// The period in TSC cycles, 0 for a single shot timer.
+    period_tsc: u64,
+    callback: Callback,
+    next: *mut Migrated,
+}
+
+/// A multi-producer, single consumer stack of timers.
+struct Inbox {
+    head: AtomicPtr<Migrated>,
+}
+
+impl Inbox {
+    fn push(&self, timer: Migrated) {
+        let timer = Box::into_raw(Box::new(timer));
+        let mut head = self.head.load(Ordering::Relaxed);
+
+        loop {
+            unsafe { (*timer).next = head };
+
+            match self
+                .head
+                .compare_exchange_weak(head, timer, Ordering::Release, Ordering::Relaxed)
+            {
+                Ok(_) => break,
+                Err(current) => head = current,
+            }
+        }
+    }
+
+    /// Take all the timers pushed so far.
+    fn take(&self) -> *mut Migrated {
+        if self.head.load(Ordering::Relaxed).is_null() {
+            ptr::null_mut()
+        } else {
+            self.head.swap(ptr::null_mut(), Ordering::Acquire)
+        }
+    }
+}
+
+impl Drop for Inbox {
+    fn drop(&mut self) {
+        let mut p = self.take();
+
+        while !p.is_null() {
+            let timer = unsafe { Box::from_raw(p) };
+
+            p = timer.next;
+        }
+    }
+}
+
+/// Arm timers on a `TimerWheel` from another lcore.
+#[derive(Clone)]
+pub struct Remote {
+    inbox: Arc<Inbox>,
+    hz: u64,
+}
+
+impl Remote {
+    /// Arm a single shot timer, it is added to the wheel by its next tick.
+    pub fn arm<F>(&self, delay: Duration, callback: F)
+    where
+        F: FnOnce() + Send + 'static,
+    {
+        let mut callback = Some(callback);
+
+        self.push(
+            rdtsc() + to_cycles(delay, self.hz),
+            0,
+            Box::new(move || (callback.take().unwrap())()),
+        )
+    }
+
+    /// Arm a periodic timer, it is added to the wheel by its next tick.
+    pub fn arm_periodic<F>(&self, period: Duration, callback: F)
+    where
+        F: FnMut() + Send + 'static,
+    {
+        let period = to_cycles(period, self.hz);
+
+        self.push(rdtsc() + period, period, Box::new(callback))
+    }
+
+    fn push(&self, expire_tsc: u64, period_tsc: u64, callback: Callback) {
+        self.inbox.push(Migrated {
+            expire_tsc,
+            period_tsc,
+            callback,
+            next: ptr::null_mut(),
+        })
+    }
+}
+
+/// A hierarchical timer wheel, it is not shared by the lcores, use a `Remote` to reach it.
+pub struct TimerWheel {
+    entries: Vec<Entry>,
+    /// The released entries.
+    free: u32,
+    /// The heads of the slots of each level.
+    slots: Vec<u32>,
+    /// The entries linked in the slots of each level.
+    counts: [usize; LEVELS],
+    /// The current tick.
+    now: u64,
+    /// The TSC of the tick 0.
+    start_tsc: u64,
+    cycles_per_tick: u64,
+    hz: u64,
+    inbox: Arc<Inbox>,
+}
+
+impl TimerWheel {
+    /// Create a wheel ticking at `resolution`, measured with the TSC.
+    pub fn new(resolution: Duration) -> Self {
+        Self::with_clock(get_tsc_hz(), resolution, rdtsc())
+    }
+
+    /// Create a wheel ticking at `resolution` of a clock running at `hz`, which reads `now` at the tick 0.
+    pub fn with_clock(hz: u64, resolution: Duration, now: u64) -> Self {
+        TimerWheel {
+            entries: Vec::new(),
+            free: NIL,
+            slots: vec![NIL; LEVELS * SLOTS],
+            counts: [0; LEVELS],
+            now: 0,
+            start_tsc: now,
+            cycles_per_tick: to_cycles(resolution, hz).max(1),
+            hz,
+            inbox: Arc::new(Inbox {
+                head: AtomicPtr::new(ptr::null_mut()),
+            }),
+        }
+    }
+
+    /// The armed timers, without the ones pending in the inbox.
+    pub fn len(&self) -> usize {
+        self.counts.iter().sum()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// The current tick.
+    pub fn now(&self) -> u64 {
+        self.now
+    }
+
+    /// Convert a duration to ticks, rounded up.
+    pub fn ticks(&self, d: Duration) -> u64 {
+        (to_cycles(d, self.hz) + self.cycles_per_tick - 1) / self.cycles_per_tick
+    }
+
+    /// A handle to arm timers on this wheel from another lcore.
+    pub fn remote(&self) -> Remote {
+        Remote {
+            inbox: self.inbox.clone(),
+            hz: self.hz,
+        }
+    }
+
+    /// Arm a single shot timer.
+    pub fn arm<F>(&mut self, delay: Duration, callback: F) -> TimerId
+    where
+        F: FnOnce() + Send + 'static,
+    {
+        let mut callback = Some(callback);
+        let ticks = self.ticks(delay);
+
+        self.arm_ticks(ticks, 0, Box::new(move || (callback.take().unwrap())()))
+    }
+
+    /// Arm a periodic timer.
+    pub fn arm_periodic<F>(&mut self, period: Duration, callback: F) -> TimerId
+    where
+        F: FnMut() + Send + 'static,
+    {
+        let period = self.ticks(period).max(1);
+
+        self.arm_ticks(period, period, Box::new(callback))
+    }
+
+    /// Arm a timer expiring in `ticks`, fired again every `period` ticks unless it is 0.
+    pub fn arm_ticks(&mut self, ticks: u64, period: u64, callback: Callback) -> TimerId {
+        let index = self.alloc(Entry {
+            expire: self.now + ticks.max(1).min(MAX_TICKS),
+            period,
+            callback: Some(callback),
+            gen: 0,
+            slot: NIL,
+            prev: NIL,
+            next: NIL,
+        });
+
+        self.link(index);
+
+        TimerId {
+            index,
+            gen: self.entries[index as usize].gen,
+        }
+    }
+
+    /// Whether the timer is still armed.
+    pub fn is_pending(&self, id: TimerId) -> bool {
+        self.entries
+            .get(id.index as usize)
+            .map_or(false, |e| e.gen == id.gen && e.slot != NIL)
+    }
+
+    /// Rearm a pending timer to expire in `delay`, return `false` if it is stale.
+    pub fn reset(&mut self, id: TimerId, delay: Duration) -> bool {
+        if !self.is_pending(id) {
+            return false;
+        }
+
+        let ticks = self.ticks(delay).max(1).min(MAX_TICKS);
+
+        self.unlink(id.index);
+        self.entries[id.index as usize].expire = self.now + ticks;
+        self.link(id.index);
+
+        true
+    }
+
+    /// Cancel a pending timer, return its callback, or `None` if it is stale.
+    pub fn cancel(&mut self, id: TimerId) -> Option<Callback> {
+        if !self.is_pending(id) {
+            return None;
+        }
+
+        self.unlink(id.index);
+
+        self.release(id.index)
+    }
+
+    /// Hand over a pending timer to the wheel behind `remote`, with the time it has left,
+    /// return `false` if it is stale.
+    pub fn migrate(&mut self, id: TimerId, remote: &Remote) -> bool {
+        if !self.is_pending(id) {
+            return false;
+        }
+
+        let (expire, period) = {
+            let e = &self.entries[id.index as usize];
+
+            (e.expire, e.period)
+        };
+
+        match self.cancel(id) {
+            Some(callback) => {
+                remote.push(
+                    self.start_tsc + expire * self.cycles_per_tick,
+                    period * self.cycles_per_tick,
+                    callback,
+                );
+
+                true
+            }
+            None => false,
+        }
+    }
+
+    /// Advance the wheel to the TSC `now` and fire the expired timers, return how many fired.
+    ///
+    /// It is cheap enough to be called on every iteration of a poll loop.
+    pub fn tick(&mut self, now: u64) -> usize {
+        let target = now.saturating_sub(self.start_tsc) / self.cycles_per_tick;
+
+        self.drain_inbox();
+
+        if target <= self.now {
+            return 0;
+        }
+
+        if self.is_empty() {
+            self.now = target;
+
+            return 0;
+        }
+
+        let mut fired = 0;
+
+        while self.now < target {
+            self.now += 1;
+
+            self.cascade();
+
+            fired += self.expire();
+        }
+
+        fired
+    }
+
+    /// Fire the timers of the current tick.
+    fn expire(&mut self) -> usize {
+        let slot = (self.now & SLOT_MASK) as usize;
+        let mut fired = 0;
+
+        while self.slots[slot] != NIL {
+            let index = self.slots[slot];
+
+            self.unlink(index);
+
+            let mut callback = self.entries[index as usize].callback.take();
+
+            if let Some(ref mut callback) = callback {
+                callback();
+            }
+
+            fired += 1;
+
+            let period = self.entries[index as usize].period;
+
+            match callback {
+                Some(callback) if period != 0 => {
+                    let e = &mut self.entries[index as usize];
+
+                    e.callback = Some(callback);
+                    e.expire = self.now + period.min(MAX_TICKS);
+
+                    self.link(index);
+                }
+                _ => {
+                    self.release(index);
+                }
+            }
+        }
+
+        fired
+    }
+
+    /// Move the timers of the upper levels reaching the current turn of the level below.
+    fn cascade(&mut self) {
+        for level in 1..LEVELS {
+            let shift = SLOT_BITS * level as u32;
+
+            if self.now & ((1 << shift) - 1) != 0 {
+                break;
+            }
+
+            let slot = level * SLOTS + ((self.now >> shift) & SLOT_MASK) as usize;
+
+            let mut index = mem::replace(&mut self.slots[slot], NIL);
+
+            while index != NIL {
+                let next = self.entries[index as usize].next;
+
+                self.counts[level] -= 1;
+                self.link(index);
+
+                index = next;
+            }
+        }
+    }
+
+    fn drain_inbox(&mut self) {
+        let mut p = self.inbox.take();
+
+        while !p.is_null() {
+            let timer = unsafe { Box::from_raw(p) };
+            let cycles = timer.expire_tsc.saturating_sub(self.start_tsc);
+            let expire = (cycles + self.cycles_per_tick - 1) / self.cycles_per_tick;
+            let period = (timer.period_tsc + self.cycles_per_tick - 1) / self.cycles_per_tick;
+
+            p = timer.next;
+
+            self.arm_ticks(
+                expire.saturating_sub(self.now),
+                if timer.period_tsc == 0 { 0 } else { period.max(1) },
+                timer.callback,
+            );
+        }
+    }
+
+    fn alloc(&mut self, mut entry: Entry) -> u32 {
+        if self.free == NIL {
+            self.entries.push(entry);
+
+            (self.entries.len() - 1) as u32
+        } else {
+            let index = self.free;
+            let e = &mut self.entries[index as usize];
+
+            self.free = e.next;
+            entry.gen = e.gen;
+            *e = entry;
+
+            index
+        }
+    }
+
+    fn release(&mut self, index: u32) -> Option<Callback> {
+        let free = self.free;
+        let e = &mut self.entries[index as usize];
+
+        e.gen = e.gen.wrapping_add(1);
+        e.next = free;
+        self.free = index;
+
+        e.callback.take()
+    }
+
+    /// Link an entry in the slot covering its expiry.
+    ///
+    /// The timers are armed at least one tick ahead, only a cascaded timer may expire on the current tick,
+    /// it goes to the current level 0 slot, which `expire` visits right after `cascade`.
+    fn link(&mut self, index: u32) {
+        let expire = self.entries[index as usize].expire;
+
+        debug_assert!(expire >= self.now);
+
+        let delta = expire - self.now;
+        let level = (0..LEVELS)
+            .find(|&level| delta < 1 << (SLOT_BITS * (level as u32 + 1)))
+            .unwrap_or(LEVELS - 1);
+        let slot = (level * SLOTS) as u32 + ((expire >> (SLOT_BITS * level as u32)) & SLOT_MASK) as u32;
+        let head = self.slots[slot as usize];
+
+        {
+            let e = &mut self.entries[index as usize];
+
+            e.slot = slot;
+            e.prev = NIL;
+            e.next = head;
+        }
+
+        if head != NIL {
+            self.entries[head as usize].prev = index;
+        }
+
+        self.slots[slot as usize] = index;
+        self.counts[level] += 1;
+    }
+
+    fn unlink(&mut self, index: u32) {
+        let (slot, prev, next) = {
+            let e = &mut self.entries[index as usize];
+
+            (mem::replace(&mut e.slot, NIL), e.prev, e.next)
+        };
+
+        if prev == NIL {
+            self.slots[slot as usize] = next;
+        } else {
+            self.entries[prev as usize].next = next;
+        }
+
+        if next != NIL {
+            self.entries[next as usize].prev = prev;
+        }
+
+        self.counts[slot as usize / SLOTS] -= 1;
+    }
+}
+
+#[inline]
+fn to_cycles(d: Duration, hz: u64) -> u64 {
+    (d.as_secs() * hz) + (d.subsec_nanos() as u64 * hz / 1_000_000_000)
+}
+
+#[cfg(test)]
+mod tests {
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::sync::Arc;
+    use std::thread;
+    use std::time::Duration;
+
+    use super::*;
+
+    const HZ: u64 = 1_000_000;
+
+    fn counter() -> (Arc<AtomicUsize>, impl FnMut() + Send + 'static) {
+        let n = Arc::new(AtomicUsize::new(0));
+        let c = n.clone();
+
+        (n, move || {
+            c.fetch_add(1, Ordering::Relaxed);
+        })
+    }
+
+    #[test]
+    fn test_wheel() {
+        // 1ms per tick
+        let mut wheel = TimerWheel::with_clock(HZ, Duration::from_millis(1), 0);
+        let ms = |n: u64| n * 1_000;
+
+        let (short, f) = counter();
+        wheel.arm(Duration::from_millis(3), f);
+        let (long, f) = counter();
+        let long_id = wheel.arm(Duration::from_secs(100), f);
+        let (cancelled, f) = counter();
+        let cancelled_id = wheel.arm(Duration::from_millis(5), f);
+        let (periodic, f) = counter();
+        let periodic_id = wheel.arm_periodic(Duration::from_millis(10), f);
+
+        assert_eq!(wheel.len(), 4);
+        assert!(wheel.cancel(cancelled_id).is_some());
+        assert!(wheel.cancel(cancelled_id).is_none());
+        assert!(!wheel.is_pending(cancelled_id));
+
+        assert_eq!(wheel.tick(ms(2)), 0);
+        assert_eq!(wheel.tick(ms(3)), 1);
+        assert_eq!(short.load(Ordering::Relaxed), 1);
+
+        wheel.tick(ms(95));
+        assert_eq!(periodic.load(Ordering::Relaxed), 9);
+        assert_eq!(cancelled.load(Ordering::Relaxed), 0);
+
+        // a slot reused by another timer invalidates the stale handle
+        let (_, f) = counter();
+        let reused = wheel.arm(Duration::from_millis(1), f);
+        assert!(wheel.reset(reused, Duration::from_millis(100)));
+        assert!(!wheel.reset(cancelled_id, Duration::from_millis(1)));
+
+        // cascaded down from the upper levels
+        wheel.tick(ms(99_999));
+        assert_eq!(long.load(Ordering::Relaxed), 0);
+        assert!(wheel.is_pending(long_id));
+        wheel.tick(ms(100_000));
+        assert_eq!(long.load(Ordering::Relaxed), 1);
+        assert!(!wheel.is_pending(long_id));
+
+        assert!(wheel.cancel(periodic_id).is_some());
+        assert!(wheel.is_empty());
+    }
+
+    #[test]
+    fn test_wheel_turns() {
+        let mut wheel = TimerWheel::with_clock(HZ, Duration::from_millis(1), 0);
+        let ms = |n: u64| n * 1_000;
+
+        // cascaded down on the tick they expire
+        let (turn, f) = counter();
+        wheel.arm(Duration::from_millis(256), f);
+        let (turns, f) = counter();
+        wheel.arm(Duration::from_millis(65_536), f);
+        let (periodic, f) = counter();
+        let periodic_id = wheel.arm_periodic(Duration::from_millis(256), f);
+
+        assert_eq!(wheel.tick(ms(255)), 0);
+        assert_eq!(wheel.tick(ms(256)), 2);
+        assert_eq!(turn.load(Ordering::Relaxed), 1);
+
+        // without drift
+        wheel.tick(ms(1024));
+        assert_eq!(periodic.load(Ordering::Relaxed), 4);
+
+        wheel.tick(ms(65_535));
+        assert_eq!(turns.load(Ordering::Relaxed), 0);
+        wheel.tick(ms(65_536));
+        assert_eq!(turns.load(Ordering::Relaxed), 1);
+        assert_eq!(periodic.load(Ordering::Relaxed), 256);
+
+        assert!(wheel.cancel(periodic_id).is_some());
+        assert!(wheel.is_empty());
+    }
+
+    #[test]
+    fn test_migrate() {
+        let mut src = TimerWheel::with_clock(HZ, Duration::from_millis(1), 0);
+        let mut dst = TimerWheel::with_clock(HZ, Duration::from_millis(1), 0);
+
+        let (fired, f) = counter();
+        let id = src.arm(Duration::from_millis(20), f);
+
+        src.tick(10_000);
+        assert!(src.migrate(id, &dst.remote()));
+        assert!(src.is_empty());
+
+        let remote = dst.remote();
+        let (remote_fired, f) = counter();
+        thread::spawn(move || remote.arm_periodic(Duration::from_secs(3600), f))
+            .join()
+            .unwrap();
+
+        dst.tick(19_000);
+        assert_eq!(dst.len(), 2);
+        assert_eq!(fired.load(Ordering::Relaxed), 0);
+        dst.tick(20_000);
+        assert_eq!(fired.load(Ordering::Relaxed), 1);
+        assert_eq!(remote_fired.load(Ordering::Relaxed), 0);
+        assert_eq!(dst.len(), 1);
+    }
+}
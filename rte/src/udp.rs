@@ -0,0 +1,4 @@
+use ffi;
+
+/// UDP Header
+pub type UdpHdr = ffi::rte_udp_hdr;
@@ -2,6 +2,16 @@ use std::borrow::Borrow;
 use std::ffi::CString;
 use std::ops::{Deref, DerefMut};
 use std::ptr;
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Add to a counter which only the calling thread writes, and the others read.
+///
+/// Its only writer doesn't need an atomic read-modify-write, a relaxed load and store is enough,
+/// and the readers still never see a torn value.
+#[inline(always)]
+pub fn add_counter(counter: &AtomicU64, n: u64) {
+    counter.store(counter.load(Ordering::Relaxed).wrapping_add(n), Ordering::Relaxed)
+}
 
 pub trait Raw<T>: Deref<Target = T> + DerefMut + AsRaw<Raw = T> + IntoRaw + FromRaw + From<*mut T> {}
 
@@ -84,7 +94,9 @@ macro_rules! raw {
 
         impl $crate::utils::IntoRaw for $wrapper {
             fn into_raw(self) -> *mut Self::Raw {
-                self.0.as_ptr()
+                let raw = self.0.as_ptr();
+                ::std::mem::forget(self);
+                raw
             }
         }
 